@@ -3,6 +3,7 @@
 namespace App\Console\Commands;
 
 use App\Jobs\StoreTelemetryJob;
+use App\Services\TelemetryBinaryDecoder;
 use App\Services\TelemetryIngestService;
 use Illuminate\Console\Command;
 use PhpMqtt\Client\MqttClient;
@@ -35,14 +36,23 @@ public function handle(TelemetryIngestService $telemetryIngestService)
 
         $this->info("✅ Conectado a MQTT {$server}:{$port}, escuchando en [{$topic}]...");
 
-        $client->subscribe($topic, function (string $topic, string $message) {
+        $binaryDecoder = new TelemetryBinaryDecoder();
+
+        $client->subscribe($topic, function (string $topic, string $message) use ($binaryDecoder) {
             try {
-                $data = json_decode($message, true);
+                // El firmware puede enviar JSON o la trama binaria compacta (cloud.format)
+                if (TelemetryBinaryDecoder::isBinary($message)) {
+                    $data = $binaryDecoder->decode($message);
+                } else {
+                    $data = json_decode($message, true);
+                }
 
                 if (!is_array($data)) {
-                    Log::warning('MQTT telemetry: invalid JSON', [
+                    Log::warning('MQTT telemetry: invalid payload', [
                         'topic'   => $topic,
-                        'message' => $message,
+                        'message' => TelemetryBinaryDecoder::isBinary($message)
+                            ? bin2hex($message)
+                            : $message,
                     ]);
                     return;
                 }
@@ -53,7 +63,9 @@ public function handle(TelemetryIngestService $telemetryIngestService)
             } catch (\Throwable $e) {
                 Log::error('MQTT telemetry: error processing message', [
                     'topic'   => $topic,
-                    'message' => $message,
+                    'message' => TelemetryBinaryDecoder::isBinary($message)
+                        ? bin2hex($message)
+                        : $message,
                     'error'   => $e->getMessage(),
                 ]);
             }
@@ -0,0 +1,188 @@
+<?php
+
+namespace App\Services;
+
+/**
+ * Decodificador de la trama binaria del firmware
+ * (firmware_unificado/firmware_main/cloud/binary_payload.h).
+ *
+ * v1: hora de captura en u32 (segundos epoch). v2: u64 (µs UTC).
+ *
+ * Devuelve el mismo arreglo que produce json_decode() de la trama JSON,
+ * para que StoreTelemetryJob / TelemetryIngestService no distingan el
+ * formato de origen.
+ */
+class TelemetryBinaryDecoder
+{
+    public const MAGIC = 0x4E; // 'N'
+    public const VERSION = 2;
+
+    private const FLAG_DEBUG = 0x01;
+    private const FLAG_TIME_VALID = 0x02;
+
+    /**
+     * ID de canal => clave en la trama JSON.
+     * Debe coincidir con PayloadChannel del firmware (payloadId y cloudKey
+     * de TELEMETRY_SCHEMA en telemetry/telemetry_schema.h).
+     */
+    public const CHANNELS = [
+        1  => 'lat',
+        2  => 'lng',
+        3  => 'vel_kmh',
+        4  => 'alt_m',
+        5  => 'rumbo',
+        6  => 'gps_sats',
+        7  => 'accel_x',
+        8  => 'accel_y',
+        9  => 'accel_z',
+        10 => 'gyro_x',
+        11 => 'gyro_y',
+        12 => 'gyro_z',
+        13 => '0x0C',
+        14 => '0x0D',
+        15 => '0x05',
+        16 => '0x5C',
+        17 => '0x11',
+        18 => '0x04',
+        19 => '0x10',
+        20 => '0x0B',
+        21 => '0x2F',
+        22 => '0x5E',
+        23 => 'fuel_total',
+        24 => 'BAT',
+        25 => 'susp_fl',
+        26 => 'susp_fr',
+        27 => 'susp_rl',
+        28 => 'susp_rr',
+        29 => 'wifi_rssi',
+        30 => 'heap_free',
+        31 => 'engine.intake_temp',
+    ];
+
+    /**
+     * Canales enviados como i32 (grados x 1e7) en lugar de float32.
+     */
+    private const COORD_CHANNELS = [1, 2];
+
+    private string $buf = '';
+    private int $pos = 0;
+
+    /**
+     * Indica si el mensaje MQTT es una trama binaria (el JSON empieza por '{').
+     */
+    public static function isBinary(string $message): bool
+    {
+        return $message !== '' && ord($message[0]) === self::MAGIC;
+    }
+
+    /**
+     * Decodifica una trama binaria.
+     *
+     * @return array|null null si la trama está truncada o la versión no es soportada
+     */
+    public function decode(string $message): ?array
+    {
+        $this->buf = $message;
+        $this->pos = 0;
+
+        try {
+            if ($this->u8() !== self::MAGIC) {
+                return null;
+            }
+            $version = $this->u8();
+            if ($version < 1 || $version > self::VERSION) {
+                return null;
+            }
+
+            $flags = $this->u8();
+            $epoch = $version >= 2 ? intdiv($this->u64(), 1000000) : $this->u32();
+
+            $data = [
+                'id'  => $this->str(),
+                'idc' => $this->str(),
+                'd'   => ($flags & self::FLAG_DEBUG) !== 0,
+                'dt'  => ($flags & self::FLAG_TIME_VALID) !== 0
+                    ? date('Y-m-d H:i:s', $epoch)
+                    : '1970-01-01 00:00:00',
+                's'   => [],
+                'DTC' => [],
+            ];
+
+            $channelCount = $this->u8();
+            for ($i = 0; $i < $channelCount; $i++) {
+                $id = $this->u8();
+
+                if (in_array($id, self::COORD_CHANNELS, true)) {
+                    $value = round($this->i32() / 1e7, 7);
+                } else {
+                    $value = $this->f32();
+                }
+
+                // IDs desconocidos (firmware más nuevo) se descartan sin romper la trama
+                if (isset(self::CHANNELS[$id])) {
+                    $data['s'][self::CHANNELS[$id]] = ['v' => $value];
+                }
+            }
+
+            $customCount = $this->u8();
+            for ($i = 0; $i < $customCount; $i++) {
+                $key = $this->str();
+                $data['s'][$key] = ['v' => $this->f32()];
+            }
+
+            $dtcCount = $this->u8();
+            for ($i = 0; $i < $dtcCount; $i++) {
+                $data['DTC'][] = $this->str();
+            }
+
+            return $data;
+        } catch (\LengthException) {
+            return null;
+        }
+    }
+
+    private function take(int $n): string
+    {
+        if ($this->pos + $n > strlen($this->buf)) {
+            throw new \LengthException('Truncated telemetry frame');
+        }
+
+        $chunk = substr($this->buf, $this->pos, $n);
+        $this->pos += $n;
+
+        return $chunk;
+    }
+
+    private function u8(): int
+    {
+        return ord($this->take(1));
+    }
+
+    private function u32(): int
+    {
+        return unpack('V', $this->take(4))[1];
+    }
+
+    private function u64(): int
+    {
+        return unpack('P', $this->take(8))[1];
+    }
+
+    private function i32(): int
+    {
+        $v = $this->u32();
+
+        return $v >= 0x80000000 ? $v - 0x100000000 : $v;
+    }
+
+    private function f32(): float
+    {
+        // Redondeo a la precisión de float32 para no arrastrar ruido binario
+        return round(unpack('g', $this->take(4))[1], 6);
+    }
+
+    private function str(): string
+    {
+        return $this->take($this->u8());
+    }
+}
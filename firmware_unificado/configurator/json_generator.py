@@ -66,6 +66,7 @@ class JSONGenerator:
                     
                     # Otros campos
                     "signed": signal.is_signed,
+                    "float": bool(getattr(signal, 'is_float', False)),  # SIG_VALTYPE_ IEEE float32
                     "multiplier": float(signal.scale),
                     "offset_value": float(signal.offset),  # Renombrado para evitar confusión con offset de bytes
                     "byte_order": signal.byte_order,
@@ -1112,8 +1112,8 @@ class MainWindow(QMainWindow):
                         byte_order = "big_endian" if "Big" in byte_order_item.text() else "little_endian"
                     
                     # Convert Back to Firmware Format (Bits)
-                    # Start Bit = Offset Byte * 8.
-                    start_bit = offset_byte * 8
+                    # Start Bit DBC: LSB del byte (Intel) o MSB del byte (Motorola)
+                    start_bit = offset_byte * 8 + (7 if byte_order == "big_endian" else 0)
                     # Length Bit = Len Byte * 8 (Approximation for byte aligned)
                     length_bit = len_byte * 8
                     
@@ -1614,16 +1614,22 @@ class MainWindow(QMainWindow):
                     
                     msg = GenericMessage(can_id)
                     
+                    # Byte order: "byte_order" (generador DBC) o "big_endian" (firmware)
+                    byte_order = s.get("byte_order", "big_endian" if s.get("big_endian", True) else "little_endian")
+                    
                     # --- Determine Start Bit ---
                     # Priority: start_bit > start_byte * 8 > offset * 8
+                    # Sin start_bit, el firmware trata el campo como alineado a byte:
+                    # start DBC = MSB del byte (Motorola) o LSB del byte (Intel)
                     start_bit = 0
+                    byte_start = 7 if byte_order == "big_endian" else 0
                     if "start_bit" in s:
                         start_bit = s["start_bit"]
                     elif "start_byte" in s:
-                        start_bit = s["start_byte"] * 8
+                        start_bit = s["start_byte"] * 8 + byte_start
                     elif "offset" in s: # Motec byte offset
                         if isinstance(s["offset"], int):
-                             start_bit = s["offset"] * 8
+                             start_bit = s["offset"] * 8 + byte_start
                     
                     # --- Determine Length (Bits) ---
                     # Priority: length > length_bytes * 8
@@ -1655,7 +1661,7 @@ class MainWindow(QMainWindow):
                         minimum=s.get("min", 0),
                         maximum=s.get("max", 100),
                         unit=s.get("unit", ""),
-                        byte_order=s.get("byte_order", "big_endian")
+                        byte_order=byte_order
                     )
                     
                     cloud_id = s.get("cloud_id", name)
@@ -1795,13 +1801,14 @@ class MainWindow(QMainWindow):
                 offset_byte = inp_offset.value()
                 len_byte = inp_len_byte.value()
                 
-                # Convert back to internal bits for GenericSignal
-                start_bit = offset_byte * 8
-                length_bit = len_byte * 8
-                
                 # Get byte order from combo
                 byte_order = "big_endian" if inp_byte_order.currentIndex() == 0 else "little_endian"
                 
+                # Convert back to internal bits for GenericSignal
+                # (start DBC: MSB del byte en Motorola, LSB en Intel)
+                start_bit = offset_byte * 8 + (7 if byte_order == "big_endian" else 0)
+                length_bit = len_byte * 8
+                
                 msg = GenericMessage(frame_id)
                 signal = GenericSignal(
                     name=name,
@@ -346,9 +346,10 @@ class CanTab(QWidget):
                 offset_byte = inp_offset.value()
                 len_byte = inp_len_byte.value()
                 
-                start_bit = offset_byte * 8
-                length_bit = len_byte * 8
                 byte_order = "big_endian" if inp_byte_order.currentIndex() == 0 else "little_endian"
+                # Start DBC: MSB del byte en Motorola, LSB en Intel
+                start_bit = offset_byte * 8 + (7 if byte_order == "big_endian" else 0)
+                length_bit = len_byte * 8
                 
                 msg = GenericMessage(frame_id)
                 signal = GenericSignal(
@@ -79,7 +79,8 @@ class XmlLoader:
                     sig = {
                         "name": c_name,
                         "start_byte": byte_offset,
-                        "start_bit": byte_offset * 8,
+                        # Start DBC: MSB del byte en Motorola, LSB en Intel
+                        "start_bit": byte_offset * 8 + (7 if byte_order == "big_endian" else 0),
                         "length": length,
                         "signed": is_signed,
                         "scale": scale,
@@ -14,6 +14,11 @@
 #include <ArduinoJson.h>
 #include <ELMduino.h>
 #include <WiFi.h>
+#include <esp_timer.h>
+#include <obd_link.h>
+#include <obd_pid_cache.h>
+#include <obd_protocol.h>
+#include <obd_scheduler.h>
 
 // ==================== CONFIGURACIÓN HARDCODEADA ====================
 // WiFi del ELM327
@@ -42,6 +47,12 @@
   10000 // Aumentado de 2s a 10s para no bloquear DATA
 #define PID_FAIL_THRESHOLD                                                     \
   5 // Fallos consecutivos para desactivar PID temporalmente
+#define INTERVALO_MINIMO_PID_MS 80 // Mínimo entre peticiones NUEVAS al ELM
+#define LOTE_FALLOS_MAX                                                        \
+  3 // Lotes multi-PID fallidos seguidos antes de leer de a un PID
+#define RATE_REPORT_MS 10000 // Reporte de muestras/s por PID
+#define BAT_MIN_V 5.0f       // Rango válido de BAT (AT RV)
+#define BAT_MAX_V 20.0f
 
 // ==================== CONFIGURACIÓN DE FILTRO DE SUAVIZADO
 // ====================
@@ -54,7 +65,6 @@
 struct ParametroOBD {
   const char *pid;
   const char *nombre;
-  float (ELM327::*funcion)();
   bool disponible;
   float valor;    // Valor filtrado (suavizado)
   float valorRaw; // Último valor crudo leído
@@ -63,37 +73,28 @@ struct ParametroOBD {
   uint8_t lecturasValidas; // Contador de lecturas válidas consecutivas
 };
 
-// Lista de parámetros a monitorear
-// Formato: {pid, nombre, funcion, disponible, valor, valorRaw, valorEMA,
+// Lista de parámetros a monitorear. Fórmula y rango de cada PID Mode 01
+// salen de la tabla J1979 compartida (obd_pids.h): agregar un PID estándar
+// es agregar su fila
+// Formato: {pid, nombre, disponible, valor, valorRaw, valorEMA,
 // ultimaLectura, lecturasValidas}
 ParametroOBD parametros[] = {
-    {"0x0C", "RPM", (float (ELM327::*)())&ELM327::rpm, true, 0, 0, 0, 0, 0},
-    {"BAT", "BATT_V", (float (ELM327::*)())&ELM327::batteryVoltage, true, 0, 0,
-     0, 0, 0},
-    {"0x05", "COOLANT", (float (ELM327::*)())&ELM327::engineCoolantTemp, true,
-     0, 0, 0, 0, 0},
-    {"0x04", "LOAD", (float (ELM327::*)())&ELM327::engineLoad, true, 0, 0, 0, 0,
-     0},
-    {"0x0F", "IAT", (float (ELM327::*)())&ELM327::intakeAirTemp, true, 0, 0, 0,
-     0, 0},
-    {"0x0B", "MAP", (float (ELM327::*)())&ELM327::manifoldPressure, true, 0, 0,
-     0, 0, 0},
-    {"0x10", "MAF", (float (ELM327::*)())&ELM327::mafRate, true, 0, 0, 0, 0, 0},
-    {"0x11", "THROTTLE", (float (ELM327::*)())&ELM327::throttle, true, 0, 0, 0,
-     0, 0},
-    {"0x0D", "SPEED", (float (ELM327::*)())&ELM327::kph, true, 0, 0, 0, 0, 0},
+    {"0x0C", "RPM", true, 0, 0, 0, 0, 0},
+    {"BAT", "BATT_V", true, 0, 0, 0, 0, 0},
+    {"0x05", "COOLANT", true, 0, 0, 0, 0, 0},
+    {"0x04", "LOAD", true, 0, 0, 0, 0, 0},
+    {"0x0F", "IAT", true, 0, 0, 0, 0, 0},
+    {"0x0B", "MAP", true, 0, 0, 0, 0, 0},
+    {"0x10", "MAF", true, 0, 0, 0, 0, 0},
+    {"0x11", "THROTTLE", true, 0, 0, 0, 0, 0},
+    {"0x0D", "SPEED", true, 0, 0, 0, 0, 0},
 
     // PIDs adicionales
-    {"0x5E", "FUEL_RATE", (float (ELM327::*)())&ELM327::fuelRate, true, 0, 0, 0,
-     0, 0},
-    {"0x2F", "FUEL_LEVEL", (float (ELM327::*)())&ELM327::fuelLevel, true, 0, 0,
-     0, 0, 0},
-    {"0x51", "FUEL_PRESSURE", (float (ELM327::*)())&ELM327::fuelPressure, true,
-     0, 0, 0, 0, 0},
-    {"0x5C", "OIL_TEMP", (float (ELM327::*)())&ELM327::oilTemp, true, 0, 0, 0,
-     0, 0},
-    {"0x3C", "CAT_TEMP_B1S1", (float (ELM327::*)())&ELM327::catTempB1S1, true,
-     0, 0, 0, 0, 0},
+    {"0x5E", "FUEL_RATE", true, 0, 0, 0, 0, 0},
+    {"0x2F", "FUEL_LEVEL", true, 0, 0, 0, 0, 0},
+    {"0x0A", "FUEL_PRESSURE", true, 0, 0, 0, 0, 0},
+    {"0x5C", "OIL_TEMP", true, 0, 0, 0, 0, 0},
+    {"0x3C", "CAT_TEMP_B1S1", true, 0, 0, 0, 0, 0},
 };
 
 const int NUM_PARAMETROS = sizeof(parametros) / sizeof(parametros[0]);
@@ -101,6 +102,7 @@ const int NUM_PARAMETROS = sizeof(parametros) / sizeof(parametros[0]);
 // Forward declarations
 bool esPIDCombustible(const ParametroOBD &p);
 bool esPIDBase(const ParametroOBD &p);
+uint8_t numeroPID(const ParametroOBD &p);
 
 // ==================== FUNCIONES DE FILTRADO ====================
 // Aplica filtro EMA con rechazo de outliers
@@ -216,8 +218,26 @@ int parametrosDisponibles = 0;
 String dtcActivos[10];
 int numDTCs = 0;
 
-// Control de lectura secuencial
-uint8_t idxParametro = 0;
+// Planificador de lectura: canal i = parametros[i], con la tasa objetivo
+// y prioridad de obdDefaultSchedule()
+ObdScheduler planificador;
+
+// Lectura multi-PID (se desactiva si la ECU no la acepta; el re-escaneo
+// vuelve a probarla)
+bool lotesMultiPID = true;
+uint8_t fallosLote = 0;
+uint16_t muestrasPID[NUM_PARAMETROS] = {0}; // Lecturas válidas desde el
+                                            // último reporte de tasas
+
+// PIDs disponibles según los mapas de soportados de la ECU (0100, 0120, ...).
+// Con mapas sobran los re-escaneos periódicos y el sondeo oportunista: la
+// respuesta de la ECU no cambia mientras siga conectada
+bool descubrimientoPorMapa = false;
+
+// Formato hacia el Principal: tramas binarias con CRC (obd_link.h) o
+// líneas JSON para depurar con un monitor serie (comando LINK_FORMAT)
+bool formatoBinario = true;
+uint8_t secuenciaEnlace = 0;
 
 // Temporizadores
 unsigned long ultimoEnvio = 0;
@@ -248,7 +268,7 @@ uint8_t calcularChecksum(const String &s) {
 
 // ==================== FUNCIONES DE INICIALIZACIÓN (Forward Declarations)
 // ====================
-void enviarMensaje(const String &tipo, const String &datos);
+void enviarEvento(ObdLinkType tipo, uint8_t codigo, const char *texto);
 
 // ==================== HEARTBEAT SERVICE ====================
 // Se define aquí arriba para ser visible por funciones bloqueantes
@@ -257,9 +277,10 @@ void serviceHeartbeat() {
   if (millis() - lastLinkMsg > 1000) {
     lastLinkMsg = millis();
     if (elmConectado && obdEnabled) {
-      enviarMensaje("OBD_STATUS", "CONNECTED");
+      enviarEvento(OBD_LINK_STATUS, OBD_LINK_STATUS_CONNECTED, "CONNECTED");
     } else {
-      enviarMensaje("OBD_STATUS", "DISCONNECTED");
+      enviarEvento(OBD_LINK_STATUS, OBD_LINK_STATUS_DISCONNECTED,
+                   "DISCONNECTED");
     }
   }
 }
@@ -269,38 +290,77 @@ void serviceHeartbeat() {
 // ¿ELM está ocupado con un mensaje pendiente?
 inline bool elmOcupado() { return (elm.nb_rx_state == ELM_GETTING_MSG); }
 
-// Consulta “bloqueante” UN SOLO PID usando el patrón no bloqueante interno de
-// ELMduino. Se usa SOLO en el escaneo inicial y re-escanear, no en la lectura
-// continua.
-bool queryPIDBlocking(ParametroOBD &p, uint16_t timeoutMs = 500) {
+// Comando OBD "bloqueante" con el patrón no bloqueante de ELMduino; deja la
+// respuesta convertida a bytes. Solo para el escaneo, no en la lectura
+// continua
+bool consultaBloqueante(const char *cmd, uint8_t *bytes, size_t *len,
+                        uint16_t timeoutMs) {
   unsigned long start = millis();
+  elm.sendCommand(cmd);
 
   while (millis() - start < timeoutMs) {
-    float valor = (elm.*(p.funcion))();
-
+    elm.get_response();
     if (elm.nb_rx_state == ELM_SUCCESS) {
-      if (isfinite(valor)) {
-        p.valor = valor;
-        p.ultimaLectura = millis();
-        return true;
-      }
-      return false;
+      *len = obdElmResponseToBytes(elm.payload, bytes, OBD_MAX_RESPONSE_BYTES);
+      return *len > 0;
     } else if (elm.nb_rx_state != ELM_GETTING_MSG) {
-      // Algún error: NO DATA, TIMEOUT, etc.
-      elm.printError();
-      return false;
+      return false; // NO DATA, TIMEOUT, etc.
     }
-
-    // Sigue esperando respuesta - yield más frecuente
     delay(5);
-    serviceHeartbeat(); // Keep link alive during blocking query
+    serviceHeartbeat();
   }
 
-  // Timeout
-  Serial.print(" (timeout)");
+  Serial.printf("[SCAN] %s sin respuesta (timeout)\n", cmd);
   return false;
 }
 
+// Consulta "bloqueante" de UN SOLO PID: Mode 01 decodificado con la tabla
+// J1979 o, para BAT, la función de ELMduino. Solo escaneo y sondeo
+bool queryPIDBlocking(ParametroOBD &p, uint16_t timeoutMs = 500) {
+  uint8_t pid = numeroPID(p);
+  float valor = 0;
+
+  if (pid != 0) {
+    char cmd[OBD_REQUEST_MAX_LEN];
+    uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+    size_t len;
+    ObdPidData dato;
+    obdBuildMode01Request(&pid, 1, cmd, sizeof(cmd));
+    if (!consultaBloqueante(cmd, bytes, &len, timeoutMs) ||
+        obdSplitMode01Response(bytes, len, &pid, 1, &dato) == 0 ||
+        !obdDecodeMode01(pid, dato.data, dato.len, &valor)) {
+      return false;
+    }
+  } else {
+    // BAT (AT RV) no es Mode 01
+    unsigned long start = millis();
+    do {
+      valor = elm.batteryVoltage();
+      if (elm.nb_rx_state != ELM_GETTING_MSG) {
+        break;
+      }
+      delay(5);
+      serviceHeartbeat(); // Keep link alive during blocking query
+    } while (millis() - start < timeoutMs);
+
+    if (elm.nb_rx_state != ELM_SUCCESS) {
+      if (elm.nb_rx_state == ELM_GETTING_MSG) {
+        Serial.print(" (timeout)");
+      } else {
+        elm.printError(); // NO DATA, TIMEOUT, etc.
+      }
+      return false;
+    }
+  }
+
+  if (!isfinite(valor)) {
+    return false;
+  }
+  p.valor = valor;
+  p.ultimaLectura = millis();
+  return true;
+}
+
 // ==================== FUNCIONES DE INICIALIZACIÓN ====================
 void conectarWiFi();
 void conectarELM();
@@ -310,6 +370,7 @@ void leerDTCs();
 void borrarDTCs();
 void enviarDatos();
 void enviarMensaje(const String &tipo, const String &datos);
+void enviarEvento(ObdLinkType tipo, uint8_t codigo, const char *texto);
 void procesarUART();
 void procesarComando(const String &comando);
 void procesarUART();
@@ -327,6 +388,13 @@ void setup() {
   pinMode(LED_STATUS_PIN, OUTPUT);
   digitalWrite(LED_STATUS_PIN, LOW);
 
+  // Planificador: un canal por parámetro, en el mismo orden
+  for (int i = 0; i < NUM_PARAMETROS; i++) {
+    uint8_t pid = numeroPID(parametros[i]);
+    ObdSchedule plan = obdDefaultSchedule(pid);
+    planificador.add(plan.periodMs, plan.priority, pid != 0);
+  }
+
   // Inicializar UART hacia ESP32 Principal
   MainSerial.begin(UART_BAUD, SERIAL_8N1, UART_RX_PIN, UART_TX_PIN);
   MainSerial.setRxBufferSize(2048); // <-- NUEVO
@@ -422,7 +490,8 @@ void conectarELM() {
 
     // CRÍTICO: Reducido timeout de 2500ms a 1500ms para no exceder margen de
     // heartbeat
-    if (!elm.begin(elmClient, false, 1500)) {
+    // Buffer de respuesta ampliado para las respuestas multitrama
+    if (!elm.begin(elmClient, false, 1500, '0', OBD_ELM_PAYLOAD_LEN)) {
       Serial.println("✗ Init");
       elmClient.stop();
       delay(500); // Reducido de 2000ms
@@ -472,22 +541,53 @@ void conectarELM() {
 }
 
 // ==================== ESCANEO DE PIDs ====================
-void escanearPIDs() {
-  Serial.println("[SCAN] Detectando sensores disponibles...");
-  parametrosDisponibles = 0;
 
-  // Reiniciar valores pero respetar quién es base
-  for (int i = 0; i < NUM_PARAMETROS; i++) {
-    ParametroOBD &p = parametros[i];
-    bool base = esPIDBase(p);
+// VIN + mapas de PIDs soportados. Un vehículo ya visto sale de la caché en
+// NVS con una sola consulta (el VIN)
+bool descubrirPIDsSoportados(ObdSupportedPids *soportados) {
+  uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+  size_t len;
+
+  char vin[OBD_VIN_LEN + 1];
+  bool hayVin = consultaBloqueante("0902", bytes, &len, 1500) &&
+                obdParseVin(bytes, len, vin);
+  if (hayVin && obdPidCacheLoad(vin, soportados)) {
+    Serial.printf("[SCAN] VIN %s: PIDs soportados desde caché\n", vin);
+    return true;
+  }
 
-    // Resetear filtro y valores
-    resetearFiltro(p);
-    p.ultimaLectura = 0;
-    // Los base se quedan habilitados para que el loop siempre los intente
-    p.disponible = base;
+  // Mapas 0x00, 0x20, ...: el bit 0 de cada uno indica si existe el próximo
+  soportados->count = 0;
+  uint8_t base = 0x00;
+  while (soportados->count < OBD_SUPPORTED_MAPS) {
+    char cmd[5];
+    snprintf(cmd, sizeof(cmd), "01%02X", base);
+    uint32_t mapa;
+    if (!consultaBloqueante(cmd, bytes, &len, 1000) ||
+        !obdParseSupportedMap(bytes, len, base, &mapa)) {
+      break;
+    }
+    soportados->maps[soportados->count++] = mapa;
+    Serial.printf("[SCAN] Mapa %s: %08lX\n", cmd, (unsigned long)mapa);
+    if ((mapa & 1) == 0) {
+      break;
+    }
+    base += 0x20;
   }
 
+  if (soportados->count == 0) {
+    return false;
+  }
+  if (hayVin) {
+    obdPidCacheStore(vin, *soportados);
+    Serial.printf("[SCAN] VIN %s: PIDs soportados guardados\n", vin);
+  }
+  return true;
+}
+
+// Sin mapas (ECU o adaptador que no responde 0100): se prueba PID por PID,
+// primero los base y, si alguno responde, los extra
+void sondearPIDs() {
   // ========= FASE 1: SOLO PIDs BASE (arranque rápido) =========
   Serial.println("[SCAN] Fase 1: PIDs base...");
   for (int i = 0; i < NUM_PARAMETROS; i++) {
@@ -553,64 +653,118 @@ void escanearPIDs() {
     Serial.println(
         "[SCAN] Sin PIDs base - extras se probarán oportunistamente");
   }
-  serviceHeartbeat();
-
-  Serial.printf("[SCAN] Total PIDs confirmados: %d de %d\n",
-                parametrosDisponibles, NUM_PARAMETROS);
 }
 
-// ==================== LECTURA SECUENCIAL DE PIDs ====================
+void escanearPIDs() {
+  Serial.println("[SCAN] Detectando sensores disponibles...");
+  parametrosDisponibles = 0;
+  lotesMultiPID = true;
+  fallosLote = 0;
 
-// Helper para filtrar valores absurdos
-bool valorEnRango(const ParametroOBD &p, float v) {
-  // RPM
-  if (strcmp(p.nombre, "RPM") == 0) {
-    return (v >= 0 && v <= 10000);
-  }
+  // Reiniciar valores pero respetar quién es base
+  for (int i = 0; i < NUM_PARAMETROS; i++) {
+    ParametroOBD &p = parametros[i];
+    bool base = esPIDBase(p);
 
-  // Temperaturas
-  if (strcmp(p.nombre, "COOLANT") == 0 || strcmp(p.nombre, "IAT") == 0 ||
-      strcmp(p.nombre, "OIL_TEMP") == 0 ||
-      strcmp(p.nombre, "CAT_TEMP_B1S1") == 0) {
-    return (v > -50 && v < 1200);
+    // Resetear filtro y valores
+    resetearFiltro(p);
+    p.ultimaLectura = 0;
+    // Los base se quedan habilitados para que el loop siempre los intente
+    p.disponible = base;
   }
 
-  // Porcentajes
-  if (strcmp(p.nombre, "LOAD") == 0 || strcmp(p.nombre, "THROTTLE") == 0 ||
-      strcmp(p.nombre, "FUEL_LEVEL") == 0) {
-    return (v >= 0 && v <= 100);
-  }
+  ObdSupportedPids soportados;
+  descubrimientoPorMapa = descubrirPIDsSoportados(&soportados);
 
-  // Velocidad
-  if (strcmp(p.nombre, "SPEED") == 0) {
-    return (v >= 0 && v <= 300);
+  if (descubrimientoPorMapa) {
+    for (int i = 0; i < NUM_PARAMETROS; i++) {
+      ParametroOBD &p = parametros[i];
+      uint8_t pid = numeroPID(p);
+      // BAT (AT RV) lo responde el ELM, no la ECU
+      p.disponible = pid == 0 || soportados.supports(pid);
+      if (p.disponible) {
+        parametrosDisponibles++;
+      } else {
+        Serial.printf("[SCAN] %s (%s) no soportado\n", p.pid, p.nombre);
+      }
+    }
+  } else {
+    Serial.println("[SCAN] Sin mapa de PIDs soportados, sondeando...");
+    sondearPIDs();
   }
+  serviceHeartbeat();
 
-  // MAP kPa
-  if (strcmp(p.nombre, "MAP") == 0) {
-    return (v >= 0 && v <= 300);
-  }
+  Serial.printf("[SCAN] Total PIDs confirmados: %d de %d\n",
+                parametrosDisponibles, NUM_PARAMETROS);
+}
 
-  // MAF g/s
-  if (strcmp(p.nombre, "MAF") == 0) {
-    return (v >= 0 && v <= 500);
-  }
+// ==================== LECTURA SECUENCIAL DE PIDs ====================
 
-  // Fuel rate, presión, etc.
-  if (strcmp(p.nombre, "FUEL_RATE") == 0) {
-    return (v >= 0 && v <= 100);
+// Helper para filtrar valores absurdos: rango de la tabla J1979 por
+// índice; BAT no es Mode 01
+bool valorEnRango(const ParametroOBD &p, float v) {
+  uint8_t pid = numeroPID(p);
+  if (pid == 0) {
+    return (v > BAT_MIN_V && v < BAT_MAX_V);
   }
-  if (strcmp(p.nombre, "FUEL_PRESSURE") == 0) {
-    return (v >= 0 && v <= 2000);
+  return obdMode01InRange(pid, v);
+}
+
+// ==================== LECTURA PLANIFICADA ====================
+// ObdScheduler elige en cada petición los PIDs vencidos según su tasa
+// objetivo y prioridad (RPM/acelerador/velocidad a 10 Hz, temperaturas a
+// 0.5 Hz, nivel de combustible a 0.1 Hz) y los agrupa hasta
+// OBD_MAX_BATCH_PIDS por petición Mode 01 (ISO 15765-4), o de a uno si la
+// ECU no acepta multi-PID. BAT (AT RV) no es Mode 01 y se lee solo con su
+// función de ELMduino.
+
+// PID Mode 01 de un parámetro (0 = no es Mode 01, ej: "BAT")
+uint8_t numeroPID(const ParametroOBD &p) {
+  if (strncmp(p.pid, "0x", 2) != 0) {
+    return 0;
   }
+  return (uint8_t)strtol(p.pid + 2, nullptr, 16);
+}
 
-  // Batería
-  if (strcmp(p.nombre, "BATT_V") == 0) {
-    return (v > 5 && v < 20);
+void procesarLote(const uint8_t *pids, const uint8_t *indices, uint8_t n,
+                  bool ok) {
+  uint8_t encontrados = 0;
+
+  if (ok) {
+    uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+    ObdPidData datos[OBD_MAX_BATCH_PIDS];
+    size_t len = obdElmResponseToBytes(elm.payload, bytes, sizeof(bytes));
+    encontrados = obdSplitMode01Response(bytes, len, pids, n, datos);
+
+    for (uint8_t i = 0; i < encontrados; i++) {
+      for (uint8_t k = 0; k < n; k++) {
+        if (pids[k] != datos[i].pid)
+          continue;
+        ParametroOBD &p = parametros[indices[k]];
+        float valor;
+        if (obdDecodeMode01(datos[i].pid, datos[i].data, datos[i].len,
+                            &valor) &&
+            valorEnRango(p, valor)) {
+          aplicarFiltro(p, valor);
+          p.ultimaLectura = millis();
+          muestrasPID[indices[k]]++;
+        }
+        break;
+      }
+    }
+  } else {
+    elm.printError();
   }
 
-  // Por defecto, aceptamos si es finito
-  return isfinite(v);
+  // Una ECU sin multi-PID responde con error o solo al primer PID
+  if (n > 1 && encontrados < 2) {
+    if (++fallosLote >= LOTE_FALLOS_MAX) {
+      lotesMultiPID = false;
+      Serial.println("[OBD] La ECU no acepta multi-PID: lectura de a un PID");
+    }
+  } else if (encontrados > 0) {
+    fallosLote = 0;
+  }
 }
 
 void leerPIDs() {
@@ -618,86 +772,108 @@ void leerPIDs() {
     return;
   }
 
-  // THROTTLE para NUEVOS comandos: No enviar comando nuevo si el anterior aún
-  // no terminó PERO: Si el ELM está procesando (GETTING_MSG), DEBEMOS seguir
-  // llamando para leer la respuesta
   static unsigned long ultimaPeticion = 0;
-  static int8_t pidEnProceso =
-      -1; // -1 = ninguno, 0+ = índice del PID esperando respuesta
-  const unsigned long INTERVALO_MINIMO_PID =
-      80; // 80ms mínimo entre NUEVOS comandos
-
-  // Si hay un PID en proceso, debemos seguir llamando a su función hasta que
-  // termine. No avanzamos idxParametro ni aplicamos throttle.
-  if (pidEnProceso != -1) {
-    // Asegurarse de que idxParametro apunte al PID que está en proceso
-    // Esto es crucial si el loop principal avanza idxParametro por error o si
-    // se reinicia. Aunque en este diseño, idxParametro solo avanza si el PID
-    // actual termina. Para mayor robustez, podríamos hacer: idxParametro =
-    // pidEnProceso; Pero el flujo actual ya lo mantiene.
-  } else {
-    // No hay PID en proceso, podemos buscar el siguiente o aplicar throttle
-    // para uno nuevo. Verificar si ha pasado suficiente tiempo desde la última
-    // petición exitosa o con error.
-    if (millis() - ultimaPeticion < INTERVALO_MINIMO_PID) {
-      return; // Demasiado pronto para enviar un NUEVO comando, esperar.
+  static unsigned long inicioPeticion = 0;
+  static bool loteEnCurso = false;
+  static int8_t pidEnProceso = -1; // BAT, leído con batteryVoltage()
+  static uint8_t lotePids[OBD_MAX_BATCH_PIDS];
+  static uint8_t loteIdx[OBD_MAX_BATCH_PIDS];
+  static uint8_t loteN = 0;
+
+  // Respuesta pendiente: seguir leyendo sin throttle
+  if (loteEnCurso) {
+    elm.get_response();
+    if (elm.nb_rx_state == ELM_GETTING_MSG) {
+      return;
     }
+    loteEnCurso = false;
+    ultimaPeticion = millis();
+    planificador.recordRtt(ultimaPeticion - inicioPeticion);
+    procesarLote(lotePids, loteIdx, loteN, elm.nb_rx_state == ELM_SUCCESS);
+    return;
   }
 
-  // Secuencia circular de PIDs
-  if (idxParametro >= NUM_PARAMETROS) {
-    idxParametro = 0;
+  if (pidEnProceso >= 0) {
+    ParametroOBD &p = parametros[pidEnProceso];
+    float valorCrudo = elm.batteryVoltage();
+    if (elm.nb_rx_state == ELM_GETTING_MSG) {
+      return;
+    }
+    if (elm.nb_rx_state == ELM_SUCCESS && isfinite(valorCrudo) &&
+        valorEnRango(p, valorCrudo)) {
+      aplicarFiltro(p, valorCrudo);
+      p.ultimaLectura = millis();
+      muestrasPID[pidEnProceso]++;
+    } else if (elm.nb_rx_state != ELM_SUCCESS) {
+      elm.printError();
+    }
+    pidEnProceso = -1;
+    ultimaPeticion = millis();
+    planificador.recordRtt(ultimaPeticion - inicioPeticion);
+    return;
   }
 
-  ParametroOBD &p = parametros[idxParametro];
-
-  // Si no está marcado como disponible, saltar al siguiente
-  if (!p.disponible) {
-    idxParametro++;
-    // Si el PID actual no está disponible, y no hay uno en proceso,
-    // intentamos el siguiente inmediatamente sin throttle.
-    // Esto es para evitar esperas innecesarias en PIDs no disponibles.
-    if (pidEnProceso == -1) {
-      ultimaPeticion = 0; // Resetear para que el próximo ciclo intente el
-                          // siguiente PID disponible
-    }
+  // THROTTLE para NUEVOS comandos
+  if (millis() - ultimaPeticion < INTERVALO_MINIMO_PID_MS) {
     return;
   }
 
-  // Llamar a la función del PID (esto puede: enviar comando O procesar
-  // respuesta pendiente)
-  float valorCrudo = (elm.*(p.funcion))();
+  for (int i = 0; i < NUM_PARAMETROS; i++) {
+    planificador.setActive(i, parametros[i].disponible);
+  }
 
-  if (elm.nb_rx_state == ELM_SUCCESS) {
-    // ¡Respuesta recibida exitosamente!
-    if (isfinite(valorCrudo) && valorEnRango(p, valorCrudo)) {
-      aplicarFiltro(p, valorCrudo);
-      p.ultimaLectura = millis();
-    }
-    // Pasamos al siguiente PID
-    pidEnProceso = -1;
-    idxParametro++;
+  uint8_t elegidos[OBD_MAX_BATCH_PIDS];
+  uint8_t n = planificador.next(
+      millis(), lotesMultiPID ? OBD_MAX_BATCH_PIDS : 1, elegidos);
+  if (n == 0) {
+    return; // Ningún PID vencido todavía
+  }
+  inicioPeticion = millis();
 
-    // Aplicar throttle: esperar antes de enviar el siguiente comando
-    ultimaPeticion = millis();
+  if (numeroPID(parametros[elegidos[0]]) == 0) {
+    pidEnProceso = elegidos[0]; // batteryVoltage() envía la petición en la
+    return;                     // próxima llamada
+  }
 
-  } else if (elm.nb_rx_state == ELM_GETTING_MSG) {
-    // Aún esperando respuesta - marcar cuál PID está en proceso
-    if (pidEnProceso ==
-        -1) { // Solo marcar la primera vez que entra en GETTING_MSG
-      pidEnProceso = idxParametro;
-    }
-    // NO avanzamos, seguiremos llamando a esta función en el próximo loop
+  for (uint8_t i = 0; i < n; i++) {
+    lotePids[i] = numeroPID(parametros[elegidos[i]]);
+    loteIdx[i] = elegidos[i];
+  }
+  loteN = n;
 
-  } else {
-    // Error (NO_DATA, TIMEOUT, etc.) - mostrar y avanzar
-    elm.printError();
-    pidEnProceso = -1;
-    idxParametro++;
+  char cmd[OBD_REQUEST_MAX_LEN];
+  obdBuildMode01Request(lotePids, loteN, cmd, sizeof(cmd));
+  elm.sendCommand(cmd);
+  loteEnCurso = true;
+}
 
-    // Aplicar throttle también después de error
-    ultimaPeticion = millis();
+// Muestras/s efectivas de cada PID disponible, en una línea
+void reportarTasas() {
+  static unsigned long ultimoReporte = 0;
+  unsigned long ahora = millis();
+  if (ahora - ultimoReporte < RATE_REPORT_MS) {
+    return;
   }
+
+  float segundos = (ahora - ultimoReporte) / 1000.0f;
+  ultimoReporte = ahora;
+
+  String linea = "[RATE] ";
+  linea += lotesMultiPID ? "multi-PID" : "PID individual";
+  linea += " | RTT ";
+  linea += String(planificador.getRttMs());
+  linea += " ms";
+  linea += " | muestras/s:";
+  for (int i = 0; i < NUM_PARAMETROS; i++) {
+    if (parametros[i].disponible) {
+      linea += " ";
+      linea += parametros[i].nombre;
+      linea += "=";
+      linea += String(muestrasPID[i] / segundos, 1);
+    }
+    muestrasPID[i] = 0;
+  }
+  Serial.println(linea);
 }
 
 // ==================== LECTURA DE DTCs ====================
@@ -784,7 +960,7 @@ void leerDTCs() {
 void borrarDTCs() {
   if (!elmConectado || elmOcupado()) {
     Serial.println("[DTC] No se puede borrar ahora, ELM ocupado");
-    enviarMensaje("DTC_CLEARED", "BUSY");
+    enviarEvento(OBD_LINK_DTC_CLEARED, OBD_LINK_DTC_BUSY, "BUSY");
     return;
   }
 
@@ -794,22 +970,54 @@ void borrarDTCs() {
   if (elm.resetDTC()) {
     Serial.println("✓ Códigos borrados exitosamente");
     numDTCs = 0;
-    enviarMensaje("DTC_CLEARED", "SUCCESS");
+    enviarEvento(OBD_LINK_DTC_CLEARED, OBD_LINK_DTC_SUCCESS, "SUCCESS");
   } else {
     Serial.println("✗ Error al borrar códigos");
-    enviarMensaje("DTC_CLEARED", "FAILED");
+    enviarEvento(OBD_LINK_DTC_CLEARED, OBD_LINK_DTC_FAILED, "FAILED");
   }
 }
 
 // ==================== ENVÍO DE DATOS ====================
-void enviarDatos() {
+// Versión JSON de una trama DATA, para depurar con un monitor serie
+void enviarDatosJSON(const ObdLinkData &datos) {
   JsonDocument doc;
 
   doc["t"] = "DATA";
-  doc["ts"] = millis();
+  // ms de 32 bits: el Principal compila ArduinoJson sin enteros de 64 bits
+  doc["ts_ms"] = (uint32_t)(datos.tsUs / 1000);
 
   JsonObject pids = doc["pids"].to<JsonObject>();
-  int validPids = 0;
+  for (uint8_t i = 0; i < datos.count; i++) {
+    char clave[8];
+    if (datos.samples[i].pid == OBD_LINK_PID_BATTERY) {
+      strcpy(clave, "BAT");
+    } else {
+      snprintf(clave, sizeof(clave), "0x%02X", datos.samples[i].pid);
+    }
+    pids[clave] = datos.samples[i].value;
+  }
+
+  if (datos.dtcCount > 0) {
+    JsonArray dtc = doc["dtc"].to<JsonArray>();
+    for (uint8_t i = 0; i < datos.dtcCount; i++) {
+      dtc.add(datos.dtcs[i]);
+    }
+  }
+
+  String output;
+  serializeJson(doc, output);
+  MainSerial.println(output);
+}
+
+void enviarDatos() {
+  ObdLinkData datos;
+  datos.tsUs = (uint64_t)esp_timer_get_time();
+  datos.count = 0;
+  datos.dtcCount = 0;
+
+  // Mismo reloj que millis() (ultimaLectura): el Principal reconstruye el
+  // instante de cada lectura como ts_us / 1000 - antigüedad
+  unsigned long ahora = (unsigned long)(datos.tsUs / 1000);
 
   // --- Construcción de LOG en UNA sola línea ---
   String logLine = "[DATA] ";
@@ -817,20 +1025,30 @@ void enviarDatos() {
 
   bool firstField = true;
 
-  for (int i = 0; i < NUM_PARAMETROS; i++) {
+  for (int i = 0; i < NUM_PARAMETROS && datos.count < OBD_LINK_MAX_SAMPLES;
+       i++) {
     // Solo PIDs marcados como disponibles
     if (!parametros[i].disponible)
       continue;
 
     float valor = parametros[i].valor;
 
-    // Evitar NaN / infinito (esto sí rompe JSON)
+    // Evitar NaN / infinito
     if (!isfinite(valor))
       continue;
 
-    // --- Agregar al JSON (aunque sea 0) ---
-    pids[parametros[i].pid] = valor;
-    validPids++;
+    // --- Agregar a la trama (aunque sea 0) ---
+    uint8_t pid = numeroPID(parametros[i]);
+    unsigned long edad = ahora - parametros[i].ultimaLectura;
+
+    ObdLinkSample &s = datos.samples[datos.count++];
+    s.pid = pid != 0 ? pid : OBD_LINK_PID_BATTERY;
+    s.value = valor;
+    // 0xFFFF = sin lectura (o de hace más de 65 s): el Principal no la
+    // publica
+    s.ageMs = (parametros[i].ultimaLectura == 0 || edad > 0xFFFF)
+                  ? 0xFFFF
+                  : (uint16_t)edad;
 
     // --- Agregar al log en texto ---
     if (!firstField) {
@@ -853,33 +1071,37 @@ void enviarDatos() {
   }
 
   logLine += " (";
-  logLine += String(validPids);
+  logLine += String(datos.count);
   logLine += " total)";
 
-  // Agregar DTCs al JSON y al log si existen
+  // Agregar DTCs a la trama y al log si existen
   if (numDTCs > 0) {
-    JsonArray dtc = doc["dtc"].to<JsonArray>();
-
     logLine += " | DTC:";
-    for (int i = 0; i < numDTCs; i++) {
-      dtc.add(dtcActivos[i]);
+    for (int i = 0; i < numDTCs && i < OBD_LINK_MAX_DTCS; i++) {
+      strncpy(datos.dtcs[i], dtcActivos[i].c_str(), OBD_LINK_DTC_LEN);
+      datos.dtcs[i][OBD_LINK_DTC_LEN] = '\0';
+      datos.dtcCount++;
       logLine += " ";
       logLine += dtcActivos[i];
     }
   }
 
-  // Marcamos que se envió correctamente
-  logLine += " | TX→ESP32 OK";
+  // --- Envío real al ESP32 Principal ---
+  if (formatoBinario) {
+    uint8_t trama[OBD_LINK_MAX_FRAME];
+    size_t len =
+        obdLinkEncodeData(datos, secuenciaEnlace++, trama, sizeof(trama));
+    MainSerial.write(trama, len);
+    logLine += " | TX→ESP32 BIN ";
+    logLine += String((unsigned)len);
+    logLine += " B";
+  } else {
+    enviarDatosJSON(datos);
+    logLine += " | TX→ESP32 JSON";
+  }
 
   // --- Log en UNA sola línea ---
   Serial.println(logLine);
-
-  // --- Envío real al ESP32 Principal (UNA línea JSON puro) ---
-  // NOTA: Checksum removido para compatibilidad con source_obd_bridge.cpp
-  //       que espera JSON puro sin sufijo #XX
-  String output;
-  serializeJson(doc, output);
-  MainSerial.println(output);
 }
 
 // ==================== ENVÍO DE MENSAJES ====================
@@ -887,7 +1109,7 @@ void enviarMensaje(const String &tipo, const String &datos) {
   JsonDocument doc;
   doc["t"] = tipo;
   doc["data"] = datos;
-  doc["ts"] = millis();
+  doc["ts_ms"] = (uint32_t)(esp_timer_get_time() / 1000);
 
   String output;
   serializeJson(doc, output);
@@ -896,6 +1118,23 @@ void enviarMensaje(const String &tipo, const String &datos) {
   Serial.printf("[TX→] Mensaje tipo '%s' enviado\n", tipo.c_str());
 }
 
+// Evento de estado hacia el Principal: trama de un byte (codigo) o, en
+// modo JSON, el mensaje de siempre con texto
+void enviarEvento(ObdLinkType tipo, uint8_t codigo, const char *texto) {
+  if (!formatoBinario) {
+    enviarMensaje(tipo == OBD_LINK_STATUS ? "OBD_STATUS" : "DTC_CLEARED",
+                  texto);
+    return;
+  }
+
+  uint8_t trama[OBD_LINK_HEADER_LEN + 1 + OBD_LINK_CRC_LEN];
+  size_t len = obdLinkEncodeFrame(tipo, secuenciaEnlace++, &codigo, 1, trama,
+                                  sizeof(trama));
+  MainSerial.write(trama, len);
+
+  Serial.printf("[TX→] Evento %u = %s enviado\n", (unsigned)tipo, texto);
+}
+
 // ==================== PROCESAMIENTO UART ====================
 void procesarUART() {
   while (MainSerial.available()) {
@@ -958,7 +1197,17 @@ void procesarComando(const String &comando) {
 
     // Responder estado actual al Principal (opcional pero útil para
     // UI/diagnóstico)
-    enviarMensaje("OBD_STATUS", obdEnabled ? "ON" : "OFF");
+    if (obdEnabled) {
+      enviarEvento(OBD_LINK_STATUS, OBD_LINK_STATUS_OBD_ON, "ON");
+    } else {
+      enviarEvento(OBD_LINK_STATUS, OBD_LINK_STATUS_OBD_OFF, "OFF");
+    }
+  } else if (tipo == "LINK_FORMAT") {
+    // {"t":"LINK_FORMAT","data":"JSON"} o {"t":"LINK_FORMAT","data":"BIN"}
+    String data = docInput["data"] | "";
+    formatoBinario = (data != "JSON");
+    Serial.printf("[CMD] LINK_FORMAT -> %s\n",
+                  formatoBinario ? "BIN" : "JSON");
   } else if (tipo == "ACK") {
     Serial.println("[ACK] Confirmación recibida");
   }
@@ -1091,9 +1340,10 @@ void loop() {
 
   if (elmConectado) {
     if (obdEnabled) {
-      // Lectura secuencial de PIDs (uno por iteración) siguiendo el patrón de
-      // ELMduino
+      // Lectura de PIDs por lotes multi-PID (o de a uno si la ECU no lo
+      // acepta) siguiendo el patrón no bloqueante de ELMduino
       leerPIDs();
+      reportarTasas();
 
       // ========== DETECCIÓN DE ENCENDIDO DE MOTOR ==========
       // Si RPM pasa de 0 a >0, el motor acaba de encender → re-escanear
@@ -1102,11 +1352,12 @@ void loop() {
 
       // Condición: Si RPM sube de 0 a >300 (encendido real) O si voltaje sube
       // bruscamente (alternador)
+      // Con mapa de soportados no hace falta: la ECU ya informó todo
       if (ultimoRPM == 0 && rpmActual > 300) {
         motorRecienEncendido = true;
-        Serial.println(
-            "[SCAN] 🚗 ¡Motor encendido detectado! Re-escaneando PIDs...");
-        if (!elmOcupado()) {
+        Serial.println("[SCAN] 🚗 ¡Motor encendido detectado!");
+        if (!descubrimientoPorMapa && !elmOcupado()) {
+          Serial.println("[SCAN] Re-escaneando PIDs...");
           escanearPIDs();
           ultimoScan = ahora;
         }
@@ -1152,8 +1403,9 @@ void loop() {
       // ========== ESCANEO OPORTUNISTA NO BLOQUEANTE ==========
       // Cada OPPORTUNISTIC_INTERVAL_MS, probar UN PID no-disponible
       // PERO solo si el ELM no está ocupado (no queremos bloquear lectura
-      // normal)
-      if (ahora - ultimoOportunista >= OPPORTUNISTIC_INTERVAL_MS) {
+      // normal). Solo sin mapa de soportados
+      if (!descubrimientoPorMapa &&
+          ahora - ultimoOportunista >= OPPORTUNISTIC_INTERVAL_MS) {
         ultimoOportunista = ahora;
 
         // Solo intentar si ELM está libre
@@ -1190,7 +1442,7 @@ void loop() {
       // Período agresivo (primeros 2 min): escanear cada 2 min
       // Después: escanear cada 5 min
       // PERO: Si ya tenemos >= 4 PIDs, saltar el re-escaneo agresivo (no
-      // interrumpir)
+      // interrumpir). Solo sin mapa de soportados
       unsigned long tiempoDesdeArranque = ahora - startupTime;
       bool enPeriodoAgresivo = (tiempoDesdeArranque < AGGRESSIVE_PERIOD_MS);
 
@@ -1202,7 +1454,7 @@ void loop() {
       unsigned long intervaloActual =
           enPeriodoAgresivo ? SCAN_AGGRESSIVE_MS : SCAN_INTERVAL_MS;
 
-      if (ahora - ultimoScan >= intervaloActual) {
+      if (!descubrimientoPorMapa && ahora - ultimoScan >= intervaloActual) {
         if (!elmOcupado()) {
           ultimoScan = ahora;
           if (enPeriodoAgresivo) {
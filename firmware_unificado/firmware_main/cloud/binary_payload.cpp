@@ -0,0 +1,261 @@
+/**
+ * @file binary_payload.cpp
+ * @brief Serialización de la trama cloud en formato binario v2
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "binary_payload.h"
+
+// ============================================================================
+// VALIDACIÓN DEL ESQUEMA
+// ============================================================================
+
+// Un campo se envía <=> tiene ID de canal <=> tiene clave JSON
+static constexpr bool fieldWireConsistent(uint8_t i = 0) {
+  return i >= TELEMETRY_FIELD_COUNT ||
+         (((TELEMETRY_FIELDS[i].emit == TelemetryEmit::NEVER) ==
+           (TELEMETRY_FIELDS[i].payloadId == 0)) &&
+          ((TELEMETRY_FIELDS[i].payloadId == 0) ==
+           (TELEMETRY_FIELDS[i].cloudKey == nullptr)) &&
+          fieldWireConsistent(i + 1));
+}
+
+// IDs de canal dentro de rango y sin repetir (ni con los de metadata)
+static constexpr bool payloadIdUnique(uint8_t id, uint8_t i = 0) {
+  return i >= TELEMETRY_FIELD_COUNT ||
+         (TELEMETRY_FIELDS[i].payloadId != id && payloadIdUnique(id, i + 1));
+}
+static constexpr bool payloadIdsValid(uint8_t i = 0) {
+  return i >= TELEMETRY_FIELD_COUNT ||
+         ((TELEMETRY_FIELDS[i].payloadId == 0 ||
+           (TELEMETRY_FIELDS[i].payloadId <= PAYLOAD_CHANNEL_COUNT &&
+            payloadIdUnique(TELEMETRY_FIELDS[i].payloadId, i + 1))) &&
+          payloadIdsValid(i + 1));
+}
+
+static_assert(fieldWireConsistent(),
+              "TELEMETRY_SCHEMA: emit, payloadId y cloudKey no coinciden");
+static_assert(payloadIdsValid() &&
+                  payloadIdUnique((uint8_t)PayloadChannel::WIFI_RSSI) &&
+                  payloadIdUnique((uint8_t)PayloadChannel::HEAP_FREE),
+              "TELEMETRY_SCHEMA: payloadId repetido o > PAYLOAD_CHANNEL_COUNT");
+static_assert(PAYLOAD_CHANNEL_COUNT <= 31,
+              "La máscara de canales de SnapshotRecord es de 32 bits");
+
+// ============================================================================
+// ESCRITOR LITTLE-ENDIAN
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief Escritor secuencial con control de desbordamiento
+ *
+ * Si algún campo no cabe, marca overflow y las escrituras siguientes se
+ * ignoran; el llamador revisa ok() una sola vez al final.
+ */
+class BinaryWriter {
+public:
+  BinaryWriter(uint8_t *buf, size_t cap)
+      : _buf(buf), _cap(cap), _pos(0), _overflow(false) {}
+
+  void u8(uint8_t v) {
+    if (reserve(1)) {
+      _buf[_pos++] = v;
+    }
+  }
+
+  void u32(uint32_t v) {
+    if (reserve(4)) {
+      _buf[_pos++] = (uint8_t)(v);
+      _buf[_pos++] = (uint8_t)(v >> 8);
+      _buf[_pos++] = (uint8_t)(v >> 16);
+      _buf[_pos++] = (uint8_t)(v >> 24);
+    }
+  }
+
+  void u64(uint64_t v) {
+    u32((uint32_t)v);
+    u32((uint32_t)(v >> 32));
+  }
+
+  void i32(int32_t v) { u32((uint32_t)v); }
+
+  void f32(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    u32(bits);
+  }
+
+  /// Cadena con prefijo de longitud u8 (truncada a maxLen y a 255)
+  void str(const char *s, size_t maxLen) {
+    size_t len = strnlen(s, maxLen < 255 ? maxLen : 255);
+    u8((uint8_t)len);
+    if (reserve(len)) {
+      memcpy(_buf + _pos, s, len);
+      _pos += len;
+    }
+  }
+
+  /// Canal numérico con valor f32
+  void channel(PayloadChannel id, float v) {
+    u8((uint8_t)id);
+    f32(v);
+  }
+
+  /// Canal de coordenada: grados x 1e7 en i32 (~1 cm de resolución)
+  void coord(PayloadChannel id, float deg) {
+    u8((uint8_t)id);
+    i32((int32_t)lroundf(deg * 1e7f));
+  }
+
+  /// Canal de un campo del esquema, en el formato de su tipo
+  void field(TelemetryFieldType type, PayloadChannel id, float v) {
+    if (type == TelemetryFieldType::COORD) {
+      coord(id, v);
+    } else {
+      channel(id, v);
+    }
+  }
+
+  /// Reserva un byte para un contador que se rellena después
+  size_t placeholder() {
+    size_t at = _pos;
+    u8(0);
+    return at;
+  }
+
+  void patch(size_t at, uint8_t v) {
+    if (!_overflow) {
+      _buf[at] = v;
+    }
+  }
+
+  size_t size() const { return _pos; }
+  bool ok() const { return !_overflow; }
+
+private:
+  bool reserve(size_t n) {
+    if (_overflow || _pos + n > _cap) {
+      _overflow = true;
+      return false;
+    }
+    return true;
+  }
+
+  uint8_t *_buf;
+  size_t _cap;
+  size_t _pos;
+  bool _overflow;
+};
+
+} // namespace
+
+// ============================================================================
+// SERIALIZACIÓN
+// ============================================================================
+
+size_t buildBinaryPayload(const TelemetrySnapshot &snapshot,
+                          const UnifiedConfig &cfg, uint64_t timeUs,
+                          uint8_t *buf, size_t cap) {
+  BinaryWriter w(buf, cap);
+
+  // === Cabecera ===
+  bool timeValid = timeUs >= BINARY_MIN_VALID_EPOCH * 1000000ULL;
+
+  uint8_t flags = 0;
+  if (cfg.debug_mode)
+    flags |= BINARY_FLAG_DEBUG;
+  if (timeValid)
+    flags |= BINARY_FLAG_TIME_VALID;
+
+  w.u8(BINARY_PAYLOAD_MAGIC);
+  w.u8(BINARY_PAYLOAD_VERSION);
+  w.u8(flags);
+  w.u64(timeValid ? timeUs : 0);
+  w.str(cfg.device_id, sizeof(cfg.device_id));
+  w.str(cfg.car_id, sizeof(cfg.car_id));
+
+  // === Canales fijos (mismas condiciones que la trama JSON) ===
+  size_t channelCountAt = w.placeholder();
+  uint8_t channels = 0;
+
+  // Campos del esquema, en orden de tabla
+#define BINARY_FIELD(ID, Setter, member, type, key, cloudKey, pid, liveKey,    \
+                     unit, min, max, group, emit, ...)                         \
+  if (payloadFieldEmitted(snapshot, cfg, TelemetryField::ID,                   \
+                          TelemetryEmit::emit)) {                              \
+    w.field(TelemetryFieldType::type, PayloadChannel::ID,                      \
+            (float)snapshot.member);                                           \
+    channels++;                                                                \
+  }
+  TELEMETRY_SCHEMA(BINARY_FIELD)
+#undef BINARY_FIELD
+
+  w.channel(PayloadChannel::WIFI_RSSI, snapshot.wifi_rssi);
+  w.channel(PayloadChannel::HEAP_FREE, (float)snapshot.heap_free);
+  channels += 2;
+
+  w.patch(channelCountAt, channels);
+
+  // === Custom (clave textual, cloud_id del sensor; solo frescos) ===
+  size_t customCountAt = w.placeholder();
+  uint8_t customs = 0;
+  for (int i = 0; i < snapshot.custom_count; i++) {
+    if (!telemetryQualityUsable(snapshot.custom_values[i].quality))
+      continue;
+    w.str(snapshot.custom_values[i].key,
+          sizeof(snapshot.custom_values[i].key));
+    w.f32(snapshot.custom_values[i].value);
+    customs++;
+  }
+  w.patch(customCountAt, customs);
+
+  // === DTC (la trama JSON actual siempre envía un arreglo vacío) ===
+  w.u8(0);
+
+  return w.ok() ? w.size() : 0;
+}
+
+// ============================================================================
+// ACCESO POR ID DE CANAL
+// ============================================================================
+
+// Etiqueta case de un campo: su ID de canal o, si no tiene (0), un valor
+// fuera del rango u8 que nunca coincide ni repite etiqueta
+#define PAYLOAD_CASE(ID, pid)                                                  \
+  ((pid) != 0 ? (pid) : 0x100 + (int)TelemetryField::ID)
+
+float payloadChannelGet(const TelemetrySnapshot &s, uint8_t id) {
+  switch ((unsigned)id) {
+#define PAYLOAD_CHANNEL_GET(ID, Setter, member, type, key, cloudKey, pid, ...) \
+  case PAYLOAD_CASE(ID, pid):                                                  \
+    return (float)s.member;
+    TELEMETRY_SCHEMA(PAYLOAD_CHANNEL_GET)
+#undef PAYLOAD_CHANNEL_GET
+  case (uint8_t)PayloadChannel::WIFI_RSSI:
+    return s.wifi_rssi;
+  case (uint8_t)PayloadChannel::HEAP_FREE:
+    return (float)s.heap_free;
+  }
+  return 0;
+}
+
+void payloadChannelSet(TelemetrySnapshot &s, uint8_t id, float v) {
+  switch ((unsigned)id) {
+#define PAYLOAD_CHANNEL_SET(ID, Setter, member, type, key, cloudKey, pid, ...) \
+  case PAYLOAD_CASE(ID, pid):                                                  \
+    s.member = (TELEMETRY_CTYPE(type))v;                                       \
+    break;
+    TELEMETRY_SCHEMA(PAYLOAD_CHANNEL_SET)
+#undef PAYLOAD_CHANNEL_SET
+  case (uint8_t)PayloadChannel::WIFI_RSSI:
+    s.wifi_rssi = (int8_t)v;
+    break;
+  case (uint8_t)PayloadChannel::HEAP_FREE:
+    s.heap_free = (uint32_t)v;
+    break;
+  }
+}
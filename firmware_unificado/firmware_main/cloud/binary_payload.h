@@ -0,0 +1,129 @@
+/**
+ * @file binary_payload.h
+ * @brief Formato binario compacto para la trama cloud (alternativa al JSON)
+ *
+ * Esquema versionado con IDs numéricos de canal. Contiene la misma
+ * información que buildPayload() (id, idc, d, dt, s, DTC) pero sin claves
+ * repetidas ni el envoltorio {"v": x} por valor. El decodificador del
+ * servidor (app/Services/TelemetryBinaryDecoder.php) lo reconstruye al
+ * mismo arreglo que produce json_decode() de la trama JSON.
+ *
+ * Layout v2 (little-endian):
+ *
+ *   u8   magic   = 'N' (0x4E, nunca '{' -> distinguible del JSON)
+ *   u8   version = 2
+ *   u8   flags   (bit0 = debug_mode, bit1 = hora válida)
+ *   u64  hora UTC de captura (µs desde 1970; v1: u32 epoch en s)
+ *   u8   len + device_id
+ *   u8   len + car_id
+ *   u8   N canales, N x { u8 id, valor }
+ *          lat/lng: i32 grados x 1e7; resto: f32
+ *   u8   M custom,  M x { u8 len, key, f32 }
+ *   u8   K DTC,     K x { u8 len, código }
+ *
+ * Los IDs son parte del contrato con el servidor: solo se agregan nuevos,
+ * nunca se renumeran.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef BINARY_PAYLOAD_H
+#define BINARY_PAYLOAD_H
+
+#include "../config/config_schema.h"
+#include "../telemetry/telemetry_bus.h"
+#include "../telemetry/telemetry_clock.h"
+#include <Arduino.h>
+
+// ============================================================================
+// CONSTANTES DEL FORMATO
+// ============================================================================
+
+#define BINARY_PAYLOAD_MAGIC 0x4E // 'N'
+#define BINARY_PAYLOAD_VERSION 2
+
+#define BINARY_FLAG_DEBUG 0x01
+#define BINARY_FLAG_TIME_VALID 0x02
+
+// Peor caso: cabecera + 2x32 IDs + 31 canales + 64 custom de 23 chars
+#define BINARY_PAYLOAD_MAX_SIZE 2048
+
+// Epoch mínimo considerado "hora sincronizada" (2020-01-01 00:00:00 UTC)
+#define BINARY_MIN_VALID_EPOCH TELEMETRY_MIN_VALID_EPOCH
+
+/**
+ * @enum PayloadChannel
+ * @brief IDs de canal: payloadId de TELEMETRY_SCHEMA más los de metadata
+ *
+ * La clave equivalente en la trama JSON es el cloudKey del esquema. Un
+ * campo con ID 0 (GPS_FIX) no se envía como canal.
+ */
+enum class PayloadChannel : uint8_t {
+#define PAYLOAD_CHANNEL_ID(ID, Setter, member, type, key, cloudKey, pid, ...)  \
+  ID = pid,
+  TELEMETRY_SCHEMA(PAYLOAD_CHANNEL_ID)
+#undef PAYLOAD_CHANNEL_ID
+  WIFI_RSSI = 29, ///< "wifi_rssi"
+  HEAP_FREE = 30  ///< "heap_free"
+};
+
+// Último ID de PayloadChannel (los IDs son contiguos desde 1). Máximo 31:
+// los registros offline usan una máscara u32 con bit n = canal n
+#define PAYLOAD_CHANNEL_COUNT 31
+
+/**
+ * @brief Indica si un campo del esquema va en la trama cloud
+ *
+ * Mismas condiciones para la trama JSON y la binaria: el canal debe estar
+ * fresco y dentro de rango (un cero legítimo se envía, un valor congelado
+ * no) y cumplir la condición de su grupo.
+ */
+inline bool payloadFieldEmitted(const TelemetrySnapshot &snapshot,
+                                const UnifiedConfig &cfg, TelemetryField field,
+                                TelemetryEmit emit) {
+  if (!snapshot.usable(field))
+    return false;
+
+  switch (emit) {
+  case TelemetryEmit::IF_FRESH:
+    return true;
+  case TelemetryEmit::IF_GPS_FIX:
+    return snapshot.gps_fix;
+  case TelemetryEmit::IF_IMU:
+    return cfg.imu.enabled;
+  case TelemetryEmit::NEVER:
+    break;
+  }
+  return false;
+}
+
+/**
+ * @brief Serializa un snapshot al formato binario v2
+ *
+ * Emite los mismos canales, bajo las mismas condiciones, que la trama JSON
+ * de CloudManager::buildPayload().
+ *
+ * @param snapshot Snapshot del TelemetryBus
+ * @param cfg Configuración (device_id, car_id, debug_mode)
+ * @param timeUs Hora UTC de captura en µs (TelemetryClock; 0 = no
+ *        sincronizada)
+ * @param buf Buffer de salida
+ * @param cap Capacidad de buf (BINARY_PAYLOAD_MAX_SIZE cubre el peor caso)
+ * @return Bytes escritos, 0 si no cabe en el buffer
+ */
+size_t buildBinaryPayload(const TelemetrySnapshot &snapshot,
+                          const UnifiedConfig &cfg, uint64_t timeUs,
+                          uint8_t *buf, size_t cap);
+
+/**
+ * @brief Lee un canal del snapshot como float (ids de PayloadChannel)
+ */
+float payloadChannelGet(const TelemetrySnapshot &snapshot, uint8_t id);
+
+/**
+ * @brief Escribe un canal del snapshot desde float
+ */
+void payloadChannelSet(TelemetrySnapshot &snapshot, uint8_t id, float value);
+
+#endif // BINARY_PAYLOAD_H
@@ -15,26 +15,40 @@
 #include "../config/config_manager.h"
 #include "../status_led.h" // Importar StatusLed
 #include "../telemetry/telemetry_bus.h"
+#include "../telemetry/telemetry_clock.h"
 #include <ArduinoJson.h>
+#include <esp_sntp.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <vector>
 
 extern StatusLed ledCloud; // Referencia al LED definido en main.cpp
 
+// Cada sincronización SNTP (tarea lwIP) es una referencia NTP para
+// TelemetryClock; el GPS, si reporta, tiene prioridad sobre ella
+static void onNtpSync(struct timeval *tv) {
+  (void)tv;
+  TelemetryClock::getInstance().syncFromSystemTime();
+}
+
 // ... (existing code)
 
 // ============================================================================
 // ENVÍO
 // ============================================================================
 
-bool CloudManager::sendMqtt(const String &payload) {
+bool CloudManager::sendMqtt(const uint8_t *payload, size_t len) {
   auto &cfg = ConfigManager::getInstance().getConfig();
 
   if (!_mqttClient.connected()) {
     return false;
   }
 
+  // Streaming directo al socket: sin copia al buffer interno de PubSubClient
   uint32_t t0 = millis();
-  bool success = _mqttClient.publish(cfg.mqtt.topic, payload.c_str());
+  bool success = _mqttClient.beginPublish(cfg.mqtt.topic, len, false) &&
+                 _mqttClient.write(payload, len) == len &&
+                 _mqttClient.endPublish();
   uint32_t elapsed = millis() - t0;
 
   // LOG SI TARDA MÁS DE 100ms
@@ -52,7 +66,7 @@ bool CloudManager::sendMqtt(const String &payload) {
   return success;
 }
 
-bool CloudManager::sendHttp(const String &payload) {
+bool CloudManager::sendHttp(const uint8_t *payload, size_t len) {
   auto &cfg = ConfigManager::getInstance().getConfig();
 
   HTTPClient http;
@@ -60,7 +74,7 @@ bool CloudManager::sendHttp(const String &payload) {
   http.begin(cfg.http.url);
   http.addHeader("Content-Type", "application/json");
 
-  int httpCode = http.POST(payload);
+  int httpCode = http.POST(const_cast<uint8_t *>(payload), len);
   http.end();
 
   if (httpCode >= 200 && httpCode < 300) {
@@ -78,7 +92,8 @@ CloudManager::CloudManager()
       _networkState(NetworkState::DISCONNECTED), _stateEnteredAt(0),
       _lastWifiAttempt(0), _lastMqttAttempt(0), _wifiRetryCount(0),
       _mqttRetryCount(0), _successCount(0), _failCount(0), _offlineSaved(0),
-      _offlineSent(0), _lastSendTime(0) {}
+      _offlineSent(0), _lastSendTime(0), _lastOfflineSave(0),
+      _lastDrainTime(0) {}
 
 // ==========================================================================
 // FAST PATH: EVENT-DRIVEN PUBLISH
@@ -88,6 +103,10 @@ void CloudManager::requestImmediatePublish() {
   portENTER_CRITICAL(&_immediateMux);
   _immediatePublishPending = true;
   portEXIT_CRITICAL(&_immediateMux);
+
+  if (_taskHandle != nullptr) {
+    xTaskNotify(_taskHandle, CLOUD_NOTIFY_PUBLISH, eSetBits);
+  }
 }
 
 // ============================================================================
@@ -105,7 +124,7 @@ bool CloudManager::begin() {
   // Configurar MQTT con timeout (P0.4)
   if (cfg.cloud_protocol == CloudProtocol::MQTT) {
     _mqttClient.setServer(cfg.mqtt.server, cfg.mqtt.port);
-    _mqttClient.setBufferSize(4096);
+    _mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
     _mqttClient.setSocketTimeout(MQTT_CONNECT_TIMEOUT_MS / 1000); // Segundos
   }
 
@@ -161,6 +180,12 @@ void CloudManager::updateNetworkState() {
       Serial.printf("[CLOUD] WiFi connected! IP: %s, RSSI: %d dBm\n",
                     WiFi.localIP().toString().c_str(), WiFi.RSSI());
       resetWifiBackoff();
+
+      // SNTP en segundo plano (UTC): cada sincronización aporta una
+      // referencia a TelemetryClock (ver onNtpSync)
+      sntp_set_time_sync_notification_cb(onNtpSync);
+      configTime(0, 0, CLOUD_NTP_SERVER);
+
       _networkState = NetworkState::WIFI_OK;
       _stateEnteredAt = now;
     }
@@ -239,6 +264,13 @@ void CloudManager::updateNetworkState() {
 
     // Mantener conexión MQTT
     _mqttClient.loop();
+
+    // Reproducir el histórico offline en lotes, intercalado con el envío
+    // en vivo (P0.1)
+    if (now - _lastDrainTime >= OFFLINE_DRAIN_INTERVAL_MS) {
+      _lastDrainTime = now;
+      drainOfflineBuffer();
+    }
     break;
   }
 }
@@ -368,6 +400,12 @@ void CloudManager::taskFunction(void *param) {
   // P0.3: Cloud task NO se registra en WDT para evitar reinicios por delays de
   // red esp_task_wdt_add(NULL);
 
+  // Despertar cuando cambie cualquier canal del bus (ver taskLoop)
+  if (self->_busSub == TELEMETRY_NO_SUBSCRIBER) {
+    self->_busSub = TelemetryBus::getInstance().subscribe(
+        TELEMETRY_CH_ALL, xTaskGetCurrentTaskHandle(), CLOUD_NOTIFY_DATA);
+  }
+
   while (true) {
     self->taskLoop();
   }
@@ -393,6 +431,7 @@ void CloudManager::taskLoop() {
 
   // === Actualizar State Machine (P0.2) ===
   uint32_t t1 = millis();
+  NetworkState prevState = _networkState;
   updateNetworkState();
   uint32_t stateTime = millis() - t1;
 
@@ -401,6 +440,16 @@ void CloudManager::taskLoop() {
     Serial.printf("[CLOUD] ⚠️ SLOW updateNetworkState: %lums\n", stateTime);
   }
 
+  // === Persistir el buffer offline (P0.1) ===
+  // FlashLog solo vuelca su cache al llenarse o al escribir: sin pushes
+  // (fin del corte, tramas decimadas) el histórico quedaría en RAM. Un
+  // cambio de estado de red lo vuelca en el acto
+  if (_networkState != prevState) {
+    OfflineBuffer::getInstance().flush();
+  } else {
+    OfflineBuffer::getInstance().flushIfStale(millis());
+  }
+
   // === Envío de telemetría ===
   // BUGFIX: Re-calcular 'now' AQUÍ para timing preciso después de
   // updateNetworkState
@@ -408,8 +457,9 @@ void CloudManager::taskLoop() {
   unsigned long elapsed = now - _lastSendTime;
 
   // ==============================================================
-  // FAST-PATH: si hay datos nuevos (ej: llegan del C3) pedimos publish.
-  // Esto hace que el envío cloud sea "data-driven" en vez de un timer fijo.
+  // FAST-PATH: si hay datos nuevos (suscripción al bus, o pedido
+  // explícito del C3) publicamos. El envío cloud es "data-driven" en vez
+  // de un timer fijo.
   //
   // - Respeta el throttle cfg.cloud_interval_ms (100–200ms recomendado).
   // - También deja un "heartbeat" lento para mantener visibilidad si no
@@ -423,11 +473,20 @@ void CloudManager::taskLoop() {
 
   constexpr uint32_t HEARTBEAT_TX_MS = 1000;
   const bool throttleOk = (elapsed >= cfg.cloud_interval_ms);
+
+  // Los canales sucios se toman solo cuando se puede enviar: mientras
+  // sigan marcados, el bus no vuelve a notificar dentro del throttle
+  if (throttleOk && TelemetryBus::getInstance().takeDirty(_busSub) != 0) {
+    _dataPending = true;
+  }
+
   const bool heartbeatDue = (elapsed >= HEARTBEAT_TX_MS);
-  const bool shouldSend = throttleOk && (immediatePending || heartbeatDue);
+  const bool shouldSend =
+      throttleOk && (immediatePending || _dataPending || heartbeatDue);
 
   if (shouldSend) {
     _lastSendTime = now;
+    _dataPending = false;
 
     // Si entramos por publish inmediato, limpiar el flag (sin bloquear otras
     // tareas más de lo necesario)
@@ -437,10 +496,32 @@ void CloudManager::taskLoop() {
       portEXIT_CRITICAL(&_immediateMux);
     }
 
-    // DIAGNÓSTICO: Medir tiempo de buildPayload
-    uint32_t t2 = millis();
-    String payload = buildPayload();
-    uint32_t buildTime = millis() - t2;
+    // Formato binario solo por MQTT; HTTP siempre envía JSON
+    // Hora de captura: sello monotónico del snapshot convertido a UTC con
+    // el offset disciplinado (GPS o NTP), sin llamadas a libc
+    TelemetrySnapshot snapshot;
+    TelemetryBus::getInstance().getSnapshot(snapshot);
+    const uint64_t timeUs =
+        TelemetryClock::getInstance().toUtcUs(snapshot.captured_us);
+    const bool binary = (cfg.cloud_protocol == CloudProtocol::MQTT &&
+                         cfg.cloud_format == PayloadFormat::BINARY);
+
+    // DIAGNÓSTICO: Medir tiempo y heap de buildPayload
+    uint32_t heapBefore = ESP.getFreeHeap();
+    int64_t t2 = esp_timer_get_time();
+    size_t payloadLen = buildPayload(
+        snapshot, timeUs, binary ? PayloadFormat::BINARY : PayloadFormat::JSON,
+        _payloadBuf, sizeof(_payloadBuf));
+    uint32_t buildUs = (uint32_t)(esp_timer_get_time() - t2);
+    uint32_t buildTime = buildUs / 1000;
+    uint32_t heapAfterBuild = ESP.getFreeHeap();
+
+    _payloadDiag.bytes = payloadLen;
+    _payloadDiag.buildUs = buildUs;
+    if (buildUs > _payloadDiag.buildUsMax) {
+      _payloadDiag.buildUsMax = buildUs;
+    }
+    _payloadDiag.buildHeapDelta = (int32_t)(heapBefore - heapAfterBuild);
 
     bool success = false;
 
@@ -449,21 +530,33 @@ void CloudManager::taskLoop() {
     sendCount++;
 
     if (cfg.cloud_protocol == CloudProtocol::MQTT) {
-      if (_networkState == NetworkState::MQTT_OK) {
+      if (_networkState == NetworkState::MQTT_OK && payloadLen > 0) {
         // DIAGNÓSTICO: Medir tiempo de sendMqtt
         uint32_t t3 = millis();
-        success = sendMqtt(payload);
+        success = sendMqtt(_payloadBuf, payloadLen);
         uint32_t sendTime = millis() - t3;
 
+        uint32_t heapAfterPublish = ESP.getFreeHeap();
+        uint32_t heapLow = heapAfterBuild < heapAfterPublish ? heapAfterBuild
+                                                             : heapAfterPublish;
+        _payloadDiag.publishHeapDelta =
+            (int32_t)(heapAfterBuild - heapAfterPublish);
+        if (heapBefore > heapLow &&
+            heapBefore - heapLow > _payloadDiag.txHeapPeak) {
+          _payloadDiag.txHeapPeak = heapBefore - heapLow;
+        }
+
         // Métricas de latencia
         _lastPublishMs = now;
         _lastPublishLatencyMs = buildTime + sendTime;
 
         const char *srcName = dataSourceToString(cfg.source);
-        Serial.printf("[CLOUD] 📡 MQTT TX #%lu (%s) - %s (%d bytes, "
+        Serial.printf("[CLOUD] 📡 MQTT TX #%lu (%s) - %s (%d bytes %s, "
                       "elapsed=%lums, build=%lums, send=%lums)\n",
-                      sendCount, srcName, success ? "OK" : "FAIL",
-                      payload.length(), elapsed, buildTime, sendTime);
+                      sendCount, srcName, success ? "OK" : "FAIL", payloadLen,
+                      payloadFormatToString(binary ? PayloadFormat::BINARY
+                                                   : PayloadFormat::JSON),
+                      elapsed, buildTime, sendTime);
       } else {
         // DIAGNÓSTICO: Log cuando NO estamos en MQTT_OK
         Serial.printf(
@@ -472,9 +565,15 @@ void CloudManager::taskLoop() {
       }
 
       if (!success) {
-        // Guardar en buffer offline (P0.1)
-        if (OfflineBuffer::getInstance().push(payload)) {
-          _offlineSaved++;
+        // Guardar el snapshot en buffer offline (P0.1), decimado a
+        // OFFLINE_SAVE_INTERVAL_MS para que el log cubra horas de corte.
+        // La trama se serializa al drenar; sin hora UTC aún, el registro
+        // lleva captured_us y se resuelve entonces (OfflineBuffer::peek)
+        if (now - _lastOfflineSave >= OFFLINE_SAVE_INTERVAL_MS) {
+          if (OfflineBuffer::getInstance().push(snapshot, timeUs)) {
+            _offlineSaved++;
+            _lastOfflineSave = now;
+          }
         }
         _failCount++;
       } else {
@@ -483,7 +582,7 @@ void CloudManager::taskLoop() {
     } else {
       // HTTP mode
       if (WiFi.isConnected()) {
-        success = sendHttp(payload);
+        success = payloadLen > 0 && sendHttp(_payloadBuf, payloadLen);
         Serial.printf("[CLOUD] 📡 HTTP TX #%lu - %s\n", sendCount,
                       success ? "OK" : "FAIL");
       }
@@ -503,9 +602,20 @@ void CloudManager::taskLoop() {
                   loopTime, stateTime);
   }
 
-  // Pequeño yield - Mínimo para no bloquear otras tareas
-  // OPTIMIZADO: Reducido de 10ms a 1ms para mejor tiempo real
-  vTaskDelay(pdMS_TO_TICKS(1));
+  // Dormir hasta el próximo envío posible: fin del throttle si hay algo
+  // pendiente, heartbeat si no. Datos nuevos o requestImmediatePublish()
+  // despiertan antes (notificación), sin spin de 1 ms
+  bool pending = _dataPending || _immediatePublishPending;
+  uint32_t deadline = pending ? cfg.cloud_interval_ms : HEARTBEAT_TX_MS;
+  uint32_t sinceSend = millis() - _lastSendTime;
+  uint32_t waitMs = sinceSend < deadline ? deadline - sinceSend : 1;
+  if (waitMs > CLOUD_IDLE_WAIT_MS) {
+    waitMs = CLOUD_IDLE_WAIT_MS;
+  }
+
+  uint32_t notified = 0;
+  xTaskNotifyWait(0, CLOUD_NOTIFY_DATA | CLOUD_NOTIFY_PUBLISH, &notified,
+                  pdMS_TO_TICKS(waitMs));
 }
 
 // ============================================================================
@@ -519,11 +629,12 @@ void CloudManager::drainOfflineBuffer() {
     return;
   }
 
-  Serial.printf("[CLOUD] Draining offline buffer (%d frames)...\n",
+  Serial.printf("[CLOUD] Draining offline buffer (%d snapshots)...\n",
                 OfflineBuffer::getInstance().count());
 
   int batchCount = 0;
-  String payload;
+  TelemetrySnapshot snapshot;
+  uint64_t timeUs = 0;
 
   while (!OfflineBuffer::getInstance().isEmpty() &&
          batchCount < OFFLINE_DRAIN_BATCH_SIZE) {
@@ -533,26 +644,31 @@ void CloudManager::drainOfflineBuffer() {
       return;
     }
 
-    if (OfflineBuffer::getInstance().pop(payload)) {
-      bool success = _mqttClient.publish(cfg.mqtt.topic, payload.c_str());
+    // Los snapshots solo se consumen tras un publish exitoso: el orden se
+    // conserva
+    if (!OfflineBuffer::getInstance().peek(snapshot, timeUs)) {
+      break;
+    }
 
-      if (success) {
-        _offlineSent++;
-        batchCount++;
-      } else {
-        // No pudimos enviar, devolver al buffer y salir
-        OfflineBuffer::getInstance().push(payload);
-        Serial.println(F("[CLOUD] Drain failed, stopping"));
-        return;
-      }
+    size_t len = buildPayload(snapshot, timeUs, cfg.cloud_format, _payloadBuf,
+                              sizeof(_payloadBuf));
+    bool sent = len > 0 && sendMqtt(_payloadBuf, len);
 
-      // Pequeño delay entre mensajes para no saturar
-      vTaskDelay(pdMS_TO_TICKS(OFFLINE_DRAIN_DELAY_MS));
+    if (!sent) {
+      Serial.println(F("[CLOUD] Drain failed, stopping"));
+      return;
     }
+
+    OfflineBuffer::getInstance().consume();
+    _offlineSent++;
+    batchCount++;
+
+    // Pequeño delay entre mensajes para no saturar
+    vTaskDelay(pdMS_TO_TICKS(OFFLINE_DRAIN_DELAY_MS));
   }
 
   if (batchCount > 0) {
-    Serial.printf("[CLOUD] Drained %d frames, %d remaining\n", batchCount,
+    Serial.printf("[CLOUD] Drained %d snapshots, %d remaining\n", batchCount,
                   OfflineBuffer::getInstance().count());
   }
 }
@@ -561,165 +677,51 @@ void CloudManager::drainOfflineBuffer() {
 // PAYLOAD
 // ============================================================================
 
-String CloudManager::buildPayload() {
+size_t CloudManager::buildPayload(const TelemetrySnapshot &snapshot,
+                                  uint64_t timeUs, PayloadFormat format,
+                                  uint8_t *buf, size_t cap) {
   auto &cfg = ConfigManager::getInstance().getConfig();
-  TelemetrySnapshot snapshot;
-  TelemetryBus::getInstance().getSnapshot(snapshot);
 
-  JsonDocument doc;
-
-  // Formato de trama original MoTeC
-  doc["id"] = cfg.device_id;
-  doc["idc"] = cfg.car_id;
-  doc["d"] = cfg.debug_mode;
-
-  // Timestamp
-  // BUGFIX: getLocalTime() tiene timeout default de 5000ms si NTP no está
-  // sincronizado Usamos timeout de 10ms para no bloquear el envío de telemetría
-  char dt_buffer[32] = "1970-01-01 00:00:00";
-  struct tm timeinfo;
-  if (getLocalTime(&timeinfo, 10)) { // 10ms timeout (era 5000ms default!)
-    strftime(dt_buffer, sizeof(dt_buffer), "%Y-%m-%d %H:%M:%S", &timeinfo);
-  }
-  doc["dt"] = dt_buffer;
-
-  // Objeto de sensores
-  JsonObject s = doc["s"].to<JsonObject>();
-
-  // === GPS ===
-  if (snapshot.gps_fix) {
-    JsonObject lat_obj = s["lat"].to<JsonObject>();
-    lat_obj["v"] = serialized(String(snapshot.gps_lat, 6));
-
-    JsonObject lng_obj = s["lng"].to<JsonObject>();
-    lng_obj["v"] = serialized(String(snapshot.gps_lng, 6));
-
-    JsonObject vel_obj = s["vel_kmh"].to<JsonObject>();
-    vel_obj["v"] = snapshot.gps_speed;
-
-    JsonObject alt_obj = s["alt_m"].to<JsonObject>();
-    alt_obj["v"] = snapshot.gps_alt;
-
-    JsonObject rumbo_obj = s["rumbo"].to<JsonObject>();
-    rumbo_obj["v"] = snapshot.gps_course;
-
-    JsonObject sats_obj = s["gps_sats"].to<JsonObject>();
-    sats_obj["v"] = snapshot.gps_sats;
-  }
-
-  // === IMU ===
-  if (cfg.imu.enabled) {
-    JsonObject accel_x = s["accel_x"].to<JsonObject>();
-    accel_x["v"] = snapshot.imu_accel_x;
-
-    JsonObject accel_y = s["accel_y"].to<JsonObject>();
-    accel_y["v"] = snapshot.imu_accel_y;
-
-    JsonObject accel_z = s["accel_z"].to<JsonObject>();
-    accel_z["v"] = snapshot.imu_accel_z;
-
-    JsonObject gyro_x = s["gyro_x"].to<JsonObject>();
-    gyro_x["v"] = snapshot.imu_gyro_x;
-
-    JsonObject gyro_y = s["gyro_y"].to<JsonObject>();
-    gyro_y["v"] = snapshot.imu_gyro_y;
-
-    JsonObject gyro_z = s["gyro_z"].to<JsonObject>();
-    gyro_z["v"] = snapshot.imu_gyro_z;
-  }
-
-  // === ENGINE ===
-  if (snapshot.engine_rpm != 0) {
-    JsonObject rpm = s["0x0C"].to<JsonObject>(); // RPM
-    rpm["v"] = snapshot.engine_rpm;
-  }
-  if (snapshot.engine_speed != 0) {
-    JsonObject speed = s["0x0D"].to<JsonObject>(); // Speed
-    speed["v"] = snapshot.engine_speed;
-  }
-  if (snapshot.engine_coolant_temp != 0) {
-    JsonObject coolant = s["0x05"].to<JsonObject>(); // Coolant Temp
-    coolant["v"] = snapshot.engine_coolant_temp;
-  }
-  if (snapshot.engine_oil_temp != 0) {
-    JsonObject oil = s["0x5C"].to<JsonObject>(); // Oil Temp
-    oil["v"] = snapshot.engine_oil_temp;
-  }
-  if (snapshot.engine_throttle != 0) {
-    JsonObject tps = s["0x11"].to<JsonObject>(); // TPS
-    tps["v"] = snapshot.engine_throttle;
-  }
-  if (snapshot.engine_load != 0) {
-    JsonObject load = s["0x04"].to<JsonObject>(); // Load
-    load["v"] = snapshot.engine_load;
-  }
-  if (snapshot.engine_maf != 0) {
-    JsonObject maf = s["0x10"].to<JsonObject>(); // MAF
-    maf["v"] = snapshot.engine_maf;
-  }
-  if (snapshot.engine_map != 0) {
-    JsonObject map_s = s["0x0B"].to<JsonObject>(); // MAP
-    map_s["v"] = snapshot.engine_map;
+  // Ambos escritores serializan directo en buf: sin JsonDocument ni String
+  if (format == PayloadFormat::BINARY) {
+    return buildBinaryPayload(snapshot, cfg, timeUs, buf, cap);
   }
+  return buildJsonPayload(snapshot, cfg, timeUs, reinterpret_cast<char *>(buf),
+                          cap);
+}
 
-  // === FUEL ===
-  if (snapshot.fuel_level != 0) {
-    JsonObject fuel_lvl = s["0x2F"].to<JsonObject>(); // Fuel Level
-    fuel_lvl["v"] = snapshot.fuel_level;
-  }
-  if (snapshot.fuel_rate != 0) {
-    JsonObject fuel_rate = s["0x5E"].to<JsonObject>(); // Fuel Rate
-    fuel_rate["v"] = snapshot.fuel_rate;
-  }
-  if (snapshot.fuel_total != 0) {
-    JsonObject fuel_total =
-        s["fuel_total"]
-            .to<JsonObject>(); // Calculated (No PID standard, keep name)
-    fuel_total["v"] = snapshot.fuel_total;
-  }
+// ============================================================================
+// BENCHMARK JSON VS BINARIO
+// ============================================================================
 
-  // === BATTERY ===
-  if (snapshot.battery_voltage != 0) {
-    JsonObject batt =
-        s["BAT"].to<JsonObject>(); // Control Module Voltage pid 0x42
-    batt["v"] = snapshot.battery_voltage;
-  }
+PayloadBenchmark CloudManager::benchmarkPayloads(uint16_t iterations) {
+  TelemetrySnapshot snapshot;
+  TelemetryBus::getInstance().getSnapshot(snapshot);
 
-  // === SUSPENSION ===
-  if (snapshot.susp_fl != 0 || snapshot.susp_fr != 0) {
-    JsonObject susp_fl = s["susp_fl"].to<JsonObject>();
-    susp_fl["v"] = snapshot.susp_fl;
+  PayloadBenchmark result = {};
+  result.iterations = iterations > 0 ? iterations : 1;
 
-    JsonObject susp_fr = s["susp_fr"].to<JsonObject>();
-    susp_fr["v"] = snapshot.susp_fr;
+  // Buffer propio: _payloadBuf pertenece a CloudTask
+  std::vector<uint8_t> buf(CLOUD_PAYLOAD_MAX_SIZE);
 
-    JsonObject susp_rl = s["susp_rl"].to<JsonObject>();
-    susp_rl["v"] = snapshot.susp_rl;
+  const uint64_t timeUs =
+      TelemetryClock::getInstance().toUtcUs(snapshot.captured_us);
 
-    JsonObject susp_rr = s["susp_rr"].to<JsonObject>();
-    susp_rr["v"] = snapshot.susp_rr;
+  int64_t t0 = esp_timer_get_time();
+  for (uint16_t i = 0; i < result.iterations; i++) {
+    result.jsonBytes = buildPayload(snapshot, timeUs, PayloadFormat::JSON,
+                                    buf.data(), buf.size());
   }
-
-  // === CUSTOM VALUES ===
-  for (int i = 0; i < snapshot.custom_count; i++) {
-    JsonObject custom = s[snapshot.custom_values[i].key].to<JsonObject>();
-    custom["v"] = snapshot.custom_values[i].value;
+  int64_t t1 = esp_timer_get_time();
+  for (uint16_t i = 0; i < result.iterations; i++) {
+    result.binaryBytes = buildPayload(snapshot, timeUs, PayloadFormat::BINARY,
+                                      buf.data(), buf.size());
   }
+  int64_t t2 = esp_timer_get_time();
 
-  // === META ===
-  JsonObject wifi_rssi = s["wifi_rssi"].to<JsonObject>();
-  wifi_rssi["v"] = snapshot.wifi_rssi;
-
-  JsonObject heap = s["heap_free"].to<JsonObject>();
-  heap["v"] = snapshot.heap_free;
-
-  // === DTC Array ===
-  doc["DTC"].to<JsonArray>();
-
-  String output;
-  serializeJson(doc, output);
-
-  return output;
+  result.jsonUs = (uint32_t)((t1 - t0) / result.iterations);
+  result.binaryUs = (uint32_t)((t2 - t1) / result.iterations);
+  return result;
 }
 
 // Status section was here - removing duplicates
@@ -737,6 +739,9 @@ void CloudManager::printStatus() {
   Serial.printf("MQTT: %s\n",
                 _mqttClient.connected() ? "CONNECTED" : "DISCONNECTED");
   Serial.printf("Success/Fail: %lu / %lu\n", _successCount, _failCount);
+  Serial.printf("Payload format: %s\n",
+                payloadFormatToString(
+                    ConfigManager::getInstance().getConfig().cloud_format));
   Serial.printf("Offline saved/sent: %lu / %lu\n", _offlineSaved, _offlineSent);
   Serial.printf("Offline buffer: %d frames (%d%%)\n",
                 OfflineBuffer::getInstance().count(),
@@ -16,6 +16,9 @@
 #define CLOUD_MANAGER_H
 
 #include "../config/config_schema.h"
+#include "../telemetry/telemetry_bus.h"
+#include "binary_payload.h"
+#include "json_payload.h"
 #include "offline_buffer.h"
 #include <Arduino.h>
 #include <HTTPClient.h>
@@ -80,8 +83,57 @@ inline const char *networkStateToString(NetworkState state) {
 #define BACKOFF_MULTIPLIER 2    // Factor de multiplicación
 
 // Buffer offline (P0.1)
-#define OFFLINE_DRAIN_BATCH_SIZE 5 // Enviar X mensajes por ciclo al reconectar
-#define OFFLINE_DRAIN_DELAY_MS 50  // Delay entre mensajes
+#define OFFLINE_DRAIN_BATCH_SIZE 10     // Mensajes por ciclo de drenado
+#define OFFLINE_DRAIN_DELAY_MS 20       // Delay entre mensajes
+#define OFFLINE_DRAIN_INTERVAL_MS 500   // Ciclo de drenado mientras MQTT_OK
+#define OFFLINE_SAVE_INTERVAL_MS 1000   // Resolución del histórico offline
+
+// Hora UTC: SNTP al conectar WiFi; respaldo del GPS en TelemetryClock
+#define CLOUD_NTP_SERVER "pool.ntp.org"
+
+// CloudTask duerme en xTaskNotifyWait: la despiertan datos nuevos del bus
+// o requestImmediatePublish(). Espera máxima sin eventos: acota la latencia
+// de la máquina de estados de red y de mqtt.loop()
+#define CLOUD_NOTIFY_DATA 0x01    // Suscripción al TelemetryBus
+#define CLOUD_NOTIFY_PUBLISH 0x02 // requestImmediatePublish()
+#define CLOUD_IDLE_WAIT_MS 20
+
+// Buffer de trama compartido por ambos formatos (JSON es el mayor)
+#define CLOUD_PAYLOAD_MAX_SIZE JSON_PAYLOAD_MAX_SIZE
+static_assert(CLOUD_PAYLOAD_MAX_SIZE >= BINARY_PAYLOAD_MAX_SIZE,
+              "El buffer de trama debe cubrir la trama binaria");
+
+// Buffer interno de PubSubClient: las tramas se transmiten en streaming
+// (beginPublish/write/endPublish), solo aloja CONNECT y cabeceras
+#define MQTT_BUFFER_SIZE 512
+
+/**
+ * @struct PayloadBenchmark
+ * @brief Resultado de comparar la trama JSON contra la binaria
+ */
+struct PayloadBenchmark {
+  uint16_t iterations;
+  size_t jsonBytes;     ///< Bytes por trama JSON
+  size_t binaryBytes;   ///< Bytes por trama binaria
+  uint32_t jsonUs;      ///< Tiempo medio de construcción JSON (us)
+  uint32_t binaryUs;    ///< Tiempo medio de construcción binaria (us)
+};
+
+/**
+ * @struct PayloadDiag
+ * @brief Métricas de la última trama enviada (comando GET_DIAG)
+ *
+ * Las variaciones de heap se miden con ESP.getFreeHeap() antes y después de
+ * cada etapa: con el escritor en buffer fijo deben quedar en 0.
+ */
+struct PayloadDiag {
+  size_t bytes;              ///< Tamaño de la última trama
+  uint32_t buildUs;          ///< Construcción de la última trama (us)
+  uint32_t buildUsMax;       ///< Máximo desde el arranque (us)
+  int32_t buildHeapDelta;    ///< Heap consumido por la construcción
+  int32_t publishHeapDelta;  ///< Heap consumido por el publish
+  uint32_t txHeapPeak;       ///< Máximo heap consumido por build+publish
+};
 
 /**
  * @class CloudManager
@@ -160,6 +212,17 @@ public:
   uint32_t getLastPublishMs() const { return _lastPublishMs; }
   uint32_t getLastPublishLatencyMs() const { return _lastPublishLatencyMs; }
 
+  /**
+   * @brief Construye ambas tramas con el snapshot actual y mide tamaño y
+   * tiempo medio de construcción (comando serial BENCH_PAYLOAD)
+   */
+  PayloadBenchmark benchmarkPayloads(uint16_t iterations);
+
+  /**
+   * @brief Métricas de construcción/envío de la trama (GET_DIAG)
+   */
+  PayloadDiag getPayloadDiag() const { return _payloadDiag; }
+
 private:
   CloudManager();
 
@@ -186,9 +249,10 @@ private:
   unsigned long getMqttRetryDelay();
 
   // === Envío ===
-  String buildPayload();
-  bool sendMqtt(const String &payload);
-  bool sendHttp(const String &payload);
+  size_t buildPayload(const TelemetrySnapshot &snapshot, uint64_t timeUs,
+                      PayloadFormat format, uint8_t *buf, size_t cap);
+  bool sendMqtt(const uint8_t *payload, size_t len);
+  bool sendHttp(const uint8_t *payload, size_t len);
   void drainOfflineBuffer(); // P0.1: enviar buffer acumulado
 
   // === Clientes ===
@@ -212,13 +276,21 @@ private:
   uint32_t _offlineSent;
 
   unsigned long _lastSendTime;
+  unsigned long _lastOfflineSave;  ///< Último frame guardado offline
+  unsigned long _lastDrainTime;    ///< Último ciclo de drenado
 
   // === Fast publish trigger (event-driven) ===
+  int8_t _busSub = TELEMETRY_NO_SUBSCRIBER; ///< Suscripción de CloudTask
+  bool _dataPending = false; ///< Datos del bus aún no enviados (CloudTask)
   volatile bool _immediatePublishPending = false;
   portMUX_TYPE _immediateMux = portMUX_INITIALIZER_UNLOCKED;
   uint32_t _lastPublishMs = 0;
   uint32_t _lastPublishLatencyMs = 0;
 
+  // Buffer de la trama (solo CloudTask; evita alloc por envío)
+  uint8_t _payloadBuf[CLOUD_PAYLOAD_MAX_SIZE];
+  PayloadDiag _payloadDiag = {};
+
   // === Timeouts (P0.4) ===
   static constexpr unsigned long WIFI_CHECK_INTERVAL =
       100; // Check WiFi cada 100ms
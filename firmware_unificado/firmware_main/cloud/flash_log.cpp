@@ -0,0 +1,430 @@
+/**
+ * @file flash_log.cpp
+ * @brief Implementación del log offline segmentado en LittleFS
+ *
+ * PART OF: Plan Safety-Critical P0.1
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "flash_log.h"
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+FlashLog::FlashLog()
+    : _ready(false), _maxSegments(0), _writeSeq(0), _writeSize(0),
+      _cacheLen(0), _cacheRecords(0), _cacheSince(0), _readSeq(0),
+      _readOffset(0), _peekNext(0), _flashPending(0), _crcErrors(0),
+      _segmentsDropped(0), _flushCount(0) {
+  memset(_segRecords, 0, sizeof(_segRecords));
+}
+
+// ============================================================================
+// INICIALIZACIÓN Y RECUPERACIÓN
+// ============================================================================
+
+bool FlashLog::begin() {
+  if (!LittleFS.begin(true)) { // Formatear si la partición no es válida
+    Serial.println(F("[FLASH_LOG] LittleFS mount failed, RAM only"));
+    return false;
+  }
+
+  if (!LittleFS.exists(FLASH_LOG_DIR)) {
+    LittleFS.mkdir(FLASH_LOG_DIR);
+  }
+
+  // Segmentos permitidos según el tamaño real de la partición
+  size_t budget = LittleFS.totalBytes() / 100 * FLASH_LOG_MAX_FILL_PCT;
+  _maxSegments = budget / FLASH_LOG_SEGMENT_SIZE;
+  if (_maxSegments > FLASH_LOG_MAX_SEGMENTS)
+    _maxSegments = FLASH_LOG_MAX_SEGMENTS;
+  if (_maxSegments < 2)
+    _maxSegments = 2;
+
+  // Enumerar segmentos existentes (nombre = número de secuencia)
+  bool found = false;
+  uint32_t minSeq = UINT32_MAX;
+  uint32_t maxSeq = 0;
+
+  File dir = LittleFS.open(FLASH_LOG_DIR);
+  if (dir && dir.isDirectory()) {
+    File f = dir.openNextFile();
+    while (f) {
+      const char *name = f.name();
+      const char *base = strrchr(name, '/');
+      base = base ? base + 1 : name;
+
+      char *end = nullptr;
+      unsigned long seq = strtoul(base, &end, 10);
+      if (!f.isDirectory() && end != base && strcmp(end, ".log") == 0) {
+        found = true;
+        if (seq < minSeq)
+          minSeq = seq;
+        if (seq > maxSeq)
+          maxSeq = seq;
+      }
+      f.close();
+      f = dir.openNextFile();
+    }
+  }
+  if (dir)
+    dir.close();
+
+  if (found) {
+    _readSeq = minSeq;
+
+    // Dejar lugar para el nuevo segmento de escritura
+    char path[32];
+    while (maxSeq - _readSeq + 2 > _maxSegments) {
+      segmentPath(_readSeq, path, sizeof(path));
+      LittleFS.remove(path);
+      _readSeq++;
+      _segmentsDropped++;
+    }
+
+    for (uint32_t seq = _readSeq; seq <= maxSeq; seq++) {
+      segmentRecords(seq) = scanSegment(seq);
+      _flashPending += segmentRecords(seq);
+    }
+
+    // Nunca se continúa un segmento previo: su cola puede estar truncada
+    _writeSeq = maxSeq + 1;
+  } else {
+    _readSeq = 0;
+    _writeSeq = 0;
+  }
+
+  segmentRecords(_writeSeq) = 0;
+  _writeSize = 0;
+  _readOffset = 0;
+  _peekNext = 0;
+  _ready = true;
+
+  Serial.printf("[FLASH_LOG] Ready: %lu records recovered in %lu segments "
+                "(max %lu x %d KB)\n",
+                _flashPending, _writeSeq - _readSeq, _maxSegments,
+                FLASH_LOG_SEGMENT_SIZE / 1024);
+  return true;
+}
+
+uint16_t FlashLog::scanSegment(uint32_t seq) {
+  char path[32];
+  segmentPath(seq, path, sizeof(path));
+
+  File f = LittleFS.open(path, "r");
+  if (!f) {
+    return 0;
+  }
+
+  size_t size = f.size();
+  size_t offset = 0;
+  uint16_t records = 0;
+  FlashLogRecordHeader hdr;
+
+  // Solo cabeceras: el CRC se valida al reproducir cada registro
+  while (offset + sizeof(hdr) <= size) {
+    f.seek(offset);
+    if (f.read(reinterpret_cast<uint8_t *>(&hdr), sizeof(hdr)) !=
+        sizeof(hdr)) {
+      break;
+    }
+    if (hdr.magic != FLASH_LOG_RECORD_MAGIC || hdr.len == 0 ||
+        hdr.len > FLASH_LOG_MAX_RECORD ||
+        offset + sizeof(hdr) + hdr.len > size) {
+      Serial.printf("[FLASH_LOG] Segment %lu truncated at %u/%u bytes\n", seq,
+                    offset, size);
+      break;
+    }
+    offset += sizeof(hdr) + hdr.len;
+    records++;
+  }
+
+  f.close();
+  return records;
+}
+
+// ============================================================================
+// ESCRITURA
+// ============================================================================
+
+bool FlashLog::append(const uint8_t *data, size_t len) {
+  if (!_ready || len == 0 || len > FLASH_LOG_MAX_RECORD) {
+    return false;
+  }
+
+  FlashLogRecordHeader hdr;
+  hdr.magic = FLASH_LOG_RECORD_MAGIC;
+  hdr.flags = 0;
+  hdr.len = len;
+  hdr.crc = crc32(data, len);
+  size_t recLen = sizeof(hdr) + len;
+
+  // Segmento lleno -> volcar y abrir uno nuevo
+  if (_writeSize + _cacheLen + recLen > FLASH_LOG_SEGMENT_SIZE) {
+    flush();
+    rollWriteSegment();
+  }
+
+  // Cache lleno -> volcar
+  if (_cacheLen + recLen > sizeof(_cache)) {
+    flush();
+  }
+
+  if (_cacheLen == 0) {
+    _cacheSince = millis();
+  }
+
+  memcpy(_cache + _cacheLen, &hdr, sizeof(hdr));
+  memcpy(_cache + _cacheLen + sizeof(hdr), data, len);
+  _cacheLen += recLen;
+  _cacheRecords++;
+
+  flushIfStale(millis());
+  return true;
+}
+
+bool FlashLog::flushIfStale(uint32_t nowMs) {
+  if (_cacheLen == 0 || nowMs - _cacheSince < FLASH_LOG_FLUSH_MS) {
+    return true;
+  }
+  return flush();
+}
+
+bool FlashLog::flush() {
+  if (!_ready || _cacheLen == 0) {
+    return true;
+  }
+
+  char path[32];
+  segmentPath(_writeSeq, path, sizeof(path));
+
+  File f = LittleFS.open(path, "a");
+  size_t written = f ? f.write(_cache, _cacheLen) : 0;
+  if (f)
+    f.close();
+
+  if (written != _cacheLen) {
+    Serial.printf("[FLASH_LOG] Flush failed (%u/%u bytes), %lu records lost\n",
+                  written, _cacheLen, _cacheRecords);
+    // Un segmento con escritura parcial no se vuelve a usar
+    _writeSize += written;
+    _cacheLen = 0;
+    _cacheRecords = 0;
+    rollWriteSegment();
+    return false;
+  }
+
+  _writeSize += written;
+  segmentRecords(_writeSeq) += _cacheRecords;
+  _flashPending += _cacheRecords;
+  _cacheLen = 0;
+  _cacheRecords = 0;
+  _flushCount++;
+  return true;
+}
+
+void FlashLog::rollWriteSegment() {
+  _writeSeq++;
+  _writeSize = 0;
+  segmentRecords(_writeSeq) = 0;
+
+  // Log circular: descartar los segmentos más antiguos
+  while (_writeSeq - _readSeq + 1 > _maxSegments) {
+    uint16_t lost = segmentRecords(_readSeq);
+    advanceReadSegment();
+    _segmentsDropped++;
+    Serial.printf("[FLASH_LOG] Log full, dropped oldest segment (%u records)\n",
+                  lost);
+  }
+}
+
+// ============================================================================
+// LECTURA
+// ============================================================================
+
+bool FlashLog::peek(uint8_t *out, size_t cap, size_t &len) {
+  if (!_ready) {
+    return false;
+  }
+
+  char path[32];
+  FlashLogRecordHeader hdr;
+
+  while (true) {
+    if (_readSeq == _writeSeq && _readOffset >= _writeSize) {
+      // Lo pendiente del segmento actual sigue en cache: volcarlo
+      if (_cacheLen == 0) {
+        return false;
+      }
+      flush(); // Si falla, abre otro segmento y el lazo lo resuelve
+      continue;
+    }
+
+    if (_readSeq != _writeSeq && segmentRecords(_readSeq) == 0) {
+      advanceReadSegment();
+      continue;
+    }
+
+    segmentPath(_readSeq, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f) {
+      if (_readSeq == _writeSeq)
+        rollWriteSegment();
+      advanceReadSegment();
+      continue;
+    }
+
+    bool headerOk =
+        f.seek(_readOffset) &&
+        f.read(reinterpret_cast<uint8_t *>(&hdr), sizeof(hdr)) ==
+            sizeof(hdr) &&
+        hdr.magic == FLASH_LOG_RECORD_MAGIC && hdr.len > 0 &&
+        hdr.len <= FLASH_LOG_MAX_RECORD &&
+        _readOffset + sizeof(hdr) + hdr.len <= f.size();
+
+    if (!headerOk) {
+      // Resto del segmento ilegible: pasar al siguiente
+      f.close();
+      _crcErrors++;
+      if (_readSeq == _writeSeq)
+        rollWriteSegment();
+      advanceReadSegment();
+      continue;
+    }
+
+    size_t next = _readOffset + sizeof(hdr) + hdr.len;
+    bool fits = hdr.len <= cap;
+    bool crcOk = fits && f.read(out, hdr.len) == hdr.len &&
+                 crc32(out, hdr.len) == hdr.crc;
+    f.close();
+
+    if (!crcOk) {
+      // Registro corrupto (o mayor que el buffer): descartarlo
+      _crcErrors++;
+      _peekNext = next;
+      consume();
+      continue;
+    }
+
+    len = hdr.len;
+    _peekNext = next;
+    return true;
+  }
+}
+
+void FlashLog::consume() {
+  if (_peekNext == 0) {
+    return;
+  }
+
+  _readOffset = _peekNext;
+  _peekNext = 0;
+
+  if (segmentRecords(_readSeq) > 0) {
+    segmentRecords(_readSeq)--;
+    _flashPending--;
+  }
+
+  if (segmentRecords(_readSeq) == 0) {
+    if (_readSeq != _writeSeq) {
+      advanceReadSegment();
+    } else if (_cacheLen == 0) {
+      // Todo consumido: reutilizar el segmento de escritura desde cero
+      char path[32];
+      segmentPath(_writeSeq, path, sizeof(path));
+      LittleFS.remove(path);
+      _writeSize = 0;
+      _readOffset = 0;
+    }
+  }
+}
+
+void FlashLog::advanceReadSegment() {
+  char path[32];
+  segmentPath(_readSeq, path, sizeof(path));
+  LittleFS.remove(path);
+
+  _flashPending -= segmentRecords(_readSeq);
+  segmentRecords(_readSeq) = 0;
+  _readSeq++;
+  _readOffset = 0;
+  _peekNext = 0;
+}
+
+// ============================================================================
+// MANTENIMIENTO
+// ============================================================================
+
+void FlashLog::clear() {
+  if (!_ready) {
+    return;
+  }
+
+  char path[32];
+  for (uint32_t seq = _readSeq; seq <= _writeSeq; seq++) {
+    segmentPath(seq, path, sizeof(path));
+    LittleFS.remove(path);
+  }
+
+  memset(_segRecords, 0, sizeof(_segRecords));
+  _readSeq = 0;
+  _writeSeq = 0;
+  _writeSize = 0;
+  _readOffset = 0;
+  _peekNext = 0;
+  _cacheLen = 0;
+  _cacheRecords = 0;
+  _flashPending = 0;
+}
+
+uint8_t FlashLog::fillPercent() const {
+  if (!_ready || _maxSegments == 0) {
+    return 0;
+  }
+
+  uint32_t used = (_writeSeq - _readSeq) * FLASH_LOG_SEGMENT_SIZE +
+                  _writeSize + _cacheLen;
+  uint32_t capacity = _maxSegments * FLASH_LOG_SEGMENT_SIZE;
+  return (uint8_t)((uint64_t)used * 100 / capacity);
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+void FlashLog::segmentPath(uint32_t seq, char *out, size_t cap) const {
+  snprintf(out, cap, FLASH_LOG_DIR "/%08lu.log", (unsigned long)seq);
+}
+
+uint32_t FlashLog::crc32(const uint8_t *data, size_t len) {
+  // CRC-32 IEEE 802.3 (reflejado), sin tabla: registros de pocos cientos
+  // de bytes, el costo es despreciable frente a la escritura en flash
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// ============================================================================
+// STATUS
+// ============================================================================
+
+void FlashLog::printStatus() const {
+  Serial.printf("Flash log: %s\n", _ready ? "READY" : "DISABLED");
+  if (!_ready) {
+    return;
+  }
+  Serial.printf("Flash records: %lu (%lu in RAM cache)\n", count(),
+                _cacheRecords);
+  Serial.printf("Flash segments: %lu / %lu (%d%%)\n", getSegmentCount(),
+                _maxSegments, fillPercent());
+  Serial.printf("Flash flushes: %lu, CRC errors: %lu, dropped segments: %lu\n",
+                _flushCount, _crcErrors, _segmentsDropped);
+}
@@ -0,0 +1,193 @@
+/**
+ * @file flash_log.h
+ * @brief Log segmentado append-only en LittleFS para telemetría offline
+ *
+ * Persiste en flash las tramas que no se pudieron publicar, de modo que un
+ * corte largo de Starlink/celular o un reinicio no pierdan datos.
+ *
+ * Estructura:
+ * - Segmentos /olog/NNNNNNNN.log de hasta FLASH_LOG_SEGMENT_SIZE bytes,
+ *   numerados en orden creciente. Se escribe siempre en el más nuevo y se
+ *   reproduce desde el más antiguo (FIFO).
+ * - Cada registro: cabecera {magic, flags, len, crc32} + payload. El CRC
+ *   detecta escrituras incompletas (corte de energía) y corrupción.
+ * - Cache de escritura en RAM: los registros se acumulan y se vuelcan en un
+ *   solo write cuando el cache se llena o envejece (FLASH_LOG_FLUSH_MS).
+ *
+ * Recuperación al arranque: se enumeran los segmentos y se recorren sus
+ * cabeceras; la escritura continúa en un segmento nuevo, así que una cola
+ * truncada nunca se mezcla con datos nuevos. El lector salta al siguiente
+ * segmento al encontrar un registro inválido.
+ *
+ * Desgaste acotado: uso máximo FLASH_LOG_MAX_FILL_PCT de la partición; al
+ * llenarse se borra el segmento más antiguo (log circular) y las escrituras
+ * se agrupan en bloques de FLASH_LOG_CACHE_SIZE.
+ *
+ * Semántica at-least-once: el avance del lector dentro de un segmento no se
+ * persiste, por lo que tras un reinicio se pueden reenviar registros del
+ * segmento que se estaba reproduciendo.
+ *
+ * No es thread-safe: se usa bajo el mutex de OfflineBuffer.
+ *
+ * PART OF: Plan Safety-Critical P0.1
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// ============================================================================
+// CONFIGURACIÓN DEL LOG
+// ============================================================================
+
+#define FLASH_LOG_DIR "/olog"
+#define FLASH_LOG_SEGMENT_SIZE (64 * 1024) // Bytes por segmento
+#define FLASH_LOG_MAX_SEGMENTS 32          // Límite duro (2 MB)
+#define FLASH_LOG_MAX_FILL_PCT 80          // % máximo de la partición
+#define FLASH_LOG_CACHE_SIZE 4096          // Cache de escritura (RAM)
+#define FLASH_LOG_FLUSH_MS 5000            // Antigüedad máxima del cache
+#define FLASH_LOG_MAX_RECORD 2048          // Payload máximo por registro
+
+#define FLASH_LOG_RECORD_MAGIC 0xA7
+
+/**
+ * @struct FlashLogRecordHeader
+ * @brief Cabecera de cada registro en flash
+ */
+struct __attribute__((packed)) FlashLogRecordHeader {
+  uint8_t magic; ///< FLASH_LOG_RECORD_MAGIC
+  uint8_t flags; ///< Reservado (0)
+  uint16_t len;  ///< Bytes de payload
+  uint32_t crc;  ///< CRC-32 del payload
+};
+
+/**
+ * @class FlashLog
+ * @brief Cola FIFO persistente de registros binarios
+ */
+class FlashLog {
+public:
+  FlashLog();
+
+  /**
+   * @brief Monta LittleFS y recupera los segmentos existentes
+   * @return false si no hay filesystem (el llamador usa solo RAM)
+   */
+  bool begin();
+
+  bool isReady() const { return _ready; }
+
+  /**
+   * @brief Agrega un registro al final del log (vía cache RAM)
+   */
+  bool append(const uint8_t *data, size_t len);
+
+  /**
+   * @brief Indica si un registro de len bytes sería el primero de un
+   * segmento (punto de arranque de la reproducción tras un reinicio)
+   */
+  bool startsSegment(size_t len) const {
+    size_t used = _writeSize + _cacheLen;
+    return used == 0 || used + sizeof(FlashLogRecordHeader) + len >
+                            FLASH_LOG_SEGMENT_SIZE;
+  }
+
+  /**
+   * @brief Copia el registro más antiguo sin consumirlo
+   * @param out Buffer de salida
+   * @param cap Capacidad de out
+   * @param len Output: bytes del registro
+   * @return true si hay registro disponible
+   */
+  bool peek(uint8_t *out, size_t cap, size_t &len);
+
+  /**
+   * @brief Consume el registro devuelto por el último peek()
+   */
+  void consume();
+
+  /**
+   * @brief Vuelca el cache de escritura a flash
+   */
+  bool flush();
+
+  /**
+   * @brief Vuelca el cache si su primer registro tiene FLASH_LOG_FLUSH_MS
+   * o más. append() solo lo comprueba al escribir: sin nuevas escrituras,
+   * el dueño del log debe llamarlo periódicamente
+   * @param nowMs millis() actual
+   */
+  bool flushIfStale(uint32_t nowMs);
+
+  /**
+   * @brief Borra todos los segmentos
+   */
+  void clear();
+
+  /**
+   * @brief Registros pendientes (flash + cache)
+   */
+  uint32_t count() const { return _flashPending + _cacheRecords; }
+  bool isEmpty() const { return count() == 0; }
+
+  /**
+   * @brief Ocupación respecto al máximo permitido (0-100)
+   */
+  uint8_t fillPercent() const;
+
+  /**
+   * @brief Estadísticas
+   */
+  uint32_t getSegmentCount() const {
+    return _ready ? _writeSeq - _readSeq + 1 : 0;
+  }
+  uint32_t getMaxSegments() const { return _maxSegments; }
+  uint32_t getCrcErrors() const { return _crcErrors; }
+  uint32_t getSegmentsDropped() const { return _segmentsDropped; }
+  uint32_t getFlushCount() const { return _flushCount; }
+
+  void printStatus() const;
+
+private:
+  void segmentPath(uint32_t seq, char *out, size_t cap) const;
+  uint16_t scanSegment(uint32_t seq);
+  void rollWriteSegment();
+  void advanceReadSegment();
+  uint16_t &segmentRecords(uint32_t seq) {
+    return _segRecords[seq % FLASH_LOG_MAX_SEGMENTS];
+  }
+
+  static uint32_t crc32(const uint8_t *data, size_t len);
+
+  bool _ready;
+  uint32_t _maxSegments;
+
+  // Escritura
+  uint32_t _writeSeq;   ///< Segmento de escritura
+  size_t _writeSize;    ///< Bytes ya en flash del segmento de escritura
+  uint8_t _cache[FLASH_LOG_CACHE_SIZE];
+  size_t _cacheLen;
+  uint32_t _cacheRecords;
+  uint32_t _cacheSince; ///< millis() del primer registro en cache
+
+  // Lectura
+  uint32_t _readSeq;    ///< Segmento de lectura (más antiguo)
+  size_t _readOffset;   ///< Offset del próximo registro
+  size_t _peekNext;     ///< Offset tras el registro del último peek (0 = n/a)
+
+  // Registros por segmento vivo (índice seq % FLASH_LOG_MAX_SEGMENTS)
+  uint16_t _segRecords[FLASH_LOG_MAX_SEGMENTS];
+
+  // Estado / estadísticas
+  uint32_t _flashPending; ///< Registros en flash sin consumir
+  uint32_t _crcErrors;
+  uint32_t _segmentsDropped;
+  uint32_t _flushCount;
+};
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,333 @@
+/**
+ * @file json_payload.cpp
+ * @brief Serialización de la trama cloud JSON en buffer fijo
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "json_payload.h"
+#include "binary_payload.h"
+#include <math.h>
+
+// ============================================================================
+// ESCRITOR JSON
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief Escritor de texto secuencial con control de desbordamiento
+ *
+ * Igual que BinaryWriter: si algo no cabe, marca overflow, las escrituras
+ * siguientes se ignoran y el llamador revisa ok() al final. Los números se
+ * formatean a mano (sin printf) para no tocar el heap de newlib.
+ */
+class JsonWriter {
+public:
+  JsonWriter(char *buf, size_t cap)
+      : _buf(buf), _cap(cap), _pos(0), _overflow(false), _first(true) {}
+
+  void raw(const char *s) {
+    while (*s) {
+      ch(*s++);
+    }
+  }
+
+  void ch(char c) {
+    // Se reserva un byte para el terminador
+    if (_overflow || _pos + 1 >= _cap) {
+      _overflow = true;
+      return;
+    }
+    _buf[_pos++] = c;
+  }
+
+  /// Cadena entre comillas con escape JSON
+  void str(const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    ch('"');
+    for (; *s; s++) {
+      uint8_t c = (uint8_t)*s;
+      if (c == '"' || c == '\\') {
+        ch('\\');
+        ch((char)c);
+      } else if (c == '\n') {
+        raw("\\n");
+      } else if (c == '\r') {
+        raw("\\r");
+      } else if (c == '\t') {
+        raw("\\t");
+      } else if (c < 0x20) {
+        raw("\\u00");
+        ch(hex[c >> 4]);
+        ch(hex[c & 0x0F]);
+      } else {
+        ch((char)c);
+      }
+    }
+    ch('"');
+  }
+
+  /// Clave de miembro (agrega la coma separadora cuando corresponde)
+  void key(const char *k) {
+    if (!_first) {
+      ch(',');
+    }
+    _first = false;
+    str(k);
+    ch(':');
+  }
+
+  void beginObject() {
+    ch('{');
+    _first = true;
+  }
+
+  void endObject() {
+    ch('}');
+    _first = false;
+  }
+
+  void boolean(bool v) { raw(v ? "true" : "false"); }
+
+  void integer(int32_t v) {
+    if (v < 0) {
+      ch('-');
+      unsignedInt((uint64_t)(-(int64_t)v));
+    } else {
+      unsignedInt((uint64_t)v);
+    }
+  }
+
+  void unsignedInt(uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+      tmp[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+      ch(tmp[--n]);
+    }
+  }
+
+  /**
+   * @brief Número con ~7 cifras significativas (precisión de float)
+   *
+   * Notación fija; exponente solo fuera de [1e-5, 1e9). NaN/Inf -> null,
+   * como ArduinoJson.
+   */
+  void number(float value) {
+    if (!isfinite(value)) {
+      raw("null");
+      return;
+    }
+
+    double d = value;
+    if (d < 0) {
+      ch('-');
+      d = -d;
+    }
+
+    int exp10 = 0;
+    if (d >= 1e9 || (d > 0 && d < 1e-5)) {
+      exp10 = (int)floor(log10(d));
+      d /= pow(10.0, exp10);
+      if (d >= 10.0) {
+        d /= 10.0;
+        exp10++;
+      } else if (d < 1.0) {
+        d *= 10.0;
+        exp10--;
+      }
+    }
+
+    int intDigits = 1;
+    for (double p = 10.0; d >= p && intDigits < 9; p *= 10.0) {
+      intDigits++;
+    }
+    int decimals = 7 - intDigits;
+    fixed(d, decimals < 0 ? 0 : decimals, true);
+
+    if (exp10 != 0) {
+      ch('e');
+      integer(exp10);
+    }
+  }
+
+  /**
+   * @brief Número en notación fija con N decimales
+   * @param trim true = quitar ceros finales (false: como String(x, N))
+   */
+  void fixed(double d, int decimals, bool trim) {
+    if (d < 0) {
+      ch('-');
+      d = -d;
+    }
+
+    uint64_t scale = 1;
+    for (int i = 0; i < decimals; i++) {
+      scale *= 10;
+    }
+    uint64_t total = (uint64_t)llround(d * (double)scale);
+    uint64_t ip = total / scale;
+    uint64_t fp = total % scale;
+
+    unsignedInt(ip);
+    if (decimals == 0 || (trim && fp == 0)) {
+      return;
+    }
+
+    char digits[12];
+    for (int i = decimals - 1; i >= 0; i--) {
+      digits[i] = (char)('0' + fp % 10);
+      fp /= 10;
+    }
+    int n = decimals;
+    while (trim && n > 0 && digits[n - 1] == '0') {
+      n--;
+    }
+    ch('.');
+    for (int i = 0; i < n; i++) {
+      ch(digits[i]);
+    }
+  }
+
+  /// Canal de sensor: "clave":{"v":valor}
+  void channel(const char *k, float v) {
+    key(k);
+    raw("{\"v\":");
+    number(v);
+    ch('}');
+  }
+
+  void channelInt(const char *k, int32_t v) {
+    key(k);
+    raw("{\"v\":");
+    integer(v);
+    ch('}');
+  }
+
+  void channelUnsigned(const char *k, uint32_t v) {
+    key(k);
+    raw("{\"v\":");
+    unsignedInt(v);
+    ch('}');
+  }
+
+  /// Coordenada con 6 decimales fijos (mismo texto que String(x, 6))
+  void coord(const char *k, float deg) {
+    key(k);
+    raw("{\"v\":");
+    fixed(deg, 6, false);
+    ch('}');
+  }
+
+  /// Canal de un campo del esquema, en el formato de su tipo
+  void field(TelemetryFieldType type, const char *k, float v) {
+    switch (type) {
+    case TelemetryFieldType::COORD:
+      coord(k, v);
+      break;
+    case TelemetryFieldType::UINT8:
+    case TelemetryFieldType::FLAG:
+      channelUnsigned(k, (uint32_t)v);
+      break;
+    default:
+      channel(k, v);
+      break;
+    }
+  }
+
+  size_t finish() {
+    if (_overflow) {
+      return 0;
+    }
+    _buf[_pos] = '\0';
+    return _pos;
+  }
+
+private:
+  char *_buf;
+  size_t _cap;
+  size_t _pos;
+  bool _overflow;
+  bool _first; ///< Primer miembro del objeto actual (sin coma)
+};
+
+} // namespace
+
+// ============================================================================
+// SERIALIZACIÓN
+// ============================================================================
+
+size_t buildJsonPayload(const TelemetrySnapshot &snapshot,
+                        const UnifiedConfig &cfg, uint64_t timeUs, char *buf,
+                        size_t cap) {
+  if (cap == 0) {
+    return 0;
+  }
+
+  JsonWriter w(buf, cap);
+
+  // Timestamp de captura (no de envío: los snapshots offline se serializan
+  // al drenar). timeUs = 0 -> reloj no sincronizado: sin "dt", en vez de
+  // una fecha de 1970 que el servidor tomaría por válida
+  char dt_buffer[TELEMETRY_UTC_STRING_LEN];
+  if (timeUs != 0) {
+    telemetryFormatUtc(timeUs, dt_buffer);
+  }
+
+  // Formato de trama original MoTeC
+  w.beginObject();
+  w.key("id");
+  w.str(cfg.device_id);
+  w.key("idc");
+  w.str(cfg.car_id);
+  w.key("d");
+  w.boolean(cfg.debug_mode);
+  if (timeUs != 0) {
+    w.key("dt");
+    w.str(dt_buffer);
+  }
+
+  // Objeto de sensores
+  w.key("s");
+  w.beginObject();
+
+  // === CAMPOS DEL ESQUEMA ===
+  // En orden de tabla, solo canales frescos y en rango: GPS (con fix), IMU
+  // (si está habilitada), motor / combustible / batería (claves = PID OBD2,
+  // BAT = PID 0x42) y suspensión
+#define JSON_FIELD(ID, Setter, member, type, key, cloudKey, pid, liveKey,      \
+                   unit, min, max, group, emit, ...)                           \
+  if (payloadFieldEmitted(snapshot, cfg, TelemetryField::ID,                   \
+                          TelemetryEmit::emit)) {                              \
+    w.field(TelemetryFieldType::type, cloudKey, (float)snapshot.member);       \
+  }
+  TELEMETRY_SCHEMA(JSON_FIELD)
+#undef JSON_FIELD
+
+  // === CUSTOM VALUES (solo frescos y en rango) ===
+  for (int i = 0; i < snapshot.custom_count; i++) {
+    const CustomValue &cv = snapshot.custom_values[i];
+    if (telemetryQualityUsable(cv.quality)) {
+      w.channel(cv.key, cv.value);
+    }
+  }
+
+  // === META ===
+  w.channelInt("wifi_rssi", snapshot.wifi_rssi);
+  w.channelUnsigned("heap_free", snapshot.heap_free);
+
+  w.endObject();
+
+  // === DTC Array ===
+  w.key("DTC");
+  w.raw("[]");
+
+  w.endObject();
+
+  return w.finish();
+}
@@ -0,0 +1,46 @@
+/**
+ * @file json_payload.h
+ * @brief Serialización de la trama cloud JSON sin memoria dinámica
+ *
+ * Escribe la trama JSON directamente en un buffer preasignado, sin
+ * JsonDocument ni String temporales: una trama por envío ya no fragmenta
+ * el heap (heap_free es a su vez un canal de telemetría). La salida es la
+ * misma trama que producía serializeJson() en CloudManager::buildPayload():
+ *
+ *   {"id":..,"idc":..,"d":..,"dt":"YYYY-mm-dd HH:MM:SS",
+ *    "s":{"<canal>":{"v":valor},...},"DTC":[]}
+ *
+ * Sin hora UTC (reloj aún no sincronizado) la trama omite "dt".
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef JSON_PAYLOAD_H
+#define JSON_PAYLOAD_H
+
+#include "../config/config_schema.h"
+#include "../telemetry/telemetry_bus.h"
+#include <Arduino.h>
+
+// Peor caso: cabecera + 31 canales + 64 custom de 23 chars. Claves típicas
+// ocupan ~3 KB; 6 KB cubre también claves con todos los caracteres escapados
+#define JSON_PAYLOAD_MAX_SIZE 6144
+
+/**
+ * @brief Serializa un snapshot a la trama JSON
+ *
+ * @param snapshot Snapshot del TelemetryBus
+ * @param cfg Configuración (device_id, car_id, debug_mode, imu)
+ * @param timeUs Hora UTC de captura en µs (TelemetryClock; 0 = no
+ *        sincronizada: se omite "dt"). "dt" conserva la resolución de 1 s
+ *        del contrato con el servidor; la trama binaria lleva los µs
+ * @param buf Buffer de salida (queda terminado en '\0')
+ * @param cap Capacidad de buf (JSON_PAYLOAD_MAX_SIZE cubre el peor caso)
+ * @return Bytes escritos sin el terminador, 0 si no cabe en el buffer
+ */
+size_t buildJsonPayload(const TelemetrySnapshot &snapshot,
+                        const UnifiedConfig &cfg, uint64_t timeUs, char *buf,
+                        size_t cap);
+
+#endif // JSON_PAYLOAD_H
@@ -1,6 +1,6 @@
 /**
  * @file offline_buffer.cpp
- * @brief Implementación del OfflineBuffer
+ * @brief Implementación del OfflineBuffer (flash + fallback RAM)
  *
  * PART OF: Plan Safety-Critical P0.1
  *
@@ -15,10 +15,12 @@
 // ============================================================================
 
 OfflineBuffer::OfflineBuffer()
-    : _head(0), _tail(0), _count(0), _totalPushed(0), _totalOverwritten(0),
-      _totalPopped(0), _mutex(nullptr) {
+    : _head(0), _tail(0), _ramUsed(0), _count(0), _peekFromFlash(false),
+      _peekPending(false), _lastToFlash(false), _totalPushed(0),
+      _totalOverwritten(0), _totalPopped(0), _bytesPushed(0),
+      _mutex(nullptr) {
   // Inicializar buffer a ceros
-  memset(_buffer, 0, sizeof(_buffer));
+  memset(_ram, 0, sizeof(_ram));
 }
 
 // ============================================================================
@@ -35,12 +37,21 @@ void OfflineBuffer::begin() {
     return;
   }
 
-  // Limpiar buffer
-  clear();
+  // Limpiar el ring RAM (el log en flash se conserva entre reinicios)
+  _head = 0;
+  _tail = 0;
+  _ramUsed = 0;
+  _count = 0;
+  _encoder.reset();
+  _decoder.reset();
 
-  Serial.printf("[OFFLINE_BUFFER] Ready (capacity: %d frames, ~%d KB RAM)\n",
-                OFFLINE_BUFFER_SIZE,
-                (OFFLINE_BUFFER_SIZE * sizeof(TelemetryFrame)) / 1024);
+  // Log persistente en LittleFS; sin él queda solo el ring RAM
+  _flash.begin();
+
+  Serial.printf("[OFFLINE_BUFFER] Ready (RAM: %d KB ring; flash: %s, "
+                "%lu snapshots pending)\n",
+                OFFLINE_RAM_BYTES / 1024, _flash.isReady() ? "YES" : "NO",
+                _flash.count());
 }
 
 // ============================================================================
@@ -60,42 +71,159 @@ void OfflineBuffer::giveMutex() {
 }
 
 // ============================================================================
-// OPERACIONES DEL BUFFER
+// RING RAM DE REGISTROS
 // ============================================================================
 
-bool OfflineBuffer::push(const String &payload) {
-  if (payload.length() == 0 || payload.length() >= MAX_PAYLOAD_SIZE) {
-    Serial.printf("[OFFLINE_BUFFER] Push failed: invalid payload size (%d)\n",
-                  payload.length());
-    return false;
+void OfflineBuffer::ramWrite(size_t at, const uint8_t *data, size_t len) {
+  size_t first = OFFLINE_RAM_BYTES - at;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(_ram + at, data, first);
+  memcpy(_ram, data + first, len - first);
+}
+
+void OfflineBuffer::ramRead(size_t at, uint8_t *out, size_t len) const {
+  size_t first = OFFLINE_RAM_BYTES - at;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(out, _ram + at, first);
+  memcpy(out + first, _ram, len - first);
+}
+
+size_t OfflineBuffer::ramPeek(uint8_t *out, size_t cap) const {
+  if (_count == 0) {
+    return 0;
+  }
+
+  uint8_t hdr[2];
+  ramRead(_tail, hdr, 2);
+  size_t len = hdr[0] | (hdr[1] << 8);
+  if (len > cap) {
+    return 0;
   }
 
+  ramRead((_tail + 2) % OFFLINE_RAM_BYTES, out, len);
+  return len;
+}
+
+void OfflineBuffer::ramDrop() {
+  if (_count == 0) {
+    return;
+  }
+
+  uint8_t hdr[2];
+  ramRead(_tail, hdr, 2);
+  size_t total = 2 + (hdr[0] | (hdr[1] << 8));
+
+  _tail = (_tail + total) % OFFLINE_RAM_BYTES;
+  _ramUsed -= total;
+  _count--;
+}
+
+bool OfflineBuffer::ramMakeRoom(size_t len) {
+  bool dropped = false;
+
+  while (_count > 0 && _ramUsed + 2 + len > OFFLINE_RAM_BYTES) {
+    ramDrop();
+    dropped = true;
+    _totalOverwritten++;
+  }
+
+  if (dropped) {
+    // Un delta sin su base no se puede reconstruir: descartar hasta el
+    // siguiente keyframe
+    uint8_t flags = 0;
+    while (_count > 0) {
+      ramRead((_tail + 2) % OFFLINE_RAM_BYTES, &flags, 1);
+      if (flags & SNAPSHOT_RECORD_KEYFRAME) {
+        break;
+      }
+      ramDrop();
+      _totalOverwritten++;
+    }
+    if (!_peekFromFlash) {
+      _peekPending = false;
+    }
+  }
+
+  return dropped;
+}
+
+void OfflineBuffer::ramPush(const uint8_t *data, size_t len) {
+  uint8_t hdr[2] = {(uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+  ramWrite(_head, hdr, 2);
+  ramWrite((_head + 2) % OFFLINE_RAM_BYTES, data, len);
+
+  _head = (_head + 2 + len) % OFFLINE_RAM_BYTES;
+  _ramUsed += 2 + len;
+  _count++;
+}
+
+// ============================================================================
+// OPERACIONES DEL BUFFER
+// ============================================================================
+
+bool OfflineBuffer::push(const TelemetrySnapshot &snapshot, uint64_t timeUs) {
   if (!takeMutex()) {
     Serial.println(F("[OFFLINE_BUFFER] Push failed: mutex timeout"));
     return false;
   }
 
-  // Si el buffer está lleno, sobrescribimos el más antiguo
-  bool overwrite = isFull();
-  if (overwrite) {
-    // Avanzar tail (descartamos el más antiguo)
-    _tail = (_tail + 1) % OFFLINE_BUFFER_SIZE;
-    _count--;
-    _totalOverwritten++;
+  // Sello monotónico + arranque: si el reloj aún no está anclado
+  // (timeUs = 0), la hora se resuelve al drenar (ver peek())
+  SnapshotRecordTime time;
+  time.utcUs = timeUs;
+  time.monoUs = snapshot.captured_us;
+  time.bootId = telemetryBootId();
+
+  // Cambio de almacenamiento -> keyframe (cada uno se lee por separado)
+  bool toFlash = _flash.isReady();
+  bool keyframe = _encoder.keyframeDue() || toFlash != _lastToFlash;
+  size_t len =
+      _encoder.encode(snapshot, time, keyframe, _record, sizeof(_record));
+
+  if (toFlash) {
+    // Cada segmento arranca con keyframe: el más antiguo puede rotarse
+    if (!keyframe && _flash.startsSegment(len)) {
+      keyframe = true;
+      len = _encoder.encode(snapshot, time, true, _record, sizeof(_record));
+    }
+
+    // Persistencia en flash (sobrevive reinicios)
+    if (len > 0 && _flash.append(_record, len)) {
+      _encoder.commit(snapshot, keyframe);
+      _lastToFlash = true;
+      _totalPushed++;
+      _bytesPushed += len;
+      giveMutex();
+      return true;
+    }
+
+    // Flash falló: el registro va al ring RAM como keyframe
+    keyframe = true;
+    len = _encoder.encode(snapshot, time, true, _record, sizeof(_record));
   }
 
-  // Escribir en head
-  TelemetryFrame &frame = _buffer[_head];
-  strncpy(frame.payload, payload.c_str(), MAX_PAYLOAD_SIZE - 1);
-  frame.payload[MAX_PAYLOAD_SIZE - 1] = '\0';
-  frame.payload_len = payload.length();
-  frame.timestamp_ms = millis();
-  frame.valid = true;
+  if (len == 0) {
+    giveMutex();
+    Serial.println(F("[OFFLINE_BUFFER] Push failed: record encode error"));
+    return false;
+  }
 
-  // Avanzar head
-  _head = (_head + 1) % OFFLINE_BUFFER_SIZE;
-  _count++;
+  // Si el ring está lleno, sobrescribimos lo más antiguo
+  bool overwrite = ramMakeRoom(len);
+  if (overwrite && _count == 0 && !keyframe) {
+    keyframe = true;
+    len = _encoder.encode(snapshot, time, true, _record, sizeof(_record));
+  }
+
+  ramPush(_record, len);
+  _encoder.commit(snapshot, keyframe);
+  _lastToFlash = false;
   _totalPushed++;
+  _bytesPushed += len;
 
   giveMutex();
 
@@ -103,7 +231,7 @@ bool OfflineBuffer::push(const String &payload) {
     // Log solo cada 10 overwrites para no saturar serial
     if (_totalOverwritten % 10 == 1) {
       Serial.printf("[OFFLINE_BUFFER] Warning: buffer full, overwriting old "
-                    "frames (total: %lu)\n",
+                    "snapshots (total: %lu)\n",
                     _totalOverwritten);
     }
   }
@@ -111,62 +239,79 @@ bool OfflineBuffer::push(const String &payload) {
   return true;
 }
 
-bool OfflineBuffer::pop(String &payload) {
+bool OfflineBuffer::peek(TelemetrySnapshot &snapshot, uint64_t &timeUs) {
   if (!takeMutex()) {
     return false;
   }
 
-  if (_count == 0) {
-    giveMutex();
-    return false;
+  // Primero lo más antiguo: flash, luego el ring RAM (fallback). Los
+  // registros malformados se descartan sin detener el drenado
+  SnapshotRecordTime time;
+  bool found = false;
+  size_t len = 0;
+  while (!found && _flash.peek(_record, sizeof(_record), len)) {
+    if (_decoder.decode(_record, len, snapshot, time)) {
+      _peekFromFlash = true;
+      found = true;
+    } else {
+      _flash.consume();
+    }
   }
 
-  // Leer de tail
-  TelemetryFrame &frame = _buffer[_tail];
-
-  if (frame.valid) {
-    payload = String(frame.payload);
-    frame.valid = false;
-    frame.payload[0] = '\0';
-  } else {
-    // Frame inválido, skipear
-    giveMutex();
-    _tail = (_tail + 1) % OFFLINE_BUFFER_SIZE;
-    _count--;
-    return false;
+  while (!found && _count > 0) {
+    len = ramPeek(_record, sizeof(_record));
+    if (len > 0 && _decoder.decode(_record, len, snapshot, time)) {
+      _peekFromFlash = false;
+      found = true;
+    } else {
+      ramDrop();
+    }
   }
 
-  // Avanzar tail
-  _tail = (_tail + 1) % OFFLINE_BUFFER_SIZE;
-  _count--;
-  _totalPopped++;
-
+  _peekPending = found;
   giveMutex();
 
-  return true;
+  // Capturado sin hora UTC: resolverla con el reloj actual si el registro
+  // es de este arranque (el sello monotónico no vale tras un reinicio)
+  if (found) {
+    timeUs =
+        time.resolveUtcUs(telemetryBootId(), TelemetryClock::getInstance());
+  }
+  return found;
 }
 
-bool OfflineBuffer::peek(String &payload) {
+void OfflineBuffer::consume() {
   if (!takeMutex()) {
-    return false;
+    return;
   }
 
-  if (_count == 0) {
-    giveMutex();
-    return false;
+  if (_peekPending) {
+    if (_peekFromFlash) {
+      _flash.consume();
+    } else {
+      ramDrop();
+    }
+    _peekPending = false;
+    _totalPopped++;
   }
 
-  TelemetryFrame &frame = _buffer[_tail];
+  giveMutex();
+}
 
-  if (frame.valid) {
-    payload = String(frame.payload);
-  } else {
-    giveMutex();
-    return false;
+void OfflineBuffer::flush() {
+  if (!takeMutex(pdMS_TO_TICKS(100))) {
+    return;
   }
+  _flash.flush();
+  giveMutex();
+}
 
+void OfflineBuffer::flushIfStale(uint32_t nowMs) {
+  if (!takeMutex(pdMS_TO_TICKS(100))) {
+    return;
+  }
+  _flash.flushIfStale(nowMs);
   giveMutex();
-  return true;
 }
 
 void OfflineBuffer::clear() {
@@ -176,13 +321,12 @@ void OfflineBuffer::clear() {
 
   _head = 0;
   _tail = 0;
+  _ramUsed = 0;
   _count = 0;
-
-  // Marcar todos los frames como inválidos
-  for (size_t i = 0; i < OFFLINE_BUFFER_SIZE; i++) {
-    _buffer[i].valid = false;
-    _buffer[i].payload[0] = '\0';
-  }
+  _peekPending = false;
+  _flash.clear();
+  _encoder.reset();
+  _decoder.reset();
 
   giveMutex();
 
@@ -195,11 +339,14 @@ void OfflineBuffer::clear() {
 
 void OfflineBuffer::printStatus() {
   Serial.println(F("\n========== OFFLINE BUFFER STATUS =========="));
-  Serial.printf("Count: %d / %d (%d%%)\n", _count, OFFLINE_BUFFER_SIZE,
-                fillPercent());
-  Serial.printf("Total pushed: %lu\n", _totalPushed);
+  Serial.printf("RAM ring: %d snapshots, %d / %d bytes\n", _count, _ramUsed,
+                OFFLINE_RAM_BYTES);
+  Serial.printf("Pending total: %d (%d%%)\n", count(), fillPercent());
+  Serial.printf("Total pushed: %lu (%lu bytes, avg %lu B/snapshot)\n",
+                _totalPushed, _bytesPushed,
+                _totalPushed ? _bytesPushed / _totalPushed : 0);
   Serial.printf("Total popped: %lu\n", _totalPopped);
   Serial.printf("Total overwritten: %lu\n", _totalOverwritten);
-  Serial.printf("Memory used: %d bytes\n", _count * sizeof(TelemetryFrame));
+  _flash.printStatus();
   Serial.println(F("============================================\n"));
 }
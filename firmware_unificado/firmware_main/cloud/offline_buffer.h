@@ -2,8 +2,13 @@
  * @file offline_buffer.h
  * @brief Buffer offline para telemetría cuando MQTT no está disponible
  *
- * Implementa un RingBuffer en RAM para almacenar frames de telemetría
- * durante cortes de red. Sin allocación dinámica, estructura fija.
+ * Guarda snapshots del TelemetryBus como registros binarios compactos
+ * (cloud/snapshot_record.h: solo canales modificados + timestamp) y la
+ * trama cloud se serializa al drenar, en el formato configurado en ese
+ * momento. Los registros se persisten en un log segmentado en LittleFS
+ * (FlashLog), que sobrevive reinicios y cubre cortes de horas. Si el
+ * filesystem no está disponible se usa un ring de bytes en RAM, sin
+ * allocación dinámica.
  *
  * PART OF: Plan Safety-Critical P0.1
  * RISK MITIGATED: Pérdida total de telemetría en dropouts Starlink
@@ -15,6 +20,8 @@
 #ifndef OFFLINE_BUFFER_H
 #define OFFLINE_BUFFER_H
 
+#include "flash_log.h"
+#include "snapshot_record.h"
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
@@ -23,37 +30,23 @@
 // CONFIGURACIÓN DEL BUFFER
 // ============================================================================
 
-// Tamaño máximo del payload JSON (bytes)
-// Tamaño máximo del payload JSON (bytes) - Reducido para ahorrar RAM
-#define MAX_PAYLOAD_SIZE 512
+// Ring RAM de registros (fallback sin LittleFS). Misma RAM que los antiguos
+// 50 frames JSON de 512 bytes; un delta típico ocupa 20-60 bytes
+#define OFFLINE_RAM_BYTES (50 * 512)
 
-// Número de frames en el buffer (RAM)
-// 50 * 512 + overhead ~= 26KB de RAM (Mucho más seguro que 300KB)
-#define OFFLINE_BUFFER_SIZE 50
-
-// ============================================================================
-// ESTRUCTURAS
-// ============================================================================
-
-/**
- * @struct TelemetryFrame
- * @brief Frame de telemetría con estructura fija (sin alloc dinámico)
- */
-struct TelemetryFrame {
-  char payload[MAX_PAYLOAD_SIZE]; ///< JSON payload
-  uint32_t timestamp_ms;          ///< Timestamp de captura (millis)
-  uint16_t payload_len;           ///< Longitud real del payload
-  bool valid;                     ///< Frame válido para envío
-};
+static_assert(SNAPSHOT_RECORD_MAX_SIZE <= FLASH_LOG_MAX_RECORD,
+              "Un keyframe completo debe caber en un registro de flash");
+static_assert(SNAPSHOT_RECORD_MAX_SIZE + 2 <= OFFLINE_RAM_BYTES,
+              "Un keyframe completo debe caber en el ring RAM");
 
 /**
  * @class OfflineBuffer
- * @brief RingBuffer thread-safe para frames de telemetría
+ * @brief Cola FIFO thread-safe de snapshots de telemetría
  *
  * Implementación FIFO:
- * - Si mqtt.publish() falla → push al buffer
- * - Al reconectar MQTT → enviar FIFO
- * - Si buffer lleno → descartar más antiguo (overwrite)
+ * - Si mqtt.publish() falla → push del snapshot (flash; RAM si no hay FS)
+ * - Al reconectar MQTT → peek/serializar/publish/consume en orden
+ * - Si buffer lleno → descartar más antiguo (overwrite / segmento)
  */
 class OfflineBuffer {
 public:
@@ -66,53 +59,70 @@ public:
   OfflineBuffer &operator=(const OfflineBuffer &) = delete;
 
   /**
-   * @brief Inicializa el buffer (crear mutex)
+   * @brief Inicializa el buffer (crear mutex, montar log en flash)
    */
   void begin();
 
   /**
-   * @brief Agrega un frame al buffer
-   * @param payload JSON string
+   * @brief Agrega un snapshot al buffer
+   * @param snapshot Snapshot del TelemetryBus
+   * @param timeUs Hora UTC de captura en µs (TelemetryClock; 0 = no
+   *        sincronizada: se guarda captured_us con el id de arranque y la
+   *        hora se resuelve en peek())
    * @return true si se agregó, false si hubo error
    */
-  bool push(const String &payload);
+  bool push(const TelemetrySnapshot &snapshot, uint64_t timeUs);
 
   /**
-   * @brief Extrae el frame más antiguo (FIFO)
-   * @param payload Output: payload JSON
-   * @return true si hay frame disponible
+   * @brief Reconstruye el snapshot más antiguo sin extraerlo
+   * @param snapshot Output: snapshot
+   * @param timeUs Output: hora UTC de captura en µs (0 = no sincronizada
+   *        al guardar ni resoluble ahora: otro arranque o reloj sin anclar)
+   * @return true si hay snapshot disponible
    */
-  bool pop(String &payload);
+  bool peek(TelemetrySnapshot &snapshot, uint64_t &timeUs);
 
   /**
-   * @brief Peek al frame más antiguo sin extraerlo
-   * @param payload Output: payload JSON
-   * @return true si hay frame disponible
+   * @brief Descarta el snapshot devuelto por el último peek() (ya enviado)
    */
-  bool peek(String &payload);
+  void consume();
 
   /**
-   * @brief Retorna el número de frames en buffer
+   * @brief Fuerza el volcado del cache RAM del log a flash
    */
-  size_t count() const { return _count; }
+  void flush();
 
   /**
-   * @brief Retorna si el buffer está vacío
+   * @brief Vuelca el cache del log si envejeció (FlashLog::flushIfStale);
+   * CloudTask lo llama en cada ciclo
    */
-  bool isEmpty() const { return _count == 0; }
+  void flushIfStale(uint32_t nowMs);
 
   /**
-   * @brief Retorna si el buffer está lleno
+   * @brief Retorna el número de snapshots en buffer
    */
-  bool isFull() const { return _count >= OFFLINE_BUFFER_SIZE; }
+  size_t count() const { return _count + _flash.count(); }
+
+  /**
+   * @brief Retorna si el buffer está vacío
+   */
+  bool isEmpty() const { return count() == 0; }
 
   /**
    * @brief Retorna el porcentaje de ocupación (0-100)
    */
   uint8_t fillPercent() const {
-    return (uint8_t)((_count * 100) / OFFLINE_BUFFER_SIZE);
+    if (_flash.isReady()) {
+      return _flash.fillPercent();
+    }
+    return (uint8_t)((_ramUsed * 100) / OFFLINE_RAM_BYTES);
   }
 
+  /**
+   * @brief Log persistente (estadísticas)
+   */
+  const FlashLog &getFlashLog() const { return _flash; }
+
   /**
    * @brief Limpia todo el buffer
    */
@@ -124,6 +134,7 @@ public:
   uint32_t getTotalPushed() const { return _totalPushed; }
   uint32_t getTotalOverwritten() const { return _totalOverwritten; }
   uint32_t getTotalPopped() const { return _totalPopped; }
+  uint32_t getBytesPushed() const { return _bytesPushed; }
 
   /**
    * @brief Imprime estado del buffer
@@ -133,15 +144,34 @@ public:
 private:
   OfflineBuffer();
 
-  TelemetryFrame _buffer[OFFLINE_BUFFER_SIZE];
-  size_t _head;  ///< Índice de escritura (próximo push)
-  size_t _tail;  ///< Índice de lectura (próximo pop)
-  size_t _count; ///< Número de elementos en buffer
+  // Ring RAM de registros {u16 len, bytes}
+  bool ramMakeRoom(size_t len);
+  void ramPush(const uint8_t *data, size_t len);
+  size_t ramPeek(uint8_t *out, size_t cap) const;
+  void ramDrop();
+  void ramWrite(size_t at, const uint8_t *data, size_t len);
+  void ramRead(size_t at, uint8_t *out, size_t len) const;
+
+  uint8_t _ram[OFFLINE_RAM_BYTES];
+  size_t _head;    ///< Offset de escritura (próximo push)
+  size_t _tail;    ///< Offset de lectura (próximo pop)
+  size_t _ramUsed; ///< Bytes ocupados en el ring
+  size_t _count;   ///< Registros en el ring
+
+  FlashLog _flash;     ///< Log persistente (prioritario sobre el ring RAM)
+  bool _peekFromFlash; ///< Origen del último peek()
+  bool _peekPending;   ///< Hay un peek() sin consume() válido
+  bool _lastToFlash;   ///< Destino del último push (cambio -> keyframe)
+
+  SnapshotRecordEncoder _encoder;
+  SnapshotRecordDecoder _decoder;
+  uint8_t _record[SNAPSHOT_RECORD_MAX_SIZE]; ///< Scratch (bajo mutex)
 
   // Estadísticas
   uint32_t _totalPushed;
   uint32_t _totalOverwritten;
   uint32_t _totalPopped;
+  uint32_t _bytesPushed;
 
   SemaphoreHandle_t _mutex;
 
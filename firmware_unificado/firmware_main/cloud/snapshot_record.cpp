@@ -0,0 +1,314 @@
+/**
+ * @file snapshot_record.cpp
+ * @brief Codificación delta/keyframe de snapshots para el buffer offline
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "snapshot_record.h"
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+namespace {
+
+void putU32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+uint32_t getU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+void putF32(uint8_t *p, float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  putU32(p, bits);
+}
+
+void putU64(uint8_t *p, uint64_t v) {
+  putU32(p, (uint32_t)v);
+  putU32(p + 4, (uint32_t)(v >> 32));
+}
+
+uint64_t getU64(const uint8_t *p) {
+  return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32);
+}
+
+float getF32(const uint8_t *p) {
+  uint32_t bits = getU32(p);
+  float v;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+/// Igualdad bit a bit (un NaN repetido no cuenta como cambio)
+bool sameBits(float a, float b) { return memcmp(&a, &b, sizeof(float)) == 0; }
+
+/// Canales del esquema utilizables en el snapshot (bit n = PayloadChannel n)
+uint32_t usableChannels(const TelemetrySnapshot &snap) {
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    uint8_t id = TELEMETRY_FIELDS[i].payloadId;
+    if (id != 0 && snap.usable((TelemetryField)i)) {
+      mask |= (1UL << id);
+    }
+  }
+  return mask;
+}
+
+/// Custom utilizables (bit n de la palabra n / 32 = slot n)
+void usableCustoms(const TelemetrySnapshot &snap, uint32_t out[2]) {
+  out[0] = out[1] = 0;
+  for (uint8_t i = 0; i < snap.custom_count && i < MAX_CUSTOM_VALUES; i++) {
+    if (telemetryQualityUsable(snap.custom_values[i].quality)) {
+      out[i / 32] |= (1UL << (i % 32));
+    }
+  }
+}
+
+} // namespace
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+size_t SnapshotRecordEncoder::encode(const TelemetrySnapshot &snap,
+                                     const SnapshotRecordTime &time,
+                                     bool keyframe, uint8_t *out,
+                                     size_t cap) const {
+  if (!_hasBase) {
+    keyframe = true;
+  }
+
+  // Cabecera (25) + contadores de custom (2)
+  if (cap < 27) {
+    return 0;
+  }
+
+  uint8_t flags = SNAPSHOT_RECORD_TIME_US | SNAPSHOT_RECORD_MONO;
+  if (keyframe)
+    flags |= SNAPSHOT_RECORD_KEYFRAME;
+  if (snap.gps_fix)
+    flags |= SNAPSHOT_RECORD_GPS_FIX;
+  if (time.utcUs != 0)
+    flags |= SNAPSHOT_RECORD_TIME_VALID;
+
+  out[0] = flags;
+  putU64(out + 1, time.utcUs);
+  putU64(out + 9, time.monoUs);
+  putU32(out + 17, time.bootId);
+  size_t pos = 25;
+
+  // === Canales fijos ===
+  uint32_t mask = 0;
+  for (uint8_t id = 1; id <= PAYLOAD_CHANNEL_COUNT; id++) {
+    float v = payloadChannelGet(snap, id);
+    if (!keyframe && sameBits(v, payloadChannelGet(_base, id))) {
+      continue;
+    }
+    if (pos + 4 > cap) {
+      return 0;
+    }
+    mask |= (1UL << id);
+    putF32(out + pos, v);
+    pos += 4;
+  }
+  putU32(out + 21, mask);
+
+  // === Calidad (en keyframes y cuando cambió) ===
+  uint32_t usable = usableChannels(snap);
+  uint32_t customUsable[2];
+  usableCustoms(snap, customUsable);
+
+  bool qualityChanged = keyframe || usable != usableChannels(_base);
+  if (!qualityChanged) {
+    uint32_t baseCustom[2];
+    usableCustoms(_base, baseCustom);
+    qualityChanged = customUsable[0] != baseCustom[0] ||
+                     customUsable[1] != baseCustom[1];
+  }
+  if (qualityChanged) {
+    if (pos + 12 > cap) {
+      return 0;
+    }
+    out[0] |= SNAPSHOT_RECORD_QUALITY;
+    putU32(out + pos, usable);
+    putU32(out + pos + 4, customUsable[0]);
+    putU32(out + pos + 8, customUsable[1]);
+    pos += 12;
+  }
+
+  // === Custom (solo slots nuevos o modificados) ===
+  if (pos + 2 > cap) {
+    return 0;
+  }
+  out[pos++] = snap.custom_count;
+  size_t customCountAt = pos++;
+  uint8_t customs = 0;
+
+  for (uint8_t i = 0; i < snap.custom_count && i < MAX_CUSTOM_VALUES; i++) {
+    const CustomValue &cv = snap.custom_values[i];
+    bool known = !keyframe && i < _base.custom_count &&
+                 strcmp(cv.key, _base.custom_values[i].key) == 0;
+
+    if (known && sameBits(cv.value, _base.custom_values[i].value)) {
+      continue;
+    }
+
+    size_t keyLen = known ? 0 : strnlen(cv.key, MAX_KEY_LEN - 1);
+    if (pos + 2 + keyLen + 4 > cap) {
+      return 0;
+    }
+    out[pos++] = i;
+    out[pos++] = (uint8_t)keyLen;
+    memcpy(out + pos, cv.key, keyLen);
+    pos += keyLen;
+    putF32(out + pos, cv.value);
+    pos += 4;
+    customs++;
+  }
+  out[customCountAt] = customs;
+
+  return pos;
+}
+
+void SnapshotRecordEncoder::commit(const TelemetrySnapshot &snapshot,
+                                   bool keyframe) {
+  _base = snapshot;
+  _hasBase = true;
+  _sinceKeyframe = keyframe ? 0 : _sinceKeyframe + 1;
+}
+
+// ============================================================================
+// DECODER
+// ============================================================================
+
+bool SnapshotRecordDecoder::decode(const uint8_t *data, size_t len,
+                                   TelemetrySnapshot &out,
+                                   SnapshotRecordTime &time) {
+  if (len < 11) {
+    return false;
+  }
+
+  // Cabecera: u64 µs, o u32 s en registros previos a SNAPSHOT_RECORD_TIME_US;
+  // luego el sello monotónico si lo hay
+  uint8_t flags = data[0];
+  bool timeInUs = (flags & SNAPSHOT_RECORD_TIME_US) != 0;
+  bool hasMono = timeInUs && (flags & SNAPSHOT_RECORD_MONO) != 0;
+  size_t pos = (timeInUs ? 13 : 9) + (hasMono ? 12 : 0);
+  if (pos + 2 > len) {
+    return false;
+  }
+  uint32_t mask = getU32(data + pos - 4);
+
+  // Validar el registro completo antes de tocar el estado
+  size_t need = pos;
+  for (uint8_t id = 1; id <= PAYLOAD_CHANNEL_COUNT; id++) {
+    if (mask & (1UL << id))
+      need += 4;
+  }
+  if (flags & SNAPSHOT_RECORD_QUALITY)
+    need += 12;
+  if (need + 2 > len) {
+    return false;
+  }
+
+  if (flags & SNAPSHOT_RECORD_KEYFRAME) {
+    _state = TelemetrySnapshot();
+    _legacy = (flags & SNAPSHOT_RECORD_QUALITY) == 0;
+  }
+
+  for (uint8_t id = 1; id <= PAYLOAD_CHANNEL_COUNT; id++) {
+    if (mask & (1UL << id)) {
+      payloadChannelSet(_state, id, getF32(data + pos));
+      pos += 4;
+    }
+  }
+
+  if (flags & SNAPSHOT_RECORD_QUALITY) {
+    _usable = getU32(data + pos);
+    _customUsable[0] = getU32(data + pos + 4);
+    _customUsable[1] = getU32(data + pos + 8);
+    pos += 12;
+  }
+
+  uint8_t customCount = data[pos++];
+  uint8_t customs = data[pos++];
+  if (customCount > MAX_CUSTOM_VALUES) {
+    customCount = MAX_CUSTOM_VALUES;
+  }
+
+  for (uint8_t n = 0; n < customs; n++) {
+    if (pos + 2 > len) {
+      return false;
+    }
+    uint8_t slot = data[pos++];
+    uint8_t keyLen = data[pos++];
+    if (slot >= MAX_CUSTOM_VALUES || keyLen >= MAX_KEY_LEN ||
+        pos + keyLen + 4 > len) {
+      return false;
+    }
+
+    CustomValue &cv = _state.custom_values[slot];
+    if (keyLen > 0) {
+      memcpy(cv.key, data + pos, keyLen);
+      cv.key[keyLen] = '\0';
+      pos += keyLen;
+    }
+    cv.value = getF32(data + pos);
+    pos += 4;
+  }
+
+  _state.custom_count = customCount;
+  _state.gps_fix = (flags & SNAPSHOT_RECORD_GPS_FIX) != 0;
+
+  // Slots cuya clave aún no se conoce (reproducción iniciada a mitad de la
+  // cadena de deltas) se omiten hasta el próximo keyframe
+  out = _state;
+  applyQuality(out);
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < _state.custom_count; i++) {
+    if (_state.custom_values[i].key[0] != '\0') {
+      CustomValue &cv = out.custom_values[kept++];
+      cv = _state.custom_values[i];
+      bool usable = _legacy || (_customUsable[i / 32] & (1UL << (i % 32)));
+      cv.quality = usable ? TELEMETRY_Q_FRESH : TELEMETRY_Q_STALE;
+    }
+  }
+  out.custom_count = kept;
+
+  time = SnapshotRecordTime();
+  if (flags & SNAPSHOT_RECORD_TIME_VALID) {
+    time.utcUs = timeInUs ? getU64(data + 1)
+                          : (uint64_t)getU32(data + 1) * 1000000ULL;
+  }
+  if (hasMono) {
+    time.monoUs = getU64(data + 9);
+    time.bootId = getU32(data + 17);
+  }
+  return true;
+}
+
+void SnapshotRecordDecoder::applyQuality(TelemetrySnapshot &snap) const {
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    const TelemetryFieldInfo &f = TELEMETRY_FIELDS[i];
+    bool usable;
+    if (_legacy) {
+      // Criterio previo: GPS e IMU dependían solo del fix / configuración,
+      // el resto de que el valor fuera distinto de cero
+      usable = f.emit == TelemetryEmit::IF_GPS_FIX ||
+               f.emit == TelemetryEmit::IF_IMU ||
+               telemetryFieldGet(snap, (TelemetryField)i) != 0;
+    } else {
+      usable = f.payloadId != 0 && (_usable & (1UL << f.payloadId));
+    }
+    snap.quality[i] = usable ? TELEMETRY_Q_FRESH : TELEMETRY_Q_STALE;
+  }
+}
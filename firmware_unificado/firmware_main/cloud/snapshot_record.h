@@ -0,0 +1,165 @@
+/**
+ * @file snapshot_record.h
+ * @brief Registro binario compacto de snapshot para el buffer offline
+ *
+ * El buffer offline guarda snapshots del TelemetryBus, no tramas ya
+ * serializadas: la trama (JSON o binaria) se construye al drenar. Cada
+ * registro lleva solo los canales que cambiaron respecto al anterior
+ * (delta); periódicamente, y al inicio de cada segmento de flash, se emite
+ * un keyframe completo para que la reproducción pueda arrancar ahí.
+ *
+ * Layout (little-endian):
+ *
+ *   u8   flags  (bit0 keyframe, bit1 gps_fix, bit2 hora válida,
+ *                bit3 máscaras de calidad presentes, bit4 hora en µs,
+ *                bit5 sello monotónico presente)
+ *   u64  hora UTC de captura (µs desde 1970); sin bit4 (registros
+ *        anteriores): u32 epoch UNIX (s)
+ *   [u64 captured_us (µs monotónicos), u32 id de arranque]
+ *   u32  máscara de canales presentes (bit n = PayloadChannel n)
+ *   N x  f32 en orden de ID
+ *   [u32 canales utilizables (bit n = PayloadChannel n),
+ *    u32 custom utilizables slots 0-31, u32 slots 32-63]
+ *   u8   custom_count total del snapshot
+ *   u8   M custom presentes
+ *   M x  { u8 slot, u8 len (0 = misma clave que el slot), clave, f32 }
+ *
+ * Las máscaras de calidad (frescos y en rango al capturar) van en cada
+ * keyframe y en los deltas donde cambiaron: al drenar, la trama omite lo
+ * que estaba congelado en el momento de la captura, no lo que valía cero.
+ * Una cadena cuyo keyframe no las trae (registros previos a este formato)
+ * se reproduce con el criterio anterior de valor distinto de cero.
+ *
+ * Un snapshot guardado antes de que el reloj se sincronice no tiene hora
+ * UTC; el sello monotónico y el id de arranque permiten resolverla al
+ * drenar si sigue siendo el mismo arranque (SnapshotRecordTime).
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef SNAPSHOT_RECORD_H
+#define SNAPSHOT_RECORD_H
+
+#include "../telemetry/telemetry_bus.h"
+#include "../telemetry/telemetry_clock.h"
+#include "binary_payload.h"
+#include <Arduino.h>
+
+#define SNAPSHOT_RECORD_KEYFRAME 0x01
+#define SNAPSHOT_RECORD_GPS_FIX 0x02
+#define SNAPSHOT_RECORD_TIME_VALID 0x04
+#define SNAPSHOT_RECORD_QUALITY 0x08
+#define SNAPSHOT_RECORD_TIME_US 0x10
+#define SNAPSHOT_RECORD_MONO 0x20
+
+// Keyframe forzado cada N registros: acota el efecto de un registro perdido
+#define SNAPSHOT_KEYFRAME_INTERVAL 60
+
+// Peor caso: keyframe con todos los canales, máscaras de calidad y
+// MAX_CUSTOM_VALUES claves
+#define SNAPSHOT_RECORD_MAX_SIZE                                               \
+  (25 + PAYLOAD_CHANNEL_COUNT * 4 + 12 + 2 +                                   \
+   MAX_CUSTOM_VALUES * (2 + (MAX_KEY_LEN - 1) + 4))
+
+/**
+ * @struct SnapshotRecordTime
+ * @brief Hora de captura de un registro
+ */
+struct SnapshotRecordTime {
+  uint64_t utcUs = 0;  ///< UTC al guardar (0 = reloj aún sin anclar)
+  uint64_t monoUs = 0; ///< captured_us del snapshot
+  uint32_t bootId = 0; ///< Arranque que tomó monoUs (0 = desconocido)
+
+  /**
+   * @brief Hora UTC de captura al drenar
+   * @return utcUs si se conocía al guardar; si no, monoUs convertido con
+   *         el reloj actual cuando el registro es de este arranque; 0 si
+   *         no se puede resolver
+   */
+  uint64_t resolveUtcUs(uint32_t currentBootId,
+                        const TelemetryClock &clock) const {
+    if (utcUs != 0 || bootId == 0 || bootId != currentBootId)
+      return utcUs;
+    return clock.toUtcUs(monoUs);
+  }
+};
+
+/**
+ * @class SnapshotRecordEncoder
+ * @brief Codifica snapshots como delta del último registro emitido
+ */
+class SnapshotRecordEncoder {
+public:
+  SnapshotRecordEncoder() : _hasBase(false), _sinceKeyframe(0) {}
+
+  /**
+   * @brief Codifica un snapshot
+   * @param keyframe true = registro completo (independiente del anterior)
+   * @return Bytes escritos, 0 si no cabe
+   *
+   * No modifica la base: llamar a commit() cuando el registro se guardó.
+   */
+  size_t encode(const TelemetrySnapshot &snapshot,
+                const SnapshotRecordTime &time, bool keyframe, uint8_t *out,
+                size_t cap) const;
+
+  /**
+   * @brief Indica si el próximo registro debe ser keyframe por intervalo
+   */
+  bool keyframeDue() const {
+    return !_hasBase || _sinceKeyframe >= SNAPSHOT_KEYFRAME_INTERVAL;
+  }
+
+  /**
+   * @brief Toma el snapshot codificado como base del próximo delta
+   */
+  void commit(const TelemetrySnapshot &snapshot, bool keyframe);
+
+  /**
+   * @brief Olvida la base (el próximo registro será keyframe)
+   */
+  void reset() { _hasBase = false; }
+
+private:
+  TelemetrySnapshot _base;
+  bool _hasBase;
+  uint16_t _sinceKeyframe;
+};
+
+/**
+ * @class SnapshotRecordDecoder
+ * @brief Reconstruye snapshots aplicando registros en orden
+ */
+class SnapshotRecordDecoder {
+public:
+  /**
+   * @brief Aplica un registro sobre el estado acumulado
+   * @param out Snapshot reconstruido
+   * @param time Output: hora de captura (registros anteriores al sello
+   *        monotónico: solo utcUs)
+   * @return false si el registro está malformado
+   *
+   * Aplicar dos veces el mismo registro es idempotente (reintentos de
+   * drenado tras un publish fallido).
+   */
+  bool decode(const uint8_t *data, size_t len, TelemetrySnapshot &out,
+              SnapshotRecordTime &time);
+
+  void reset() {
+    _state = TelemetrySnapshot();
+    _usable = 0;
+    _customUsable[0] = _customUsable[1] = 0;
+    _legacy = false;
+  }
+
+private:
+  void applyQuality(TelemetrySnapshot &snap) const;
+
+  TelemetrySnapshot _state;
+  uint32_t _usable = 0;             ///< Canales utilizables (bit = ID)
+  uint32_t _customUsable[2] = {};   ///< Custom utilizables (bit = slot)
+  bool _legacy = false;             ///< Cadena sin máscaras de calidad
+};
+
+#endif // SNAPSHOT_RECORD_H
@@ -0,0 +1,73 @@
+/**
+ * @file can_decode.cpp
+ * @brief Compilación de planes de decodificación CAN
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "can_decode.h"
+
+bool compileDecodePlan(const SensorConfig &sensor, CanDecodePlan &plan) {
+  memset(&plan, 0, sizeof(plan));
+
+  uint8_t length = sensor.length;
+  if (length == 0 || length > 64) {
+    Serial.printf("[CONFIG] Sensor %s: invalid length %d\n", sensor.name,
+                  length);
+    return false;
+  }
+  if (sensor.is_float && length != 32) {
+    Serial.printf("[CONFIG] Sensor %s: float requires length 32\n",
+                  sensor.name);
+    return false;
+  }
+
+  // ================================================================
+  // Resolver el bit de inicio
+  // Configs antiguas (sin start_bit en el JSON, marcadas por
+  // jsonToSensors) describen un campo alineado a byte que empieza en
+  // start_byte: Intel con LSB en su bit 0, Motorola con MSB en su bit 7.
+  // Con start_bit presente manda siempre la semántica DBC.
+  // ================================================================
+  uint16_t startBit = sensor.start_bit;
+  if (sensor.byte_aligned) {
+    startBit = sensor.start_byte * 8 + (sensor.big_endian ? 7 : 0);
+  }
+
+  int lsbPos; // Posición del LSB en la palabra de 64 bits
+  int msbByte, lsbByte;
+
+  if (sensor.big_endian) {
+    // MSB en numeración DBC sawtooth
+    uint16_t msb = startBit;
+
+    // En la palabra big endian, el bit j del byte i está en (7-i)*8 + j
+    int msbPos = (7 - msb / 8) * 8 + (msb % 8);
+    lsbPos = msbPos - (length - 1);
+    msbByte = msb / 8;
+    lsbByte = 7 - (lsbPos >= 0 ? lsbPos / 8 : 0);
+  } else {
+    lsbPos = startBit;
+    msbByte = (lsbPos + length - 1) / 8;
+    lsbByte = lsbPos / 8;
+  }
+
+  if (lsbPos < 0 || lsbPos + length > 64) {
+    Serial.printf("[CONFIG] Sensor %s: signal does not fit in 8 bytes\n",
+                  sensor.name);
+    return false;
+  }
+
+  plan.shift = (uint8_t)lsbPos;
+  plan.mask = (length >= 64) ? ~0ULL : ((1ULL << length) - 1);
+  plan.signShift = 64 - length;
+  plan.minLen = (uint8_t)((msbByte > lsbByte ? msbByte : lsbByte) + 1);
+  plan.bigEndian = sensor.big_endian;
+  plan.isSigned = sensor.signed_val;
+  plan.isFloat = sensor.is_float;
+  plan.scale = sensor.multiplier;
+  plan.offset = sensor.offset;
+  plan.valid = true;
+  return true;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file can_decode.h
+ * @brief Planes de decodificación de señales CAN precompilados
+ *
+ * Cada SensorConfig se traduce una sola vez (al cargar sensores) a un
+ * CanDecodePlan: desplazamiento, máscara, orden de bytes, extensión de
+ * signo y escala ya resueltos. En el camino caliente solo queda cargar
+ * la trama como entero de 64 bits, desplazar y enmascarar.
+ *
+ * Numeración de bits (semántica DBC):
+ *   - Intel (little endian): start_bit = LSB, bit = byte*8 + bit_en_byte
+ *   - Motorola (big endian): start_bit = MSB en numeración "sawtooth"
+ *
+ * Compatibilidad con configs antiguas (solo start_byte, alineadas a
+ * byte): SensorConfig::byte_aligned, ver compileDecodePlan().
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef CAN_DECODE_H
+#define CAN_DECODE_H
+
+#include "config_schema.h"
+#include <Arduino.h>
+
+/**
+ * @struct CanDecodePlan
+ * @brief Receta de extracción de una señal
+ */
+struct CanDecodePlan {
+  uint64_t mask;     ///< (1 << length) - 1
+  float scale;       ///< Multiplicador
+  float offset;      ///< Adder
+  uint8_t shift;     ///< Posición del LSB en la palabra de 64 bits
+  uint8_t signShift; ///< 64 - length (extensión de signo)
+  uint8_t minLen;    ///< Bytes de trama necesarios
+  bool bigEndian;    ///< Cargar la trama como big endian (byte-swap)
+  bool isSigned;
+  bool isFloat; ///< IEEE754 float32 (length = 32)
+  bool valid;   ///< false si la config es incoherente (nunca decodifica)
+};
+
+/**
+ * @brief Compila la configuración de un sensor a un plan
+ * @param sensor Configuración
+ * @param plan Salida
+ * @return true si el plan es válido
+ */
+bool compileDecodePlan(const SensorConfig &sensor, CanDecodePlan &plan);
+
+/**
+ * @brief Decodifica una señal con su plan
+ * @param plan Plan compilado
+ * @param data Payload de la trama
+ * @param len DLC
+ * @param out Valor físico (raw * scale + offset)
+ * @return false si la trama es demasiado corta o el plan no es válido
+ */
+inline bool decodeWithPlan(const CanDecodePlan &plan, const uint8_t *data,
+                           uint8_t len, float &out) {
+  if (!plan.valid || len < plan.minLen)
+    return false;
+
+  // Cargar la trama completa como entero (bytes ausentes = 0)
+  uint64_t word = 0;
+  if (plan.bigEndian) {
+    for (uint8_t i = 0; i < len; i++) {
+      word |= (uint64_t)data[i] << (56 - i * 8);
+    }
+  } else {
+    for (uint8_t i = 0; i < len; i++) {
+      word |= (uint64_t)data[i] << (i * 8);
+    }
+  }
+
+  uint64_t raw = (word >> plan.shift) & plan.mask;
+
+  if (plan.isFloat) {
+    uint32_t bits = (uint32_t)raw;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    out = f * plan.scale + plan.offset;
+  } else if (plan.isSigned) {
+    int64_t s = (int64_t)(raw << plan.signShift) >> plan.signShift;
+    out = (float)s * plan.scale + plan.offset;
+  } else {
+    out = (float)raw * plan.scale + plan.offset;
+  }
+  return true;
+}
+
+#endif // CAN_DECODE_H
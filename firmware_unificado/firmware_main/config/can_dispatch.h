@@ -0,0 +1,204 @@
+/**
+ * @file can_dispatch.h
+ * @brief Índice CAN ID -> sensores para despacho O(1) de tramas
+ *
+ * Se construye una vez al cargar sensores (ConfigManager::jsonToSensors).
+ * Tabla hash de direccionamiento abierto (ocupación <= 50%) donde cada
+ * CAN ID apunta a un tramo contiguo de decodificadores (índice de sensor
+ * + plan precompilado), en el mismo orden en que aparecen en la
+ * configuración.
+ *
+ * La capacidad es un parámetro de plantilla: el firmware usa
+ * CanDispatchIndex (MAX_SENSORS); los benchmarks miden tablas mayores.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef CAN_DISPATCH_H
+#define CAN_DISPATCH_H
+
+#include "can_decode.h"
+#include "config_schema.h"
+#include <Arduino.h>
+#include <vector>
+
+/// Bits de la tabla hash: la menor potencia de 2 >= 2 * sensores
+constexpr uint32_t canDispatchBits(uint32_t sensors, uint32_t bits = 1) {
+  return (1u << bits) >= 2 * sensors ? bits
+                                     : canDispatchBits(sensors, bits + 1);
+}
+
+/**
+ * @struct CanDecoder
+ * @brief Sensor + plan de decodificación
+ */
+struct CanDecoder {
+  CanDecodePlan plan;
+  uint16_t sensor; ///< Índice en el vector de sensores
+};
+
+/**
+ * @class CanDispatchTable
+ * @brief Mapa can_id -> tramo de sensores habilitados
+ * @tparam MaxSensors Sensores indexables
+ */
+template <uint16_t MaxSensors> class CanDispatchTable {
+public:
+  static const uint32_t BITS = canDispatchBits(MaxSensors);
+  static const uint32_t BUCKETS = 1u << BITS;
+
+  CanDispatchTable() { clear(); }
+
+  /**
+   * @brief Reconstruye el índice con los sensores habilitados
+   * @param sensors Lista de sensores (los índices se refieren a ella)
+   */
+  void build(const std::vector<SensorConfig> &sensors);
+
+  /**
+   * @brief Vacía el índice (todas las tramas serán rechazadas)
+   */
+  void clear() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _idCount = 0;
+    _sensorCount = 0;
+    _generation = _generation + 1;
+  }
+
+  /**
+   * @brief Busca los decodificadores de un CAN ID
+   * @param canId ID recibido
+   * @param decoders Salida: tramo de decodificadores
+   * @param count Salida: número de decodificadores
+   * @return false si ningún sensor usa ese ID
+   */
+  bool lookup(uint32_t canId, const CanDecoder *&decoders,
+              uint16_t &count) const {
+    uint32_t slot = hash(canId);
+
+    // Ocupación <= 50%: la cadena termina en el primer bucket vacío
+    for (uint32_t probe = 0; probe < BUCKETS; probe++) {
+      const Bucket &b = _buckets[slot];
+      if (b.count == 0)
+        return false;
+      if (b.can_id == canId) {
+        decoders = &_decoders[b.first];
+        count = b.count;
+        return true;
+      }
+      slot = (slot + 1) & (BUCKETS - 1);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Número de CAN IDs distintos en el índice
+   */
+  uint16_t idCount() const { return _idCount; }
+
+  /**
+   * @brief Número de sensores indexados (habilitados y con plan válido)
+   */
+  uint16_t sensorCount() const { return _sensorCount; }
+
+  /**
+   * @brief Copia los CAN IDs distintos del índice
+   * @param out Array de salida
+   * @param maxCount Capacidad de out
+   * @return Número de IDs copiados
+   */
+  size_t getIds(uint32_t *out, size_t maxCount) const {
+    size_t n = 0;
+    for (uint32_t i = 0; i < BUCKETS && n < maxCount; i++) {
+      if (_buckets[i].count != 0) {
+        out[n++] = _buckets[i].can_id;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * @brief Contador que cambia cada vez que se reconstruye el índice
+   * (SourceCAN lo usa para recalcular los filtros hardware)
+   */
+  uint32_t generation() const { return _generation; }
+
+private:
+  struct Bucket {
+    uint32_t can_id;
+    uint16_t first; ///< Inicio del tramo en _decoders
+    uint16_t count; ///< 0 = bucket vacío
+  };
+
+  // Hash multiplicativo (Fibonacci): dispersa IDs consecutivos
+  static uint32_t hash(uint32_t canId) {
+    return (uint32_t)(canId * 2654435761u) >> (32 - BITS);
+  }
+
+  Bucket _buckets[BUCKETS];
+  CanDecoder _decoders[MaxSensors]; ///< Decodificadores agrupados por ID
+  uint16_t _idCount;
+  uint16_t _sensorCount;
+  volatile uint32_t _generation = 0;
+};
+
+template <uint16_t MaxSensors>
+void CanDispatchTable<MaxSensors>::build(
+    const std::vector<SensorConfig> &sensors) {
+  clear();
+
+  size_t total = sensors.size();
+  if (total > MaxSensors)
+    total = MaxSensors;
+
+  // Marcar sensores ya agrupados (el orden de configuración se conserva
+  // dentro de cada tramo)
+  bool grouped[MaxSensors] = {};
+
+  for (size_t i = 0; i < total; i++) {
+    if (grouped[i] || !sensors[i].enabled)
+      continue;
+
+    uint32_t canId = sensors[i].can_id;
+    uint16_t first = _sensorCount;
+
+    for (size_t j = i; j < total; j++) {
+      if (grouped[j] || !sensors[j].enabled || sensors[j].can_id != canId)
+        continue;
+      grouped[j] = true;
+
+      // Sensores con config incoherente no entran al índice
+      CanDecoder &dec = _decoders[_sensorCount];
+      if (compileDecodePlan(sensors[j], dec.plan)) {
+        dec.sensor = (uint16_t)j;
+        _sensorCount++;
+      }
+    }
+
+    if (_sensorCount == first)
+      continue; // Ningún plan válido para este ID
+
+    // Insertar en el primer bucket libre de la cadena
+    uint32_t slot = hash(canId);
+    while (_buckets[slot].count != 0) {
+      slot = (slot + 1) & (BUCKETS - 1);
+    }
+    _buckets[slot].can_id = canId;
+    _buckets[slot].first = first;
+    _buckets[slot].count = _sensorCount - first;
+    _idCount++;
+  }
+
+  // Segundo incremento: quien leyó el índice a medio construir (tras
+  // clear()) vuelve a ver un cambio cuando ya está completo
+  _generation = _generation + 1;
+
+  Serial.printf("[CONFIG] CAN dispatch index: %d IDs, %d sensors\n",
+                _idCount, _sensorCount);
+}
+
+/// Índice del firmware
+typedef CanDispatchTable<MAX_SENSORS> CanDispatchIndex;
+
+#endif // CAN_DISPATCH_H
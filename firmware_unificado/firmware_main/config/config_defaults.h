@@ -25,6 +25,9 @@
 #define DEFAULT_GPS_RX_PIN 16
 #define DEFAULT_GPS_TX_PIN 17
 #define DEFAULT_GPS_BAUD 9600
+#define DEFAULT_GPS_PPS_PIN -1 // Sin PPS cableado: hora solo por NMEA
+#define DEFAULT_GPS_UBX_BAUD 115200
+#define DEFAULT_GPS_UBX_RATE_HZ 10
 
 // IMU (I2C)
 #define DEFAULT_IMU_SDA_PIN 21
@@ -70,6 +73,7 @@
 
 #define DEFAULT_MQTT_PORT 1883
 #define DEFAULT_MQTT_TOPIC "vehicles/telemetry"
+#define DEFAULT_CLOUD_FORMAT PayloadFormat::JSON
 
 // ============================================================================
 // COMBUSTIBLE POR DEFECTO
@@ -79,6 +83,15 @@
 #define DEFAULT_VOLUMETRIC_EFF 0.85f
 #define DEFAULT_AIR_FUEL_RATIO 14.7f
 
+// ============================================================================
+// HISTORIAL DEL BUS POR DEFECTO
+// ============================================================================
+
+// Sin canales por defecto; p. ej. IMU a 100 Hz, 10 s por eje:
+// "imu.accel_x:1024,imu.accel_y:1024,imu.accel_z:1024"
+#define DEFAULT_HISTORY_BUDGET_KB 64
+#define DEFAULT_HISTORY_CHANNELS ""
+
 // ============================================================================
 // PIDs OBD2 POR DEFECTO
 // ============================================================================
@@ -91,6 +104,8 @@
 // 0x10 = MAF
 // 0x0B = Intake Manifold Pressure
 // BAT  = Battery Voltage
+// Sufijo opcional "@<Hz>" para cambiar la tasa objetivo del planificador
+// (ej: "0x0C@20,0x2F@0.1"); sin él se usa obdDefaultSchedule()
 
 // ============================================================================
 // FUNCIÓN PARA OBTENER CONFIGURACIÓN POR DEFECTO
@@ -128,6 +143,7 @@ inline UnifiedConfig getDefaultConfig() {
           sizeof(cfg.http.url) - 1);
   cfg.cloud_interval_ms = DEFAULT_CLOUD_INTERVAL_MS;
   cfg.debug_mode = false;
+  cfg.cloud_format = DEFAULT_CLOUD_FORMAT;
 
   // Serial
   cfg.serial_interval_ms = DEFAULT_SERIAL_INTERVAL_MS;
@@ -170,6 +186,16 @@ inline UnifiedConfig getDefaultConfig() {
   cfg.fuel.volumetric_efficiency = DEFAULT_VOLUMETRIC_EFF;
   cfg.fuel.air_fuel_ratio = DEFAULT_AIR_FUEL_RATIO;
 
+  // Historial
+  cfg.history.budget_kb = DEFAULT_HISTORY_BUDGET_KB;
+  strncpy(cfg.history.channels, DEFAULT_HISTORY_CHANNELS,
+          sizeof(cfg.history.channels) - 1);
+
+  cfg.gps_pps_pin = DEFAULT_GPS_PPS_PIN;
+  cfg.gps_ubx.enabled = false;
+  cfg.gps_ubx.baud = DEFAULT_GPS_UBX_BAUD;
+  cfg.gps_ubx.rate_hz = DEFAULT_GPS_UBX_RATE_HZ;
+
   return cfg;
 }
 
@@ -7,6 +7,9 @@
  */
 
 #include "config_manager.h"
+#include "../telemetry/telemetry_bus.h"
+#include <math.h>
+#include <stddef.h>
 
 // ============================================================================
 // INICIALIZACIÓN
@@ -40,21 +43,31 @@ bool ConfigManager::begin() {
 bool ConfigManager::loadFromPreferences() {
   size_t len = _prefs.getBytesLength(PREFS_KEY_CONFIG);
 
-  if (len == 0 || len != sizeof(UnifiedConfig)) {
+  // Se aceptan blobs de firmwares anteriores, más cortos, siempre que
+  // contengan al menos hasta el último campo histórico; los campos
+  // agregados al final conservan su valor por defecto.
+  const size_t minLen = offsetof(UnifiedConfig, cloud_format);
+  if (len < minLen || len > sizeof(UnifiedConfig)) {
     Serial.printf(
         "[CONFIG] Invalid or no config in Preferences (len=%d, expected=%d)\n",
         len, sizeof(UnifiedConfig));
     return false;
   }
 
-  size_t read =
-      _prefs.getBytes(PREFS_KEY_CONFIG, &_config, sizeof(UnifiedConfig));
+  _config = getDefaultConfig();
+  size_t read = _prefs.getBytes(PREFS_KEY_CONFIG, &_config, len);
 
-  if (read != sizeof(UnifiedConfig)) {
+  if (read != len) {
     Serial.println(F("[CONFIG] Failed to read config from Preferences"));
     return false;
   }
 
+  if (len < sizeof(UnifiedConfig)) {
+    Serial.printf("[CONFIG] Legacy config blob (%d bytes), new fields "
+                  "set to defaults\n",
+                  len);
+  }
+
   // Verificar versión
   if (strcmp(_config.version, CONFIG_VERSION) != 0) {
     Serial.printf("[CONFIG] Version mismatch: stored=%s, current=%s\n",
@@ -162,6 +175,7 @@ void ConfigManager::configToJson(JsonDocument &doc) {
       (_config.cloud_protocol == CloudProtocol::MQTT) ? "mqtt" : "http";
   cloud["interval_ms"] = _config.cloud_interval_ms;
   cloud["debug_mode"] = _config.debug_mode;
+  cloud["format"] = payloadFormatToString(_config.cloud_format);
 
   JsonObject mqtt = cloud["mqtt"].to<JsonObject>();
   mqtt["server"] = _config.mqtt.server;
@@ -209,6 +223,10 @@ void ConfigManager::configToJson(JsonDocument &doc) {
   gps["rx_pin"] = _config.gps.rx_pin;
   gps["tx_pin"] = _config.gps.tx_pin;
   gps["baud"] = _config.gps.baud;
+  gps["pps_pin"] = _config.gps_pps_pin;
+  gps["ubx"] = _config.gps_ubx.enabled;
+  gps["ubx_baud"] = _config.gps_ubx.baud;
+  gps["rate_hz"] = _config.gps_ubx.rate_hz;
 
   // IMU
   JsonObject imu = doc["imu"].to<JsonObject>();
@@ -222,6 +240,11 @@ void ConfigManager::configToJson(JsonDocument &doc) {
   fuel["displacement_l"] = _config.fuel.displacement_l;
   fuel["volumetric_efficiency"] = _config.fuel.volumetric_efficiency;
   fuel["air_fuel_ratio"] = _config.fuel.air_fuel_ratio;
+
+  // Historial (aplica al reiniciar)
+  JsonObject history = doc["history"].to<JsonObject>();
+  history["budget_kb"] = _config.history.budget_kb;
+  history["channels"] = _config.history.channels;
 }
 
 void ConfigManager::jsonToConfig(JsonDocument &doc) {
@@ -262,6 +285,8 @@ void ConfigManager::jsonToConfig(JsonDocument &doc) {
       _config.cloud_interval_ms = cloud["interval_ms"];
     if (cloud["debug_mode"])
       _config.debug_mode = cloud["debug_mode"];
+    if (cloud["format"])
+      _config.cloud_format = stringToPayloadFormat(cloud["format"]);
 
     if (cloud["mqtt"].is<JsonObject>()) {
       JsonObject mqtt = cloud["mqtt"];
@@ -358,6 +383,14 @@ void ConfigManager::jsonToConfig(JsonDocument &doc) {
       _config.gps.tx_pin = gps["tx_pin"];
     if (gps["baud"])
       _config.gps.baud = gps["baud"];
+    if (gps.containsKey("pps_pin"))
+      _config.gps_pps_pin = gps["pps_pin"];
+    if (gps.containsKey("ubx"))
+      _config.gps_ubx.enabled = gps["ubx"];
+    if (gps["ubx_baud"])
+      _config.gps_ubx.baud = gps["ubx_baud"];
+    if (gps["rate_hz"])
+      _config.gps_ubx.rate_hz = gps["rate_hz"];
   }
 
   // IMU
@@ -383,12 +416,50 @@ void ConfigManager::jsonToConfig(JsonDocument &doc) {
     if (fuel["air_fuel_ratio"])
       _config.fuel.air_fuel_ratio = fuel["air_fuel_ratio"];
   }
+
+  // Historial
+  if (doc["history"].is<JsonObject>()) {
+    JsonObject history = doc["history"];
+    if (history.containsKey("budget_kb"))
+      _config.history.budget_kb = history["budget_kb"];
+    if (history.containsKey("channels"))
+      strncpy(_config.history.channels, history["channels"] | "",
+              sizeof(_config.history.channels) - 1);
+  }
 }
 
 // ============================================================================
 // SENSORS JSON
 // ============================================================================
 
+// Alias cortos de cloud_id aceptados por configuraciones anteriores
+static const struct {
+  const char *alias;
+  TelemetryField field;
+} CLOUD_ID_ALIASES[] = {
+    {"rpm", TelemetryField::ENGINE_RPM},
+    {"speed", TelemetryField::ENGINE_SPEED},
+    {"temp", TelemetryField::ENGINE_COOLANT_TEMP},
+    {"tps", TelemetryField::ENGINE_THROTTLE},
+    {"fuel", TelemetryField::FUEL_LEVEL},
+    {"batt", TelemetryField::BATTERY_VOLTAGE},
+};
+
+// cloud_id -> campo estándar del bus (clave del esquema o alias)
+static bool mappedField(const char *cloudId, TelemetryField &field) {
+  if (cloudId == nullptr)
+    return false;
+  if (telemetryFieldByKey(cloudId, field))
+    return true;
+  for (const auto &a : CLOUD_ID_ALIASES) {
+    if (strcmp(cloudId, a.alias) == 0) {
+      field = a.field;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool ConfigManager::loadSensorsFromJson(const String &json) {
   JsonDocument doc;
   DeserializationError error = deserializeJson(doc, json);
@@ -398,8 +469,12 @@ bool ConfigManager::loadSensorsFromJson(const String &json) {
     return false;
   }
 
+  xSemaphoreTake(_sensorMutex, portMAX_DELAY);
   jsonToSensors(doc);
-  Serial.printf("[CONFIG] Loaded %d sensors from JSON\n", _sensors.size());
+  size_t count = _sensors.size();
+  xSemaphoreGive(_sensorMutex);
+
+  Serial.printf("[CONFIG] Loaded %d sensors from JSON\n", count);
   return true;
 }
 
@@ -426,18 +501,28 @@ void ConfigManager::sensorsToJson(JsonDocument &doc) {
     obj["cloud_id"] = sensor.cloud_id;
     obj["can_id"] = sensor.can_id;
     obj["start_byte"] = sensor.start_byte;
-    obj["start_bit"] = sensor.start_bit;
+    if (!sensor.byte_aligned)
+      obj["start_bit"] = sensor.start_bit;
     obj["length"] = sensor.length;
     obj["signed"] = sensor.signed_val;
+    if (sensor.is_float)
+      obj["float"] = true;
     obj["multiplier"] = sensor.multiplier;
     obj["offset"] = sensor.offset;
     obj["big_endian"] = sensor.big_endian;
     obj["enabled"] = sensor.enabled;
+    if (sensor.max_age_ms != 0)
+      obj["max_age_ms"] = sensor.max_age_ms;
+    if (!isnan(sensor.min_value))
+      obj["min"] = sensor.min_value;
+    if (!isnan(sensor.max_value))
+      obj["max"] = sensor.max_value;
   }
 }
 
 void ConfigManager::jsonToSensors(JsonDocument &doc) {
   _sensors.clear();
+  _canDispatch.clear();
 
   JsonArray arr = doc["sensors"].as<JsonArray>();
   if (!arr) {
@@ -464,52 +549,79 @@ void ConfigManager::jsonToSensors(JsonDocument &doc) {
       strncpy(sensor.cloud_id, obj["cloud_id"], sizeof(sensor.cloud_id) - 1);
     sensor.can_id = obj["can_id"] | 0;
     sensor.start_byte = obj["start_byte"] | 0;
-    sensor.start_bit = obj["start_bit"] | 0;
     sensor.length = obj["length"] | 8;
     sensor.signed_val = obj["signed"] | false;
+    sensor.is_float = obj["float"] | false;
     sensor.multiplier = obj["multiplier"] | 1.0f;
-    sensor.offset = obj["offset"] | 0.0f;
-    sensor.big_endian = obj["big_endian"] | false;
     sensor.enabled = obj["enabled"] | true;
 
+    // Calidad: antigüedad máxima y rango válido (opcionales)
+    sensor.max_age_ms = obj["max_age_ms"] | 0;
+    sensor.min_value = obj["min"] | NAN;
+    sensor.max_value = obj["max"] | NAN;
+
+    // Byte order: "big_endian" (firmware/UI) o "byte_order" (generador DBC)
+    if (obj.containsKey("big_endian")) {
+      sensor.big_endian = obj["big_endian"] | false;
+    } else {
+      const char *order = obj["byte_order"] | "little_endian";
+      sensor.big_endian = (strcmp(order, "big_endian") == 0);
+    }
+
+    // Adder: el generador DBC usa "offset" para el byte de inicio y
+    // "offset_value" para el offset físico
+    if (obj.containsKey("offset_value")) {
+      sensor.offset = obj["offset_value"] | 0.0f;
+    } else {
+      sensor.offset = obj["offset"] | 0.0f;
+    }
+
+    // Bit de inicio DBC. Si falta es una config antigua alineada a byte:
+    // se marca para que compileDecodePlan use start_byte y se deriva
+    // start_bit (Intel: LSB del byte, Motorola: MSB del byte)
+    sensor.byte_aligned = !obj.containsKey("start_bit");
+    if (sensor.byte_aligned) {
+      sensor.start_bit = sensor.start_byte * 8 + (sensor.big_endian ? 7 : 0);
+    } else {
+      sensor.start_bit = obj["start_bit"] | 0;
+    }
+
     // Runtime init
     sensor.value = 0;
     sensor.updated = false;
 
     // Detectar tipo de mapeo basado en cloud_id
+    sensor.map_type = SensorConfig::MappingType::CUSTOM;
     if (obj.containsKey("cloud_id")) {
-      const char *cid = obj["cloud_id"];
-      if (strcmp(cid, "engine.rpm") == 0 || strcmp(cid, "rpm") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_RPM;
-      else if (strcmp(cid, "engine.speed") == 0 || strcmp(cid, "speed") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_SPEED;
-      else if (strcmp(cid, "engine.coolant_temp") == 0 ||
-               strcmp(cid, "temp") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_COOLANT;
-      else if (strcmp(cid, "engine.oil_temp") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_OIL_TEMP;
-      else if (strcmp(cid, "engine.throttle") == 0 || strcmp(cid, "tps") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_THROTTLE;
-      else if (strcmp(cid, "engine.load") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_LOAD;
-      else if (strcmp(cid, "engine.maf") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_MAF;
-      else if (strcmp(cid, "engine.map") == 0)
-        sensor.map_type = SensorConfig::MappingType::ENGINE_MAP;
-      else if (strcmp(cid, "fuel.level") == 0 || strcmp(cid, "fuel") == 0)
-        sensor.map_type = SensorConfig::MappingType::FUEL_LEVEL;
-      else if (strcmp(cid, "fuel.rate") == 0)
-        sensor.map_type = SensorConfig::MappingType::FUEL_RATE;
-      else if (strcmp(cid, "battery.voltage") == 0 || strcmp(cid, "batt") == 0)
-        sensor.map_type = SensorConfig::MappingType::BATTERY_VOLT;
-      else
-        sensor.map_type = SensorConfig::MappingType::CUSTOM;
-    } else {
-      sensor.map_type = SensorConfig::MappingType::CUSTOM;
+      TelemetryField field;
+      if (mappedField(obj["cloud_id"], field))
+        sensor.map_type = SensorConfig::mappingFor(field);
+    }
+
+    // cloud_id internado una vez: SourceCAN escribe por slot, sin strings
+    sensor.bus_slot = TELEMETRY_NO_SLOT;
+    if (sensor.map_type == SensorConfig::MappingType::CUSTOM) {
+      sensor.bus_slot = TelemetryBus::getInstance().internKey(sensor.cloud_id);
+    }
+
+    // Frescura y rango del canal destino (campo del esquema o custom)
+    int16_t qualitySlot = sensor.bus_slot;
+    if (sensor.map_type != SensorConfig::MappingType::CUSTOM) {
+      qualitySlot = (int16_t)SensorConfig::fieldFor(sensor.map_type);
+    }
+    if (sensor.max_age_ms != 0) {
+      TelemetryBus::getInstance().setMaxAgeAt(qualitySlot, sensor.max_age_ms);
+    }
+    if (!isnan(sensor.min_value) || !isnan(sensor.max_value)) {
+      TelemetryBus::getInstance().setRangeAt(qualitySlot, sensor.min_value,
+                                             sensor.max_value);
     }
 
     _sensors.push_back(sensor);
   }
+
+  // Índice de despacho para SourceCAN::processFrame
+  _canDispatch.build(_sensors);
 }
 
 // ============================================================================
@@ -518,7 +630,10 @@ void ConfigManager::jsonToSensors(JsonDocument &doc) {
 
 void ConfigManager::resetToDefaults() {
   _config = getDefaultConfig();
+  xSemaphoreTake(_sensorMutex, portMAX_DELAY);
   _sensors.clear();
+  _canDispatch.clear();
+  xSemaphoreGive(_sensorMutex);
   Serial.println(F("[CONFIG] Reset to defaults"));
 }
 
@@ -533,6 +648,8 @@ void ConfigManager::printConfig() {
   Serial.printf("Cloud Protocol: %s\n",
                 (_config.cloud_protocol == CloudProtocol::MQTT) ? "MQTT"
                                                                 : "HTTP");
+  Serial.printf("Cloud Format: %s\n",
+                payloadFormatToString(_config.cloud_format));
   Serial.printf("Cloud Interval: %d ms\n", _config.cloud_interval_ms);
   Serial.printf("Debug Mode: %s\n", _config.debug_mode ? "YES" : "NO");
   Serial.println(F("---"));
@@ -541,10 +658,17 @@ void ConfigManager::printConfig() {
                 _config.can.int_pin, _config.can.baud_kbps);
   Serial.printf("OBD Enabled: %s (mode=%s)\n",
                 _config.obd.enabled ? "YES" : "NO", _config.obd.mode);
-  Serial.printf("GPS Enabled: %s (RX=%d, TX=%d)\n",
+  Serial.printf("GPS Enabled: %s (RX=%d, TX=%d, PPS=%d)\n",
                 _config.gps.enabled ? "YES" : "NO", _config.gps.rx_pin,
-                _config.gps.tx_pin);
+                _config.gps.tx_pin, _config.gps_pps_pin);
+  if (_config.gps_ubx.enabled) {
+    Serial.printf("GPS UBX: %lu baud @ %u Hz\n",
+                  (unsigned long)_config.gps_ubx.baud,
+                  _config.gps_ubx.rate_hz);
+  }
   Serial.printf("IMU Enabled: %s\n", _config.imu.enabled ? "YES" : "NO");
+  Serial.printf("History: %u KB [%s]\n", _config.history.budget_kb,
+                _config.history.channels);
   Serial.println(F("---"));
   Serial.printf("Sensors configured: %d\n", _sensors.size());
   Serial.println(F("=============================================\n"));
@@ -607,6 +731,18 @@ bool ConfigManager::validateConfig(String *errors) {
       errList += "GPS TX pin is Input-Only; ";
       valid = false;
     }
+    if (_config.gps_pps_pin < -1 || _config.gps_pps_pin > 39) {
+      errList += "GPS PPS pin invalid; ";
+      valid = false;
+    }
+    // NAV-PVT = 100 bytes por solución (10 bits por byte en 8N1)
+    if (_config.gps_ubx.enabled &&
+        (_config.gps_ubx.rate_hz < 1 || _config.gps_ubx.rate_hz > 25 ||
+         _config.gps_ubx.baud < 9600 || _config.gps_ubx.baud > 921600 ||
+         (uint32_t)_config.gps_ubx.rate_hz * 1000 > _config.gps_ubx.baud)) {
+      errList += "GPS UBX rate/baud invalid; ";
+      valid = false;
+    }
   }
 
   // === Validar pines IMU ===
@@ -648,7 +784,7 @@ bool ConfigManager::validateConfig(String *errors) {
 
   // === Validar MQTT port ===
   if (_config.cloud_protocol == CloudProtocol::MQTT) {
-    if (_config.mqtt.port == 0 || _config.mqtt.port > 65535) {
+    if (_config.mqtt.port == 0) {
       errList += "MQTT port invalid; ";
       valid = false;
     }
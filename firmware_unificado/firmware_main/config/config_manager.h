@@ -12,11 +12,14 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
+#include "can_dispatch.h"
 #include "config_defaults.h"
 #include "config_schema.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <vector>
 
 // Namespace para Preferences
@@ -93,6 +96,21 @@ public:
    */
   std::vector<SensorConfig> &getSensors() { return _sensors; }
 
+  /**
+   * @brief Índice CAN ID -> sensores (se reconstruye al cargar sensores)
+   * @return Referencia al índice de despacho
+   */
+  const CanDispatchIndex &getCanDispatch() const { return _canDispatch; }
+
+  /**
+   * @brief Mutex de los sensores y su índice de despacho
+   *
+   * loadSensorsFromJson() lo mantiene mientras reconstruye ambos
+   * (SET_SENSORS llega desde la tarea serial); SourceCAN lo toma para
+   * buscar, decodificar y actualizar cada trama.
+   */
+  SemaphoreHandle_t getSensorMutex() const { return _sensorMutex; }
+
   /**
    * @brief Carga definición de sensores desde JSON
    * @param json JSON con array de sensores
@@ -148,12 +166,14 @@ public:
   void printConfig();
 
 private:
-  ConfigManager() : _firstRun(true) {}
+  ConfigManager() : _firstRun(true), _sensorMutex(xSemaphoreCreateMutex()) {}
 
   UnifiedConfig _config;
   std::vector<SensorConfig> _sensors;
+  CanDispatchIndex _canDispatch;
   Preferences _prefs;
   bool _firstRun;
+  SemaphoreHandle_t _sensorMutex; ///< Protege _sensors y _canDispatch
 
   // Helpers internos
   void configToJson(JsonDocument &doc);
@@ -12,6 +12,7 @@
 #ifndef CONFIG_SCHEMA_H
 #define CONFIG_SCHEMA_H
 
+#include "../telemetry/telemetry_schema.h"
 #include <Arduino.h>
 
 // ============================================================================
@@ -46,6 +47,14 @@ enum class DataSource : uint8_t {
  */
 enum class CloudProtocol : uint8_t { MQTT = 0, HTTP = 1 };
 
+/**
+ * @brief Codificación de la trama cloud (ver cloud/binary_payload.h)
+ */
+enum class PayloadFormat : uint8_t {
+  JSON = 0,  ///< JSON {"s":{"clave":{"v":x}}} (compatible con todo)
+  BINARY = 1 ///< Binario v1 con IDs numéricos de canal (solo MQTT)
+};
+
 /**
  * @brief Método de cálculo de consumo de combustible
  */
@@ -68,39 +77,41 @@ struct SensorConfig {
   char name[32];      ///< Nombre del sensor (ej: "RPM")
   char cloud_id[32];  ///< ID para cloud (ej: "engine.rpm")
   uint32_t can_id;    ///< ID de la trama CAN
-  uint8_t start_byte; ///< Byte inicial (big endian)
-  uint8_t start_bit;  ///< Bit inicial (little endian)
+  uint8_t start_byte; ///< Byte inicial (configs alineadas a byte)
+  uint8_t start_bit;  ///< Bit inicial DBC (Intel: LSB, Motorola: MSB)
+  bool byte_aligned;  ///< JSON sin start_bit: campo que empieza en start_byte
   uint8_t length;     ///< Longitud en bits
   bool signed_val;    ///< Valor con signo
+  bool is_float;      ///< IEEE754 float32 (DBC SIG_VALTYPE_ 1)
   float multiplier;   ///< Multiplicador
   float offset;       ///< Offset (adder)
   bool big_endian;    ///< Byte order
   bool enabled;       ///< Habilitado para lectura
+  uint32_t max_age_ms; ///< Antigüedad máxima (0 = default del bus)
+  float min_value;     ///< Mínimo válido (NAN = sin límite)
+  float max_value;     ///< Máximo válido (NAN = sin límite)
 
   // Optimization (P1.5 - String Removal)
-  // Mapeo directo a TelemetryBus para evitar strcmp en cada frame
+  // Mapeo directo a TelemetryBus para evitar strcmp en cada frame:
+  // CUSTOM o un campo de TELEMETRY_SCHEMA (mismo orden que TelemetryField)
   enum class MappingType : uint8_t {
     CUSTOM = 0,
-    ENGINE_RPM,
-    ENGINE_SPEED,
-    ENGINE_COOLANT,
-    ENGINE_OIL_TEMP,
-    ENGINE_THROTTLE,
-    ENGINE_LOAD,
-    ENGINE_MAF,
-    ENGINE_MAP,
-    FUEL_LEVEL,
-    FUEL_RATE,
-    BATTERY_VOLT,
-    SUSP_FL,
-    SUSP_FR,
-    SUSP_RL,
-    SUSP_RR
+#define SENSOR_MAPPING_TYPE(ID, ...) ID,
+    TELEMETRY_SCHEMA(SENSOR_MAPPING_TYPE)
+#undef SENSOR_MAPPING_TYPE
   } map_type;
 
+  static constexpr MappingType mappingFor(TelemetryField field) {
+    return (MappingType)((uint8_t)field + 1);
+  }
+  static constexpr TelemetryField fieldFor(MappingType type) {
+    return (TelemetryField)((uint8_t)type - 1);
+  }
+
   // Runtime (no persistente)
   volatile float value;  ///< Valor actual
   volatile bool updated; ///< Flag de actualización
+  int16_t bus_slot;      ///< Slot de cloud_id en TelemetryBus (CUSTOM)
 };
 
 /**
@@ -183,6 +194,18 @@ struct GpsConfig {
   uint32_t baud; ///< Velocidad (default: 9600)
 };
 
+/**
+ * @brief Modo binario UBX para receptores u-blox (solo NAV-PVT)
+ *
+ * Se configura al arranque desde gps.baud; si el receptor no lo confirma,
+ * SourceGPS sigue en NMEA.
+ */
+struct GpsUbxConfig {
+  bool enabled;
+  uint32_t baud;   ///< Velocidad UBX (default: 115200)
+  uint8_t rate_hz; ///< Soluciones por segundo, 1..25 (default: 10)
+};
+
 /**
  * @brief Configuración IMU (MPU6050)
  */
@@ -192,6 +215,16 @@ struct ImuConfig {
   int8_t scl_pin; ///< Pin SCL (default: 22)
 };
 
+/**
+ * @brief Historial de alta frecuencia del TelemetryBus
+ *
+ * Se aplica al arranque (la memoria se reserva una sola vez).
+ */
+struct HistoryConfig {
+  uint16_t budget_kb; ///< Memoria máxima para todos los rings
+  char channels[MAX_PIDS_STRING]; ///< "clave:muestras,..." ("" = sin historial)
+};
+
 /**
  * @brief Configuración unificada del sistema
  */
@@ -225,6 +258,13 @@ struct UnifiedConfig {
   GpsConfig gps;
   ImuConfig imu;
   FuelConfig fuel;
+
+  // Agregado al final: los blobs guardados sin este campo siguen siendo
+  // válidos (ver ConfigManager::loadFromPreferences)
+  PayloadFormat cloud_format;
+  HistoryConfig history;
+  int8_t gps_pps_pin; ///< PPS del GPS para la hora UTC (-1 = no cableado)
+  GpsUbxConfig gps_ubx;
 };
 
 // ============================================================================
@@ -303,4 +343,20 @@ inline FuelMethod stringToFuelMethod(const char *str) {
   return FuelMethod::AUTO;
 }
 
+/**
+ * @brief Convierte PayloadFormat a string ("json" / "binary")
+ */
+inline const char *payloadFormatToString(PayloadFormat format) {
+  return (format == PayloadFormat::BINARY) ? "binary" : "json";
+}
+
+/**
+ * @brief Convierte string a PayloadFormat (JSON si no se reconoce)
+ */
+inline PayloadFormat stringToPayloadFormat(const char *str) {
+  if (strcasecmp(str, "binary") == 0)
+    return PayloadFormat::BINARY;
+  return PayloadFormat::JSON;
+}
+
 #endif // CONFIG_SCHEMA_H
@@ -18,6 +18,7 @@
 
 // === Telemetry Bus ===
 #include "telemetry/telemetry_bus.h"
+#include "telemetry/telemetry_clock.h"
 
 // === Data Sources ===
 #include "sources/source_can.h"
@@ -55,6 +56,9 @@ static SourceCAN *sourceCan = nullptr;
 static SourceOBDDirect *sourceObdDirect = nullptr;
 static SourceOBDBridge *sourceObdBridge = nullptr;
 
+// Suscripción del LED de actividad a valores custom/genéricos del bus
+static int8_t activitySub = TELEMETRY_NO_SUBSCRIBER;
+
 // ============================================================================
 // PROTOTIPOS
 // ============================================================================
@@ -107,6 +111,15 @@ void setup() {
   Serial.println(F("[MAIN] Initializing TelemetryBus..."));
   TelemetryBus::getInstance().begin();
 
+  // Rings de historial: se reservan antes de que escriban las fuentes
+  auto &cfg = ConfigManager::getInstance().getConfig();
+  TelemetryBus::getInstance().beginHistory(
+      cfg.history.channels, (size_t)cfg.history.budget_kb * 1024);
+
+  // Solo consulta: loop() ya corre cada 10 ms por Serial y LEDs
+  activitySub = TelemetryBus::getInstance().subscribe(TELEMETRY_CH_CUSTOM |
+                                                      TELEMETRY_CH_GENERIC);
+
   // === 5. Inicializar fuentes de datos ===
   Serial.println(F("[MAIN] Initializing data sources..."));
   initSources();
@@ -145,11 +158,11 @@ void loop() {
   ledObd.update();
 
   // === System LED Logic (Activity Monitor - using WIFI/SYSTEM LED) ===
-  // Si hay datos nuevos en TelemetryBus, parpadear CAN LED (Activity)
-  if (TelemetryBus::getInstance().countUpdated() > 0) {
+  // Si hay datos nuevos en TelemetryBus, parpadear CAN LED (Activity).
+  // takeDirty() es propio de esta suscripción: no toca los flags "updated"
+  // ni compite con otros consumidores
+  if (TelemetryBus::getInstance().takeDirty(activitySub) != 0) {
     ledCan.flash(); // Flash en cada ciclo con datos nuevos
-    TelemetryBus::getInstance()
-        .clearUpdatedFlags(); // Limpiar flags para detectar nuevos prox ciclo
   } else {
     // Si no hay datos, heartbeat lento en System LED
     ledWifi.setPattern(StatusLed::HEARTBEAT);
@@ -167,12 +180,13 @@ void loop() {
   }
 
   // === GPS/OBD LED Logic ===
-  TelemetrySnapshot snap;
-  TelemetryBus::getInstance().getSnapshot(snap);
+  // Solo el campo gps.fix: copiar el snapshot completo cada 10 ms es caro
+  float gpsFix = 0;
+  TelemetryBus::getInstance().getLatest(TelemetryKeys::GPS_FIX, gpsFix);
 
   // Usamos el LED OBD (Pin 14) para indicar GPS Fix si no tenemos OBD activo
   // O podemos alternar si tenemos OBD. Por simplicidad, GPS Fix ON.
-  if (snap.gps_fix) {
+  if (gpsFix != 0) {
     ledObd.setPattern(StatusLed::ON);
   } else {
     ledObd.setPattern(StatusLed::OFF);
@@ -372,6 +386,10 @@ void printSystemStatus() {
 
   Serial.println(F("---"));
 
+  // Hora UTC (GPS / NTP)
+  TelemetryClock::getInstance().printStatus();
+  Serial.println(F("---"));
+
   // Memory
   Serial.printf("Free Heap: %lu bytes\n", ESP.getFreeHeap());
   Serial.printf("Min Free Heap: %lu bytes\n", ESP.getMinFreeHeap());
@@ -0,0 +1,191 @@
+/**
+ * @file Arduino.h
+ * @brief Shim mínimo del core Arduino-ESP32 para el entorno native
+ *
+ * Solo lo que usan los módulos compilados en env:native (TelemetryBus,
+ * decodificación CAN, tramas cloud, buffer offline): tiempo, Serial,
+ * String y ESP. Sin hardware: pines, WiFi e interrupciones no existen.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F(x) (x)
+#define PROGMEM
+#define IRAM_ATTR
+
+using std::max;
+using std::min;
+
+// ============================================================================
+// TIEMPO (reloj monotónico del host)
+// ============================================================================
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// ============================================================================
+// STRING
+// ============================================================================
+
+/**
+ * @class String
+ * @brief Subconjunto de Arduino String sobre std::string
+ */
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned int v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { format(v, decimals); }
+  String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+  const char *c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  void reserve(unsigned int n) { _s.reserve(n); }
+
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  bool operator==(const String &o) const { return _s == o._s; }
+  bool operator==(const char *o) const { return _s == (o ? o : ""); }
+  bool operator!=(const String &o) const { return _s != o._s; }
+  bool operator<(const String &o) const { return _s < o._s; }
+
+  String &operator+=(const String &o) {
+    _s += o._s;
+    return *this;
+  }
+  String &operator+=(const char *o) {
+    _s += o ? o : "";
+    return *this;
+  }
+  String &operator+=(char c) {
+    _s += c;
+    return *this;
+  }
+  friend String operator+(String a, const String &b) { return a += b; }
+
+  bool equals(const String &o) const { return _s == o._s; }
+  bool equalsIgnoreCase(const String &o) const {
+    return strcasecmp(_s.c_str(), o._s.c_str()) == 0;
+  }
+  bool startsWith(const String &p) const { return _s.rfind(p._s, 0) == 0; }
+  bool endsWith(const String &p) const {
+    return _s.size() >= p._s.size() &&
+           _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t i = _s.find(c, from);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  int indexOf(const String &s, unsigned int from = 0) const {
+    size_t i = _s.find(s._s, from);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  String substring(unsigned int from) const {
+    return from < _s.size() ? String(_s.substr(from)) : String();
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from >= _s.size() || to <= from)
+      return String();
+    return String(_s.substr(from, to - from));
+  }
+  void trim() {
+    size_t a = _s.find_first_not_of(" \t\r\n");
+    size_t b = _s.find_last_not_of(" \t\r\n");
+    _s = (a == std::string::npos) ? "" : _s.substr(a, b - a + 1);
+  }
+  void toUpperCase() {
+    for (auto &c : _s)
+      c = (char)toupper((unsigned char)c);
+  }
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(_s.c_str(), nullptr); }
+
+private:
+  void format(double v, unsigned int decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    _s = buf;
+  }
+
+  std::string _s;
+};
+
+// ============================================================================
+// SERIAL (stdout; setQuiet(true) lo silencia en benchmarks)
+// ============================================================================
+
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+  void setQuiet(bool quiet) { _quiet = quiet; }
+
+  // Sin atributo format: el firmware usa %lu con uint32_t (unsigned long en
+  // el ESP32, unsigned int en x86-64)
+  int printf(const char *fmt, ...);
+  size_t print(const String &s) { return out(s.c_str()); }
+  size_t print(const char *s) { return out(s); }
+  size_t println(const String &s) { return out(s.c_str()) + out("\n"); }
+  size_t println(const char *s) { return out(s) + out("\n"); }
+  size_t println() { return out("\n"); }
+  template <typename T> size_t print(T v) { return print(String(v)); }
+  template <typename T> size_t println(T v) { return println(String(v)); }
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() { fflush(stdout); }
+
+private:
+  size_t out(const char *s);
+  bool _quiet = false;
+};
+
+extern HardwareSerial Serial;
+
+// ============================================================================
+// ESP (métricas del sistema)
+// ============================================================================
+
+class EspClass {
+public:
+  uint32_t getFreeHeap() { return 256 * 1024; }
+  uint32_t getHeapSize() { return 320 * 1024; }
+  uint32_t getMinFreeHeap() { return 256 * 1024; }
+  uint32_t getFreePsram() { return 0; }
+};
+
+extern EspClass ESP;
+
+uint32_t esp_random();
+
+// Sin PSRAM en el host: ps_malloc cae al heap normal
+inline bool psramFound() { return false; }
+inline void *ps_malloc(size_t size) { return malloc(size); }
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,90 @@
+/**
+ * @file LittleFS.h
+ * @brief LittleFS en memoria para el entorno native
+ *
+ * Mismo subconjunto de fs::FS/fs::File que usa FlashLog. Los archivos
+ * viven en RAM del proceso: una instancia nueva de FlashLog sobre el mismo
+ * LittleFS simula un reinicio. format() vacía todo entre tests.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct NativeFileData;
+
+/**
+ * @class File
+ * @brief Handle de archivo o directorio (copiable, como fs::File)
+ */
+class File {
+public:
+  File() {}
+
+  explicit operator bool() const { return _data != nullptr || _isDir; }
+
+  size_t write(const uint8_t *buf, size_t len);
+  size_t read(uint8_t *buf, size_t len);
+  bool seek(uint32_t pos);
+  size_t position() const { return _pos; }
+  size_t size() const;
+  void close();
+
+  const char *name() const { return _name.c_str(); }
+  bool isDirectory() const { return _isDir; }
+  File openNextFile();
+
+private:
+  friend class LittleFSFS;
+
+  std::shared_ptr<NativeFileData> _data;
+  std::string _name;
+  size_t _pos = 0;
+  bool _isDir = false;
+  std::vector<std::string> _entries; ///< Hijos (solo directorios)
+  size_t _next = 0;
+};
+
+/**
+ * @class LittleFSFS
+ * @brief Filesystem en memoria con capacidad fija
+ */
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false, const char *basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char *label = "spiffs");
+  void end() {}
+  bool format();
+
+  File open(const char *path, const char *mode = "r");
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool mkdir(const char *path);
+
+  size_t totalBytes() { return _totalBytes; }
+  size_t usedBytes();
+
+  // === Solo native (tests) ===
+  void setTotalBytes(size_t bytes) { _totalBytes = bytes; }
+  void setMountFails(bool fail) { _mountFails = fail; }
+  /// La próxima escritura acepta solo n bytes (escritura cortada)
+  void failNextWriteAfter(long n) { _failWriteAfter = n; }
+
+private:
+  friend class File;
+
+  size_t _totalBytes = 1408 * 1024; ///< Partición "spiffs" de default.csv
+  bool _mountFails = false;
+  long _failWriteAfter = -1;
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // NATIVE_LITTLEFS_H
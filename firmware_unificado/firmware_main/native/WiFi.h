@@ -0,0 +1,22 @@
+/**
+ * @file WiFi.h
+ * @brief WiFi siempre desconectado (entorno native)
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+class WiFiClass {
+public:
+  bool isConnected() { return false; }
+  int8_t RSSI() { return 0; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
@@ -0,0 +1,16 @@
+/**
+ * @file esp_timer.h
+ * @brief esp_timer_get_time() sobre el reloj monotónico (entorno native)
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <cstdint>
+
+int64_t esp_timer_get_time();
+
+#endif // NATIVE_ESP_TIMER_H
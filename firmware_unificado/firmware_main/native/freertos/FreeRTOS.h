@@ -0,0 +1,45 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Tipos y macros de FreeRTOS para el entorno native
+ *
+ * Un tick = 1 ms (configTICK_RATE_HZ del ESP32 Arduino). Las secciones
+ * críticas (portMUX) son un mutex recursivo del host.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <cstdint>
+#include <mutex>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configASSERT(x)                                                        \
+  do {                                                                         \
+    if (!(x))                                                                  \
+      abort();                                                                 \
+  } while (0)
+
+typedef std::recursive_mutex portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED                                           \
+  {}
+#define portENTER_CRITICAL(mux) (mux)->lock()
+#define portEXIT_CRITICAL(mux) (mux)->unlock()
+#define portENTER_CRITICAL_ISR(mux) (mux)->lock()
+#define portEXIT_CRITICAL_ISR(mux) (mux)->unlock()
+
+#include "task.h"
+
+#endif // NATIVE_FREERTOS_H
@@ -0,0 +1,454 @@
+/**
+ * @file native_shims.cpp
+ * @brief Implementación de los shims Arduino/FreeRTOS del entorno native
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <esp_timer.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+LittleFSFS LittleFS;
+
+// ============================================================================
+// TIEMPO
+// ============================================================================
+
+namespace {
+const auto bootTime = std::chrono::steady_clock::now();
+
+int64_t elapsedUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime)
+      .count();
+}
+} // namespace
+
+uint32_t millis() { return (uint32_t)(elapsedUs() / 1000); }
+uint32_t micros() { return (uint32_t)elapsedUs(); }
+int64_t esp_timer_get_time() { return elapsedUs(); }
+
+uint32_t esp_random() {
+  static std::random_device rd;
+  return rd();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+int HardwareSerial::printf(const char *fmt, ...) {
+  if (_quiet)
+    return 0;
+  va_list args;
+  va_start(args, fmt);
+  int n = vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+size_t HardwareSerial::out(const char *s) {
+  if (_quiet || s == nullptr)
+    return 0;
+  return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+}
+
+// ============================================================================
+// FREERTOS: TAREAS
+// ============================================================================
+
+struct NativeTask {
+  TaskFunction_t fn = nullptr;
+  void *param = nullptr;
+
+  // Notificación directa
+  std::mutex notifyMutex;
+  std::condition_variable notifyCv;
+  uint32_t notifyValue = 0;
+  bool notifyPending = false;
+};
+
+namespace {
+std::atomic<UBaseType_t> taskCount{1}; // loop() de Arduino
+
+struct TaskExit {};
+
+thread_local NativeTask *currentTask = nullptr;
+
+// Espera con timeout en ticks (portMAX_DELAY = sin límite)
+template <typename Pred>
+bool waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+             TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(
+      lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred);
+}
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *,
+                                   uint32_t, void *param, UBaseType_t,
+                                   TaskHandle_t *handle, BaseType_t) {
+  NativeTask *task = new NativeTask();
+  task->fn = fn;
+  task->param = param;
+  taskCount++;
+  std::thread([task]() {
+    currentTask = task;
+    try {
+      task->fn(task->param);
+    } catch (const TaskExit &) {
+    }
+    taskCount--;
+    delete task;
+  }).detach();
+  if (handle)
+    *handle = task;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stackDepth, void *param, UBaseType_t priority,
+                       TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority,
+                                 handle, 0);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr) {
+    // Desenrolla hasta el wrapper del hilo
+    throw TaskExit();
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    std::this_thread::yield();
+  } else {
+    delay(ticks * portTICK_PERIOD_MS);
+  }
+}
+
+TickType_t xTaskGetTickCount() { return millis() / portTICK_PERIOD_MS; }
+UBaseType_t uxTaskGetNumberOfTasks() { return taskCount; }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+void taskYIELD() { std::this_thread::yield(); }
+
+// ============================================================================
+// FREERTOS: NOTIFICACIONES DE TAREA
+// ============================================================================
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (currentTask == nullptr) {
+    // Hilo adoptado: vive lo que vive el hilo
+    static thread_local NativeTask adopted;
+    currentTask = &adopted;
+  }
+  return currentTask;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+                       eNotifyAction action) {
+  if (task == nullptr)
+    return pdFAIL;
+
+  std::lock_guard<std::mutex> lock(task->notifyMutex);
+  switch (action) {
+  case eNoAction:
+    break;
+  case eSetBits:
+    task->notifyValue |= value;
+    break;
+  case eIncrement:
+    task->notifyValue++;
+    break;
+  case eSetValueWithOverwrite:
+    task->notifyValue = value;
+    break;
+  case eSetValueWithoutOverwrite:
+    if (task->notifyPending)
+      return pdFAIL;
+    task->notifyValue = value;
+    break;
+  }
+  task->notifyPending = true;
+  task->notifyCv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit,
+                           uint32_t *value, TickType_t ticks) {
+  NativeTask *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->notifyMutex);
+
+  if (!task->notifyPending)
+    task->notifyValue &= ~clearOnEntry;
+
+  bool got = waitFor(task->notifyCv, lock, ticks,
+                     [task] { return task->notifyPending; });
+  if (value)
+    *value = task->notifyValue;
+  if (!got)
+    return pdFALSE;
+
+  task->notifyValue &= ~clearOnExit;
+  task->notifyPending = false;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  NativeTask *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->notifyMutex);
+
+  waitFor(task->notifyCv, lock, ticks,
+          [task] { return task->notifyValue != 0; });
+  uint32_t value = task->notifyValue;
+  if (value != 0)
+    task->notifyValue = clearOnExit ? 0 : value - 1;
+  task->notifyPending = false;
+  return value;
+}
+
+// ============================================================================
+// FREERTOS: EVENT GROUPS
+// ============================================================================
+
+struct NativeEventGroup {
+  std::mutex mutex;
+  std::condition_variable cv;
+  EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate() { return new NativeEventGroup(); }
+
+void vEventGroupDelete(EventGroupHandle_t group) { delete group; }
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+  std::lock_guard<std::mutex> lock(group->mutex);
+  group->bits |= bits;
+  group->cv.notify_all();
+  return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+  std::lock_guard<std::mutex> lock(group->mutex);
+  EventBits_t before = group->bits;
+  group->bits &= ~bits;
+  return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+  std::lock_guard<std::mutex> lock(group->mutex);
+  return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clearOnExit, BaseType_t waitForAll,
+                                TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(group->mutex);
+  auto ready = [group, bits, waitForAll] {
+    return waitForAll ? (group->bits & bits) == bits
+                      : (group->bits & bits) != 0;
+  };
+
+  bool got = waitFor(group->cv, lock, ticks, ready);
+  EventBits_t result = group->bits;
+  if (got && clearOnExit)
+    group->bits &= ~bits;
+  return result;
+}
+
+// ============================================================================
+// FREERTOS: MUTEX
+// ============================================================================
+
+struct NativeSemaphore {
+  std::timed_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new NativeSemaphore(); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  if (sem == nullptr)
+    return pdFALSE;
+  if (ticks == portMAX_DELAY) {
+    sem->mutex.lock();
+    return pdTRUE;
+  }
+  return sem->mutex.try_lock_for(
+             std::chrono::milliseconds(ticks * portTICK_PERIOD_MS))
+             ? pdTRUE
+             : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  if (sem == nullptr)
+    return pdFALSE;
+  sem->mutex.unlock();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
+
+// ============================================================================
+// LITTLEFS EN MEMORIA
+// ============================================================================
+
+struct NativeFileData {
+  std::vector<uint8_t> bytes;
+};
+
+namespace {
+std::map<std::string, std::shared_ptr<NativeFileData>> fsFiles;
+std::set<std::string> fsDirs = {"/"};
+} // namespace
+
+bool LittleFSFS::begin(bool, const char *, uint8_t, const char *) {
+  return !_mountFails;
+}
+
+bool LittleFSFS::format() {
+  fsFiles.clear();
+  fsDirs = {"/"};
+  return true;
+}
+
+File LittleFSFS::open(const char *path, const char *mode) {
+  File f;
+  std::string p(path);
+
+  if (fsDirs.count(p)) {
+    f._isDir = true;
+    f._name = p;
+    std::string prefix = (p == "/") ? "/" : p + "/";
+    for (const auto &kv : fsFiles) {
+      const std::string &name = kv.first;
+      if (name.rfind(prefix, 0) == 0 &&
+          name.find('/', prefix.size()) == std::string::npos) {
+        f._entries.push_back(name);
+      }
+    }
+    return f;
+  }
+
+  auto it = fsFiles.find(p);
+  if (mode[0] == 'r') {
+    if (it == fsFiles.end())
+      return f;
+    f._data = it->second;
+  } else {
+    if (it == fsFiles.end()) {
+      it = fsFiles.emplace(p, std::make_shared<NativeFileData>()).first;
+    }
+    f._data = it->second;
+    if (mode[0] == 'w')
+      f._data->bytes.clear();
+    f._pos = f._data->bytes.size();
+  }
+  f._name = p;
+  return f;
+}
+
+bool LittleFSFS::exists(const char *path) {
+  return fsDirs.count(path) || fsFiles.count(path);
+}
+
+bool LittleFSFS::remove(const char *path) { return fsFiles.erase(path) > 0; }
+
+bool LittleFSFS::mkdir(const char *path) {
+  fsDirs.insert(path);
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t used = 0;
+  for (const auto &kv : fsFiles) {
+    used += kv.second->bytes.size();
+  }
+  return used;
+}
+
+size_t File::write(const uint8_t *buf, size_t len) {
+  if (!_data)
+    return 0;
+
+  size_t n = len;
+  if (LittleFS._failWriteAfter >= 0) {
+    n = std::min(len, (size_t)LittleFS._failWriteAfter);
+    LittleFS._failWriteAfter = -1;
+  }
+  size_t used = LittleFS.usedBytes();
+  if (used + n > LittleFS._totalBytes) {
+    n = LittleFS._totalBytes > used ? LittleFS._totalBytes - used : 0;
+  }
+
+  auto &bytes = _data->bytes;
+  if (_pos > bytes.size())
+    bytes.resize(_pos);
+  size_t overlap = std::min(n, bytes.size() - _pos);
+  if (overlap > 0)
+    memcpy(bytes.data() + _pos, buf, overlap);
+  bytes.insert(bytes.end(), buf + overlap, buf + n);
+  _pos += n;
+  return n;
+}
+
+size_t File::read(uint8_t *buf, size_t len) {
+  if (!_data || _pos >= _data->bytes.size())
+    return 0;
+  size_t n = std::min(len, _data->bytes.size() - _pos);
+  memcpy(buf, _data->bytes.data() + _pos, n);
+  _pos += n;
+  return n;
+}
+
+bool File::seek(uint32_t pos) {
+  if (!_data || pos > _data->bytes.size())
+    return false;
+  _pos = pos;
+  return true;
+}
+
+size_t File::size() const { return _data ? _data->bytes.size() : 0; }
+
+void File::close() {
+  _data.reset();
+  _isDir = false;
+  _entries.clear();
+}
+
+File File::openNextFile() {
+  if (!_isDir || _next >= _entries.size())
+    return File();
+  return LittleFS.open(_entries[_next++].c_str(), "r");
+}
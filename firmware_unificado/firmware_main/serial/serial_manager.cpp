@@ -10,8 +10,36 @@
 #include "../cloud/cloud_manager.h"
 #include "../config/config_manager.h"
 #include "../telemetry/telemetry_bus.h"
+#include "../telemetry/telemetry_clock.h"
 #include <ArduinoJson.h>
 
+// ============================================================================
+// CAMPOS DEL ESQUEMA
+// ============================================================================
+
+// Condición de envío de un campo en el stream LIVE: calidad del bus
+// (fresco y en rango) en lugar de heurísticas por grupo sobre el valor
+static bool liveFieldActive(const TelemetrySnapshot &snapshot,
+                            TelemetryField field) {
+  return snapshot.usable(field);
+}
+
+// Valor de un campo del esquema con el tipo JSON de su TelemetryFieldType
+static void setJsonField(JsonVariant dst, TelemetryFieldType type,
+                         float value) {
+  switch (type) {
+  case TelemetryFieldType::UINT8:
+    dst.set((unsigned)value);
+    break;
+  case TelemetryFieldType::FLAG:
+    dst.set(value != 0);
+    break;
+  default:
+    dst.set(value);
+    break;
+  }
+}
+
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
@@ -57,7 +85,7 @@ void SerialManager::process() {
         _bufferIndex = 0;
         memset(_buffer, 0, sizeof(_buffer));
       }
-    } else if (_bufferIndex < sizeof(_buffer) - 1) {
+    } else if (_bufferIndex < (int)sizeof(_buffer) - 1) {
       _buffer[_bufferIndex++] = c;
     }
   }
@@ -90,6 +118,8 @@ void SerialManager::processCommand(const String &cmd) {
     handleGetSensors();
   } else if (cmd.equalsIgnoreCase("GET_DIAG")) {
     handleGetDiag();
+  } else if (cmd.equalsIgnoreCase("BENCH_PAYLOAD")) {
+    handleBenchPayload();
   } else if (cmd.equalsIgnoreCase("REBOOT")) {
     handleReboot();
   } else if (cmd.equalsIgnoreCase("FACTORY_RESET")) {
@@ -184,28 +214,16 @@ void SerialManager::handleGetStatus() {
 }
 
 void SerialManager::handleGetTelemetry() {
-  // Usar el mismo builder del CloudManager
   TelemetrySnapshot snapshot;
   TelemetryBus::getInstance().getSnapshot(snapshot);
 
+  // Todos los campos del esquema, con su clave del bus ("engine.rpm")
   JsonDocument doc;
-
-  doc["gps_lat"] = snapshot.gps_lat;
-  doc["gps_lng"] = snapshot.gps_lng;
-  doc["gps_speed"] = snapshot.gps_speed;
-  doc["gps_fix"] = snapshot.gps_fix;
-
-  doc["rpm"] = snapshot.engine_rpm;
-  doc["speed"] = snapshot.engine_speed;
-  doc["coolant"] = snapshot.engine_coolant_temp;
-  doc["throttle"] = snapshot.engine_throttle;
-
-  doc["accel_x"] = snapshot.imu_accel_x;
-  doc["accel_y"] = snapshot.imu_accel_y;
-  doc["accel_z"] = snapshot.imu_accel_z;
-
-  doc["battery"] = snapshot.battery_voltage;
-  doc["fuel_level"] = snapshot.fuel_level;
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    setJsonField(doc[TELEMETRY_FIELDS[i].key].to<JsonVariant>(),
+                 TELEMETRY_FIELDS[i].type,
+                 telemetryFieldGet(snapshot, (TelemetryField)i));
+  }
 
   String output;
   serializeJson(doc, output);
@@ -245,6 +263,50 @@ void SerialManager::handleGetDiag() {
   // Tareas FreeRTOS
   doc["task_count"] = uxTaskGetNumberOfTasks();
 
+  // Trama cloud: construcción y heap consumido por envío (debe ser 0)
+  PayloadDiag pd = CloudManager::getInstance().getPayloadDiag();
+  JsonObject payload = doc["payload"].to<JsonObject>();
+  payload["bytes"] = pd.bytes;
+  payload["build_us"] = pd.buildUs;
+  payload["build_us_max"] = pd.buildUsMax;
+  payload["build_heap_delta"] = pd.buildHeapDelta;
+  payload["publish_heap_delta"] = pd.publishHeapDelta;
+  payload["tx_heap_peak"] = pd.txHeapPeak;
+
+  // TelemetryBus: tomas del mutex de escritura vs campos escritos
+  // (fields/locks > 1 = las fuentes agrupan sus escrituras)
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  JsonObject busDiag = doc["bus"].to<JsonObject>();
+  busDiag["write_locks"] = bus.getWriteLocks();
+  busDiag["write_fields"] = bus.getWriteFields();
+  busDiag["version"] = bus.getVersion();
+  busDiag["read_retries"] = bus.getReadRetries();
+  busDiag["subscribers"] = bus.getSubscriberCount();
+  busDiag["notifications"] = bus.getNotifications();
+
+  const TelemetryHistory &history = bus.getHistory();
+  JsonObject historyDiag = busDiag["history"].to<JsonObject>();
+  historyDiag["channels"] = history.channelCount();
+  historyDiag["bytes"] = history.bytesAllocated();
+  historyDiag["psram"] = history.inPsram();
+
+  // Reloj UTC: fuente vigente, error de la última referencia y deriva
+  TelemetryClockStatus cs = TelemetryClock::getInstance().getStatus();
+  JsonObject clockDiag = doc["clock"].to<JsonObject>();
+  clockDiag["source"] = telemetryTimeSourceToString(cs.source);
+  // offset_us pasa de 2^31 (época UTC en µs) y ArduinoJson no tiene
+  // enteros de 64 bits en este build (ARDUINOJSON_USE_LONG_LONG=0): se
+  // emite como cadena decimal
+  char offsetUs[24];
+  snprintf(offsetUs, sizeof(offsetUs), "%lld", (long long)cs.offsetUs);
+  clockDiag["offset_us"] = offsetUs;
+  clockDiag["last_error_us"] = cs.lastErrorUs;
+  clockDiag["drift_ppb"] = cs.driftPpb;
+  clockDiag["syncs"] = cs.syncs;
+  clockDiag["steps"] = cs.steps;
+  clockDiag["rejected"] = cs.rejected;
+  clockDiag["last_sync_age_ms"] = cs.lastSyncAgeMs;
+
   // === CONFIGURACIÓN CRÍTICA (NUEVO) ===
   JsonObject config = doc["config"].to<JsonObject>();
   config["source"] = dataSourceToString(cfg.source);
@@ -253,6 +315,7 @@ void SerialManager::handleGetDiag() {
   config["protocol"] =
       (cfg.cloud_protocol == CloudProtocol::MQTT) ? "MQTT" : "HTTP";
   config["debug_mode"] = cfg.debug_mode;
+  config["format"] = payloadFormatToString(cfg.cloud_format);
 
   // OBD Config
   JsonObject obd = config["obd"].to<JsonObject>();
@@ -274,6 +337,26 @@ void SerialManager::handleGetDiag() {
   sendJson("DIAG", output);
 }
 
+void SerialManager::handleBenchPayload() {
+  // Compara la trama JSON contra la binaria con el snapshot actual
+  PayloadBenchmark bench = CloudManager::getInstance().benchmarkPayloads(100);
+
+  JsonDocument doc;
+  doc["iterations"] = bench.iterations;
+
+  JsonObject json = doc["json"].to<JsonObject>();
+  json["bytes"] = bench.jsonBytes;
+  json["build_us"] = bench.jsonUs;
+
+  JsonObject binary = doc["binary"].to<JsonObject>();
+  binary["bytes"] = bench.binaryBytes;
+  binary["build_us"] = bench.binaryUs;
+
+  String output;
+  serializeJson(doc, output);
+  sendJson("BENCH", output);
+}
+
 void SerialManager::handleReboot() {
   sendResponse("REBOOT", true, "Rebooting in 1 second...");
   delay(1000);
@@ -298,6 +381,7 @@ void SerialManager::handleHelp() {
   Serial.println(F("GET_SENSORS       - Get configured CAN sensors"));
   Serial.println(F("SET_SENSORS:{json}- Set CAN sensors from JSON"));
   Serial.println(F("GET_DIAG          - Get diagnostic info"));
+  Serial.println(F("BENCH_PAYLOAD     - Compare JSON vs binary cloud payload"));
   Serial.println(F("LIVE_ON           - Enable live telemetry stream"));
   Serial.println(F("LIVE_OFF          - Disable live telemetry stream"));
   Serial.println(F("REBOOT            - Restart the device"));
@@ -331,44 +415,26 @@ void SerialManager::sendTelemetry() {
   JsonDocument doc;
   JsonObject s = doc.createNestedObject("s");
 
-  // Only send ENGINE data if valid (fresh & > 0)
-  if (snapshot.engine_valid) {
-    s["rpm"] = snapshot.engine_rpm;
-    s["speed"] = snapshot.engine_speed;
-    s["temp"] = snapshot.engine_coolant_temp;
-    s["throttle"] = snapshot.engine_throttle;
-    s["load"] = snapshot.engine_load;
-    s["maf"] = snapshot.engine_maf;
-    s["map"] = snapshot.engine_map;
-  }
-
-  // Always send Battery and Fuel if they have been updated at least once
-  if (snapshot.battery_voltage > 0)
-    s["batt"] = snapshot.battery_voltage;
-  if (snapshot.fuel_level > 0)
-    s["fuel"] = snapshot.fuel_level;
-
-  // Only send GPS if we have a FIX or recent data
-  if (snapshot.gps_valid || snapshot.gps_sats > 0) {
-    s["lat"] = snapshot.gps_lat;
-    s["lng"] = snapshot.gps_lng;
-    s["gps_spd"] = snapshot.gps_speed;
-    s["gps_sats"] = snapshot.gps_sats;
-  }
+  // Campos con liveKey en el esquema (claves del configurador)
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    const TelemetryFieldInfo &f = TELEMETRY_FIELDS[i];
+    if (f.liveKey == nullptr)
+      continue;
 
-  // Use timestamp to check for recent IMU data (2 seconds window)
-  if (millis() - snapshot.ts_imu < 2000) {
-    s["ax"] = snapshot.imu_accel_x;
-    s["ay"] = snapshot.imu_accel_y;
-    s["az"] = snapshot.imu_accel_z;
+    if (liveFieldActive(snapshot, (TelemetryField)i))
+      setJsonField(s[f.liveKey].to<JsonVariant>(), f.type,
+                   telemetryFieldGet(snapshot, (TelemetryField)i));
   }
 
-  // Custom Values (CAN) - Already filtered by existence
+  // Custom Values (CAN) - solo los frescos y en rango
   for (int i = 0; i < snapshot.custom_count; i++) {
-    s[snapshot.custom_values[i].key] = snapshot.custom_values[i].value;
+    const CustomValue &cv = snapshot.custom_values[i];
+    if (telemetryQualityUsable(cv.quality))
+      s[cv.key] = cv.value;
   }
 
   String output;
   serializeJson(doc, output);
   Serial.println(output);
 }
+
@@ -62,6 +62,7 @@ private:
   void handleGetSensors();
   void handleSetSensors(const String &json);
   void handleGetDiag();
+  void handleBenchPayload();
   void handleReboot();
   void handleFactoryReset();
   void handleHelp();
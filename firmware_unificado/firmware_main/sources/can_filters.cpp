@@ -0,0 +1,184 @@
+/**
+ * @file can_filters.cpp
+ * @brief Implementación del cálculo de filtros hardware del MCP2515
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "can_filters.h"
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+/**
+ * @brief Cuenta valores distintos de (id & mask), deteniéndose al pasar
+ * de CAN_HW_FILTER_COUNT
+ * @param values Salida opcional con los valores distintos
+ * @return Número de valores distintos (CAN_HW_FILTER_COUNT + 1 si excede)
+ */
+static uint8_t distinctMasked(const uint32_t *ids, size_t count,
+                              uint32_t mask, uint32_t *values) {
+  uint32_t seen[CAN_HW_FILTER_COUNT];
+  uint8_t n = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t v = ids[i] & mask;
+    bool found = false;
+    for (uint8_t j = 0; j < n; j++) {
+      if (seen[j] == v) {
+        found = true;
+        break;
+      }
+    }
+    if (found)
+      continue;
+    if (n >= CAN_HW_FILTER_COUNT)
+      return CAN_HW_FILTER_COUNT + 1;
+    seen[n++] = v;
+  }
+
+  if (values != nullptr) {
+    memcpy(values, seen, n * sizeof(uint32_t));
+  }
+  return n;
+}
+
+static uint8_t popcount32(uint32_t v) {
+  return (uint8_t)__builtin_popcount(v);
+}
+
+// ============================================================================
+// ESTRATEGIAS
+// ============================================================================
+
+/**
+ * @brief IDs estándar: probar todas las máscaras de 11 bits y quedarse con
+ * la que acepta menos IDs (valores * 2^bits_libres)
+ */
+static uint32_t bestStandardMask(const uint32_t *ids, size_t count) {
+  uint32_t bestMask = 0;
+  uint32_t bestCost = 0xFFFFFFFFUL;
+
+  for (uint32_t mask = 0; mask <= CAN_STD_ID_MASK; mask++) {
+    uint8_t k = distinctMasked(ids, count, mask, nullptr);
+    if (k > CAN_HW_FILTER_COUNT)
+      continue;
+
+    uint32_t cost = (uint32_t)k << (CAN_STD_ID_BITS - popcount32(mask));
+    // Empate: preferir la máscara con más bits (menos alias)
+    if (cost < bestCost ||
+        (cost == bestCost && popcount32(mask) > popcount32(bestMask))) {
+      bestCost = cost;
+      bestMask = mask;
+    }
+  }
+  return bestMask;
+}
+
+/**
+ * @brief IDs extendidos: partir de la máscara completa y quitar, bit a bit,
+ * el que más reduce el número de valores distintos hasta que quepan
+ */
+static uint32_t greedyExtendedMask(const uint32_t *ids, size_t count) {
+  uint32_t mask = CAN_EXT_ID_MASK;
+
+  while (distinctMasked(ids, count, mask, nullptr) > CAN_HW_FILTER_COUNT &&
+         mask != 0) {
+    uint32_t bestBit = 0;
+    uint32_t bestDistinct = 0xFFFFFFFFUL;
+
+    for (uint8_t bit = 0; bit < CAN_EXT_ID_BITS; bit++) {
+      uint32_t b = 1UL << bit;
+      if (!(mask & b))
+        continue;
+
+      // Conteo completo (sin corte en 6) para comparar candidatos
+      uint32_t trial = mask & ~b;
+      uint32_t distinct = 0;
+      for (size_t i = 0; i < count; i++) {
+        bool dup = false;
+        for (size_t j = 0; j < i; j++) {
+          if ((ids[j] & trial) == (ids[i] & trial)) {
+            dup = true;
+            break;
+          }
+        }
+        if (!dup)
+          distinct++;
+      }
+
+      // Empate: quitar el bit más bajo (IDs vecinos suelen diferir ahí)
+      if (distinct < bestDistinct) {
+        bestDistinct = distinct;
+        bestBit = b;
+      }
+    }
+    mask &= ~bestBit;
+  }
+  return mask;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+void computeCanFilterPlan(const uint32_t *ids, size_t count,
+                          CanFilterPlan &plan) {
+  plan = CanFilterPlan();
+  plan.idCount = (count > 255) ? 255 : (uint8_t)count;
+
+  if (count == 0 || count > CAN_FILTER_MAX_IDS)
+    return; // Nada configurado o demasiados IDs: no filtrar
+
+  // Clasificar IDs. mcp_can marca los extendidos con el bit 31; un valor
+  // mayor que 11 bits también solo puede ser extendido.
+  uint32_t raw[CAN_FILTER_MAX_IDS];
+  bool anyStd = false, anyExt = false;
+  for (size_t i = 0; i < plan.idCount; i++) {
+    bool ext = (ids[i] & CAN_ID_EXT_FLAG) ||
+               ((ids[i] & CAN_EXT_ID_MASK) > CAN_STD_ID_MASK);
+    raw[i] = ids[i] & CAN_EXT_ID_MASK;
+    if (ext)
+      anyExt = true;
+    else
+      anyStd = true;
+  }
+
+  if (anyStd && anyExt)
+    return; // Mezcla: filtrado solo en software
+
+  uint8_t idBits = anyExt ? CAN_EXT_ID_BITS : CAN_STD_ID_BITS;
+  uint32_t mask = anyExt ? greedyExtendedMask(raw, plan.idCount)
+                         : bestStandardMask(raw, plan.idCount);
+
+  if (mask == 0)
+    return; // La máscara no discrimina nada
+
+  uint32_t values[CAN_HW_FILTER_COUNT];
+  uint8_t k = distinctMasked(raw, plan.idCount, mask, values);
+
+  plan.mode = anyExt ? CanFilterPlan::Mode::EXTENDED
+                     : CanFilterPlan::Mode::STANDARD;
+  plan.mask = mask;
+  plan.filterCount = k;
+  plan.wildcardBits = idBits - popcount32(mask);
+  plan.exact = (plan.wildcardBits == 0);
+
+  // Rellenar los 6 filtros: repetir el primer valor no amplía la aceptación
+  for (uint8_t i = 0; i < CAN_HW_FILTER_COUNT; i++) {
+    plan.filters[i] = (i < k) ? values[i] : values[0];
+  }
+}
+
+const char *canFilterModeToString(CanFilterPlan::Mode mode) {
+  switch (mode) {
+  case CanFilterPlan::Mode::STANDARD:
+    return "STD";
+  case CanFilterPlan::Mode::EXTENDED:
+    return "EXT";
+  default:
+    return "ACCEPT_ALL";
+  }
+}
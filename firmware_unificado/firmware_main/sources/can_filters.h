@@ -0,0 +1,80 @@
+/**
+ * @file can_filters.h
+ * @brief Cálculo de máscaras/filtros de aceptación del MCP2515
+ *
+ * El MCP2515 tiene 2 máscaras y 6 filtros (RXB0: M0 + F0-F1,
+ * RXB1: M1 + F2-F5). A partir de los CAN IDs configurados se calcula la
+ * máscara que deja pasar el menor número de IDs posible con como mucho
+ * 6 valores de filtro. Si los IDs caben exactos (<= 6) no pasa nada más;
+ * si no, el hardware deja pasar un superconjunto y el índice de despacho
+ * (CanDispatchIndex) termina de rechazar en software.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef CAN_FILTERS_H
+#define CAN_FILTERS_H
+
+#include <Arduino.h>
+
+#define CAN_HW_FILTER_COUNT 6
+#define CAN_STD_ID_BITS 11
+#define CAN_EXT_ID_BITS 29
+#define CAN_STD_ID_MASK 0x7FFUL
+#define CAN_EXT_ID_MASK 0x1FFFFFFFUL
+#define CAN_ID_EXT_FLAG 0x80000000UL ///< Bit de ID extendido (mcp_can)
+#define CAN_FILTER_MAX_IDS 64         ///< Más IDs: filtrado solo en software
+
+/**
+ * @struct CanFilterPlan
+ * @brief Resultado del cálculo de filtros hardware
+ */
+struct CanFilterPlan {
+  enum class Mode : uint8_t {
+    ACCEPT_ALL = 0, ///< Sin filtros (MCP_ANY): todo el filtrado en software
+    STANDARD = 1,   ///< Filtros sobre IDs de 11 bits
+    EXTENDED = 2    ///< Filtros sobre IDs de 29 bits
+  };
+
+  Mode mode = Mode::ACCEPT_ALL;
+  uint32_t mask = 0;                         ///< Máscara (M0 = M1)
+  uint32_t filters[CAN_HW_FILTER_COUNT] = {}; ///< F0..F5
+  uint8_t filterCount = 0;                   ///< Valores distintos usados
+  uint8_t idCount = 0;                       ///< IDs configurados
+  uint8_t wildcardBits = 0; ///< Bits de ID ignorados por la máscara
+  bool exact = false;       ///< true si el hardware acepta solo esos IDs
+
+  /**
+   * @brief Número de IDs que el hardware deja pasar
+   * (filterCount * 2^wildcardBits; saturado a 32 bits). 0 en ACCEPT_ALL
+   */
+  uint32_t acceptedIds() const {
+    if (mode == Mode::ACCEPT_ALL)
+      return 0;
+    if (wildcardBits >= 29)
+      return 0xFFFFFFFFUL;
+    uint64_t n = (uint64_t)filterCount << wildcardBits;
+    return (n > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : (uint32_t)n;
+  }
+};
+
+/**
+ * @brief Calcula máscara y filtros para un conjunto de CAN IDs
+ * @param ids IDs configurados (bit 31 = extendido, como los entrega mcp_can)
+ * @param count Número de IDs
+ * @param plan Salida
+ *
+ * IDs estándar: búsqueda exhaustiva de las 2048 máscaras posibles.
+ * IDs extendidos: reducción greedy bit a bit. Mezcla de estándar y
+ * extendido, conjunto vacío o más de CAN_FILTER_MAX_IDS: ACCEPT_ALL.
+ */
+void computeCanFilterPlan(const uint32_t *ids, size_t count,
+                          CanFilterPlan &plan);
+
+/**
+ * @brief Texto del modo (para diagnóstico)
+ */
+const char *canFilterModeToString(CanFilterPlan::Mode mode);
+
+#endif // CAN_FILTERS_H
@@ -0,0 +1,113 @@
+/**
+ * @file can_frame_ring.h
+ * @brief Ring buffer SPSC (single-producer/single-consumer) de tramas CAN
+ *
+ * Desacopla la extracción de tramas del MCP2515 (tarea RX de alta
+ * prioridad, despertada por la interrupción del pin INT) de la
+ * decodificación de señales (CanTask). Sin mutex: el productor solo
+ * escribe _head y el consumidor solo escribe _tail.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef CAN_FRAME_RING_H
+#define CAN_FRAME_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Capacidad del ring (potencia de 2). A 1 Mbit/s con tramas de 8 bytes
+// llegan ~8000 tramas/s: 256 tramas cubren ~30 ms de ráfaga.
+#define CAN_FRAME_RING_SIZE 256
+
+/**
+ * @struct CanFrame
+ * @brief Trama CAN cruda con timestamp de recepción
+ */
+struct CanFrame {
+  uint32_t id;           ///< CAN ID (bit 31 = extendido, como mcp_can)
+  uint64_t timestamp_us; ///< telemetryNowUs() del flanco INT (ISR)
+  uint8_t len;           ///< DLC (0-8)
+  uint8_t data[8];       ///< Payload
+};
+
+/**
+ * @class CanFrameRing
+ * @brief Cola lock-free de tramas CAN (un productor, un consumidor)
+ */
+template <size_t N> class CanFrameRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N debe ser potencia de 2");
+
+public:
+  CanFrameRing() : _head(0), _tail(0), _highWater(0), _overflows(0) {}
+
+  /**
+   * @brief Encola una trama (solo productor)
+   * @return false si el ring está lleno (trama descartada)
+   */
+  bool push(const CanFrame &frame) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t tail = _tail.load(std::memory_order_acquire);
+    uint32_t used = head - tail;
+
+    if (used >= N) {
+      _overflows = _overflows + 1;
+      return false;
+    }
+
+    _buf[head & (N - 1)] = frame;
+    _head.store(head + 1, std::memory_order_release);
+
+    if (used + 1 > _highWater) {
+      _highWater = used + 1;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Extrae la trama más antigua (solo consumidor)
+   * @return false si el ring está vacío
+   */
+  bool pop(CanFrame &frame) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t head = _head.load(std::memory_order_acquire);
+
+    if (head == tail) {
+      return false;
+    }
+
+    frame = _buf[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool isEmpty() const {
+    return _head.load(std::memory_order_acquire) ==
+           _tail.load(std::memory_order_acquire);
+  }
+
+  size_t count() const {
+    return _head.load(std::memory_order_acquire) -
+           _tail.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return N; }
+
+  /// Máxima ocupación observada desde el arranque
+  uint32_t highWater() const { return _highWater; }
+
+  /// Tramas descartadas por ring lleno
+  uint32_t overflows() const { return _overflows; }
+
+private:
+  CanFrame _buf[N];
+  std::atomic<uint32_t> _head; ///< Escrito solo por el productor
+  std::atomic<uint32_t> _tail; ///< Escrito solo por el consumidor
+
+  // Estadísticas (escritas solo por el productor)
+  volatile uint32_t _highWater;
+  volatile uint32_t _overflows;
+};
+
+#endif // CAN_FRAME_RING_H
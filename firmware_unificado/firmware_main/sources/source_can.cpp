@@ -17,25 +17,41 @@
 // ráfagas)
 #define MAX_FRAMES_PER_LOOP 40
 
+// Tarea RX: vacía el MCP2515 al ring en cuanto la ISR la despierta.
+// Más prioridad que CanTask para que los 2 buffers del MCP2515 no se
+// desborden mientras se decodifica.
+#define CAN_RX_TASK_PRIORITY 3
+#define CAN_RX_TASK_STACK 3072
+
+// Timeout de espera de notificación. Es solo respaldo: si se pierde un
+// flanco con INT ya en LOW, la tarea vuelve a sondear el pin.
+#define CAN_RX_IDLE_TIMEOUT_MS 10
+
+// Bits de overflow en el registro EFLG del MCP2515
+#define CAN_EFLG_RX_OVERFLOW (MCP_EFLG_RX1OVR | MCP_EFLG_RX0OVR)
+
+// Reloj SPI del MCP2515 (el mismo que usa mcp_can en sus transacciones)
+#define CAN_SPI_CLOCK_HZ 10000000
+
 // ============================================================================
 // CONSTRUCTOR / DESTRUCTOR
 // ============================================================================
 
 SourceCAN::SourceCAN()
     : BaseDataSource("CAN"), _can(nullptr), _busActive(false), _csPin(-1),
-      _intPin(-1), _baudKbps(500), _crystalMhz(8), _frameCount(0),
+      _intPin(-1), _baudKbps(500), _crystalMhz(8), _canSpeed(CAN_500KBPS),
+      _clockSet(MCP_8MHZ), _filterGeneration(0), _frameCount(0),
       _framesDiscarded(0), _errorCount(0), _maxFramesPerCycle(0),
-      _sensors(nullptr), _sensorMutex(nullptr) {}
+      _maxLatencyUs(0), _rxTaskHandle(nullptr), _isrTimestampUs(0),
+      _lastDrainUs(0), _framesUnmatched(0), _shortFrames(0),
+      _sensors(nullptr),
+      _dispatch(nullptr), _sensorMutex(nullptr) {}
 
 SourceCAN::~SourceCAN() {
   if (_can != nullptr) {
     delete _can;
     _can = nullptr;
   }
-  if (_sensorMutex != nullptr) {
-    vSemaphoreDelete(_sensorMutex);
-    _sensorMutex = nullptr;
-  }
 }
 
 // ============================================================================
@@ -60,56 +76,56 @@ bool SourceCAN::begin() {
   _baudKbps = cfg.can.baud_kbps;
   _crystalMhz = cfg.can.crystal_mhz;
 
-  // Referencia a sensores
+  // Referencia a sensores y a su índice de despacho por CAN ID
   _sensors = &ConfigManager::getInstance().getSensors();
+  _dispatch = &ConfigManager::getInstance().getCanDispatch();
 
-  // Crear mutex para sensores
-  _sensorMutex = xSemaphoreCreateMutex();
+  // Mutex de sensores (compartido con la recarga de ConfigManager)
+  _sensorMutex = ConfigManager::getInstance().getSensorMutex();
   if (_sensorMutex == nullptr) {
     Serial.println(F("[CAN] ERROR: Failed to create mutex"));
     setState(SourceState::ERROR_STATE);
     return false;
   }
 
-  // Configurar pin de interrupción
+  // Configurar pin de interrupción (la ISR se engancha en startTask)
   pinMode(_intPin, INPUT);
 
   // Crear instancia MCP_CAN
   _can = new MCP_CAN(_csPin);
 
   // Determinar velocidad CAN
-  uint8_t canSpeed;
   switch (_baudKbps) {
   case 250:
-    canSpeed = (_crystalMhz == 8) ? CAN_250KBPS : CAN_250KBPS;
+    _canSpeed = (_crystalMhz == 8) ? CAN_250KBPS : CAN_250KBPS;
     break;
   case 500:
-    canSpeed = (_crystalMhz == 8) ? CAN_500KBPS : CAN_500KBPS;
+    _canSpeed = (_crystalMhz == 8) ? CAN_500KBPS : CAN_500KBPS;
     break;
   case 1000:
-    canSpeed = (_crystalMhz == 8) ? CAN_1000KBPS : CAN_1000KBPS;
+    _canSpeed = (_crystalMhz == 8) ? CAN_1000KBPS : CAN_1000KBPS;
     break;
   default:
-    canSpeed = CAN_500KBPS;
+    _canSpeed = CAN_500KBPS;
   }
 
   // Frecuencia del cristal
-  uint8_t clockSet = (_crystalMhz == 16) ? MCP_16MHZ : MCP_8MHZ;
+  _clockSet = (_crystalMhz == 16) ? MCP_16MHZ : MCP_8MHZ;
 
   Serial.printf("[CAN] CS=%d, INT=%d, %dkbps, %dMHz crystal\n", _csPin, _intPin,
                 _baudKbps, _crystalMhz);
 
-  // Inicializar MCP2515
-  if (_can->begin(MCP_ANY, canSpeed, clockSet) != CAN_OK) {
+  // Inicializar MCP2515 una sola vez. MCP_STDEXT deja máscaras y filtros
+  // siempre activos: "aceptar todo" se programa como máscara 0 (ver
+  // applyFilters), así recargar sensores nunca exige otro begin()
+  if (_can->begin(MCP_STDEXT, _canSpeed, _clockSet) != CAN_OK ||
+      !applyFilters()) {
     Serial.println(F("[CAN] ERROR: MCP2515 initialization failed!"));
     setState(SourceState::ERROR_STATE);
     _busActive = false;
     return false;
   }
 
-  // Modo normal
-  _can->setMode(MCP_NORMAL);
-
   _busActive = true;
   setState(SourceState::READY);
 
@@ -119,6 +135,60 @@ bool SourceCAN::begin() {
   return true;
 }
 
+bool SourceCAN::applyFilters() {
+  uint32_t ids[CAN_FILTER_MAX_IDS + 1];
+  xSemaphoreTake(_sensorMutex, portMAX_DELAY);
+  size_t idCount = _dispatch->getIds(ids, CAN_FILTER_MAX_IDS + 1);
+  _filterGeneration = _dispatch->generation();
+  xSemaphoreGive(_sensorMutex);
+
+  computeCanFilterPlan(ids, idCount, _filterPlan);
+
+  // Modo configuración: el MCP2515 deja de recibir durante unas pocas
+  // transacciones SPI pero conserva RXB0/RXB1 (a diferencia de begin(),
+  // que resetea el controlador y descarta lo pendiente). Con mcpMode en
+  // configuración, init_Mask/init_Filt no alternan de modo en cada llamada
+  if (_can->setMode(MODE_CONFIG) != CAN_OK) {
+    return false;
+  }
+
+  bool filtering = (_filterPlan.mode != CanFilterPlan::Mode::ACCEPT_ALL);
+  if (filtering) {
+    // mcp_can espera los IDs estándar desplazados a los 16 bits altos
+    bool ext = (_filterPlan.mode == CanFilterPlan::Mode::EXTENDED);
+    uint8_t shift = ext ? 0 : 16;
+
+    _can->init_Mask(0, ext, _filterPlan.mask << shift);
+    _can->init_Mask(1, ext, _filterPlan.mask << shift);
+    for (uint8_t i = 0; i < CAN_HW_FILTER_COUNT; i++) {
+      _can->init_Filt(i, ext, _filterPlan.filters[i] << shift);
+    }
+
+    Serial.printf("[CAN] HW filters %s: %d IDs -> mask 0x%lX, %d filters, "
+                  "accepts %lu IDs%s\n",
+                  canFilterModeToString(_filterPlan.mode), _filterPlan.idCount,
+                  (unsigned long)_filterPlan.mask, _filterPlan.filterCount,
+                  (unsigned long)_filterPlan.acceptedIds(),
+                  _filterPlan.exact ? " (exact)" : " (+software)");
+  } else {
+    // Máscara 0: cualquier ID coincide; el bit EXIDE de cada filtro
+    // decide el tipo de trama, así que cada buffer (RXB0 = F0-F1,
+    // RXB1 = F2-F5) lleva un filtro estándar y otro extendido
+    _can->init_Mask(0, 1, 0);
+    _can->init_Mask(1, 1, 0);
+    for (uint8_t i = 0; i < CAN_HW_FILTER_COUNT; i++) {
+      _can->init_Filt(i, i & 1, 0);
+    }
+
+    Serial.printf("[CAN] HW filters off (%d IDs): software filtering only\n",
+                  _filterPlan.idCount);
+  }
+
+  // Modo normal
+  _can->setMode(MCP_NORMAL);
+  return true;
+}
+
 // ============================================================================
 // TAREA FREERTOS
 // ============================================================================
@@ -140,17 +210,44 @@ void SourceCAN::startTask() {
                           0 // Core 0 (Pro CPU - menos interrupciones WiFi)
   );
 
-  if (handle != nullptr) {
-    setTaskHandle(handle);
-    setState(SourceState::RUNNING);
-    Serial.println(F("[CAN] Task started on Core 0 (high priority)"));
-  } else {
+  if (handle == nullptr) {
     Serial.println(F("[CAN] Failed to create task!"));
     setState(SourceState::ERROR_STATE);
+    return;
+  }
+  setTaskHandle(handle);
+
+  // Tarea RX (productor del ring). Se crea después de CanTask porque la
+  // notifica al encolar tramas.
+  xTaskCreatePinnedToCore(rxTaskFunction, "CanRxTask", CAN_RX_TASK_STACK,
+                          this, CAN_RX_TASK_PRIORITY, &_rxTaskHandle, 0);
+
+  if (_rxTaskHandle == nullptr) {
+    Serial.println(F("[CAN] Failed to create RX task!"));
+    vTaskDelete(handle);
+    setTaskHandle(nullptr);
+    setState(SourceState::ERROR_STATE);
+    return;
   }
+
+  // MCP2515 baja INT mientras haya tramas pendientes
+  attachInterruptArg(digitalPinToInterrupt(_intPin), onCanInterrupt, this,
+                     FALLING);
+
+  setState(SourceState::RUNNING);
+  Serial.println(F("[CAN] Tasks started on Core 0 (RX prio 3, decode prio 2)"));
 }
 
 void SourceCAN::stopTask() {
+  if (_intPin >= 0) {
+    detachInterrupt(digitalPinToInterrupt(_intPin));
+  }
+
+  if (_rxTaskHandle != nullptr) {
+    vTaskDelete(_rxTaskHandle);
+    _rxTaskHandle = nullptr;
+  }
+
   TaskHandle_t handle = getTaskHandle();
   if (handle != nullptr) {
     vTaskDelete(handle);
@@ -160,6 +257,134 @@ void SourceCAN::stopTask() {
   }
 }
 
+// ============================================================================
+// ETAPA DE RECEPCIÓN (ISR -> CanRxTask -> ring)
+// ============================================================================
+
+void IRAM_ATTR SourceCAN::onCanInterrupt(void *param) {
+  SourceCAN *self = static_cast<SourceCAN *>(param);
+
+  // El SPI del MCP2515 no puede usarse desde ISR (usa mutex de bus):
+  // solo se captura el instante y se despierta a la tarea RX. Se guardan
+  // los 32 bits bajos (escritura atómica); la tarea RX los extiende.
+  self->_isrTimestampUs.store((uint32_t)esp_timer_get_time(),
+                             std::memory_order_relaxed);
+
+  BaseType_t woken = pdFALSE;
+  if (self->_rxTaskHandle != nullptr) {
+    vTaskNotifyGiveFromISR(self->_rxTaskHandle, &woken);
+  }
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void SourceCAN::rxTaskFunction(void *param) {
+  SourceCAN *self = static_cast<SourceCAN *>(param);
+
+  Serial.printf("[CAN] RX task running on core %d\n", xPortGetCoreID());
+
+  esp_task_wdt_add(NULL);
+
+  while (true) {
+    self->rxTaskLoop();
+  }
+}
+
+void SourceCAN::rxTaskLoop() {
+  esp_task_wdt_reset();
+
+  // Dormir hasta el flanco de INT. El sello se consume junto con la
+  // notificación: tras un timeout no hay sello de esta espera
+  uint32_t notified =
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_RX_IDLE_TIMEOUT_MS));
+  uint32_t isrTimestamp =
+      _isrTimestampUs.exchange(0, std::memory_order_relaxed);
+  if (notified == 0) {
+    isrTimestamp = 0;
+  }
+
+  if (!_busActive || _can == nullptr) {
+    vTaskDelay(pdMS_TO_TICKS(100));
+    return;
+  }
+
+  // Sensores recargados (SET_SENSORS): reprogramar filtros hardware
+  if (_dispatch->generation() != _filterGeneration) {
+    if (!applyFilters()) {
+      Serial.println(F("[CAN] ERROR: Failed to reapply HW filters"));
+      _errorCount++;
+    }
+  }
+
+  // Sello de la ISR; sin él, o si es de un flanco anterior al último
+  // vaciado (sus tramas ya se leyeron), la primera trama se sella al leerla
+  uint64_t isrUs = 0;
+  if (isrTimestamp != 0) {
+    isrUs = telemetryExtendUs(isrTimestamp, telemetryNowUs());
+    if (isrUs < _lastDrainUs)
+      isrUs = 0;
+  }
+
+  int framesRead = 0;
+  CanFrame frame;
+  INT32U rxId;
+
+  // Vaciar ambos buffers del MCP2515 mientras INT siga en LOW. Las tramas
+  // que llegan durante el vaciado no generan nuevo flanco, así que el
+  // bucle también las recoge.
+  while (digitalRead(_intPin) == LOW) {
+    if (_can->readMsgBuf(&rxId, &frame.len, frame.data) != CAN_OK) {
+      _errorCount++;
+      break;
+    }
+
+    frame.id = rxId;
+    if (frame.len > 8)
+      frame.len = 8; // Seguridad
+
+    // La primera trama es la que disparó la ISR; las siguientes se
+    // sellan al leerlas
+    uint64_t now = telemetryNowUs();
+    frame.timestamp_us = (framesRead == 0 && isrUs != 0) ? isrUs : now;
+    _rxRing.push(frame); // Si está lleno, cuenta en overflows()
+    framesRead++;
+  }
+
+  if (framesRead > 0) {
+    _lastDrainUs = telemetryNowUs();
+    xTaskNotifyGive(getTaskHandle());
+  }
+
+  // Diagnóstico de saturación del MCP2515. EFLG.RXnOVR es persistente:
+  // se cuenta un desbordamiento por buffer y se limpia para que el
+  // siguiente vuelva a activarlo
+  uint8_t overflow = _can->getError() & CAN_EFLG_RX_OVERFLOW;
+  if (overflow != 0) {
+    _framesDiscarded += ((overflow & MCP_EFLG_RX0OVR) ? 1 : 0) +
+                        ((overflow & MCP_EFLG_RX1OVR) ? 1 : 0);
+    clearRxOverflow();
+  }
+}
+
+void SourceCAN::clearRxOverflow() {
+  // mcp_can no expone mcp2515_modifyRegister(): BIT MODIFY directo sobre
+  // el SPI global (el que usa MCP_CAN(cs)), con los mismos ajustes que la
+  // librería. Solo los bits RXnOVR; el resto de EFLG es de solo lectura
+  SPI.beginTransaction(SPISettings(CAN_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+  digitalWrite(_csPin, LOW);
+  SPI.transfer(MCP_BITMOD);
+  SPI.transfer(MCP_EFLG);
+  SPI.transfer(CAN_EFLG_RX_OVERFLOW); // Máscara
+  SPI.transfer(0x00);                 // Valor
+  digitalWrite(_csPin, HIGH);
+  SPI.endTransaction();
+}
+
+// ============================================================================
+// ETAPA DE DECODIFICACIÓN (CanTask)
+// ============================================================================
+
 void SourceCAN::taskFunction(void *param) {
   SourceCAN *self = static_cast<SourceCAN *>(param);
 
@@ -177,191 +402,131 @@ void SourceCAN::taskLoop() {
   // Reset watchdog
   esp_task_wdt_reset();
 
-  // Yield mínimo para no monopolizar CPU
-  vTaskDelay(1);
-
   if (!_busActive || _can == nullptr) {
     vTaskDelay(pdMS_TO_TICKS(100));
     return;
   }
 
-  // Buffer local
-  static uint8_t rxBuf[8];
-  uint32_t rxId;
-  uint8_t len = 0;
-
-  // Verificar si hay datos (INT pin LOW)
-  if (digitalRead(_intPin) == LOW) {
-    int framesProcessed = 0;
-
-    // Procesar ráfaga (P1.3)
-    while (digitalRead(_intPin) == LOW &&
-           framesProcessed < MAX_FRAMES_PER_LOOP) {
-      if (_can->readMsgBuf((unsigned long *)&rxId, &len, rxBuf) == CAN_OK) {
-        processFrame(rxId, len, rxBuf);
-        _frameCount++;
-        framesProcessed++;
-      } else {
-        _errorCount++;
-      }
-    }
+  // Esperar a que CanRxTask encole tramas (sin piso de 1 tick)
+  if (_rxRing.isEmpty()) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+  }
 
-    // Diagnóstico de saturación: verificar flags de overflow
-    uint8_t errFlags = _can->checkError(); // Usar checkError estándar
+  CanFrame frame;
+  int framesProcessed = 0;
 
-    if (errFlags & 0xC0) { // RX0OVR o RX1OVR (Overflows)
-      _framesDiscarded++;
-      // Intentar limpiar flags si la librería lo permite
-      // (algunas implementaciones de readMsgBuf ya lo hacen)
-    }
+  // Procesar ráfaga (P1.3)
+  while (framesProcessed < MAX_FRAMES_PER_LOOP && _rxRing.pop(frame)) {
+    processFrame(frame.id, frame.len, frame.data, frame.timestamp_us);
+    _frameCount++;
+    framesProcessed++;
 
-    // Actualizar max frames por ciclo (para diagnóstico de flood)
-    if (framesProcessed > (int)_maxFramesPerCycle) {
-      _maxFramesPerCycle = framesProcessed;
+    uint32_t latency = (uint32_t)(telemetryNowUs() - frame.timestamp_us);
+    if (latency > _maxLatencyUs) {
+      _maxLatencyUs = latency;
     }
+  }
 
-    // P1.3: Yield después del lote para dar tiempo a otras tareas (WDT, WiFi)
-    if (framesProcessed > (int)(MAX_FRAMES_PER_LOOP / 2)) {
-      vTaskDelay(1);
-    } else {
-      taskYIELD();
-    }
+  // Actualizar max frames por ciclo (para diagnóstico de flood)
+  if (framesProcessed > (int)_maxFramesPerCycle) {
+    _maxFramesPerCycle = framesProcessed;
+  }
+
+  // P1.3: Ceder CPU si el lote fue grande; el ring absorbe la ráfaga
+  if (framesProcessed >= MAX_FRAMES_PER_LOOP) {
+    taskYIELD();
   }
 }
 
+void SourceCAN::printStatus() const {
+  BaseDataSource::printStatus();
+  Serial.printf("[CAN] Frames: %lu, Errors: %lu, HW overflows: %lu, "
+                "Max/cycle: %lu\n",
+                (unsigned long)_frameCount, (unsigned long)_errorCount,
+                (unsigned long)_framesDiscarded,
+                (unsigned long)_maxFramesPerCycle);
+  Serial.printf("[CAN] Dispatch: %d IDs / %d sensors, short frames: %lu\n",
+                _dispatch ? _dispatch->idCount() : 0,
+                _dispatch ? _dispatch->sensorCount() : 0,
+                (unsigned long)_shortFrames);
+  Serial.printf("[CAN] HW filter: %s, mask 0x%lX, %d filters, accepts %lu "
+                "IDs (%s); rejected in software: %lu\n",
+                canFilterModeToString(_filterPlan.mode),
+                (unsigned long)_filterPlan.mask, _filterPlan.filterCount,
+                (unsigned long)_filterPlan.acceptedIds(),
+                _filterPlan.exact ? "exact" : "superset",
+                (unsigned long)_framesUnmatched);
+  Serial.printf("[CAN] Ring: %u/%u (high-water %lu), overflows: %lu, "
+                "max latency: %lu us\n",
+                (unsigned)_rxRing.count(), (unsigned)_rxRing.capacity(),
+                (unsigned long)_rxRing.highWater(),
+                (unsigned long)_rxRing.overflows(),
+                (unsigned long)_maxLatencyUs);
+}
+
 // ============================================================================
 // PROCESAMIENTO DE TRAMAS
 // ============================================================================
 
-void SourceCAN::processFrame(uint32_t canId, uint8_t len, uint8_t *data) {
+void SourceCAN::processFrame(uint32_t canId, uint8_t len, uint8_t *data,
+                             uint64_t timestampUs) {
   if (len > 8)
     len = 8; // Seguridad
 
-  // Tomar mutex
+  // Tomar mutex: SET_SENSORS puede estar reconstruyendo el índice
   if (xSemaphoreTake(_sensorMutex, pdMS_TO_TICKS(5)) != pdTRUE) {
     return; // No pudimos tomar el mutex, saltamos este frame
   }
 
-  // Buscar sensores que coincidan con este CAN ID
-  for (auto &sensor : *_sensors) {
-    if (!sensor.enabled)
-      continue;
-    if (sensor.can_id != canId)
+  // Despacho O(1): IDs sin sensores se descartan
+  const CanDecoder *decoders;
+  uint16_t count;
+  if (!_dispatch->lookup(canId, decoders, count)) {
+    xSemaphoreGive(_sensorMutex);
+    _framesUnmatched++;
+    return;
+  }
+
+  // Todas las señales de la trama se publican juntas (una toma del mutex
+  // del bus por trama, no por señal), selladas con el instante de la ISR
+  TelemetryWriteTx tx(TelemetryBus::getInstance(), timestampUs);
+
+  // Solo los sensores de este CAN ID (en orden de configuración)
+  for (uint16_t i = 0; i < count; i++) {
+    const CanDecoder &dec = decoders[i];
+    if (dec.sensor >= _sensors->size())
       continue;
 
-    // Decodificar valor
-    float value = decodeSensor(sensor, data, len);
+    // Decodificar valor con el plan precompilado
+    float value;
+    if (!decodeWithPlan(dec.plan, data, len, value)) {
+      _shortFrames++; // DLC menor que el que requiere la señal
+      continue;
+    }
 
     // Actualizar sensor
+    SensorConfig &sensor = (*_sensors)[dec.sensor];
     sensor.value = value;
     sensor.updated = true;
 
     incrementReadCount();
 
     // Publicar al TelemetryBus
-    publishToTelemetryBus(sensor, value);
+    publishToTelemetryBus(tx, sensor, value);
   }
 
+  tx.commit();
   xSemaphoreGive(_sensorMutex);
 }
 
-float SourceCAN::decodeSensor(const SensorConfig &sensor, uint8_t *data,
-                              uint8_t len) {
-  uint64_t raw = 0;
-
-  if (sensor.big_endian) {
-    // === BIG ENDIAN (MoTeC) ===
-    int startByte = sensor.start_byte;
-    int numBytes = sensor.length / 8;
-    if (numBytes == 0)
-      numBytes = 1;
-
-    if (startByte + numBytes <= len) {
-      if (numBytes == 1) {
-        raw = data[startByte];
-      } else if (numBytes == 2) {
-        raw = ((uint16_t)data[startByte] << 8) | data[startByte + 1];
-      } else if (numBytes == 4) {
-        raw = ((uint32_t)data[startByte] << 24) |
-              ((uint32_t)data[startByte + 1] << 16) |
-              ((uint32_t)data[startByte + 2] << 8) | data[startByte + 3];
-      }
-    }
-  } else {
-    // === LITTLE ENDIAN (Intel) ===
-    // Convertir buffer a uint64
-    uint64_t fullData = 0;
-    for (int i = 0; i < len; i++) {
-      fullData |= ((uint64_t)data[i] << (i * 8));
-    }
-
-    // Aplicar máscara y shift
-    uint64_t mask = 0;
-    if (sensor.length >= 64) {
-      mask = ~0ULL;
-    } else {
-      mask = (1ULL << sensor.length) - 1;
-    }
-
-    if (sensor.start_bit < 64) {
-      raw = (fullData >> sensor.start_bit) & mask;
-    }
-  }
-
-  // Extensión de signo si es necesario
-  int64_t signedRaw = (int64_t)raw;
-  if (sensor.signed_val && sensor.length > 0 && sensor.length < 64) {
-    int shift = 64 - sensor.length;
-    signedRaw = ((int64_t)raw << shift) >> shift;
-  }
-
-  // Aplicar escala y offset
-  float value = (signedRaw * sensor.multiplier) + sensor.offset;
-  return value;
-}
-
-void SourceCAN::publishToTelemetryBus(const SensorConfig &sensor, float value) {
-  TelemetryBus &bus = TelemetryBus::getInstance();
-
+void SourceCAN::publishToTelemetryBus(TelemetryWriteTx &tx,
+                                      const SensorConfig &sensor, float value) {
   // P1.5 Optimization: Usar mapeo pre-calculado (O(1)) en lugar de strcmp
   // (O(N))
-  switch (sensor.map_type) {
-  case SensorConfig::MappingType::ENGINE_RPM:
-    bus.setEngineRpm(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_SPEED:
-    bus.setEngineSpeed(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_COOLANT:
-    bus.setEngineCoolantTemp(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_OIL_TEMP:
-    bus.setEngineOilTemp(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_THROTTLE:
-    bus.setEngineThrottle(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_LOAD:
-    bus.setEngineLoad(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_MAF:
-    bus.setEngineMaf(value);
-    break;
-  case SensorConfig::MappingType::ENGINE_MAP:
-    bus.setEngineMap(value);
-    break;
-  case SensorConfig::MappingType::FUEL_LEVEL:
-    bus.setFuelLevel(value);
-    break;
-  case SensorConfig::MappingType::FUEL_RATE:
-    bus.setFuelRate(value);
-    break;
-  case SensorConfig::MappingType::BATTERY_VOLT:
-    bus.setBatteryVoltage(value);
-    break;
-  default:
-    // Fallback para custom values
-    bus.setCustomValue(sensor.cloud_id, value);
-    break;
+  if (sensor.map_type == SensorConfig::MappingType::CUSTOM) {
+    // Slot internado al cargar la config
+    tx.setCustomValueAt(sensor.bus_slot, value);
+    return;
   }
+  tx.setField(SensorConfig::fieldFor(sensor.map_type), value);
 }
@@ -2,8 +2,13 @@
  * @file source_can.h
  * @brief Fuente de datos CAN Bus (MoTeC/MCP2515)
  *
- * Lee tramas CAN del MCP2515 y decodifica señales según configuración.
- * Soporta byte order Big Endian (MoTeC) y Little Endian.
+ * Lee tramas CAN del MCP2515 y decodifica señales según configuración
+ * mediante planes precompilados (config/can_decode.h): Motorola/Intel con
+ * cualquier bit de inicio y longitud, enteros con/sin signo y float32.
+ *
+ * Recepción en dos etapas:
+ *   ISR (pin INT) -> CanRxTask (vacía el MCP2515 al ring SPSC)
+ *                 -> CanTask (decodifica y publica al TelemetryBus)
  *
  * @author Neurona Racing Development
  * @date 2024-12-19
@@ -12,9 +17,14 @@
 #ifndef SOURCE_CAN_H
 #define SOURCE_CAN_H
 
+#include "../config/can_dispatch.h"
 #include "../config/config_schema.h"
+#include "../telemetry/telemetry_bus.h"
+#include "can_filters.h"
+#include "can_frame_ring.h"
 #include "data_source.h"
 #include <SPI.h>
+#include <atomic>
 #include <mcp_can.h>
 #include <vector>
 
@@ -48,24 +58,59 @@ public:
   uint32_t getErrorCount() const { return _errorCount; }
   uint32_t getMaxFramesPerCycle() const { return _maxFramesPerCycle; }
 
+  /**
+   * @brief Estadísticas del ring de recepción
+   */
+  uint32_t getRingHighWater() const { return _rxRing.highWater(); }
+  uint32_t getRingOverflows() const { return _rxRing.overflows(); }
+  uint32_t getMaxLatencyUs() const { return _maxLatencyUs; }
+
+  /**
+   * @brief Tramas sin ningún sensor configurado (rechazadas en O(1))
+   */
+  uint32_t getFramesUnmatched() const { return _framesUnmatched; }
+
+  /**
+   * @brief Filtros de aceptación programados en el MCP2515
+   */
+  const CanFilterPlan &getFilterPlan() const { return _filterPlan; }
+
+  void printStatus() const override;
+
 private:
   static void taskFunction(void *param);
   void taskLoop();
 
+  // Etapa de recepción (ISR + tarea RX)
+  static void IRAM_ATTR onCanInterrupt(void *param);
+  static void rxTaskFunction(void *param);
+  void rxTaskLoop();
+
   /**
-   * @brief Procesa una trama CAN recibida
+   * @brief Reprograma máscaras/filtros del MCP2515 (en modo
+   * configuración, sin reiniciar el controlador) a partir de los CAN IDs
+   * configurados. Solo desde begin() o CanRxTask (dueños del SPI).
    */
-  void processFrame(uint32_t canId, uint8_t len, uint8_t *data);
+  bool applyFilters();
 
   /**
-   * @brief Decodifica un sensor de la trama
+   * @brief Limpia EFLG.RX0OVR/RX1OVR del MCP2515 tras contarlos. Solo
+   * desde CanRxTask (dueña del SPI).
    */
-  float decodeSensor(const SensorConfig &sensor, uint8_t *data, uint8_t len);
+  void clearRxOverflow();
 
   /**
-   * @brief Mapea nombre de sensor a setter del TelemetryBus
+   * @brief Procesa una trama CAN recibida
    */
-  void publishToTelemetryBus(const SensorConfig &sensor, float value);
+  void processFrame(uint32_t canId, uint8_t len, uint8_t *data,
+                    uint64_t timestampUs);
+
+  /**
+   * @brief Mapea sensor a setter del TelemetryBus (dentro de la transacción
+   * de la trama)
+   */
+  void publishToTelemetryBus(TelemetryWriteTx &tx, const SensorConfig &sensor,
+                             float value);
 
   MCP_CAN *_can;
   bool _busActive;
@@ -75,17 +120,34 @@ private:
   int8_t _intPin;
   uint16_t _baudKbps;
   uint8_t _crystalMhz;
+  uint8_t _canSpeed; ///< Constante CAN_xxxKBPS de mcp_can
+  uint8_t _clockSet; ///< Constante MCP_xMHZ de mcp_can
+
+  // Filtros hardware
+  CanFilterPlan _filterPlan;
+  uint32_t _filterGeneration; ///< generation() del índice aplicado
 
   // Stats (P1.3)
   volatile uint32_t _frameCount;
-  volatile uint32_t _framesDiscarded;   ///< Frames descartados por flood
+  volatile uint32_t _framesDiscarded;   ///< Overflows RXnOVR (uno por aviso)
   volatile uint32_t _errorCount;        ///< Errores de bus CAN
   volatile uint32_t _maxFramesPerCycle; ///< Max frames procesados en un ciclo
+  volatile uint32_t _maxLatencyUs;      ///< Max ISR -> decodificación (us)
+
+  // Recepción por interrupción
+  CanFrameRing<CAN_FRAME_RING_SIZE> _rxRing;
+  TaskHandle_t _rxTaskHandle;
+  std::atomic<uint32_t> _isrTimestampUs; ///< esp_timer del INT, 0 = consumido
+  uint64_t _lastDrainUs;                 ///< Fin del último vaciado
+  volatile uint32_t _framesUnmatched; ///< IDs sin sensores configurados
+  volatile uint32_t _shortFrames;     ///< DLC menor que el de la señal
 
   // Referencia a sensores configurados
   std::vector<SensorConfig> *_sensors;
+  const CanDispatchIndex *_dispatch; ///< can_id -> índices en _sensors
 
-  // Mutex para acceso a sensores (heredamos del global para compatibilidad)
+  // Mutex de ConfigManager: SET_SENSORS reconstruye sensores e índice en
+  // su lugar, así que búsqueda y decodificación van bajo el mismo mutex
   SemaphoreHandle_t _sensorMutex;
 };
 
@@ -9,15 +9,28 @@
 #include "source_gps.h"
 #include "../config/config_manager.h"
 #include "../telemetry/telemetry_bus.h"
+#include "../telemetry/telemetry_clock.h"
 #include <esp_task_wdt.h>
 
+// Sin fix, la hora de la RMC sale del RTC del receptor y no es fiable
+#define GPS_TIME_MAX_FIX_AGE_MS 2000
+
+// Modo UBX: espera de ACK por comando, pausa tras cambiar de velocidad,
+// bytes leídos por bloque y buffer RX (una ráfaga NAV-PVT = 100 bytes)
+#define GPS_UBX_ACK_TIMEOUT_MS 300
+#define GPS_UBX_BAUD_SETTLE_MS 50
+#define GPS_UBX_READ_CHUNK 128
+#define GPS_UART_RX_BUFFER 1024
+
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
 SourceGPS::SourceGPS()
     : BaseDataSource("GPS"), _serial(nullptr), _lat(0), _lng(0), _alt(0),
-      _speed(0), _course(0), _sats(0), _fix(false), _rxPin(-1), _txPin(-1),
+      _speed(0), _course(0), _sats(0), _fix(false), _ppsLowUs(0),
+      _ppsCount(0), _ppsUsedCount(0), _messageUs(0), _charUs(0),
+      _timeSyncs(0), _ubxActive(false), _rxPin(-1), _txPin(-1), _ppsPin(-1),
       _baud(9600) {}
 
 // ============================================================================
@@ -40,14 +53,38 @@ bool SourceGPS::begin() {
   _rxPin = cfg.gps.rx_pin;
   _txPin = cfg.gps.tx_pin;
   _baud = cfg.gps.baud;
+  _ppsPin = cfg.gps_pps_pin;
+  if (_baud == 0)
+    _baud = DEFAULT_GPS_BAUD;
+  _charUs = 10000000UL / _baud; // 8N1 = 10 bits por carácter
 
   // Usar UART2
   _serial = new HardwareSerial(2);
 
   Serial.printf("[GPS] Starting UART2 on RX=%d, TX=%d @ %lu baud\n", _rxPin,
                 _txPin, _baud);
+  _serial->setRxBufferSize(GPS_UART_RX_BUFFER);
   _serial->begin(_baud, SERIAL_8N1, _rxPin, _txPin);
 
+  // Modo UBX (u-blox): NAV-PVT binario a la tasa configurada; si el
+  // receptor no lo confirma se queda en NMEA
+  if (cfg.gps_ubx.enabled) {
+    _ubxActive = configureUbx(cfg.gps_ubx.baud, cfg.gps_ubx.rate_hz);
+    if (_ubxActive) {
+      Serial.printf("[GPS] UBX NAV-PVT @ %u Hz, %lu baud\n",
+                    cfg.gps_ubx.rate_hz, (unsigned long)cfg.gps_ubx.baud);
+    } else {
+      Serial.println(F("[GPS] No UBX ACK, falling back to NMEA"));
+      _serial->updateBaudRate(_baud);
+      _charUs = 10000000UL / _baud;
+    }
+  }
+
+  if (_ppsPin >= 0) {
+    pinMode(_ppsPin, INPUT);
+    Serial.printf("[GPS] PPS on pin %d\n", _ppsPin);
+  }
+
   // Esperar un momento para que el GPS se estabilice
   delay(100);
 
@@ -81,6 +118,10 @@ void SourceGPS::startTask() {
   if (handle != nullptr) {
     setTaskHandle(handle);
     setState(SourceState::RUNNING);
+    if (_ppsPin >= 0) {
+      attachInterruptArg(digitalPinToInterrupt(_ppsPin), onPpsInterrupt, this,
+                         RISING);
+    }
     Serial.println(F("[GPS] Task started on Core 1"));
   } else {
     Serial.println(F("[GPS] Failed to create task!"));
@@ -89,6 +130,10 @@ void SourceGPS::startTask() {
 }
 
 void SourceGPS::stopTask() {
+  if (_ppsPin >= 0) {
+    detachInterrupt(digitalPinToInterrupt(_ppsPin));
+  }
+
   TaskHandle_t handle = getTaskHandle();
   if (handle != nullptr) {
     vTaskDelete(handle);
@@ -115,15 +160,42 @@ void SourceGPS::taskLoop() {
   // Reset watchdog
   esp_task_wdt_reset();
 
+  if (_ubxActive) {
+    readUbx();
+  } else {
+    readNmea();
+  }
+
+  // Pequeño delay para no saturar
+  vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+// ============================================================================
+// NMEA (TinyGPSPlus)
+// ============================================================================
+
+void SourceGPS::readNmea() {
   // Leer datos del GPS (Limitado a 64 bytes para evitar hogging)
   int bytesRead = 0;
   while (_serial->available() > 0 && bytesRead < 64) {
     char c = _serial->read();
     bytesRead++;
 
+    // Los bytes aún en el buffer llegaron después del '$': descontarlos
+    // acota la espera entre ciclos de lectura
+    if (c == '$') {
+      _messageUs =
+          telemetryNowUs() - (uint64_t)_serial->available() * _charUs;
+    }
+
     if (_gps.encode(c)) {
       // Se procesó una sentencia completa
       incrementReadCount();
+
+      // Solo la RMC trae fecha: referencia de hora
+      if (_gps.date.isUpdated()) {
+        handleRmcTime();
+      }
     }
   }
 
@@ -162,7 +234,181 @@ void SourceGPS::taskLoop() {
     TelemetryBus::getInstance().setGps(_lat, _lng, _alt, _speed, _course, _sats,
                                        _fix);
   }
+}
+
+void SourceGPS::handleRmcTime() {
+  if (!_gps.location.isValid() ||
+      _gps.location.age() > GPS_TIME_MAX_FIX_AGE_MS ||
+      !_gps.date.isValid() || !_gps.time.isValid() ||
+      _gps.date.year() < 2020) {
+    return;
+  }
 
-  // Pequeño delay para no saturar
-  vTaskDelay(pdMS_TO_TICKS(10));
+  uint64_t epoch = telemetryEpochFromUtc(
+      _gps.date.year(), _gps.date.month(), _gps.date.day(), _gps.time.hour(),
+      _gps.time.minute(), _gps.time.second());
+  uint8_t centis = _gps.time.centisecond();
+  addTimeReference(epoch * 1000000ULL + centis * 10000ULL, centis == 0);
+}
+
+// ============================================================================
+// UBX (u-blox NAV-PVT)
+// ============================================================================
+
+bool SourceGPS::configureUbx(uint32_t baud, uint8_t rateHz) {
+  uint8_t frame[UBX_CFG_MAX_FRAME];
+
+  // El receptor puede conservar la velocidad de un arranque anterior
+  // (backup/flash): se intenta primero a la velocidad UBX y luego desde
+  // la de NMEA. CFG-PRT cambia la velocidad antes de poder confirmarla.
+  const uint32_t tries[2] = {baud, _baud};
+  for (uint8_t t = 0; t < 2; t++) {
+    if (t == 1 && _baud == baud)
+      break;
+
+    _serial->updateBaudRate(tries[t]);
+    size_t len = ubxBuildCfgPrt(baud, frame, sizeof(frame));
+    _serial->write(frame, len);
+    _serial->flush();
+    delay(GPS_UBX_BAUD_SETTLE_MS);
+    _serial->updateBaudRate(baud);
+
+    len = ubxBuildCfgMsg(UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1, frame,
+                         sizeof(frame));
+    if (!sendUbx(frame, len))
+      continue;
+
+    len = ubxBuildCfgRate((uint16_t)(1000 / rateHz), frame, sizeof(frame));
+    if (!sendUbx(frame, len))
+      continue;
+
+    _charUs = 10000000UL / baud;
+    return true;
+  }
+  return false;
+}
+
+bool SourceGPS::sendUbx(const uint8_t *frame, size_t len) {
+  while (_serial->available() > 0) {
+    _serial->read();
+  }
+  _ubx.reset();
+  _serial->write(frame, len);
+
+  // ACK-ACK / ACK-NAK llevan clase e ID del comando confirmado
+  uint32_t start = millis();
+  while (millis() - start < GPS_UBX_ACK_TIMEOUT_MS) {
+    while (_serial->available() > 0) {
+      if (!_ubx.push((uint8_t)_serial->read()) ||
+          _ubx.msgClass() != UBX_CLASS_ACK || _ubx.length() != 2 ||
+          _ubx.payload()[0] != frame[2] || _ubx.payload()[1] != frame[3]) {
+        continue;
+      }
+      return _ubx.msgId() == UBX_ID_ACK_ACK;
+    }
+    delay(5);
+  }
+  return false;
+}
+
+void SourceGPS::readUbx() {
+  uint8_t buf[GPS_UBX_READ_CHUNK];
+
+  // Acotado a unas pocas tramas por ciclo (a 25 Hz llega una cada 40 ms)
+  for (uint8_t chunk = 0; chunk < 4 && _serial->available() > 0; chunk++) {
+    size_t n = _serial->read(buf, sizeof(buf));
+    uint64_t now = telemetryNowUs();
+    size_t pending = (size_t)_serial->available();
+
+    for (size_t i = 0; i < n; i++) {
+      // Llegada del sync: los bytes posteriores ya leídos o en el buffer
+      // se descuentan, como con el '$' de NMEA
+      if (buf[i] == UBX_SYNC_1 && _ubx.idle()) {
+        _messageUs = now - (uint64_t)(n - 1 - i + pending) * _charUs;
+      }
+      if (_ubx.push(buf[i]) && _ubx.is(UBX_CLASS_NAV, UBX_ID_NAV_PVT) &&
+          _ubx.length() == UBX_NAV_PVT_LEN) {
+        handleNavPvt(UbxNavPvtView(_ubx.payload()));
+      }
+    }
+  }
+}
+
+void SourceGPS::handleNavPvt(const UbxNavPvtView &pvt) {
+  incrementReadCount();
+
+  _fix = pvt.gnssFixOk() && pvt.fixType() >= 2;
+  _lat = (float)(pvt.latE7() * 1e-7);
+  _lng = (float)(pvt.lonE7() * 1e-7);
+  _alt = pvt.heightMslMm() / 1000.0f;
+  _speed = pvt.groundSpeedMmS() * 0.0036f; // mm/s -> km/h
+  _course = pvt.headingE5() * 1e-5f;
+  _sats = pvt.numSv();
+
+  // Sellada con la llegada de la trama, no con el fin del parseo
+  {
+    TelemetryWriteTx tx(TelemetryBus::getInstance(), _messageUs);
+    tx.setGps(_lat, _lng, _alt, _speed, _course, _sats, _fix);
+  }
+
+  // Una referencia de hora por segundo: la solución en el segundo exacto
+  // (nano puede ser levemente negativo: el segundo ya viene redondeado)
+  int32_t nano = pvt.nanoNs();
+  if (pvt.utcValid() && pvt.year() >= 2020 && nano > -1000000 &&
+      nano < 1000000) {
+    uint64_t epoch =
+        telemetryEpochFromUtc(pvt.year(), pvt.month(), pvt.day(), pvt.hour(),
+                              pvt.minute(), pvt.second());
+    addTimeReference(epoch * 1000000ULL, true);
+  }
+}
+
+// ============================================================================
+// HORA UTC
+// ============================================================================
+
+void IRAM_ATTR SourceGPS::onPpsInterrupt(void *param) {
+  SourceGPS *self = static_cast<SourceGPS *>(param);
+
+  // 32 bits bajos (escritura atómica); addTimeReference() los extiende
+  self->_ppsLowUs = (uint32_t)esp_timer_get_time();
+  self->_ppsCount++;
+}
+
+void SourceGPS::addTimeReference(uint64_t utcUs, bool onSecond) {
+  uint32_t ppsCount = _ppsCount;
+  bool newEdge = ppsCount != _ppsUsedCount;
+  _ppsUsedCount = ppsCount;
+
+  TelemetryClock &clock = TelemetryClock::getInstance();
+
+  // El mensaje describe el segundo que marcó el flanco PPS previo a su
+  // inicio; un flanco posterior ya es del segundo siguiente
+  if (newEdge && onSecond) {
+    uint64_t edgeUs = telemetryExtendUs(_ppsLowUs, telemetryNowUs());
+    if (edgeUs <= _messageUs && _messageUs - edgeUs < 1000000ULL) {
+      if (clock.addReference(utcUs, edgeUs, TelemetryTimeSource::GPS_PPS))
+        _timeSyncs++;
+      return;
+    }
+  }
+
+  if (clock.addReference(utcUs, _messageUs, TelemetryTimeSource::GPS))
+    _timeSyncs++;
+}
+
+void SourceGPS::printStatus() const {
+  BaseDataSource::printStatus();
+  Serial.printf("[GPS] Mode: %s, fix: %s, sats: %u, PPS pin: %d (edges: "
+                "%lu), time syncs: %lu\n",
+                _ubxActive ? "UBX" : "NMEA", _fix ? "YES" : "NO",
+                (unsigned)_sats, _ppsPin, (unsigned long)_ppsCount,
+                (unsigned long)_timeSyncs);
+  if (_ubxActive) {
+    Serial.printf("[GPS] UBX frames: %lu, checksum errors: %lu, "
+                  "oversize: %lu\n",
+                  (unsigned long)_ubx.getFrames(),
+                  (unsigned long)_ubx.getChecksumErrors(),
+                  (unsigned long)_ubx.getOversize());
+  }
 }
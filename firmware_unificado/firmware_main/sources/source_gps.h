@@ -3,6 +3,15 @@
  * @brief Fuente de datos GPS
  *
  * Lee datos GPS via UART usando TinyGPSPlus y los publica al TelemetryBus.
+ * Dos modos:
+ *   - NMEA (TinyGPSPlus): cualquier receptor, ~1 Hz.
+ *   - UBX (u-blox): al arranque se configura NAV-PVT binario a 1..25 Hz,
+ *     a mayor velocidad de UART y sin NMEA. Si el receptor no confirma,
+ *     se sigue en NMEA.
+ *
+ * Con fix, la solución de cada segundo es además una referencia de hora
+ * UTC para TelemetryClock: el flanco PPS (si está cableado, ~µs) o, sin
+ * él, el instante de llegada del mensaje (latencia de salida, ~ms).
  *
  * @author Neurona Racing Development
  * @date 2024-12-19
@@ -12,6 +21,7 @@
 #define SOURCE_GPS_H
 
 #include "data_source.h"
+#include "ubx_parser.h"
 #include <HardwareSerial.h>
 #include <TinyGPSPlus.h>
 
@@ -37,12 +47,29 @@ public:
   uint8_t getSatellites() const { return _sats; }
   bool hasFix() const { return _fix; }
 
+  void printStatus() const override;
+
 private:
   static void taskFunction(void *param);
   void taskLoop();
 
+  // NMEA
+  void readNmea();
+  void handleRmcTime();
+
+  // UBX
+  bool configureUbx(uint32_t baud, uint8_t rateHz);
+  bool sendUbx(const uint8_t *frame, size_t len); ///< true = ACK-ACK
+  void readUbx();
+  void handleNavPvt(const UbxNavPvtView &pvt);
+
+  // Hora UTC (RMC / NAV-PVT + PPS -> TelemetryClock)
+  static void IRAM_ATTR onPpsInterrupt(void *param);
+  void addTimeReference(uint64_t utcUs, bool onSecond);
+
   HardwareSerial *_serial;
   TinyGPSPlus _gps;
+  UbxParser _ubx;
 
   // Datos actuales (volatile por acceso desde tarea)
   volatile float _lat;
@@ -53,9 +80,20 @@ private:
   volatile uint8_t _sats;
   volatile bool _fix;
 
+  // Hora UTC
+  volatile uint32_t _ppsLowUs; ///< esp_timer (32 bits bajos) del último PPS
+  volatile uint32_t _ppsCount;
+  uint32_t _ppsUsedCount;  ///< _ppsCount en la última RMC procesada
+  uint64_t _messageUs;     ///< Llegada del inicio ('$' / sync UBX) en curso
+  uint32_t _charUs;        ///< Duración de un carácter en la UART
+  uint32_t _timeSyncs;
+
+  bool _ubxActive; ///< Receptor configurado en UBX (si no, NMEA)
+
   // Config
   int8_t _rxPin;
   int8_t _txPin;
+  int8_t _ppsPin;
   uint32_t _baud;
 };
 
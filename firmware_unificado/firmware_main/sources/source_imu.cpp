@@ -158,10 +158,10 @@ void SourceIMU::taskLoop() {
 
     incrementReadCount();
 
-    // Publicar al TelemetryBus
-    TelemetryBus &bus = TelemetryBus::getInstance();
-    bus.setImuAccel(_accelX, _accelY, _accelZ);
-    bus.setImuGyro(_gyroX, _gyroY, _gyroZ);
+    // Publicar al TelemetryBus (accel + gyro de la misma muestra)
+    TelemetryWriteTx tx(TelemetryBus::getInstance());
+    tx.setImuAccel(_accelX, _accelY, _accelZ);
+    tx.setImuGyro(_gyroX, _gyroY, _gyroZ);
   } else {
     // Error de lectura (Resiliencia P1.1)
     _consecutiveErrors++;
@@ -14,6 +14,7 @@
 #include "../config/config_manager.h"
 #include "../telemetry/telemetry_bus.h"
 #include <esp_task_wdt.h>
+#include <obd_pids.h>
 
 // ============================================================================
 // CONSTRUCTOR
@@ -22,10 +23,11 @@
 SourceOBDBridge::SourceOBDBridge()
     : BaseDataSource("OBD_BRIDGE"), _serial(nullptr), _bufferIndex(0),
       _c3Connected(false), _obdEnabled(true), _lastReceiveTime(0), _pidCount(0),
-      _rpm(0), _speed(0), _coolant(0), _throttle(0), _load(0), _maf(0), _map(0),
-      _intakeTemp(0), _oilTemp(0), _fuelLevel(0), _fuelRate(0),
-      _batteryVoltage(0), _rxPin(-1), _txPin(-1), _baud(460800) {
+      _crcErrors(0), _framesLost(0), _lastSeq(0), _seqValid(false),
+      _routeCount(0), _rxPin(-1), _txPin(-1), _baud(460800) {
   memset(_buffer, 0, sizeof(_buffer));
+  memset(&_rxData, 0, sizeof(_rxData));
+  memset(_routes, 0, sizeof(_routes));
 }
 
 // ============================================================================
@@ -67,7 +69,7 @@ bool SourceOBDBridge::begin() {
   Serial.println(F("[OBD_BRIDGE] Ready, waiting for data from C3..."));
 
   // Init Status in TelemetryBus so it appears in JSON immediately
-  TelemetryBus::getInstance().setCustomValue("OBD_Status", 0.0f);
+  TelemetryBus::getInstance().setCustomValue(TelemetryKeys::OBD_STATUS, 0.0f);
 
   return true;
 }
@@ -85,7 +87,7 @@ void SourceOBDBridge::startTask() {
   TaskHandle_t handle = nullptr;
 
   xTaskCreatePinnedToCore(taskFunction, "ObdBridgeTask",
-                          8192, // 8KB stack (JSON parsing)
+                          8192, // 8KB stack (JSON de depuración)
                           this,
                           1, // Prioridad baja
                           &handle,
@@ -136,7 +138,8 @@ void SourceOBDBridge::taskLoop() {
     if (_c3Connected) {
       Serial.println(F("[OBD_BRIDGE] ❌ Connection to C3 LOST (timeout)"));
       _c3Connected = false;
-      TelemetryBus::getInstance().setCustomValue("OBD_Status", 0.0f);
+      TelemetryBus::getInstance().setCustomValue(TelemetryKeys::OBD_STATUS,
+                                                 0.0f);
     }
   }
 
@@ -144,9 +147,11 @@ void SourceOBDBridge::taskLoop() {
   static uint32_t lastStatusLog = 0;
   if (millis() - lastStatusLog >= 5000) {
     lastStatusLog = millis();
-    Serial.printf("[OBD_BRIDGE] Status: C3=%s, PIDs=%d, LastRx=%lums ago\n",
+    Serial.printf("[OBD_BRIDGE] Status: C3=%s, PIDs=%d, LastRx=%lums ago, "
+                  "CRC errors=%lu, lost frames=%lu\n",
                   _c3Connected ? "OK" : "DISC", _pidCount,
-                  _lastReceiveTime > 0 ? (millis() - _lastReceiveTime) : 0);
+                  _lastReceiveTime > 0 ? (millis() - _lastReceiveTime) : 0,
+                  (unsigned long)_crcErrors, (unsigned long)_framesLost);
   }
 
   vTaskDelay(pdMS_TO_TICKS(10));
@@ -161,21 +166,102 @@ void SourceOBDBridge::processC3Data() {
     return;
 
   while (_serial->available()) {
-    char c = _serial->read();
+    uint8_t c = (uint8_t)_serial->read();
 
-    if (c == '\n' || c == '\r') {
-      if (_bufferIndex > 0) {
+    // Línea JSON de depuración en curso
+    if (_bufferIndex > 0) {
+      if (c == '\n' || c == '\r') {
         _buffer[_bufferIndex] = '\0';
         processC3Message(String(_buffer));
         _bufferIndex = 0;
+        continue;
       }
-    } else if (_bufferIndex < OBD_BRIDGE_BUFFER_SIZE - 1) {
-      _buffer[_bufferIndex++] = c;
-    } else {
-      // Buffer overflow, reset
+      if (c >= 0x20 && c < 0x7F) {
+        if (_bufferIndex < OBD_BRIDGE_BUFFER_SIZE - 1) {
+          _buffer[_bufferIndex++] = (char)c;
+        } else {
+          // Buffer overflow, reset
+          _bufferIndex = 0;
+          incrementErrorCount();
+        }
+        continue;
+      }
+      // Byte binario: se perdió el fin de línea y empieza una trama
       _bufferIndex = 0;
       incrementErrorCount();
     }
+
+    if (c == '{' && !_link.inFrame()) {
+      _buffer[_bufferIndex++] = (char)c;
+      continue;
+    }
+
+    switch (_link.push(c)) {
+    case OBD_LINK_FRAME:
+      processC3Frame();
+      break;
+    case OBD_LINK_ERROR_CRC:
+      _crcErrors++;
+      incrementErrorCount();
+      break;
+    case OBD_LINK_ERROR_VERSION:
+      Serial.printf("[OBD_BRIDGE] Unsupported frame version %u\n",
+                    _link.version());
+      incrementErrorCount();
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void SourceOBDBridge::processC3Frame() {
+  // Tramas perdidas (la secuencia es común a todos los tipos)
+  uint8_t seq = _link.seq();
+  if (_seqValid) {
+    _framesLost += (uint8_t)(seq - _lastSeq - 1);
+  }
+  _lastSeq = seq;
+  _seqValid = true;
+
+  const uint8_t *payload = _link.payload();
+  uint8_t len = _link.payloadLen();
+
+  switch (_link.type()) {
+  case OBD_LINK_DATA:
+    if (!obdLinkDecodeData(payload, len, &_rxData)) {
+      Serial.println(F("[OBD_BRIDGE] Malformed DATA frame"));
+      incrementErrorCount();
+      return;
+    }
+    processData(_rxData);
+    incrementReadCount();
+    break;
+
+  case OBD_LINK_STATUS: {
+    if (len < 1)
+      return;
+    static const char *const NAMES[] = {"DISCONNECTED", "CONNECTED", "OFF",
+                                        "ON"};
+    uint8_t status = payload[0];
+    processStatus(status == OBD_LINK_STATUS_CONNECTED,
+                  status < 4 ? NAMES[status] : "?");
+    break;
+  }
+
+  case OBD_LINK_DTC_CLEARED: {
+    if (len < 1)
+      return;
+    static const char *const NAMES[] = {"FAILED", "SUCCESS", "BUSY"};
+    uint8_t result = payload[0];
+    processDtcCleared(result == OBD_LINK_DTC_SUCCESS,
+                      result < 3 ? NAMES[result] : "?");
+    break;
+  }
+
+  default:
+    // Tipo de una versión posterior del C3
+    break;
   }
 }
 
@@ -192,34 +278,87 @@ void SourceOBDBridge::processC3Message(const String &json) {
   String type = doc["t"] | "";
 
   if (type == "DATA") {
-    processDataMessage(doc);
-    incrementReadCount();
-  } else if (type == "OBD_STATUS") {
-    String status = doc["data"] | "";
-    Serial.printf("[OBD_BRIDGE] C3 OBD Status: %s\n", status.c_str());
-    _c3Connected = (status == "CONNECTED" || status == "OK");
+    // Mismo camino que la trama binaria: "0x0C" -> PID 0x0C, "BAT" -> 0xFF
+    // ts_ms de 32 bits (este build no lee enteros de 64 bits del JSON);
+    // solo se usa en ms para fechar las lecturas, así que basta
+    _rxData.tsUs = (uint64_t)(doc["ts_ms"] | (uint32_t)0) * 1000;
+    _rxData.count = 0;
+    _rxData.dtcCount = 0;
+
+    JsonObject pids = doc["pids"];
+    for (JsonPair kv : pids) {
+      if (_rxData.count >= OBD_LINK_MAX_SAMPLES)
+        break;
+      const char *key = kv.key().c_str();
+      ObdLinkSample &sample = _rxData.samples[_rxData.count];
+      if (strcmp(key, "BAT") == 0) {
+        sample.pid = OBD_LINK_PID_BATTERY;
+      } else if (strncmp(key, "0x", 2) == 0) {
+        sample.pid = (uint8_t)strtol(key + 2, nullptr, 16);
+      } else {
+        continue;
+      }
+      sample.value = kv.value().as<float>();
+      sample.ageMs = 0; // Sin antigüedad en JSON: lectura del mensaje
+      _rxData.count++;
+    }
 
-    // CRÍTICO: Actualizar _lastReceiveTime también con heartbeat
-    // Esto evita falsos timeouts cuando C3 está ocupado (scan, DTC) pero vivo
-    if (_c3Connected) {
-      _lastReceiveTime = millis();
+    JsonArray dtcArray = doc["dtc"];
+    for (JsonVariant dtc : dtcArray) {
+      if (_rxData.dtcCount >= OBD_LINK_MAX_DTCS)
+        break;
+      const char *code = dtc.as<const char *>();
+      if (code == nullptr)
+        continue;
+      char *out = _rxData.dtcs[_rxData.dtcCount++];
+      strncpy(out, code, OBD_LINK_DTC_LEN);
+      out[OBD_LINK_DTC_LEN] = '\0';
     }
 
-    // Publish status to shared bus for visibility in Configurator
-    TelemetryBus::getInstance().setValue("OBD_Status",
-                                         _c3Connected ? 1.0f : 0.0f, "", "OBD");
+    processData(_rxData);
+    incrementReadCount();
+  } else if (type == "OBD_STATUS") {
+    String status = doc["data"] | "";
+    processStatus(status == "CONNECTED" || status == "OK", status.c_str());
   } else if (type == "DTC_CLEARED") {
     String result = doc["data"] | "";
-    Serial.printf("[OBD_BRIDGE] DTCs cleared: %s\n", result.c_str());
-    if (result == "OK") {
-      _dtcCodes.clear();
-    }
+    processDtcCleared(result == "SUCCESS" || result == "OK", result.c_str());
   } else {
     Serial.printf("[OBD_BRIDGE] Unknown message type: %s\n", type.c_str());
   }
 }
 
-void SourceOBDBridge::processDataMessage(JsonDocument &doc) {
+void SourceOBDBridge::processStatus(bool connected, const char *status) {
+  Serial.printf("[OBD_BRIDGE] C3 OBD Status: %s\n", status);
+  _c3Connected = connected;
+
+  // CRÍTICO: Actualizar _lastReceiveTime también con heartbeat
+  // Esto evita falsos timeouts cuando C3 está ocupado (scan, DTC) pero vivo
+  if (_c3Connected) {
+    _lastReceiveTime = millis();
+  }
+
+  // Publish status to shared bus for visibility in Configurator
+  TelemetryBus::getInstance().setValue(TelemetryKeys::OBD_STATUS,
+                                       _c3Connected ? 1.0f : 0.0f, "", "OBD");
+}
+
+void SourceOBDBridge::processDtcCleared(bool success, const char *result) {
+  Serial.printf("[OBD_BRIDGE] DTCs cleared: %s\n", result);
+  if (success) {
+    _dtcCodes.clear();
+  }
+}
+
+static float sampleValue(const ObdLinkData &data, uint8_t pid) {
+  for (uint8_t i = 0; i < data.count; i++) {
+    if (data.samples[i].pid == pid)
+      return data.samples[i].value;
+  }
+  return 0;
+}
+
+void SourceOBDBridge::processData(const ObdLinkData &data) {
   _lastReceiveTime = millis();
 
   // Log si es la primera conexión o si se reconectó
@@ -229,110 +368,28 @@ void SourceOBDBridge::processDataMessage(JsonDocument &doc) {
   _c3Connected = true;
 
   // Confirm connection on every data packet
-  TelemetryBus::getInstance().setCustomValue("OBD_Status", 1.0f);
+  TelemetryBus::getInstance().setCustomValue(TelemetryKeys::OBD_STATUS, 1.0f);
 
-  // Procesar PIDs
-  JsonObject pids = doc["pids"];
-  if (!pids.isNull()) {
-    _pidCount = 0;
+  _pidCount = data.count;
 
-    // RPM (0x0C)
-    if (pids.containsKey("0x0C")) {
-      _rpm = pids["0x0C"].as<float>();
-      _pidCount++;
-    }
-
-    // Velocidad (0x0D)
-    if (pids.containsKey("0x0D")) {
-      _speed = pids["0x0D"].as<float>();
-      _pidCount++;
-    }
-
-    // Engine Load (0x04)
-    if (pids.containsKey("0x04")) {
-      _load = pids["0x04"].as<float>();
-      _pidCount++;
-    }
-
-    // Coolant Temp (0x05)
-    if (pids.containsKey("0x05")) {
-      _coolant = pids["0x05"].as<float>();
-      _pidCount++;
-    }
-
-    // Intake Air Temp (0x0F)
-    if (pids.containsKey("0x0F")) {
-      _intakeTemp = pids["0x0F"].as<float>();
-      _pidCount++;
-    }
-
-    // MAF (0x10)
-    if (pids.containsKey("0x10")) {
-      _maf = pids["0x10"].as<float>();
-      _pidCount++;
-    }
-
-    // MAP (0x0B)
-    if (pids.containsKey("0x0B")) {
-      _map = pids["0x0B"].as<float>();
-      _pidCount++;
-    }
-
-    // Throttle (0x11)
-    if (pids.containsKey("0x11")) {
-      _throttle = pids["0x11"].as<float>();
-      _pidCount++;
-    }
-
-    // Fuel Level (0x2F)
-    if (pids.containsKey("0x2F")) {
-      _fuelLevel = pids["0x2F"].as<float>();
-      _pidCount++;
-    }
-
-    // Oil Temp (0x5C)
-    if (pids.containsKey("0x5C")) {
-      _oilTemp = pids["0x5C"].as<float>();
-      _pidCount++;
-    }
-
-    // Fuel Rate (0x5E)
-    if (pids.containsKey("0x5E")) {
-      _fuelRate = pids["0x5E"].as<float>();
-      _pidCount++;
-    }
-
-    // Battery Voltage (custom "BAT")
-    if (pids.containsKey("BAT")) {
-      _batteryVoltage = pids["BAT"].as<float>();
-      _pidCount++;
-    }
-
-    // Control Module Voltage (0x42)
-    if (pids.containsKey("0x42")) {
-      _batteryVoltage = pids["0x42"].as<float>();
-      _pidCount++;
-    }
-  }
-
-  // Procesar DTCs
-  JsonArray dtcArray = doc["dtc"];
-  if (!dtcArray.isNull()) {
-    _dtcCodes.clear();
-    for (JsonVariant dtc : dtcArray) {
-      DtcCode code;
-      strncpy(code.code, dtc.as<const char *>(), sizeof(code.code) - 1);
-      _dtcCodes.push_back(code);
-    }
+  // DTCs: el C3 manda la lista completa en cada mensaje (vacía = sin DTCs)
+  _dtcCodes.clear();
+  for (uint8_t i = 0; i < data.dtcCount; i++) {
+    DtcCode code;
+    memset(&code, 0, sizeof(code));
+    strncpy(code.code, data.dtcs[i], sizeof(code.code) - 1);
+    _dtcCodes.push_back(code);
   }
 
   // Log de PIDs recibidos para diagnóstico
   Serial.printf("[OBD_BRIDGE] 📊 DATA: RPM=%.0f, SPD=%.0f, TEMP=%.0f, "
                 "BATT=%.1f, PIDs=%d\n",
-                _rpm, _speed, _coolant, _batteryVoltage, _pidCount);
+                sampleValue(data, 0x0C), sampleValue(data, 0x0D),
+                sampleValue(data, 0x05),
+                sampleValue(data, OBD_LINK_PID_BATTERY), _pidCount);
 
   // Publicar al bus
-  publishToTelemetryBus();
+  publishToTelemetryBus(data);
 
   // FAST PATH: pedir publish inmediato (sin bloquear) para que el payload
   // completo (GPS/IMU/CAN/OBD) se envíe lo antes posible al MQTT.
@@ -340,36 +397,104 @@ void SourceOBDBridge::processDataMessage(JsonDocument &doc) {
   CloudManager::getInstance().requestImmediatePublish();
 }
 
-void SourceOBDBridge::publishToTelemetryBus() {
+ObdBridgeRoute *SourceOBDBridge::routeFor(uint8_t pid) {
+  for (uint8_t i = 0; i < _routeCount; i++) {
+    if (_routes[i].pid == pid)
+      return &_routes[i];
+  }
+  if (_routeCount >= OBD_BRIDGE_MAX_ROUTES)
+    return nullptr;
+
+  ObdBridgeRoute &route = _routes[_routeCount++];
+  route.pid = pid;
+  route.busField = -1;
+  route.busSlot = TELEMETRY_NO_SLOT;
+  route.published = false;
+  route.lastReadMs = 0;
+
+  // BAT (AT RV) y el voltaje del módulo de control (0x42) van al campo de
+  // batería; el resto según la tabla J1979 o como "obd.<pid hex>"
+  const ObdPidInfo *info = obdMode01Info(pid);
+  TelemetryField field;
+  if (pid == OBD_LINK_PID_BATTERY || pid == 0x42) {
+    route.busField = (int8_t)TelemetryField::BATTERY_VOLTAGE;
+  } else if (info != nullptr && info->busKey != nullptr &&
+             telemetryFieldByKey(info->busKey, field)) {
+    route.busField = (int8_t)field;
+  } else {
+    char key[MAX_KEY_LEN];
+    snprintf(key, sizeof(key), "obd.%x", pid);
+    route.busSlot = TelemetryBus::getInstance().internKey(key);
+  }
+  return &route;
+}
+
+void SourceOBDBridge::publishToTelemetryBus(const ObdLinkData &data) {
+  // Cada lectura se sella con su instante de captura en el reloj de la
+  // telemetría: recepción - antigüedad informada por el C3. Las lecturas
+  // de igual antigüedad (misma ronda de polling) van en una transacción,
+  // así los lectores nunca ven RPM nueva con carga de la ronda anterior
   TelemetryBus &bus = TelemetryBus::getInstance();
+  uint64_t rxUs = telemetryNowUs();
+  uint32_t frameMs = (uint32_t)(data.tsUs / 1000);
+
+  // Lecturas nuevas con destino en el bus
+  const ObdLinkSample *fresh[OBD_LINK_MAX_SAMPLES];
+  ObdBridgeRoute *routes[OBD_LINK_MAX_SAMPLES];
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < data.count; i++) {
+    const ObdLinkSample &sample = data.samples[i];
+
+    // Sin lectura en el último minuto (o nunca leído): no es un dato
+    if (sample.ageMs == 0xFFFF)
+      continue;
+
+    ObdBridgeRoute *route = routeFor(sample.pid);
+    if (route == nullptr)
+      continue;
+
+    // El C3 repite el último valor de cada PID en cada mensaje; solo se
+    // publica si es una lectura nueva, así el bus conserva su antigüedad
+    uint32_t readMs = frameMs - sample.ageMs;
+    if (route->published && sample.ageMs > 0 && readMs == route->lastReadMs)
+      continue;
+    route->published = true;
+    route->lastReadMs = readMs;
+
+    fresh[count] = &sample;
+    routes[count] = route;
+    count++;
+  }
+
+  // Una transacción por antigüedad, de la más antigua a la más reciente
+  // (el sello del grupo del bus queda en la última lectura)
+  while (count > 0) {
+    uint16_t ageMs = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      if (fresh[i]->ageMs > ageMs)
+        ageMs = fresh[i]->ageMs;
+    }
+
+    uint64_t ageUs = (uint64_t)ageMs * 1000;
+    TelemetryWriteTx tx(bus, rxUs > ageUs ? rxUs - ageUs : 0);
 
-  // Publicar todos los valores al bus
-  if (_rpm > 0)
-    bus.setEngineRpm(_rpm);
-  if (_speed >= 0)
-    bus.setEngineSpeed(_speed);
-  if (_coolant > -40)
-    bus.setEngineCoolantTemp(_coolant); // -40 es el mínimo OBD
-  if (_throttle >= 0)
-    bus.setEngineThrottle(_throttle);
-  if (_load >= 0)
-    bus.setEngineLoad(_load);
-  if (_maf >= 0)
-    bus.setEngineMaf(_maf);
-  if (_map > 0)
-    bus.setEngineMap(_map);
-  if (_oilTemp > -40)
-    bus.setEngineOilTemp(_oilTemp);
-  if (_fuelLevel >= 0)
-    bus.setFuelLevel(_fuelLevel);
-  if (_fuelRate >= 0)
-    bus.setFuelRate(_fuelRate);
-  if (_batteryVoltage > 0)
-    bus.setBatteryVoltage(_batteryVoltage);
-
-  // Valores custom para intake temp ya que no hay setter directo
-  if (_intakeTemp > -40) {
-    bus.setCustomValue("engine.intake_temp", _intakeTemp);
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      if (fresh[i]->ageMs != ageMs) {
+        fresh[kept] = fresh[i];
+        routes[kept] = routes[i];
+        kept++;
+        continue;
+      }
+      if (routes[i]->busField >= 0) {
+        tx.setField((TelemetryField)routes[i]->busField, fresh[i]->value);
+      } else {
+        tx.setCustomValueAt(routes[i]->busSlot, fresh[i]->value);
+      }
+    }
+    tx.commit();
+    count = kept;
   }
 }
 
@@ -5,10 +5,17 @@
  * Recibe datos OBD2 del ESP32-C3 que está conectado al ELM327.
  * El C3 actúa como puente WiFi<->UART.
  *
- * Protocolo de entrada (desde C3):
+ * Protocolo de entrada (desde C3): tramas binarias con CRC-16
+ * (shared/obd_protocol/obd_link.h) DATA, OBD_STATUS y DTC_CLEARED. Las
+ * líneas JSON de depuración del C3 (LINK_FORMAT = JSON) se aceptan en el
+ * mismo puerto:
  * - {"t":"DATA", "pids":{"0x0C":5000, "0x0D":120, ...}, "dtc":["P0301"]}
  * - {"t":"OBD_STATUS", "data":"CONNECTED"}
- * - {"t":"DTC_CLEARED", "data":"OK"}
+ * - {"t":"DTC_CLEARED", "data":"SUCCESS"}
+ *
+ * Cada PID se publica en el campo del bus que indica la tabla J1979
+ * (obd_pids.h) o como "obd.<pid hex>", y solo cuando trae una lectura
+ * nueva.
  *
  * @author Neurona Racing Development
  * @date 2024-12-19
@@ -20,12 +27,14 @@
 #include "data_source.h"
 #include <ArduinoJson.h>
 #include <HardwareSerial.h>
+#include <obd_link.h>
 #include <vector>
 
 // Configuración del buffer
 #define OBD_BRIDGE_BUFFER_SIZE 1024
 #define OBD_BRIDGE_TIMEOUT_MS                                                  \
   4000 // Aumentado a 4s para dar margen durante escaneo PIDs del C3
+#define OBD_BRIDGE_MAX_ROUTES 32 // PIDs distintos recibidos del C3
 
 /**
  * @brief Código DTC almacenado
@@ -34,6 +43,17 @@ struct DtcCode {
   char code[8]; // Ej: "P0301"
 };
 
+/**
+ * @brief Destino en el bus de un PID recibido del C3
+ */
+struct ObdBridgeRoute {
+  uint8_t pid;         ///< PID Mode 01 u OBD_LINK_PID_BATTERY
+  int8_t busField;     ///< TelemetryField, -1 = sin campo
+  int16_t busSlot;     ///< Slot "obd.<pid>" en TelemetryBus (sin campo)
+  bool published;      ///< Ya se publicó alguna lectura
+  uint32_t lastReadMs; ///< Reloj del C3 de la última lectura publicada
+};
+
 /**
  * @class SourceOBDBridge
  * @brief Fuente de datos OBD2 via UART bridge con ESP32-C3
@@ -86,14 +106,35 @@ private:
   void processC3Data();
 
   /**
-   * @brief Procesa un mensaje JSON completo del C3
+   * @brief Procesa la trama binaria recién recibida por _link
+   */
+  void processC3Frame();
+
+  /**
+   * @brief Procesa una línea JSON de depuración del C3
    */
   void processC3Message(const String &json);
 
   /**
-   * @brief Procesa mensaje tipo DATA con PIDs
+   * @brief Procesa los PIDs y DTCs de un mensaje DATA (binario o JSON)
+   */
+  void processData(const ObdLinkData &data);
+
+  /**
+   * @brief Procesa OBD_STATUS (binario o JSON)
+   */
+  void processStatus(bool connected, const char *status);
+
+  /**
+   * @brief Procesa DTC_CLEARED (binario o JSON)
    */
-  void processDataMessage(JsonDocument &doc);
+  void processDtcCleared(bool success, const char *result);
+
+  /**
+   * @brief Destino en el bus de un PID (se arma la primera vez)
+   * @return nullptr si no quedan rutas libres
+   */
+  ObdBridgeRoute *routeFor(uint8_t pid);
 
   /**
    * @brief Envía mensaje al C3
@@ -101,15 +142,18 @@ private:
   void sendToC3(const char *type, const char *data);
 
   /**
-   * @brief Publica datos al TelemetryBus
+   * @brief Publica las lecturas nuevas de un mensaje DATA al TelemetryBus,
+   * cada una sellada con su instante de captura (recepción - antigüedad)
    */
-  void publishToTelemetryBus();
+  void publishToTelemetryBus(const ObdLinkData &data);
 
   HardwareSerial *_serial;
 
-  // Buffer de recepción
+  // Recepción: tramas binarias y líneas JSON de depuración
+  ObdLinkParser _link;
   char _buffer[OBD_BRIDGE_BUFFER_SIZE];
   int _bufferIndex;
+  ObdLinkData _rxData;
 
   // Estado
   bool _c3Connected;
@@ -117,19 +161,15 @@ private:
   unsigned long _lastReceiveTime;
   uint8_t _pidCount;
 
-  // Datos OBD recibidos
-  float _rpm;
-  float _speed;
-  float _coolant;
-  float _throttle;
-  float _load;
-  float _maf;
-  float _map;
-  float _intakeTemp;
-  float _oilTemp;
-  float _fuelLevel;
-  float _fuelRate;
-  float _batteryVoltage;
+  // Integridad del enlace
+  uint32_t _crcErrors;
+  uint32_t _framesLost; ///< Huecos en la secuencia de tramas
+  uint8_t _lastSeq;
+  bool _seqValid;
+
+  // Destino en el bus de cada PID recibido
+  ObdBridgeRoute _routes[OBD_BRIDGE_MAX_ROUTES];
+  uint8_t _routeCount;
 
   // DTCs
   std::vector<DtcCode> _dtcCodes;
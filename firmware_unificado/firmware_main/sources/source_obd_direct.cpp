@@ -12,20 +12,7 @@
 #include "../config/config_manager.h"
 #include "../telemetry/telemetry_bus.h"
 #include <esp_task_wdt.h>
-
-// PIDs estándar OBD2 conocidos
-struct StandardPid {
-  uint8_t pid;
-  const char *name;
-};
-
-static const StandardPid STANDARD_PIDS[] = {
-    {0x0C, "RPM"},          {0x0D, "SPEED"},           {0x04, "ENGINE_LOAD"},
-    {0x05, "COOLANT_TEMP"}, {0x0F, "INTAKE_TEMP"},     {0x10, "MAF"},
-    {0x0B, "MAP"},          {0x11, "THROTTLE"},        {0x2F, "FUEL_LEVEL"},
-    {0x5C, "OIL_TEMP"},     {0x42, "CONTROL_VOLTAGE"}, // Voltaje del módulo de
-                                                       // control
-};
+#include <obd_pid_cache.h>
 
 // ============================================================================
 // CONSTRUCTOR
@@ -34,7 +21,10 @@ static const StandardPid STANDARD_PIDS[] = {
 SourceOBDDirect::SourceOBDDirect()
     : BaseDataSource("OBD"), _elmWifiConnected(false), _elmConnected(false),
       _pidCount(0), _activePidCount(0), _currentPidIndex(0),
-      _waitingResponse(false), _pollStartTime(0), _pollIntervalMs(100) {
+      _waitingResponse(false), _pollStartTime(0), _lastResponseMs(0),
+      _batchMode(true),
+      _batchFailures(0), _batchCount(0), _rateStartMs(0),
+      _pollIntervalMs(100) {
   memset(_pids, 0, sizeof(_pids));
   memset(_elmSsid, 0, sizeof(_elmSsid));
   memset(_elmPassword, 0, sizeof(_elmPassword));
@@ -60,8 +50,11 @@ bool SourceOBDDirect::begin() {
 
   // Copiar configuración
   strncpy(_elmSsid, cfg.obd.elm_ssid, sizeof(_elmSsid) - 1);
+  _elmSsid[sizeof(_elmSsid) - 1] = '\0';
   strncpy(_elmPassword, cfg.obd.elm_password, sizeof(_elmPassword) - 1);
+  _elmPassword[sizeof(_elmPassword) - 1] = '\0';
   strncpy(_elmIp, cfg.obd.elm_ip, sizeof(_elmIp) - 1);
+  _elmIp[sizeof(_elmIp) - 1] = '\0';
   _elmPort = cfg.obd.elm_port;
   _pollIntervalMs = cfg.obd.poll_interval_ms;
 
@@ -81,6 +74,7 @@ bool SourceOBDDirect::begin() {
 
 void SourceOBDDirect::parsePidsFromString(const char *pidsStr) {
   _pidCount = 0;
+  _scheduler.clear();
 
   if (pidsStr == nullptr || strlen(pidsStr) == 0) {
     return;
@@ -97,33 +91,61 @@ void SourceOBDDirect::parsePidsFromString(const char *pidsStr) {
     while (*token == ' ')
       token++;
 
-    if (strcasecmp(token, "BAT") == 0) {
+    if (strncasecmp(token, "BAT", 3) == 0) {
       // Caso especial: BAT usa función batteryVoltage()
       _pids[_pidCount].pid = 0xFF; // Marcador especial
       _pids[_pidCount].name = "BATT_V";
+      _pids[_pidCount].busField = (int8_t)TelemetryField::BATTERY_VOLTAGE;
+      _pids[_pidCount].busSlot = TELEMETRY_NO_SLOT;
       _pids[_pidCount].enabled = true;
       _pids[_pidCount].available = true;
       _pidCount++;
     } else if (strncasecmp(token, "0x", 2) == 0) {
-      // PID en formato hexadecimal
+      // PID en formato hexadecimal: fórmula, nombre y campo del bus salen
+      // de la tabla J1979 (obd_pids.h)
       uint8_t pid = (uint8_t)strtol(token, nullptr, 16);
+      const ObdPidInfo *info = obdMode01Info(pid);
+      if (info == nullptr || info->formula == OBD_FORMULA_NONE) {
+        Serial.printf("[OBD] PID 0x%02X has no numeric value, ignored\n",
+                      pid);
+        token = strtok(nullptr, ",");
+        continue;
+      }
 
       _pids[_pidCount].pid = pid;
+      _pids[_pidCount].name = info->name;
       _pids[_pidCount].enabled = true;
       _pids[_pidCount].available = true; // Se verificará en scan
 
-      // Buscar nombre en PIDs estándar
-      _pids[_pidCount].name = "UNKNOWN";
-      for (const auto &std : STANDARD_PIDS) {
-        if (std.pid == pid) {
-          _pids[_pidCount].name = std.name;
-          break;
-        }
+      // PIDs sin campo en el bus se publican como "obd.<pid hex>": la
+      // clave se interna aquí y publishToTelemetryBus() escribe por slot
+      TelemetryField field;
+      _pids[_pidCount].busField = -1;
+      _pids[_pidCount].busSlot = TELEMETRY_NO_SLOT;
+      if (info->busKey != nullptr && telemetryFieldByKey(info->busKey, field)) {
+        _pids[_pidCount].busField = (int8_t)field;
+      } else {
+        char key[MAX_KEY_LEN];
+        snprintf(key, sizeof(key), "obd.%x", pid);
+        _pids[_pidCount].busSlot = TelemetryBus::getInstance().internKey(key);
       }
 
       _pidCount++;
     }
 
+    // Tasa objetivo: la del plan por defecto o "@<Hz>"
+    if (_pidCount > 0 && _scheduler.getCount() < _pidCount) {
+      ObdPid &added = _pids[_pidCount - 1];
+      ObdSchedule plan = obdDefaultSchedule(added.pid);
+      const char *rate = strchr(token, '@');
+      if (rate != nullptr && atof(rate + 1) > 0) {
+        float periodMs = 1000.0f / atof(rate + 1);
+        plan.periodMs = periodMs > 60000.0f ? 60000 : (uint16_t)periodMs;
+      }
+      added.periodMs = plan.periodMs;
+      _scheduler.add(plan.periodMs, plan.priority, added.pid != 0xFF);
+    }
+
     token = strtok(nullptr, ",");
   }
 
@@ -178,8 +200,8 @@ bool SourceOBDDirect::connectToElmDevice() {
 
   Serial.println(F("[OBD] TCP connected, initializing ELM327..."));
 
-  // Inicializar ELM327
-  if (!_elm.begin(_elmClient, true, 2000)) {
+  // Inicializar ELM327 (buffer ampliado para respuestas multitrama)
+  if (!_elm.begin(_elmClient, true, 2000, '0', OBD_ELM_PAYLOAD_LEN)) {
     Serial.println(F("[OBD] ELM327 initialization failed"));
     _elmConnected = false;
     return false;
@@ -188,6 +210,15 @@ bool SourceOBDDirect::connectToElmDevice() {
   Serial.println(F("[OBD] ELM327 ready"));
   _elmConnected = true;
 
+  // Cada conexión vuelve a probar multi-PID (puede ser otro vehículo)
+  _batchMode = true;
+  _batchFailures = 0;
+  _waitingResponse = false;
+  for (int i = 0; i < _pidCount; i++) {
+    _pids[i].samples = 0;
+  }
+  _rateStartMs = millis();
+
   return true;
 }
 
@@ -195,9 +226,74 @@ bool SourceOBDDirect::connectToElmDevice() {
 // ESCANEO DE PIDs
 // ============================================================================
 
+bool SourceOBDDirect::queryBlocking(const char *cmd, uint8_t *bytes,
+                                    size_t *len) {
+  _elm.sendCommand(cmd);
+  do {
+    esp_task_wdt_reset();
+    vTaskDelay(pdMS_TO_TICKS(5));
+    _elm.get_response();
+  } while (_elm.nb_rx_state == ELM_GETTING_MSG);
+
+  if (_elm.nb_rx_state != ELM_SUCCESS) {
+    return false;
+  }
+  *len = obdElmResponseToBytes(_elm.payload, bytes, OBD_MAX_RESPONSE_BYTES);
+  return *len > 0;
+}
+
+bool SourceOBDDirect::discoverSupportedPids(ObdSupportedPids *out) {
+  uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+  size_t len;
+
+  // VIN (Mode 09): si el vehículo ya se vio, no hace falta preguntar más
+  char vin[OBD_VIN_LEN + 1];
+  bool hasVin = queryBlocking("0902", bytes, &len) &&
+                obdParseVin(bytes, len, vin);
+  if (hasVin && obdPidCacheLoad(vin, out)) {
+    Serial.printf("[OBD] VIN %s: supported PIDs from cache\n", vin);
+    return true;
+  }
+
+  // Mapas 0x00, 0x20, ...: el bit 0 de cada uno indica si existe el próximo
+  out->count = 0;
+  uint8_t base = 0x00;
+  while (out->count < OBD_SUPPORTED_MAPS) {
+    char cmd[5];
+    snprintf(cmd, sizeof(cmd), "01%02X", base);
+    uint32_t map;
+    if (!queryBlocking(cmd, bytes, &len) ||
+        !obdParseSupportedMap(bytes, len, base, &map)) {
+      break;
+    }
+    out->maps[out->count++] = map;
+    if ((map & 1) == 0) {
+      break;
+    }
+    base += 0x20;
+  }
+
+  if (out->count == 0) {
+    return false;
+  }
+  if (hasVin) {
+    obdPidCacheStore(vin, *out);
+    Serial.printf("[OBD] VIN %s: supported PIDs cached\n", vin);
+  }
+  return true;
+}
+
 void SourceOBDDirect::scanSupportedPids() {
   Serial.println(F("[OBD] Scanning supported PIDs..."));
 
+  ObdSupportedPids supported;
+  bool discovered = discoverSupportedPids(&supported);
+  if (!discovered) {
+    // Sin mapas (ELM o ECU que no responde 0100): se prueban todos y los
+    // no soportados quedan sin datos
+    Serial.println(F("[OBD] No supported-PID map, polling all PIDs"));
+  }
+
   _activePidCount = 0;
 
   for (int i = 0; i < _pidCount; i++) {
@@ -211,11 +307,17 @@ void SourceOBDDirect::scanSupportedPids() {
       continue;
     }
 
-    // Consultar PID
-    // Usamos un timeout más largo para el scan
-    // TODO: Implementar verificación real con supportedPIDs_1_20, etc.
-    _pids[i].available = true; // Por ahora asumir disponible
-    _activePidCount++;
+    _pids[i].available = !discovered || supported.supports(_pids[i].pid);
+    if (_pids[i].available) {
+      _activePidCount++;
+    } else {
+      Serial.printf("[OBD] PID 0x%02X (%s) not supported\n", _pids[i].pid,
+                    _pids[i].name);
+    }
+  }
+
+  for (int i = 0; i < _pidCount; i++) {
+    _scheduler.setActive(i, _pids[i].enabled && _pids[i].available);
   }
 
   Serial.printf("[OBD] Scan complete: %d PIDs available\n", _activePidCount);
@@ -304,103 +406,166 @@ void SourceOBDDirect::taskLoop() {
     return;
   }
 
-  // Polling secuencial no bloqueante
+  // Polling no bloqueante: el planificador decide qué PIDs tocan y
+  // poll_interval_ms es la pausa mínima entre una respuesta y la próxima
+  // petición
   pollNextPid();
 
-  vTaskDelay(pdMS_TO_TICKS(_pollIntervalMs));
+  vTaskDelay(pdMS_TO_TICKS(_waitingResponse ? 5 : 10));
 }
 
 void SourceOBDDirect::pollNextPid() {
-  // Buscar siguiente PID activo
-  int startIndex = _currentPidIndex;
-  do {
-    if (_pids[_currentPidIndex].enabled && _pids[_currentPidIndex].available) {
-      break;
-    }
-    _currentPidIndex = (_currentPidIndex + 1) % _pidCount;
-  } while (_currentPidIndex != startIndex);
+  if (_waitingResponse) {
+    readPendingResponse();
+    return;
+  }
+
+  if (millis() - _lastResponseMs < _pollIntervalMs) {
+    return;
+  }
+
+  uint8_t limit = _batchMode ? OBD_MAX_BATCH_PIDS : 1;
+  uint8_t picked[OBD_MAX_BATCH_PIDS];
+  uint8_t count = _scheduler.next(millis(), limit, picked);
+  if (count == 0) {
+    return; // Ningún PID vencido todavía
+  }
 
-  ObdPid &pid = _pids[_currentPidIndex];
+  _pollStartTime = millis();
+  _waitingResponse = true;
 
-  if (!pid.enabled || !pid.available) {
-    return; // No hay PIDs activos
+  // BAT no es Mode 01 (AT RV): petición propia vía ELMduino
+  if (_pids[picked[0]].pid == 0xFF) {
+    _currentPidIndex = picked[0];
+    _batchCount = 0;
+    readPendingResponse();
+    return;
   }
 
-  float value = 0;
-  bool success = false;
+  for (uint8_t i = 0; i < count; i++) {
+    _batchPids[i] = _pids[picked[i]].pid;
+    _batchIndex[i] = picked[i];
+  }
+  _batchCount = count;
 
-  // Leer PID
-  if (pid.pid == 0xFF) {
-    // BAT especial
-    value = _elm.batteryVoltage();
-    success = (_elm.nb_rx_state == ELM_SUCCESS);
+  char cmd[OBD_REQUEST_MAX_LEN];
+  obdBuildMode01Request(_batchPids, _batchCount, cmd, sizeof(cmd));
+  _elm.sendCommand(cmd);
+}
+
+void SourceOBDDirect::readPendingResponse() {
+  bool battery = _batchCount == 0;
+  float voltage = 0;
+
+  if (battery) {
+    voltage = _elm.batteryVoltage();
   } else {
-    // Usar funciones específicas de ELMduino según PID
-    switch (pid.pid) {
-    case 0x0C:
-      value = _elm.rpm();
-      break;
-    case 0x0D:
-      value = _elm.kph();
-      break;
-    case 0x04:
-      value = _elm.engineLoad();
-      break;
-    case 0x05:
-      value = _elm.engineCoolantTemp();
-      break;
-    case 0x0F:
-      value = _elm.intakeAirTemp();
-      break;
-    case 0x10:
-      value = _elm.mafRate();
-      break;
-    case 0x0B:
-      value = _elm.manifoldPressure();
-      break;
-    case 0x11:
-      value = _elm.throttle();
-      break;
-    case 0x2F:
-      value = _elm.fuelLevel();
-      break;
-    case 0x5C:
-      value = _elm.oilTemp();
-      break;
-    default:
-      // PID genérico - usar processPID
-      // TODO: Implementar lectura genérica
-      success = false;
-    }
-    success = (_elm.nb_rx_state == ELM_SUCCESS);
+    _elm.get_response();
+  }
+
+  if (_elm.nb_rx_state == ELM_GETTING_MSG) {
+    return; // ELMduino corta con ELM_TIMEOUT si no llega
   }
+  _waitingResponse = false;
+  _lastResponseMs = millis();
+  _scheduler.recordRtt(_lastResponseMs - _pollStartTime);
 
-  if (success) {
-    // Aplicar filtro EMA
-    if (pid.lastRead > 0) {
-      pid.valueFiltered =
-          EMA_ALPHA * value + (1 - EMA_ALPHA) * pid.valueFiltered;
+  if (battery) {
+    if (_elm.nb_rx_state == ELM_SUCCESS) {
+      applyPidValue(_pids[_currentPidIndex], voltage);
     } else {
-      pid.valueFiltered = value;
+      incrementErrorCount();
     }
+  } else {
+    processBatchResponse(_elm.nb_rx_state == ELM_SUCCESS);
+  }
+
+  // Publicar al bus
+  publishToTelemetryBus();
+}
 
-    pid.value = value;
-    pid.lastRead = millis();
+void SourceOBDDirect::processBatchResponse(bool ok) {
+  uint8_t found = 0;
+
+  if (ok) {
+    uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+    ObdPidData data[OBD_MAX_BATCH_PIDS];
+    size_t len = obdElmResponseToBytes(_elm.payload, bytes, sizeof(bytes));
+    found = obdSplitMode01Response(bytes, len, _batchPids, _batchCount, data);
+
+    for (uint8_t i = 0; i < found; i++) {
+      for (uint8_t k = 0; k < _batchCount; k++) {
+        if (_batchPids[k] != data[i].pid)
+          continue;
+        float value;
+        if (obdDecodeMode01(data[i].pid, data[i].data, data[i].len, &value) &&
+            obdMode01InRange(data[i].pid, value)) {
+          applyPidValue(_pids[_batchIndex[k]], value);
+        } else {
+          incrementErrorCount(); // Lectura corrupta o fuera de rango
+        }
+        break;
+      }
+    }
+  }
 
-    incrementReadCount();
-  } else if (_elm.nb_rx_state != ELM_GETTING_MSG) {
+  if (found == 0) {
     incrementErrorCount();
   }
 
-  // Publicar al bus
-  publishToTelemetryBus();
+  // Una ECU sin multi-PID responde con error o solo al primer PID
+  if (_batchMode && _batchCount > 1) {
+    if (found < 2) {
+      if (++_batchFailures >= BATCH_FAIL_LIMIT) {
+        _batchMode = false;
+        Serial.println(
+            F("[OBD] ECU rejects multi-PID requests, polling one PID at a "
+              "time"));
+      }
+    } else {
+      _batchFailures = 0;
+    }
+  }
+}
+
+void SourceOBDDirect::applyPidValue(ObdPid &pid, float value) {
+  // Aplicar filtro EMA
+  if (pid.lastRead > 0) {
+    pid.valueFiltered = EMA_ALPHA * value + (1 - EMA_ALPHA) * pid.valueFiltered;
+  } else {
+    pid.valueFiltered = value;
+  }
 
-  // Siguiente PID
-  _currentPidIndex = (_currentPidIndex + 1) % _pidCount;
+  pid.value = value;
+  pid.lastRead = millis();
+  pid.samples++;
+
+  incrementReadCount();
+}
+
+void SourceOBDDirect::printStatus() const {
+  BaseDataSource::printStatus();
+  Serial.printf("[OBD] Mode: %s, active PIDs: %u, ELM RTT: %lu ms\n",
+                _batchMode ? "MULTI-PID" : "SINGLE PID",
+                (unsigned)_activePidCount,
+                (unsigned long)_scheduler.getRttMs());
+
+  unsigned long elapsedMs = millis() - _rateStartMs;
+  if (!_elmConnected || elapsedMs == 0)
+    return;
+
+  for (int i = 0; i < _pidCount; i++) {
+    if (!_pids[i].enabled || !_pids[i].available)
+      continue;
+    Serial.printf("[OBD]   %-16s %5.2f samples/s (target %.2f)\n",
+                  _pids[i].name, _pids[i].samples * 1000.0f / elapsedMs,
+                  1000.0f / _pids[i].periodMs);
+  }
 }
 
 void SourceOBDDirect::publishToTelemetryBus() {
-  TelemetryBus &bus = TelemetryBus::getInstance();
+  // Todos los PIDs del ciclo en una sola transacción del bus
+  TelemetryWriteTx tx(TelemetryBus::getInstance());
 
   for (int i = 0; i < _pidCount; i++) {
     if (!_pids[i].enabled || !_pids[i].available || _pids[i].lastRead == 0)
@@ -408,40 +573,10 @@ void SourceOBDDirect::publishToTelemetryBus() {
 
     float val = _pids[i].valueFiltered;
 
-    switch (_pids[i].pid) {
-    case 0x0C:
-      bus.setEngineRpm(val);
-      break;
-    case 0x0D:
-      bus.setEngineSpeed(val);
-      break;
-    case 0x04:
-      bus.setEngineLoad(val);
-      break;
-    case 0x05:
-      bus.setEngineCoolantTemp(val);
-      break;
-    case 0x10:
-      bus.setEngineMaf(val);
-      break;
-    case 0x0B:
-      bus.setEngineMap(val);
-      break;
-    case 0x11:
-      bus.setEngineThrottle(val);
-      break;
-    case 0x2F:
-      bus.setFuelLevel(val);
-      break;
-    case 0x5C:
-      bus.setEngineOilTemp(val);
-      break;
-    case 0xFF:
-      bus.setBatteryVoltage(val);
-      break;
-    default:
-      bus.setCustomValue((String("obd.") + String(_pids[i].pid, HEX)).c_str(),
-                         val);
+    if (_pids[i].busField >= 0) {
+      tx.setField((TelemetryField)_pids[i].busField, val);
+    } else {
+      tx.setCustomValueAt(_pids[i].busSlot, val);
     }
   }
 }
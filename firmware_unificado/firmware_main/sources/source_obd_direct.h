@@ -15,6 +15,8 @@
 #include "data_source.h"
 #include <ELMduino.h>
 #include <WiFi.h>
+#include <obd_protocol.h>
+#include <obd_scheduler.h>
 
 // Número máximo de PIDs a monitorear
 #define MAX_OBD_PIDS 20
@@ -30,6 +32,10 @@ struct ObdPid {
   bool available;         ///< PID soportado por el vehículo
   bool enabled;           ///< Habilitado para lectura
   unsigned long lastRead; ///< Timestamp última lectura
+  uint32_t samples;       ///< Lecturas válidas desde la conexión
+  uint16_t periodMs;      ///< Período objetivo (ver ObdScheduler)
+  int8_t busField;        ///< TelemetryField del PID, -1 = sin campo
+  int16_t busSlot;        ///< Slot "obd.<pid>" en TelemetryBus (sin campo)
 };
 
 /**
@@ -56,22 +62,39 @@ public:
 
   /**
    * @brief Escanea PIDs soportados por el vehículo
+   *
+   * Lee el VIN y los mapas de soportados (0100, 0120, ...); los mapas
+   * quedan en NVS por VIN y la próxima conexión al mismo vehículo solo
+   * pide el VIN.
    */
   void scanSupportedPids();
 
   /**
    * @brief Parsea lista de PIDs desde string (ej: "0x0C,0x0D,BAT")
+   *
+   * Acepta cualquier PID con valor numérico de la tabla J1979
+   * (obd_pids.h). Un sufijo "@<Hz>" cambia la tasa objetivo del plan por
+   * defecto (ej: "0x0C@20,0x2F@0.1").
    */
   void parsePidsFromString(const char *pidsStr);
 
+  /**
+   * @brief Estado + modo de lectura y muestras/s efectivas por PID
+   */
+  void printStatus() const override;
+
 private:
   static void taskFunction(void *param);
   void taskLoop();
 
   bool connectToElm327Wifi();
   bool connectToElmDevice();
+  bool queryBlocking(const char *cmd, uint8_t *bytes, size_t *len);
+  bool discoverSupportedPids(ObdSupportedPids *out);
   void pollNextPid();
-  void processPidResult(uint8_t pidIndex);
+  void readPendingResponse();
+  void processBatchResponse(bool ok);
+  void applyPidValue(ObdPid &pid, float value);
   void publishToTelemetryBus();
 
   WiFiClient _elmClient;
@@ -86,9 +109,20 @@ private:
   uint8_t _activePidCount;
 
   // Estado del polling
-  uint8_t _currentPidIndex;
+  ObdScheduler _scheduler;     ///< Canal i = _pids[i]
+  uint8_t _currentPidIndex;    ///< PID pedido solo (BAT)
   bool _waitingResponse;
   unsigned long _pollStartTime;
+  unsigned long _lastResponseMs;
+
+  // Lectura por lotes: hasta OBD_MAX_BATCH_PIDS PIDs por petición Mode 01.
+  // Si la ECU no lo acepta se vuelve a un PID por petición
+  bool _batchMode;
+  uint8_t _batchFailures;
+  uint8_t _batchCount;
+  uint8_t _batchPids[OBD_MAX_BATCH_PIDS];
+  uint8_t _batchIndex[OBD_MAX_BATCH_PIDS];
+  unsigned long _rateStartMs; ///< Base de las muestras/s de printStatus
 
   // Config
   char _elmSsid[32];
@@ -102,6 +136,9 @@ private:
 
   // Timeout para respuesta OBD
   static constexpr uint16_t OBD_TIMEOUT_MS = 1000;
+
+  // Lotes seguidos sin respuesta multi-PID antes de pasar a PID individual
+  static constexpr uint8_t BATCH_FAIL_LIMIT = 3;
 };
 
 #endif // SOURCE_OBD_DIRECT_H
@@ -0,0 +1,157 @@
+/**
+ * @file ubx_parser.cpp
+ * @brief Implementación del parser UBX y de los comandos de configuración
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "ubx_parser.h"
+
+// ============================================================================
+// PARSER
+// ============================================================================
+
+UbxParser::UbxParser()
+    : _state(State::SYNC_1), _class(0), _id(0), _length(0), _pos(0), _ckA(0),
+      _ckB(0), _frames(0), _checksumErrors(0), _oversize(0) {}
+
+void UbxParser::reset() {
+  _state = State::SYNC_1;
+  _length = 0;
+}
+
+bool UbxParser::push(uint8_t byte) {
+  switch (_state) {
+  case State::SYNC_1:
+    if (byte == UBX_SYNC_1)
+      _state = State::SYNC_2;
+    return false;
+
+  case State::SYNC_2:
+    // 0xB5 0xB5 0x62: el segundo 0xB5 puede ser el inicio real
+    if (byte == UBX_SYNC_2) {
+      _state = State::CLASS;
+      _ckA = _ckB = 0;
+    } else if (byte != UBX_SYNC_1) {
+      _state = State::SYNC_1;
+    }
+    return false;
+
+  case State::CLASS:
+    _class = byte;
+    checksum(byte);
+    _state = State::ID;
+    return false;
+
+  case State::ID:
+    _id = byte;
+    checksum(byte);
+    _state = State::LENGTH_LO;
+    return false;
+
+  case State::LENGTH_LO:
+    _length = byte;
+    checksum(byte);
+    _state = State::LENGTH_HI;
+    return false;
+
+  case State::LENGTH_HI:
+    _length |= (uint16_t)byte << 8;
+    checksum(byte);
+    if (_length > UBX_MAX_PAYLOAD) {
+      // Mensaje no pedido (o basura): resincronizar en el próximo 0xB5
+      _oversize++;
+      _state = State::SYNC_1;
+      return false;
+    }
+    _pos = 0;
+    _state = _length > 0 ? State::PAYLOAD : State::CK_A;
+    return false;
+
+  case State::PAYLOAD:
+    _payload[_pos++] = byte;
+    checksum(byte);
+    if (_pos >= _length)
+      _state = State::CK_A;
+    return false;
+
+  case State::CK_A:
+    if (byte != _ckA) {
+      _checksumErrors++;
+      _state = State::SYNC_1;
+      return false;
+    }
+    _state = State::CK_B;
+    return false;
+
+  case State::CK_B:
+    _state = State::SYNC_1;
+    if (byte != _ckB) {
+      _checksumErrors++;
+      return false;
+    }
+    _frames++;
+    return true;
+  }
+
+  return false;
+}
+
+// ============================================================================
+// COMANDOS
+// ============================================================================
+
+size_t ubxBuildFrame(uint8_t cls, uint8_t id, const uint8_t *payload,
+                     uint16_t len, uint8_t *out, size_t cap) {
+  if (cap < (size_t)len + UBX_FRAME_OVERHEAD) {
+    return 0;
+  }
+
+  out[0] = UBX_SYNC_1;
+  out[1] = UBX_SYNC_2;
+  out[2] = cls;
+  out[3] = id;
+  out[4] = (uint8_t)len;
+  out[5] = (uint8_t)(len >> 8);
+  memcpy(out + 6, payload, len);
+
+  uint8_t ckA = 0, ckB = 0;
+  for (size_t i = 2; i < (size_t)len + 6; i++) {
+    ckA += out[i];
+    ckB += ckA;
+  }
+  out[len + 6] = ckA;
+  out[len + 7] = ckB;
+  return (size_t)len + UBX_FRAME_OVERHEAD;
+}
+
+size_t ubxBuildCfgPrt(uint32_t baud, uint8_t *out, size_t cap) {
+  uint8_t p[20] = {0};
+  p[0] = 1;    // portID: UART1
+  p[4] = 0xD0; // mode: 8 bits, sin paridad, 1 stop (0x000008D0)
+  p[5] = 0x08;
+  p[8] = (uint8_t)baud;
+  p[9] = (uint8_t)(baud >> 8);
+  p[10] = (uint8_t)(baud >> 16);
+  p[11] = (uint8_t)(baud >> 24);
+  p[12] = 0x03; // inProtoMask: UBX + NMEA
+  p[14] = 0x01; // outProtoMask: solo UBX
+  return ubxBuildFrame(UBX_CLASS_CFG, UBX_ID_CFG_PRT, p, sizeof(p), out, cap);
+}
+
+size_t ubxBuildCfgMsg(uint8_t cls, uint8_t id, uint8_t rate, uint8_t *out,
+                      size_t cap) {
+  uint8_t p[3] = {cls, id, rate};
+  return ubxBuildFrame(UBX_CLASS_CFG, UBX_ID_CFG_MSG, p, sizeof(p), out, cap);
+}
+
+size_t ubxBuildCfgRate(uint16_t measMs, uint8_t *out, size_t cap) {
+  uint8_t p[6] = {0};
+  p[0] = (uint8_t)measMs;
+  p[1] = (uint8_t)(measMs >> 8);
+  p[2] = 1; // navRate: una solución por medición
+  p[4] = 0; // timeRef: UTC (épocas alineadas al segundo UTC, como el PPS)
+  return ubxBuildFrame(UBX_CLASS_CFG, UBX_ID_CFG_RATE, p, sizeof(p), out,
+                       cap);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file ubx_parser.h
+ * @brief Protocolo binario UBX de u-blox: parser y comandos de configuración
+ *
+ * Trama: 0xB5 0x62 | clase | id | largo (u16 LE) | payload | CK_A CK_B,
+ * con checksum Fletcher-8 sobre clase..payload.
+ *
+ * UbxParser es una máquina de estados byte a byte sin dependencias de
+ * hardware (se prueba en native con capturas del receptor): descarta lo
+ * que no sea UBX (p. ej. NMEA residual), valida el checksum y deja el
+ * payload en un buffer fijo. UbxNavPvtView lee los campos de NAV-PVT
+ * directamente de ese buffer, sin copiarlos a una estructura.
+ *
+ * Los comandos usan la configuración legacy (CFG-PRT/MSG/RATE), que
+ * aceptan los receptores u-blox 6/7/8 y M9.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef UBX_PARSER_H
+#define UBX_PARSER_H
+
+#include <Arduino.h>
+
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+
+// Cabecera (6) + checksum (2)
+#define UBX_FRAME_OVERHEAD 8
+
+// Payload más largo que se procesa (NAV-PVT = 92); los mayores se descartan
+#define UBX_MAX_PAYLOAD 100
+
+// Clases e IDs usados
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+#define UBX_ID_NAV_PVT 0x07
+#define UBX_ID_ACK_NAK 0x00
+#define UBX_ID_ACK_ACK 0x01
+#define UBX_ID_CFG_PRT 0x00
+#define UBX_ID_CFG_MSG 0x01
+#define UBX_ID_CFG_RATE 0x08
+
+#define UBX_NAV_PVT_LEN 92
+
+// Trama de configuración más larga que se construye (CFG-PRT)
+#define UBX_CFG_MAX_FRAME (UBX_FRAME_OVERHEAD + 20)
+
+/**
+ * @class UbxParser
+ * @brief Reensamblado y validación de tramas UBX byte a byte
+ */
+class UbxParser {
+public:
+  UbxParser();
+
+  /**
+   * @brief Procesa un byte
+   * @return true si con este byte se completó una trama con checksum
+   *         válido (disponible en msgClass()/msgId()/payload() hasta el
+   *         próximo push)
+   */
+  bool push(uint8_t byte);
+
+  /// Descarta la trama en curso (los contadores se conservan)
+  void reset();
+
+  /// Entre tramas (el próximo 0xB5 inicia una nueva)
+  bool idle() const { return _state == State::SYNC_1; }
+
+  uint8_t msgClass() const { return _class; }
+  uint8_t msgId() const { return _id; }
+  uint16_t length() const { return _length; }
+  const uint8_t *payload() const { return _payload; }
+
+  bool is(uint8_t cls, uint8_t id) const { return _class == cls && _id == id; }
+
+  uint32_t getFrames() const { return _frames; }
+  uint32_t getChecksumErrors() const { return _checksumErrors; }
+  uint32_t getOversize() const { return _oversize; }
+
+private:
+  enum class State : uint8_t {
+    SYNC_1,
+    SYNC_2,
+    CLASS,
+    ID,
+    LENGTH_LO,
+    LENGTH_HI,
+    PAYLOAD,
+    CK_A,
+    CK_B
+  };
+
+  void checksum(uint8_t byte) {
+    _ckA += byte;
+    _ckB += _ckA;
+  }
+
+  State _state;
+  uint8_t _class;
+  uint8_t _id;
+  uint16_t _length;
+  uint16_t _pos;
+  uint8_t _ckA;
+  uint8_t _ckB;
+  uint8_t _payload[UBX_MAX_PAYLOAD];
+
+  uint32_t _frames;
+  uint32_t _checksumErrors;
+  uint32_t _oversize;
+};
+
+/**
+ * @class UbxNavPvtView
+ * @brief Acceso en su lugar a los campos de un payload NAV-PVT
+ */
+class UbxNavPvtView {
+public:
+  explicit UbxNavPvtView(const uint8_t *payload) : _p(payload) {}
+
+  uint16_t year() const { return u16(4); }
+  uint8_t month() const { return _p[6]; }
+  uint8_t day() const { return _p[7]; }
+  uint8_t hour() const { return _p[8]; }
+  uint8_t minute() const { return _p[9]; }
+  uint8_t second() const { return _p[10]; }
+  int32_t nanoNs() const { return i32(16); } ///< Fracción (puede ser < 0)
+  uint32_t timeAccNs() const { return u32(12); }
+
+  /// Fecha y hora válidas y sin ambigüedad de semana/segundo intercalar
+  bool utcValid() const { return (_p[11] & 0x07) == 0x07; }
+
+  uint8_t fixType() const { return _p[20]; } ///< 2 = 2D, 3 = 3D
+  bool gnssFixOk() const { return (_p[21] & 0x01) != 0; }
+  uint8_t numSv() const { return _p[23]; }
+
+  int32_t lonE7() const { return i32(24); }
+  int32_t latE7() const { return i32(28); }
+  int32_t heightMslMm() const { return i32(36); }
+  uint32_t hAccMm() const { return u32(40); }
+  int32_t groundSpeedMmS() const { return i32(60); }
+  int32_t headingE5() const { return i32(64); } ///< Rumbo de movimiento
+
+private:
+  uint16_t u16(uint8_t at) const {
+    return (uint16_t)(_p[at] | (_p[at + 1] << 8));
+  }
+  uint32_t u32(uint8_t at) const {
+    return (uint32_t)_p[at] | ((uint32_t)_p[at + 1] << 8) |
+           ((uint32_t)_p[at + 2] << 16) | ((uint32_t)_p[at + 3] << 24);
+  }
+  int32_t i32(uint8_t at) const { return (int32_t)u32(at); }
+
+  const uint8_t *_p;
+};
+
+/**
+ * @brief Arma una trama UBX completa (sync, cabecera, checksum)
+ * @return Bytes escritos, 0 si no cabe
+ */
+size_t ubxBuildFrame(uint8_t cls, uint8_t id, const uint8_t *payload,
+                     uint16_t len, uint8_t *out, size_t cap);
+
+/**
+ * @brief CFG-PRT para UART1: 8N1 a baud, entrada UBX+NMEA, salida solo UBX
+ */
+size_t ubxBuildCfgPrt(uint32_t baud, uint8_t *out, size_t cap);
+
+/**
+ * @brief CFG-MSG: tasa de un mensaje en el puerto actual (0 = apagado)
+ */
+size_t ubxBuildCfgMsg(uint8_t cls, uint8_t id, uint8_t rate, uint8_t *out,
+                      size_t cap);
+
+/**
+ * @brief CFG-RATE: período de medición en ms, alineado a UTC
+ */
+size_t ubxBuildCfgRate(uint16_t measMs, uint8_t *out, size_t cap);
+
+#endif // UBX_PARSER_H
@@ -74,6 +74,9 @@ public:
           _state = false;
       }
       break;
+    case FLASH:
+      // Solo como override momentáneo (ver flash())
+      break;
     }
 
     // Flash Override (Higher Priority)
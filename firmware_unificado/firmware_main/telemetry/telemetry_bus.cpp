@@ -13,6 +13,53 @@
 // INICIALIZACIÓN
 // ============================================================================
 
+// Los slots fijos de TelemetryKeys::STANDARD deben coincidir con su posición
+// (los campos del esquema primero, en orden de TelemetryField)
+static constexpr bool standardSlotsInOrder(int16_t i = 0) {
+  return i >= TelemetryKeys::STANDARD_COUNT ||
+         (TelemetryKeys::STANDARD[i].slot == i && standardSlotsInOrder(i + 1));
+}
+static_assert(standardSlotsInOrder(),
+              "TelemetryKeys: slot fijo distinto de la posición en STANDARD");
+static_assert(TelemetryKeys::STANDARD_COUNT <= TELEMETRY_MAX_KEYS,
+              "TELEMETRY_MAX_KEYS no alcanza para las claves estándar");
+
+TelemetryBus::TelemetryBus()
+    : _mutex(nullptr), _seq(0), _version(0), _keyCount(0), _subCount(0),
+      _notifications(0) {
+  // El registro de claves vive desde la construcción: ConfigManager interna
+  // los cloud_id de los sensores antes de TelemetryBus::begin()
+  memset(_keyBuckets, 0xFF, sizeof(_keyBuckets));
+  memset(_genericPos, 0xFF, sizeof(_genericPos));
+  memset(_customPos, 0xFF, sizeof(_customPos));
+  memset(_historyRing, 0xFF, sizeof(_historyRing));
+  memset(_fieldVersion, 0, sizeof(_fieldVersion));
+  memset(_fieldTs, 0, sizeof(_fieldTs));
+  memset(_fieldValue, 0, sizeof(_fieldValue));
+  memset(_fieldDeadline, 0, sizeof(_fieldDeadline));
+  memset(_fieldOutOfRange, 0, sizeof(_fieldOutOfRange));
+  memset(_customSlot, 0xFF, sizeof(_customSlot));
+
+  // Frescura y rango: los del esquema para los campos estándar, sin rango
+  // para el resto
+  for (int16_t i = 0; i < TELEMETRY_MAX_KEYS; i++) {
+    _fieldMaxAge[i] = TELEMETRY_DEFAULT_MAX_AGE_MS;
+    _fieldMin[i] = NAN;
+    _fieldMax[i] = NAN;
+  }
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    _fieldMaxAge[i] = TELEMETRY_FIELDS[i].staleMs;
+    _fieldMin[i] = TELEMETRY_FIELDS[i].min;
+    _fieldMax[i] = TELEMETRY_FIELDS[i].max;
+  }
+
+  // Claves estándar primero: quedan en sus slots fijos
+  for (int16_t i = 0; i < TelemetryKeys::STANDARD_COUNT; i++) {
+    const TelemetryKey &key = TelemetryKeys::STANDARD[i];
+    lookupKey(key.name, key.id, true);
+  }
+}
+
 void TelemetryBus::begin() {
   Serial.println(F("[TELEMETRY] Initializing TelemetryBus..."));
 
@@ -24,8 +71,8 @@ void TelemetryBus::begin() {
     return;
   }
 
-  // Inicializar snapshot a ceros
-  memset(&_snapshot, 0, sizeof(TelemetrySnapshot));
+  // Inicializar snapshot a ceros (inicializadores por defecto del struct)
+  _snapshot = TelemetrySnapshot();
 
   // Inicializar valores genéricos
   _generic_count = 0;
@@ -34,6 +81,18 @@ void TelemetryBus::begin() {
     _generic_keys[i][0] = '\0';
   }
 
+  // Los slots internados se conservan; solo se olvida dónde se escribieron
+  memset(_genericPos, 0xFF, sizeof(_genericPos));
+  memset(_customPos, 0xFF, sizeof(_customPos));
+
+  // _version sigue avanzando: un lector con una versión vieja no confunde
+  // el reinicio con "sin cambios"
+  memset(_fieldVersion, 0, sizeof(_fieldVersion));
+  memset(_fieldTs, 0, sizeof(_fieldTs));
+  memset(_fieldValue, 0, sizeof(_fieldValue));
+  memset(_fieldOutOfRange, 0, sizeof(_fieldOutOfRange));
+  memset(_customSlot, 0xFF, sizeof(_customSlot));
+
   Serial.println(F("[TELEMETRY] TelemetryBus ready"));
 }
 
@@ -54,239 +113,580 @@ void TelemetryBus::giveMutex() {
 }
 
 // ============================================================================
-// ESCRITURA GENÉRICA
+// SEQLOCK HELPERS
 // ============================================================================
 
-bool TelemetryBus::setValue(const String &key, float value, const char *unit,
-                            const char *source) {
+bool TelemetryBus::beginWrite() {
   if (!takeMutex())
     return false;
 
-  int index = -1;
-  const char *keyStr = key.c_str();
+  _writeLocks = _writeLocks + 1;
 
-  // Buscar si ya existe
-  for (int i = 0; i < _generic_count; i++) {
-    if (strcmp(_generic_keys[i], keyStr) == 0) {
-      index = i;
-      break;
+  // Solo el dueño del mutex modifica _seq: impar = escritura en curso
+  _seq.store(_seq.load(std::memory_order_relaxed) + 1,
+             std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return true;
+}
+
+void TelemetryBus::endWrite() {
+  // Publicar datos (y su versión) antes de volver a par
+  _version.store(_version.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+  _seq.store(_seq.load(std::memory_order_relaxed) + 1,
+             std::memory_order_release);
+  giveMutex();
+}
+
+uint32_t TelemetryBus::readBegin() {
+  uint32_t spins = 0;
+  uint32_t seq = _seq.load(std::memory_order_acquire);
+
+  while (seq & 1) {
+    // Un escritor está a mitad de actualización. Si el lector tiene más
+    // prioridad y comparte core con él, girar no lo deja terminar: tras
+    // unos intentos cedemos un tick.
+    if (++spins >= TELEMETRY_SEQLOCK_SPINS) {
+      vTaskDelay(1);
+      spins = 0;
     }
+    seq = _seq.load(std::memory_order_acquire);
   }
+  return seq;
+}
 
-  // Si no existe, buscar slot libre o crear uno
-  if (index == -1 && _generic_count < MAX_CUSTOM_VALUES) {
-    index = _generic_count++;
-    strncpy(_generic_keys[index], keyStr, MAX_KEY_LEN - 1);
-    _generic_keys[index][MAX_KEY_LEN - 1] = '\0';
-  } else if (index == -1) {
-    Serial.printf("[TELEMETRY] CRITICAL: Buffer full! Dropping key: %s\n",
-                  keyStr);
-  }
+bool TelemetryBus::readRetry(uint32_t seq) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (_seq.load(std::memory_order_relaxed) == seq)
+    return false;
 
-  if (index != -1) {
-    _generic_values[index].value = value;
-    _generic_values[index].timestamp = millis();
-    _generic_values[index].updated = true;
-    _generic_values[index].valid = true;
-    strncpy(_generic_values[index].unit, unit,
-            sizeof(_generic_values[index].unit) - 1);
-    strncpy(_generic_values[index].source, source,
-            sizeof(_generic_values[index].source) - 1);
-  }
+  _readRetries = _readRetries + 1;
+  return true;
+}
 
-  giveMutex();
-  return (index != -1);
+// ============================================================================
+// ESCRITURA GENÉRICA
+// ============================================================================
+
+bool TelemetryBus::setValue(const String &key, float value, const char *unit,
+                            const char *source) {
+  return setValueAt(internKey(key.c_str()), value, unit, source);
+}
+
+bool TelemetryBus::setValue(const TelemetryKey &key, float value,
+                            const char *unit, const char *source) {
+  return setValueAt(internKey(key), value, unit, source);
+}
+
+bool TelemetryBus::setValueAt(int16_t slot, float value, const char *unit,
+                              const char *source) {
+  TelemetryWriteTx tx(*this);
+  return tx.setValueAt(slot, value, unit, source);
 }
 
 void TelemetryBus::setValues(const String keys[], const float values[],
                              size_t count, const char *source) {
+  // Internar fuera de la sección de escritura; publicar todo junto
+  int16_t slots[MAX_CUSTOM_VALUES];
+  if (count > MAX_CUSTOM_VALUES)
+    count = MAX_CUSTOM_VALUES;
   for (size_t i = 0; i < count; i++) {
-    setValue(keys[i], values[i], "", source);
+    slots[i] = internKey(keys[i].c_str());
+  }
+
+  TelemetryWriteTx tx(*this);
+  for (size_t i = 0; i < count; i++) {
+    tx.setValueAt(slots[i], values[i], "", source);
+  }
+}
+
+bool TelemetryBus::writeGeneric(int16_t slot, float value, uint64_t now,
+                                const char *unit, const char *source) {
+  if (!validSlot(slot))
+    return false;
+
+  int index = _genericPos[slot];
+
+  // Primera escritura de esta clave: asignar posición en _generic_values
+  if (index < 0 && _generic_count < MAX_CUSTOM_VALUES) {
+    index = _generic_count++;
+    memcpy(_generic_keys[index], _keyNames[slot], MAX_KEY_LEN);
+    _genericPos[slot] = (int8_t)index;
+  } else if (index < 0) {
+    Serial.printf("[TELEMETRY] CRITICAL: Buffer full! Dropping key: %s\n",
+                  _keyNames[slot]);
+    return false;
   }
+
+  _generic_values[index].value = value;
+  _generic_values[index].timestamp_us = now;
+  _generic_values[index].updated = true;
+  _generic_values[index].valid = true;
+  strncpy(_generic_values[index].unit, unit,
+          sizeof(_generic_values[index].unit) - 1);
+  strncpy(_generic_values[index].source, source,
+          sizeof(_generic_values[index].source) - 1);
+  return true;
+}
+
+bool TelemetryBus::writeCustom(int16_t slot, float value) {
+  if (!validSlot(slot))
+    return false;
+
+  int index = _customPos[slot];
+
+  // Primera escritura: la clave entra al snapshot (orden de aparición)
+  if (index < 0 && _snapshot.custom_count < MAX_CUSTOM_VALUES) {
+    index = _snapshot.custom_count++;
+    memcpy(_snapshot.custom_values[index].key, _keyNames[slot], MAX_KEY_LEN);
+    _customPos[slot] = (int8_t)index;
+    _customSlot[index] = slot;
+  } else if (index < 0) {
+    Serial.printf(
+        "[TELEMETRY] CRITICAL: Custom Buffer full! Dropping key: %s\n",
+        _keyNames[slot]);
+    return false;
+  }
+
+  _snapshot.custom_values[index].value = value;
+  _snapshot.custom_values[index].updated = true;
+  return true;
 }
 
 // ============================================================================
-// SETTERS RÁPIDOS
+// SETTERS RÁPIDOS (transacción de un solo campo)
 // ============================================================================
 
+#define TELEMETRY_BUS_SETTER(ID, Setter, member, type, ...)                    \
+  void TelemetryBus::set##Setter(TELEMETRY_CTYPE(type) value) {                \
+    TelemetryWriteTx tx(*this);                                                \
+    tx.set##Setter(value);                                                     \
+  }
+TELEMETRY_SCHEMA(TELEMETRY_BUS_SETTER)
+#undef TELEMETRY_BUS_SETTER
+
+void TelemetryBus::setField(TelemetryField field, float value) {
+  TelemetryWriteTx tx(*this);
+  tx.setField(field, value);
+}
+
 void TelemetryBus::setGps(float lat, float lng, float alt, float speed,
                           float course, uint8_t sats, bool fix) {
-  if (!takeMutex())
-    return;
+  TelemetryWriteTx tx(*this);
+  tx.setGps(lat, lng, alt, speed, course, sats, fix);
+}
 
-  _snapshot.gps_lat = lat;
-  _snapshot.gps_lng = lng;
-  _snapshot.gps_alt = alt;
-  _snapshot.gps_speed = speed;
-  _snapshot.gps_course = course;
-  _snapshot.gps_sats = sats;
-  _snapshot.gps_fix = fix;
-  _snapshot.ts_gps = millis(); // P1.1: timestamp
+void TelemetryBus::setImuAccel(float x, float y, float z) {
+  TelemetryWriteTx tx(*this);
+  tx.setImuAccel(x, y, z);
+}
 
-  giveMutex();
+void TelemetryBus::setImuGyro(float x, float y, float z) {
+  TelemetryWriteTx tx(*this);
+  tx.setImuGyro(x, y, z);
 }
 
-void TelemetryBus::setImuAccel(float x, float y, float z) {
-  if (!takeMutex())
-    return;
+void TelemetryBus::setSuspension(float fl, float fr, float rl, float rr) {
+  TelemetryWriteTx tx(*this);
+  tx.setSuspension(fl, fr, rl, rr);
+}
 
-  _snapshot.imu_accel_x = x;
-  _snapshot.imu_accel_y = y;
-  _snapshot.imu_accel_z = z;
-  _snapshot.ts_imu = millis(); // P1.1: timestamp
+void TelemetryBus::setCustomValue(const char *cloud_id, float value) {
+  setCustomValueAt(internKey(cloud_id), value);
+}
 
-  giveMutex();
+void TelemetryBus::setCustomValue(const TelemetryKey &key, float value) {
+  setCustomValueAt(internKey(key), value);
 }
 
-void TelemetryBus::setImuGyro(float x, float y, float z) {
-  if (!takeMutex())
+void TelemetryBus::setCustomValueAt(int16_t slot, float value) {
+  TelemetryWriteTx tx(*this);
+  tx.setCustomValueAt(slot, value);
+}
+
+// ============================================================================
+// TRANSACCIÓN DE ESCRITURA
+// ============================================================================
+
+TelemetryWriteTx::TelemetryWriteTx(TelemetryBus &bus)
+    : TelemetryWriteTx(bus, telemetryNowUs()) {}
+
+TelemetryWriteTx::TelemetryWriteTx(TelemetryBus &bus, uint64_t sampleUs)
+    : _bus(bus), _snap(bus._snapshot), _now(sampleUs), _fields(0),
+      _changed(0), _open(bus.beginWrite()) {}
+
+void TelemetryWriteTx::commit() {
+  if (!_open)
     return;
+  _open = false;
 
-  _snapshot.imu_gyro_x = x;
-  _snapshot.imu_gyro_y = y;
-  _snapshot.imu_gyro_z = z;
+  // Bajo el mutex: el contador no necesita atómicos
+  _bus._writeFields = _bus._writeFields + _fields;
+  _bus.endWrite();
 
-  giveMutex();
+  if (_changed != 0)
+    _bus.notifySubscribers(_changed);
 }
 
-void TelemetryBus::setEngineRpm(float rpm) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_rpm = rpm;
-  _snapshot.ts_engine = millis(); // P1.1: timestamp
-  giveMutex();
+void TelemetryWriteTx::stamp(TelemetryChannelMask channel) {
+  touch(channel);
+
+  switch (channel) {
+  case TELEMETRY_CH_GPS:
+    _snap.ts_gps_us = _now;
+    break;
+  case TELEMETRY_CH_IMU:
+    _snap.ts_imu_us = _now;
+    break;
+  case TELEMETRY_CH_ENGINE:
+    _snap.ts_engine_us = _now;
+    break;
+  case TELEMETRY_CH_FUEL:
+    _snap.ts_fuel_us = _now;
+    break;
+  case TELEMETRY_CH_BATTERY:
+    _snap.ts_battery_us = _now;
+    break;
+  case TELEMETRY_CH_SUSPENSION:
+    _snap.ts_suspension_us = _now;
+    break;
+  default:
+    break;
+  }
 }
 
-void TelemetryBus::setEngineSpeed(float speed) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_speed = speed;
-  _snapshot.ts_engine = millis(); // P1.1: timestamp (cualquier dato de motor)
-  giveMutex();
+#define TELEMETRY_TX_SETTER(ID, Setter, member, type, key, cloudKey, pid,     \
+                            liveKey, unit, min, max, group, ...)               \
+  void TelemetryWriteTx::set##Setter(TELEMETRY_CTYPE(type) value) {            \
+    if (!_open)                                                                \
+      return;                                                                  \
+    _snap.member = value;                                                      \
+    record(TelemetryKeys::ID, (float)value);                                   \
+    stamp(TELEMETRY_CH_##group);                                               \
+  }
+TELEMETRY_SCHEMA(TELEMETRY_TX_SETTER)
+#undef TELEMETRY_TX_SETTER
+
+void TelemetryWriteTx::setField(TelemetryField field, float value) {
+  switch (field) {
+#define TELEMETRY_TX_SET_FIELD(ID, Setter, member, type, ...)                  \
+  case TelemetryField::ID:                                                     \
+    set##Setter((TELEMETRY_CTYPE(type))value);                                 \
+    break;
+    TELEMETRY_SCHEMA(TELEMETRY_TX_SET_FIELD)
+#undef TELEMETRY_TX_SET_FIELD
+  default:
+    break;
+  }
 }
 
-void TelemetryBus::setEngineCoolantTemp(float temp) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_coolant_temp = temp;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+void TelemetryWriteTx::setGps(float lat, float lng, float alt, float speed,
+                              float course, uint8_t sats, bool fix) {
+  setGpsLat(lat);
+  setGpsLng(lng);
+  setGpsAlt(alt);
+  setGpsSpeed(speed);
+  setGpsCourse(course);
+  setGpsSats(sats);
+  setGpsFix(fix);
 }
 
-void TelemetryBus::setEngineOilTemp(float temp) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_oil_temp = temp;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+void TelemetryWriteTx::setImuAccel(float x, float y, float z) {
+  setImuAccelX(x);
+  setImuAccelY(y);
+  setImuAccelZ(z);
 }
 
-void TelemetryBus::setEngineThrottle(float throttle) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_throttle = throttle;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+void TelemetryWriteTx::setImuGyro(float x, float y, float z) {
+  setImuGyroX(x);
+  setImuGyroY(y);
+  setImuGyroZ(z);
 }
 
-void TelemetryBus::setEngineLoad(float load) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_load = load;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+void TelemetryWriteTx::setSuspension(float fl, float fr, float rl, float rr) {
+  setSuspFl(fl);
+  setSuspFr(fr);
+  setSuspRl(rl);
+  setSuspRr(rr);
 }
 
-void TelemetryBus::setEngineMaf(float maf) {
-  if (!takeMutex())
+void TelemetryWriteTx::setCustomValueAt(int16_t slot, float value) {
+  if (!_open || !_bus.writeCustom(slot, value))
     return;
-  _snapshot.engine_maf = maf;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+  _bus.recordField(slot, _now, value);
+  touch(TELEMETRY_CH_CUSTOM);
 }
 
-void TelemetryBus::setEngineMap(float mapVal) {
-  if (!takeMutex())
-    return;
-  _snapshot.engine_map = mapVal;
-  _snapshot.ts_engine = millis(); // P1.1
-  giveMutex();
+bool TelemetryWriteTx::setValueAt(int16_t slot, float value, const char *unit,
+                                  const char *source) {
+  if (!_open || !_bus.writeGeneric(slot, value, _now, unit, source))
+    return false;
+  _bus.recordField(slot, _now, value);
+  touch(TELEMETRY_CH_GENERIC);
+  return true;
 }
 
-void TelemetryBus::setFuelLevel(float level) {
-  if (!takeMutex())
-    return;
-  _snapshot.fuel_level = level;
-  _snapshot.ts_fuel = millis(); // P1.1
-  giveMutex();
+// ============================================================================
+// SUSCRIPCIONES
+// ============================================================================
+
+int8_t TelemetryBus::subscribe(TelemetryChannelMask mask, TaskHandle_t task,
+                               uint32_t notifyBits) {
+  return addSubscriber(mask, task, nullptr, notifyBits);
 }
 
-void TelemetryBus::setFuelRate(float rate) {
-  if (!takeMutex())
-    return;
-  _snapshot.fuel_rate = rate;
-  _snapshot.ts_fuel = millis(); // P1.1
-  giveMutex();
+int8_t TelemetryBus::subscribeEventGroup(TelemetryChannelMask mask,
+                                         EventGroupHandle_t group,
+                                         EventBits_t bits) {
+  return addSubscriber(mask, nullptr, group, bits);
 }
 
-void TelemetryBus::setFuelTotal(float total) {
-  if (!takeMutex())
-    return;
-  _snapshot.fuel_total = total;
-  _snapshot.ts_fuel = millis(); // P1.1
-  giveMutex();
+int8_t TelemetryBus::addSubscriber(TelemetryChannelMask mask,
+                                   TaskHandle_t task, EventGroupHandle_t group,
+                                   uint32_t bits) {
+  int8_t id = TELEMETRY_NO_SUBSCRIBER;
+
+  portENTER_CRITICAL(&_subMux);
+  uint8_t count = _subCount.load(std::memory_order_relaxed);
+  if (count < TELEMETRY_MAX_SUBSCRIBERS) {
+    Subscriber &sub = _subs[count];
+    sub.mask = mask;
+    sub.task = task;
+    sub.group = group;
+    sub.bits = bits;
+    sub.dirty.store(0, std::memory_order_relaxed);
+    _subCount.store(count + 1, std::memory_order_release);
+    id = (int8_t)count;
+  }
+  portEXIT_CRITICAL(&_subMux);
+
+  if (id == TELEMETRY_NO_SUBSCRIBER) {
+    Serial.println(F("[TELEMETRY] ERROR: Subscriber table full"));
+  }
+  return id;
 }
 
-void TelemetryBus::setBatteryVoltage(float voltage) {
-  if (!takeMutex())
-    return;
-  _snapshot.battery_voltage = voltage;
-  _snapshot.ts_battery = millis(); // P1.1
-  giveMutex();
+TelemetryChannelMask TelemetryBus::takeDirty(int8_t subscriber) {
+  if (subscriber < 0 || subscriber >= (int8_t)getSubscriberCount())
+    return 0;
+  return _subs[subscriber].dirty.exchange(0, std::memory_order_acq_rel);
 }
 
-void TelemetryBus::setSuspension(float fl, float fr, float rl, float rr) {
-  if (!takeMutex())
-    return;
+void TelemetryBus::notifySubscribers(TelemetryChannelMask changed) {
+  uint8_t count = _subCount.load(std::memory_order_acquire);
+
+  for (uint8_t i = 0; i < count; i++) {
+    Subscriber &sub = _subs[i];
+    TelemetryChannelMask pending = changed & sub.mask;
+    if (pending == 0)
+      continue;
+
+    // Ya estaban sucios: el suscriptor fue notificado y aún no los tomó
+    TelemetryChannelMask before =
+        sub.dirty.fetch_or(pending, std::memory_order_acq_rel);
+    if ((before & pending) == pending)
+      continue;
+
+    if (sub.task != nullptr) {
+      xTaskNotify(sub.task, sub.bits, eSetBits);
+    } else if (sub.group != nullptr) {
+      xEventGroupSetBits(sub.group, sub.bits);
+    } else {
+      continue;
+    }
+    _notifications.fetch_add(1, std::memory_order_relaxed);
+  }
+}
 
-  _snapshot.susp_fl = fl;
-  _snapshot.susp_fr = fr;
-  _snapshot.susp_rl = rl;
-  _snapshot.susp_rr = rr;
+// ============================================================================
+// REGISTRO DE CLAVES
+// ============================================================================
 
-  giveMutex();
+int16_t TelemetryBus::lookupKey(const char *key, TelemetryKeyId id,
+                                bool insert) {
+  uint32_t bucket = id & (TELEMETRY_KEY_BUCKETS - 1);
+
+  // Ocupación <= 50%: la cadena termina en el primer bucket vacío
+  for (uint32_t probe = 0; probe < TELEMETRY_KEY_BUCKETS; probe++) {
+    int16_t slot = _keyBuckets[bucket];
+    if (slot < 0)
+      break;
+    if (_keyIds[slot] == id &&
+        strncmp(_keyNames[slot], key, MAX_KEY_LEN - 1) == 0)
+      return slot;
+    bucket = (bucket + 1) & (TELEMETRY_KEY_BUCKETS - 1);
+  }
+
+  uint16_t count = _keyCount.load(std::memory_order_relaxed);
+  if (!insert || count >= TELEMETRY_MAX_KEYS || _keyBuckets[bucket] >= 0)
+    return TELEMETRY_NO_SLOT;
+
+  strncpy(_keyNames[count], key, MAX_KEY_LEN - 1);
+  _keyNames[count][MAX_KEY_LEN - 1] = '\0';
+  _keyIds[count] = id;
+  _keyBuckets[bucket] = (int16_t)count;
+  _keyCount.store(count + 1, std::memory_order_release);
+  return (int16_t)count;
 }
 
-void TelemetryBus::setCustomValue(const char *cloud_id, float value) {
-  if (!takeMutex())
-    return;
+int16_t TelemetryBus::internKey(const TelemetryKey &key) {
+  if (key.slot >= 0)
+    return key.slot; // Clave estándar (internada en el constructor)
 
-  int index = -1;
-  // Buscar en el array de snapshot
-  for (int i = 0; i < _snapshot.custom_count; i++) {
-    if (strcmp(_snapshot.custom_values[i].key, cloud_id) == 0) {
-      index = i;
+  portENTER_CRITICAL(&_keyMux);
+  int16_t slot = lookupKey(key.name, key.id, true);
+  portEXIT_CRITICAL(&_keyMux);
+
+  if (slot < 0) {
+    Serial.printf("[TELEMETRY] CRITICAL: Key registry full! Dropping key: %s\n",
+                  key.name);
+  }
+  return slot;
+}
+
+int16_t TelemetryBus::internKey(const char *key) {
+  // El ID se calcula sobre la clave truncada, igual que la copia guardada
+  char name[MAX_KEY_LEN];
+  strncpy(name, key, MAX_KEY_LEN - 1);
+  name[MAX_KEY_LEN - 1] = '\0';
+  return internKey(TelemetryKey(name));
+}
+
+int16_t TelemetryBus::findKey(const char *key) {
+  char name[MAX_KEY_LEN];
+  strncpy(name, key, MAX_KEY_LEN - 1);
+  name[MAX_KEY_LEN - 1] = '\0';
+
+  portENTER_CRITICAL(&_keyMux);
+  int16_t slot = lookupKey(name, telemetryKeyId(name), false);
+  portEXIT_CRITICAL(&_keyMux);
+  return slot;
+}
+
+// ============================================================================
+// HISTORIAL
+// ============================================================================
+
+uint8_t TelemetryBus::beginHistory(const char *spec, size_t budgetBytes) {
+  int16_t slots[TELEMETRY_HISTORY_MAX_CHANNELS];
+  size_t capacities[TELEMETRY_HISTORY_MAX_CHANNELS];
+  int8_t rings[TELEMETRY_HISTORY_MAX_CHANNELS];
+  uint8_t count = 0;
+
+  if (spec == nullptr || spec[0] == '\0' || budgetBytes == 0)
+    return 0;
+
+  // Parsear "clave:muestras,clave:muestras"
+  char buffer[256];
+  strncpy(buffer, spec, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  char *save = nullptr;
+  for (char *token = strtok_r(buffer, ",", &save); token != nullptr;
+       token = strtok_r(nullptr, ",", &save)) {
+    while (*token == ' ')
+      token++;
+
+    char *colon = strchr(token, ':');
+    long samples = colon ? strtol(colon + 1, nullptr, 10) : 0;
+    if (colon == nullptr || samples <= 0) {
+      Serial.printf("[TELEMETRY] Invalid history entry: %s\n", token);
+      continue;
+    }
+    *colon = '\0';
+
+    if (count >= TELEMETRY_HISTORY_MAX_CHANNELS) {
+      Serial.printf("[TELEMETRY] History: max %d channels, ignoring %s\n",
+                    TELEMETRY_HISTORY_MAX_CHANNELS, token);
       break;
     }
+
+    int16_t slot = internKey(token);
+    if (slot < 0)
+      continue;
+    slots[count] = slot;
+    capacities[count] = (size_t)samples;
+    count++;
   }
 
-  // Si no existe y hay espacio, agregar
-  if (index == -1 && _snapshot.custom_count < MAX_CUSTOM_VALUES) {
-    index = _snapshot.custom_count++;
-    strncpy(_snapshot.custom_values[index].key, cloud_id, MAX_KEY_LEN - 1);
-    _snapshot.custom_values[index].key[MAX_KEY_LEN - 1] = '\0';
-  } else if (index == -1) {
-    Serial.printf(
-        "[TELEMETRY] CRITICAL: Custom Buffer full! Dropping key: %s\n",
-        cloud_id);
+  uint8_t created = _history.begin(capacities, count, budgetBytes, rings);
+
+  // El mapa slot -> ring se publica como cualquier escritura del bus
+  bool locked = beginWrite();
+  for (uint8_t i = 0; i < count; i++) {
+    if (rings[i] >= 0) {
+      _historyRing[slots[i]] = rings[i];
+    }
   }
+  if (locked)
+    endWrite();
+
+  return created;
+}
 
-  if (index != -1) {
-    _snapshot.custom_values[index].value = value;
-    _snapshot.custom_values[index].updated = true;
+bool TelemetryBus::openHistory(const TelemetryKey &key, HistoryCursor &cursor,
+                               bool fromOldest) {
+  int16_t slot = key.slot;
+  if (slot < 0) {
+    portENTER_CRITICAL(&_keyMux);
+    slot = lookupKey(key.name, key.id, false);
+    portEXIT_CRITICAL(&_keyMux);
   }
+  if (!validSlot(slot))
+    return false;
+  return _history.open(_historyRing[slot], cursor, fromOldest);
+}
 
-  giveMutex();
+bool TelemetryBus::openHistory(const char *key, HistoryCursor &cursor,
+                               bool fromOldest) {
+  int16_t slot = findKey(key);
+  if (!validSlot(slot))
+    return false;
+  return _history.open(_historyRing[slot], cursor, fromOldest);
+}
+
+// ============================================================================
+// FRESCURA Y RANGO
+// ============================================================================
+
+bool TelemetryBus::setMaxAgeAt(int16_t slot, uint32_t maxAgeMs) {
+  if (!validSlot(slot) || maxAgeMs == 0)
+    return false;
+  _fieldMaxAge[slot] = maxAgeMs;
+  return true;
+}
+
+bool TelemetryBus::setRangeAt(int16_t slot, float minValue, float maxValue) {
+  if (!validSlot(slot))
+    return false;
+  _fieldMin[slot] = minValue;
+  _fieldMax[slot] = maxValue;
+  return true;
+}
+
+uint8_t TelemetryBus::getQualityAt(int16_t slot) {
+  if (_mutex == nullptr || !validSlot(slot))
+    return TELEMETRY_Q_NEVER;
+
+  uint64_t now = telemetryNowUs();
+  uint8_t quality;
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    quality = qualityAt(slot, now);
+  } while (readRetry(seq));
+
+  return quality;
+}
+
+uint8_t TelemetryBus::getQuality(const TelemetryKey &key) {
+  int16_t slot = key.slot;
+  if (slot < 0) {
+    portENTER_CRITICAL(&_keyMux);
+    slot = lookupKey(key.name, key.id, false);
+    portEXIT_CRITICAL(&_keyMux);
+  }
+  return getQualityAt(slot);
 }
 
 // ============================================================================
@@ -294,76 +694,165 @@ void TelemetryBus::setCustomValue(const char *cloud_id, float value) {
 // ============================================================================
 
 bool TelemetryBus::getValue(const String &key, TelemetryValue &out) {
-  if (!takeMutex())
+  int16_t slot = findKey(key.c_str());
+  if (slot < 0)
+    return false;
+  return getValueAt(slot, out);
+}
+
+bool TelemetryBus::getValue(const TelemetryKey &key, TelemetryValue &out) {
+  int16_t slot = key.slot;
+  if (slot < 0) {
+    portENTER_CRITICAL(&_keyMux);
+    slot = lookupKey(key.name, key.id, false);
+    portEXIT_CRITICAL(&_keyMux);
+  }
+  if (slot < 0)
+    return false;
+  return getValueAt(slot, out);
+}
+
+bool TelemetryBus::getValueAt(int16_t slot, TelemetryValue &out) {
+  if (_mutex == nullptr || !validSlot(slot))
     return false;
 
-  bool found = false;
-  const char *keyStr = key.c_str();
+  bool found;
+  uint32_t seq;
 
-  for (int i = 0; i < _generic_count; i++) {
-    if (strcmp(_generic_keys[i], keyStr) == 0) {
-      out = _generic_values[i];
-      found = true;
-      break;
+  do {
+    seq = readBegin();
+    int index = _genericPos[slot];
+    found = (index >= 0 && index < MAX_CUSTOM_VALUES);
+    if (found) {
+      out = _generic_values[index];
     }
-  }
+  } while (readRetry(seq));
 
-  giveMutex();
   return found;
 }
 
 void TelemetryBus::getSnapshot(TelemetrySnapshot &snapshot) {
-  if (!takeMutex())
+  if (_mutex == nullptr)
     return;
 
-  // Copiar snapshot directo
-  snapshot = _snapshot;
+  // Copiar snapshot directo (sin mutex: se repite si hubo escritura)
+  uint64_t now = telemetryNowUs();
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    snapshot = _snapshot;
+
+    // Calidad: comparación contra el deadline guardado al escribir
+    for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+      snapshot.quality[i] = qualityAt(i, now);
+    }
+    for (uint8_t i = 0; i < snapshot.custom_count; i++) {
+      snapshot.custom_values[i].quality = qualityAt(_customSlot[i], now);
+    }
+  } while (readRetry(seq));
 
   // Agregar metadata
-  uint32_t now = millis();
-  snapshot.uptime_ms = now;
+  snapshot.uptime_ms = (uint32_t)(now / 1000);
+  snapshot.captured_us = now;
   snapshot.wifi_rssi = WiFi.isConnected() ? WiFi.RSSI() : 0;
   snapshot.heap_free = ESP.getFreeHeap();
 
   // ================================================================
-  // P1.1: Calcular flags de validez (stale detection)
-  // Datos son STALE si tienen más de 2000ms de antigüedad
+  // P1.1: Flags de validez (stale detection) desde la calidad por canal
   // ================================================================
-  constexpr uint32_t STALE_THRESHOLD_MS = 2000;
 
   // GPS válido si tiene fix Y datos frescos
-  snapshot.gps_valid = snapshot.gps_fix && (snapshot.ts_gps > 0) &&
-                       ((now - snapshot.ts_gps) < STALE_THRESHOLD_MS);
+  snapshot.gps_valid =
+      snapshot.gps_fix && snapshot.usable(TelemetryField::GPS_FIX);
+
+  // Engine válido si algún dato de motor está fresco (NO depende de RPM>0
+  // para permitir 0)
+  snapshot.engine_valid = false;
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    if (TELEMETRY_FIELDS[i].channel == TELEMETRY_CH_ENGINE &&
+        (snapshot.quality[i] & TELEMETRY_Q_FRESH)) {
+      snapshot.engine_valid = true;
+      break;
+    }
+  }
+}
+
+uint16_t TelemetryBus::getDelta(uint32_t sinceVersion, TelemetryDelta &out) {
+  out.count = 0;
+  if (_mutex == nullptr)
+    return 0;
 
-  // Engine válido si hay RPM > 0 Y datos frescos
-  // Engine válido si hay datos frescos (NO depende de RPM>0 para permitir 0)
-  snapshot.engine_valid = (snapshot.ts_engine > 0) &&
-                          ((now - snapshot.ts_engine) < STALE_THRESHOLD_MS);
+  uint16_t keys = getKeyCount();
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    out.version = _version.load(std::memory_order_relaxed);
+    out.count = 0;
+
+    for (uint16_t slot = 0; slot < keys; slot++) {
+      uint32_t v = _fieldVersion[slot];
+      // Modular: válido mientras el lector no quede 2^31 versiones atrás
+      if (v == 0 || (int32_t)(v - sinceVersion) <= 0)
+        continue;
+
+      TelemetryDeltaEntry &e = out.entries[out.count++];
+      e.slot = (int16_t)slot;
+      e.value = _fieldValue[slot];
+      e.timestamp_us = _fieldTs[slot];
+    }
+  } while (readRetry(seq));
 
-  giveMutex();
+  return out.count;
+}
+
+bool TelemetryBus::getLatest(const TelemetryKey &key, float &value) {
+  int16_t slot = key.slot;
+  if (slot < 0) {
+    portENTER_CRITICAL(&_keyMux);
+    slot = lookupKey(key.name, key.id, false);
+    portEXIT_CRITICAL(&_keyMux);
+  }
+  return getLatestAt(slot, value);
+}
+
+bool TelemetryBus::getLatestAt(int16_t slot, float &value) {
+  if (_mutex == nullptr || !validSlot(slot))
+    return false;
+
+  bool written;
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    written = _fieldVersion[slot] != 0;
+    value = _fieldValue[slot];
+  } while (readRetry(seq));
+
+  return written;
 }
 
 void TelemetryBus::getAllValues(TelemetryValue *outArray,
                                 char keys[][MAX_KEY_LEN], size_t maxCount,
                                 size_t &actualCount) {
-  if (!takeMutex()) {
+  if (_mutex == nullptr) {
     actualCount = 0;
     return;
   }
 
-  actualCount = (_generic_count < maxCount) ? _generic_count : maxCount;
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    actualCount = (_generic_count < maxCount) ? _generic_count : maxCount;
 
-  for (size_t i = 0; i < actualCount; i++) {
-    outArray[i] = _generic_values[i];
-    strncpy(keys[i], _generic_keys[i], MAX_KEY_LEN - 1);
-    keys[i][MAX_KEY_LEN - 1] = '\0';
-  }
-
-  giveMutex();
+    for (size_t i = 0; i < actualCount; i++) {
+      outArray[i] = _generic_values[i];
+      strncpy(keys[i], _generic_keys[i], MAX_KEY_LEN - 1);
+      keys[i][MAX_KEY_LEN - 1] = '\0';
+    }
+  } while (readRetry(seq));
 }
 
 void TelemetryBus::clearUpdatedFlags() {
-  if (!takeMutex())
+  if (!beginWrite())
     return;
 
   for (int i = 0; i < _generic_count; i++) {
@@ -374,54 +863,75 @@ void TelemetryBus::clearUpdatedFlags() {
     _snapshot.custom_values[i].updated = false;
   }
 
-  giveMutex();
+  endWrite();
 }
 
 size_t TelemetryBus::countUpdated() {
-  if (!takeMutex())
+  if (_mutex == nullptr)
     return 0;
 
-  size_t count = 0;
-  for (int i = 0; i < _generic_count; i++) {
-    if (_generic_values[i].updated)
-      count++;
-  }
+  size_t count;
+  uint32_t seq;
+  do {
+    seq = readBegin();
+    count = 0;
 
-  for (int i = 0; i < _snapshot.custom_count; i++) {
-    if (_snapshot.custom_values[i].updated)
-      count++;
-  }
+    for (int i = 0; i < _generic_count && i < MAX_CUSTOM_VALUES; i++) {
+      if (_generic_values[i].updated)
+        count++;
+    }
+
+    for (int i = 0; i < _snapshot.custom_count && i < MAX_CUSTOM_VALUES;
+         i++) {
+      if (_snapshot.custom_values[i].updated)
+        count++;
+    }
+  } while (readRetry(seq));
 
-  giveMutex();
   return count;
 }
 
+// Calidad legible para printStatus()
+static const char *qualityName(uint8_t quality) {
+  if (quality & TELEMETRY_Q_NEVER)
+    return "never";
+  if (quality & TELEMETRY_Q_RANGE)
+    return "range";
+  return (quality & TELEMETRY_Q_FRESH) ? "fresh" : "stale";
+}
+
 void TelemetryBus::printStatus() {
-  if (!takeMutex())
-    return;
+  // Copia consistente primero; Serial es lento y no debe ocurrir dentro
+  // de la ventana de lectura
+  TelemetrySnapshot snap;
+  getSnapshot(snap);
+  uint8_t genericCount = _generic_count;
 
   Serial.println(F("\n========== TELEMETRY BUS STATUS =========="));
-  Serial.printf(
-      "GPS: %.6f, %.6f (alt=%.1fm, speed=%.1f km/h, sats=%d, fix=%s)\n",
-      _snapshot.gps_lat, _snapshot.gps_lng, _snapshot.gps_alt,
-      _snapshot.gps_speed, _snapshot.gps_sats,
-      _snapshot.gps_fix ? "YES" : "NO");
-  Serial.printf("IMU Accel: X=%.2f Y=%.2f Z=%.2f\n", _snapshot.imu_accel_x,
-                _snapshot.imu_accel_y, _snapshot.imu_accel_z);
-  Serial.printf("Engine: RPM=%.0f Speed=%.1f Coolant=%.1f Throttle=%.1f%%\n",
-                _snapshot.engine_rpm, _snapshot.engine_speed,
-                _snapshot.engine_coolant_temp, _snapshot.engine_throttle);
-  Serial.printf("Fuel: Level=%.1f%% Rate=%.2f L/h Total=%.2f L\n",
-                _snapshot.fuel_level, _snapshot.fuel_rate,
-                _snapshot.fuel_total);
-  Serial.printf("Battery: %.2f V\n", _snapshot.battery_voltage);
-  Serial.printf("Custom values: %d\n", _snapshot.custom_count);
-  for (int i = 0; i < _snapshot.custom_count; i++) {
-    Serial.printf("  [%s]: %.2f\n", _snapshot.custom_values[i].key,
-                  _snapshot.custom_values[i].value);
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    const TelemetryFieldInfo &f = TELEMETRY_FIELDS[i];
+    Serial.printf("%-20s %12.6g %-6s %s\n", f.key,
+                  telemetryFieldGet(snap, (TelemetryField)i), f.unit,
+                  qualityName(snap.quality[i]));
+  }
+  Serial.printf("Custom values: %d\n", snap.custom_count);
+  for (int i = 0; i < snap.custom_count; i++) {
+    Serial.printf("  [%s]: %.2f %s\n", snap.custom_values[i].key,
+                  snap.custom_values[i].value,
+                  qualityName(snap.custom_values[i].quality));
   }
-  Serial.printf("Generic values: %d\n", _generic_count);
+  Serial.printf("Generic values: %d\n", genericCount);
+  Serial.printf("Registered keys: %u/%d\n", (unsigned)getKeyCount(),
+                TELEMETRY_MAX_KEYS);
+  Serial.printf("History: %u channels, %u bytes (%s)\n",
+                _history.channelCount(), (unsigned)_history.bytesAllocated(),
+                _history.inPsram() ? "PSRAM" : "RAM");
+  Serial.printf("Seqlock read retries: %lu\n", (unsigned long)_readRetries);
+  Serial.printf("Write locks: %lu (fields: %lu, version: %lu)\n",
+                (unsigned long)_writeLocks, (unsigned long)_writeFields,
+                (unsigned long)getVersion());
+  Serial.printf("Subscribers: %u/%d (notifications: %lu)\n",
+                getSubscriberCount(), TELEMETRY_MAX_SUBSCRIBERS,
+                (unsigned long)getNotifications());
   Serial.println(F("=============================================\n"));
-
-  giveMutex();
 }
@@ -5,8 +5,36 @@
  * TelemetryBus es el buffer central donde todas las fuentes de datos
  * escriben y de donde CloudManager/SerialManager leen.
  *
- * Implementado como Singleton con mutex FreeRTOS para acceso seguro
- * desde múltiples tareas.
+ * Implementado como Singleton. Los escritores se serializan con un mutex
+ * FreeRTOS; los lectores usan un seqlock (contador de secuencia) y nunca
+ * toman el mutex, de modo que un lector lento no retrasa a SourceCAN.
+ *
+ * Una fuente que actualiza varios campos a la vez lo hace dentro de una
+ * TelemetryWriteTx: una sola toma del mutex y un solo avance del seqlock,
+ * así ningún lector ve un estado a medias (RPM nueva con carga vieja).
+ *
+ * Opcionalmente, canales configurados guardan además cada muestra en un
+ * ring de historial (telemetry_history.h) que varios lectores drenan.
+ *
+ * Cada campo lleva la versión del bus en que se escribió por última vez:
+ * getDelta() devuelve solo lo cambiado desde la versión que el lector vio,
+ * sin copiar el snapshot completo.
+ *
+ * Los consumidores no hacen polling: se suscriben a una máscara de canales
+ * y reciben una notificación de tarea (o un bit de event group) cuando una
+ * escritura confirmada toca alguno; cada suscriptor lleva su propio
+ * conjunto de canales sucios.
+ *
+ * Los campos estándar (miembros del snapshot, claves, setters) se generan
+ * desde TELEMETRY_SCHEMA (telemetry_schema.h).
+ *
+ * Todos los sellos de tiempo son µs monotónicos de 64 bits
+ * (telemetry_clock.h), comunes a todas las fuentes.
+ *
+ * Las claves de texto se internan una sola vez en un registro (hash
+ * FNV-1a, calculable en compilación para TelemetryKeys) que devuelve un
+ * slot entero; las fuentes escriben después por slot, en O(1) y sin
+ * comparar cadenas.
  *
  * @author Neurona Racing Development
  * @date 2024-12-19
@@ -15,9 +43,15 @@
 #ifndef TELEMETRY_BUS_H
 #define TELEMETRY_BUS_H
 
+#include "telemetry_clock.h"
+#include "telemetry_history.h"
+#include "telemetry_schema.h"
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -28,14 +62,82 @@
 #define MAX_CUSTOM_VALUES 64
 #define MAX_KEY_LEN 24
 
+// Registro de claves internadas (valores genéricos + custom)
+#define TELEMETRY_MAX_KEYS (2 * MAX_CUSTOM_VALUES)
+#define TELEMETRY_KEY_BUCKETS 256 // Potencia de 2, >= 2 * TELEMETRY_MAX_KEYS
+#define TELEMETRY_NO_SLOT -1
+
+static_assert((TELEMETRY_KEY_BUCKETS & (TELEMETRY_KEY_BUCKETS - 1)) == 0 &&
+                  TELEMETRY_KEY_BUCKETS >= 2 * TELEMETRY_MAX_KEYS,
+              "TELEMETRY_KEY_BUCKETS debe ser potencia de 2 >= 2x claves");
+
+// Reintentos del lector seqlock antes de ceder CPU al escritor (ver readBegin)
+#define TELEMETRY_SEQLOCK_SPINS 8
+
+// ============================================================================
+// CALIDAD POR CANAL
+// ============================================================================
+
+// Bits de calidad (TelemetrySnapshot::quality, CustomValue::quality)
+#define TELEMETRY_Q_FRESH 0x01 // Escrito hace menos de su max-age
+#define TELEMETRY_Q_STALE 0x02 // Escrito, pero más viejo que su max-age
+#define TELEMETRY_Q_NEVER 0x04 // Nunca escrito desde begin()
+#define TELEMETRY_Q_RANGE 0x08 // Último valor fuera del rango del canal
+
+// Max-age de canales sin staleMs en el esquema (custom, genéricos)
+#define TELEMETRY_DEFAULT_MAX_AGE_MS 2000
+
+/**
+ * @brief true si un canal se puede publicar: fresco y dentro de rango
+ */
+inline bool telemetryQualityUsable(uint8_t quality) {
+  return (quality & (TELEMETRY_Q_FRESH | TELEMETRY_Q_RANGE)) ==
+         TELEMETRY_Q_FRESH;
+}
+
+// Suscriptores simultáneos (se registran al arranque, no se liberan)
+#define TELEMETRY_MAX_SUBSCRIBERS 8
+#define TELEMETRY_NO_SUBSCRIBER -1
+
+// ============================================================================
+// IDS DE CLAVE
+// ============================================================================
+
+typedef uint32_t TelemetryKeyId;
+
+/**
+ * @brief Hash FNV-1a de 32 bits de una clave (constexpr)
+ */
+constexpr TelemetryKeyId telemetryKeyId(const char *key,
+                                        TelemetryKeyId h = 2166136261u) {
+  return *key ? telemetryKeyId(key + 1, (h ^ (uint8_t)*key) * 16777619u) : h;
+}
+
+/**
+ * @struct TelemetryKey
+ * @brief Clave con su ID calculado en compilación
+ *
+ * Las claves estándar (TelemetryKeys) además tienen slot fijo: se internan
+ * en ese orden al construir el bus, así que no requieren búsqueda.
+ */
+struct TelemetryKey {
+  const char *name;
+  TelemetryKeyId id;
+  int16_t slot; ///< Slot fijo, o TELEMETRY_NO_SLOT
+
+  constexpr TelemetryKey(const char *keyName,
+                         int16_t fixedSlot = TELEMETRY_NO_SLOT)
+      : name(keyName), id(telemetryKeyId(keyName)), slot(fixedSlot) {}
+};
+
 /**
  * @struct TelemetryValue
  * @brief Valor de telemetría con metadata
  */
 struct TelemetryValue {
-  float value;        ///< Valor numérico
-  uint32_t timestamp; ///< Timestamp en millis()
-  bool updated;       ///< Flag de actualización desde última lectura
+  float value;           ///< Valor numérico
+  uint64_t timestamp_us; ///< Muestra (telemetryNowUs)
+  bool updated;          ///< Flag de actualización desde última lectura
   char unit[8];       ///< Unidad de medida (ej: "km/h", "°C")
   char source[16];    ///< Fuente del dato (ej: "CAN", "OBD", "GPS")
   bool valid;         ///< Slot ocupado/válido
@@ -49,6 +151,27 @@ struct CustomValue {
   char key[MAX_KEY_LEN];
   float value;
   bool updated;
+  uint8_t quality; ///< TELEMETRY_Q_* al tomar el snapshot
+};
+
+/**
+ * @struct TelemetryDeltaEntry
+ * @brief Campo cambiado (ver TelemetryBus::getDelta)
+ */
+struct TelemetryDeltaEntry {
+  int16_t slot;          ///< Slot de la clave (TelemetryBus::getKeyName)
+  float value;           ///< Último valor escrito
+  uint64_t timestamp_us; ///< Muestra (telemetryNowUs)
+};
+
+/**
+ * @struct TelemetryDelta
+ * @brief Campos cambiados desde una versión del bus
+ */
+struct TelemetryDelta {
+  uint32_t version = 0; ///< Versión leída: pasarla en la próxima llamada
+  uint16_t count = 0;
+  TelemetryDeltaEntry entries[TELEMETRY_MAX_KEYS];
 };
 
 /**
@@ -56,50 +179,15 @@ struct CustomValue {
  * @brief Snapshot completo de telemetría para serialización
  */
 struct TelemetrySnapshot {
-  // GPS
-  float gps_lat = 0;
-  float gps_lng = 0;
-  float gps_alt = 0;
-  float gps_speed = 0;
-  float gps_course = 0;
-  uint8_t gps_sats = 0;
-  bool gps_fix = false;
-
-  // IMU
-  float imu_accel_x = 0;
-  float imu_accel_y = 0;
-  float imu_accel_z = 0;
-  float imu_gyro_x = 0;
-  float imu_gyro_y = 0;
-  float imu_gyro_z = 0;
-
-  // Engine (from CAN or OBD)
-  float engine_rpm = 0;
-  float engine_speed = 0;
-  float engine_coolant_temp = 0;
-  float engine_oil_temp = 0;
-  float engine_throttle = 0;
-  float engine_load = 0;
-  float engine_maf = 0;
-  float engine_map = 0;
-  float engine_intake_temp = 0;
-
-  // Fuel
-  float fuel_level = 0;
-  float fuel_rate = 0;
-  float fuel_total = 0;
-
-  // Battery
-  float battery_voltage = 0;
-
-  // Suspensión (MoTeC)
-  float susp_fl = 0;
-  float susp_fr = 0;
-  float susp_rl = 0;
-  float susp_rr = 0;
+  // Campos estándar (TELEMETRY_SCHEMA)
+#define TELEMETRY_SNAPSHOT_MEMBER(ID, Setter, member, type, ...)               \
+  TELEMETRY_CTYPE(type) member = 0;
+  TELEMETRY_SCHEMA(TELEMETRY_SNAPSHOT_MEMBER)
+#undef TELEMETRY_SNAPSHOT_MEMBER
 
   // Metadata
   uint32_t uptime_ms = 0;
+  uint64_t captured_us = 0; ///< telemetryNowUs() al tomar el snapshot
   int8_t wifi_rssi = 0;
   uint32_t heap_free = 0;
 
@@ -108,19 +196,46 @@ struct TelemetrySnapshot {
   uint8_t custom_count = 0;
 
   // ================================================================
-  // TIMESTAMPS POR FUENTE (P1.1 - Detección de datos stale)
+  // TIMESTAMPS POR FUENTE (P1.1, µs monotónicos de la última muestra)
   // ================================================================
-  uint32_t ts_gps = 0;     ///< Último update GPS (millis)
-  uint32_t ts_imu = 0;     ///< Último update IMU (millis)
-  uint32_t ts_engine = 0;  ///< Último update motor CAN/OBD (millis)
-  uint32_t ts_fuel = 0;    ///< Último update combustible (millis)
-  uint32_t ts_battery = 0; ///< Último update batería (millis)
-
-  // Flags de validez (P1.1)
-  bool gps_valid = false;    ///< GPS data is fresh (<2s old)
-  bool engine_valid = false; ///< Engine data is fresh (<2s old)
+  uint64_t ts_gps_us = 0;        ///< Último update GPS
+  uint64_t ts_imu_us = 0;        ///< Último update IMU
+  uint64_t ts_engine_us = 0;     ///< Último update motor CAN/OBD
+  uint64_t ts_fuel_us = 0;       ///< Último update combustible
+  uint64_t ts_battery_us = 0;    ///< Último update batería
+  uint64_t ts_suspension_us = 0; ///< Último update suspensión
+
+  // Flags de validez (P1.1, umbral = max-age del canal)
+  bool gps_valid = false;    ///< GPS data is fresh
+  bool engine_valid = false; ///< Engine data is fresh
+
+  // Calidad por campo estándar (TELEMETRY_Q_*), índice = TelemetryField
+  uint8_t quality[TELEMETRY_FIELD_COUNT] = {};
+
+  /**
+   * @brief true si el campo está fresco y dentro de rango
+   */
+  bool usable(TelemetryField f) const {
+    return telemetryQualityUsable(quality[(uint8_t)f]);
+  }
 };
 
+/**
+ * @brief Lee un campo estándar del snapshot como float
+ */
+inline float telemetryFieldGet(const TelemetrySnapshot &s, TelemetryField f) {
+  switch (f) {
+#define TELEMETRY_FIELD_GET(ID, Setter, member, ...)                           \
+  case TelemetryField::ID:                                                     \
+    return (float)s.member;
+    TELEMETRY_SCHEMA(TELEMETRY_FIELD_GET)
+#undef TELEMETRY_FIELD_GET
+  default:
+    break;
+  }
+  return 0;
+}
+
 /**
  * @class TelemetryBus
  * @brief Singleton para bus de telemetría thread-safe
@@ -159,6 +274,8 @@ public:
    */
   bool setValue(const String &key, float value, const char *unit = "",
                 const char *source = "");
+  bool setValue(const TelemetryKey &key, float value, const char *unit = "",
+                const char *source = "");
 
   /**
    * @brief Establece múltiples valores de una vez (más eficiente)
@@ -174,37 +291,168 @@ public:
   // SETTERS RÁPIDOS (evitan overhead de strings)
   // ========================================================================
 
-  // GPS
+  // Un setter por campo de TELEMETRY_SCHEMA (setEngineRpm, setGpsFix, ...)
+#define TELEMETRY_BUS_SETTER(ID, Setter, member, type, ...)                    \
+  void set##Setter(TELEMETRY_CTYPE(type) value);
+  TELEMETRY_SCHEMA(TELEMETRY_BUS_SETTER)
+#undef TELEMETRY_BUS_SETTER
+
+  /**
+   * @brief Escribe un campo estándar por índice (despacho de SourceCAN)
+   */
+  void setField(TelemetryField field, float value);
+
+  // Grupos que se escriben juntos (una sola versión del bus)
   void setGps(float lat, float lng, float alt, float speed, float course,
               uint8_t sats, bool fix);
-
-  // IMU
   void setImuAccel(float x, float y, float z);
   void setImuGyro(float x, float y, float z);
-
-  // Engine
-  void setEngineRpm(float rpm);
-  void setEngineSpeed(float speed);
-  void setEngineCoolantTemp(float temp);
-  void setEngineOilTemp(float temp);
-  void setEngineThrottle(float throttle);
-  void setEngineLoad(float load);
-  void setEngineMaf(float maf);
-  void setEngineMap(float map);
-
-  // Fuel
-  void setFuelLevel(float level);
-  void setFuelRate(float rate);
-  void setFuelTotal(float total);
-
-  // Battery
-  void setBatteryVoltage(float voltage);
-
-  // Suspension
   void setSuspension(float fl, float fr, float rl, float rr);
 
   // Custom sensor by cloud_id
   void setCustomValue(const char *cloud_id, float value);
+  void setCustomValue(const TelemetryKey &key, float value);
+
+  // ========================================================================
+  // REGISTRO DE CLAVES (escritura por slot, sin strings)
+  // ========================================================================
+
+  /**
+   * @brief Interna una clave y devuelve su slot (idempotente)
+   *
+   * Thread-safe y utilizable antes de begin(): se llama al cargar la
+   * configuración, no en cada escritura.
+   *
+   * @param key Clave (se trunca a MAX_KEY_LEN - 1)
+   * @return Slot, o TELEMETRY_NO_SLOT si el registro está lleno
+   */
+  int16_t internKey(const char *key);
+  int16_t internKey(const TelemetryKey &key);
+
+  /**
+   * @brief Busca el slot de una clave sin registrarla
+   * @return Slot, o TELEMETRY_NO_SLOT si nunca se internó
+   */
+  int16_t findKey(const char *key);
+
+  /**
+   * @brief Escribe un valor genérico por slot (ver setValue)
+   */
+  bool setValueAt(int16_t slot, float value, const char *unit = "",
+                  const char *source = "");
+
+  /**
+   * @brief Escribe un valor custom del snapshot por slot (ver setCustomValue)
+   */
+  void setCustomValueAt(int16_t slot, float value);
+
+  // ========================================================================
+  // FRESCURA Y RANGO POR CANAL
+  // ========================================================================
+
+  /**
+   * @brief Configura la antigüedad máxima de un canal
+   *
+   * Por defecto: staleMs del esquema para los campos estándar,
+   * TELEMETRY_DEFAULT_MAX_AGE_MS para el resto. Se aplica desde la próxima
+   * escritura del canal (configuración, no camino crítico).
+   *
+   * @return false si el slot no existe o maxAgeMs es 0
+   */
+  bool setMaxAgeAt(int16_t slot, uint32_t maxAgeMs);
+
+  /**
+   * @brief Configura el rango válido de un canal (NAN = sin límite)
+   * @return false si el slot no existe
+   */
+  bool setRangeAt(int16_t slot, float minValue, float maxValue);
+
+  /**
+   * @brief Calidad actual de un canal (TELEMETRY_Q_*)
+   *
+   * El rango se evalúa al escribir y el vencimiento se guarda como
+   * deadline absoluto: leer la calidad es una comparación, sin recorrer
+   * timestamps por fuente.
+   */
+  uint8_t getQualityAt(int16_t slot);
+  uint8_t getQuality(const TelemetryKey &key);
+
+  // ========================================================================
+  // HISTORIAL DE ALTA FRECUENCIA
+  // ========================================================================
+
+  /**
+   * @brief Reserva los rings de historial (una vez, antes de las fuentes)
+   * @param spec Canales "clave:muestras,clave:muestras" (ej:
+   *        "imu.accel_x:1024,suspension.fl:512")
+   * @param budgetBytes Memoria máxima para todos los rings
+   * @return Número de canales con historial
+   */
+  uint8_t beginHistory(const char *spec, size_t budgetBytes);
+
+  /**
+   * @brief Abre un cursor de lectura sobre el historial de una clave
+   * @param fromOldest true = desde la muestra más vieja disponible
+   * @return false si la clave no tiene historial
+   */
+  bool openHistory(const TelemetryKey &key, HistoryCursor &cursor,
+                   bool fromOldest = true);
+  bool openHistory(const char *key, HistoryCursor &cursor,
+                   bool fromOldest = true);
+
+  /**
+   * @brief Rings de historial (peek/consume con el cursor abierto)
+   */
+  const TelemetryHistory &getHistory() const { return _history; }
+
+  // ========================================================================
+  // SUSCRIPCIONES (notificación por cambio, sin polling)
+  // ========================================================================
+
+  /**
+   * @brief Registra un consumidor de cambios
+   *
+   * Al confirmarse una escritura que toca canales de mask, éstos se marcan
+   * en el conjunto sucio del suscriptor y, si estaban limpios, se notifica
+   * a la tarea con xTaskNotify(task, notifyBits, eSetBits). Mientras el
+   * suscriptor no llame a takeDirty() no recibe más notificaciones: un
+   * escritor a 1 kHz no despierta 1000 veces a un consumidor lento.
+   *
+   * task = nullptr registra un suscriptor solo de consulta (takeDirty).
+   *
+   * @return Id de suscriptor, o TELEMETRY_NO_SUBSCRIBER si no hay lugar
+   */
+  int8_t subscribe(TelemetryChannelMask mask, TaskHandle_t task = nullptr,
+                   uint32_t notifyBits = 0);
+
+  /**
+   * @brief Igual que subscribe(), señalizando bits de un event group
+   */
+  int8_t subscribeEventGroup(TelemetryChannelMask mask,
+                             EventGroupHandle_t group, EventBits_t bits);
+
+  /**
+   * @brief Toma y limpia los canales cambiados del suscriptor
+   * @return Canales escritos desde la llamada anterior (0 = nada nuevo)
+   */
+  TelemetryChannelMask takeDirty(int8_t subscriber);
+
+  /**
+   * @brief Suscriptores registrados / notificaciones enviadas (diagnóstico)
+   */
+  uint8_t getSubscriberCount() const {
+    return _subCount.load(std::memory_order_acquire);
+  }
+  uint32_t getNotifications() const {
+    return _notifications.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Número de claves internadas
+   */
+  uint16_t getKeyCount() const {
+    return _keyCount.load(std::memory_order_acquire);
+  }
 
   // ========================================================================
   // MÉTODOS DE LECTURA (para CloudManager/SerialManager)
@@ -217,6 +465,8 @@ public:
    * @return true si el valor existe
    */
   bool getValue(const String &key, TelemetryValue &out);
+  bool getValue(const TelemetryKey &key, TelemetryValue &out);
+  bool getValueAt(int16_t slot, TelemetryValue &out);
 
   /**
    * @brief Obtiene un snapshot completo de todos los valores
@@ -224,6 +474,41 @@ public:
    */
   void getSnapshot(TelemetrySnapshot &snapshot);
 
+  /**
+   * @brief Campos escritos después de una versión del bus
+   *
+   * Recorre las versiones por campo (4 bytes por clave) y copia solo los
+   * cambiados: el costo depende de lo que cambió, no del tamaño de
+   * TelemetrySnapshot. Primera llamada con sinceVersion = 0 (todo lo
+   * escrito alguna vez); después, con out.version de la anterior.
+   *
+   *   static uint32_t seen = 0;
+   *   bus.getDelta(seen, delta);
+   *   ... delta.entries[0..count) ...
+   *   seen = delta.version;
+   *
+   * Los valores son el último escrito de cada campo (campos estándar,
+   * custom y genéricos por igual); los flags derivados de getSnapshot()
+   * (gps_valid, heap_free, ...) no forman parte del delta.
+   *
+   * @return Número de campos cambiados (out.count)
+   */
+  uint16_t getDelta(uint32_t sinceVersion, TelemetryDelta &out);
+
+  /**
+   * @brief Último valor escrito de un campo, sin copiar el snapshot
+   * @return false si el campo nunca se escribió
+   */
+  bool getLatest(const TelemetryKey &key, float &value);
+  bool getLatestAt(int16_t slot, float &value);
+
+  /**
+   * @brief Nombre de una clave internada (nullptr si el slot no existe)
+   */
+  const char *getKeyName(int16_t slot) const {
+    return validSlot(slot) ? _keyNames[slot] : nullptr;
+  }
+
   /**
    * @brief Obtiene todos los valores (solo para debug/serialización controlada)
    */
@@ -232,6 +517,9 @@ public:
 
   /**
    * @brief Resetea todos los flags "updated"
+   *
+   * Los flags son compartidos por todos los lectores: para detectar datos
+   * nuevos usar subscribe()/takeDirty().
    */
   void clearUpdatedFlags();
 
@@ -246,11 +534,48 @@ public:
    */
   void printStatus();
 
+  /**
+   * @brief Número de lecturas que tuvieron que reintentarse (debug seqlock)
+   */
+  uint32_t getReadRetries() const { return _readRetries; }
+
+  /**
+   * @brief Versión de los datos: avanza 1 por escritura/transacción
+   *
+   * Da la vuelta a 2^32; getDelta() compara con aritmética modular.
+   */
+  uint32_t getVersion() const {
+    return _version.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Tomas del mutex de escritura y campos escritos (diagnóstico)
+   *
+   * writeFields / writeLocks es el número medio de campos por toma: 1.0
+   * sin transacciones, > 1 cuando las fuentes agrupan sus escrituras.
+   */
+  uint32_t getWriteLocks() const { return _writeLocks; }
+  uint32_t getWriteFields() const { return _writeFields; }
+
 private:
-  TelemetryBus() : _mutex(nullptr) {}
+  friend class TelemetryWriteTx;
+
+  TelemetryBus();
 
   SemaphoreHandle_t _mutex;
 
+  // ================================================================
+  // SEQLOCK
+  // _seq es par cuando los datos son estables e impar mientras un
+  // escritor está modificando _snapshot/_generic_*. Los lectores copian
+  // sin mutex y repiten la copia si _seq cambió durante la misma.
+  // ================================================================
+  std::atomic<uint32_t> _seq;
+  std::atomic<uint32_t> _version; ///< Escrituras publicadas (getVersion)
+  volatile uint32_t _readRetries = 0;
+  volatile uint32_t _writeLocks = 0;  ///< Tomas del mutex de escritura
+  volatile uint32_t _writeFields = 0; ///< Campos escritos en ellas
+
   // Datos del snapshot (acceso rápido)
   TelemetrySnapshot _snapshot;
 
@@ -259,58 +584,236 @@ private:
   char _generic_keys[MAX_CUSTOM_VALUES][MAX_KEY_LEN];
   uint8_t _generic_count = 0;
 
+  // ================================================================
+  // REGISTRO DE CLAVES
+  // Solo crece. _keyNames/_keyIds de un slot se escriben antes de
+  // publicar _keyCount; la tabla hash se accede bajo _keyMux.
+  // _genericPos/_customPos (slot -> posición en _generic_values /
+  // _snapshot.custom_values, -1 = aún no escrito) solo cambian bajo
+  // el mutex de escritura, y begin() los reinicia.
+  // ================================================================
+  char _keyNames[TELEMETRY_MAX_KEYS][MAX_KEY_LEN];
+  TelemetryKeyId _keyIds[TELEMETRY_MAX_KEYS];
+  int16_t _keyBuckets[TELEMETRY_KEY_BUCKETS]; ///< -1 = vacío
+  std::atomic<uint16_t> _keyCount;
+  portMUX_TYPE _keyMux = portMUX_INITIALIZER_UNLOCKED;
+  int8_t _genericPos[TELEMETRY_MAX_KEYS];
+  int8_t _customPos[TELEMETRY_MAX_KEYS];
+
+  // ================================================================
+  // HISTORIAL
+  // _historyRing (slot -> ring, -1 = sin historial) solo cambia en
+  // beginHistory(), antes de que arranquen las fuentes.
+  // ================================================================
+  TelemetryHistory _history;
+  int8_t _historyRing[TELEMETRY_MAX_KEYS];
+
+  // ================================================================
+  // SUSCRIPCIONES
+  // Un slot de _subs se completa bajo _subMux antes de publicar
+  // _subCount; después solo cambia dirty (atómico).
+  // ================================================================
+  struct Subscriber {
+    TelemetryChannelMask mask = 0;
+    TaskHandle_t task = nullptr;
+    EventGroupHandle_t group = nullptr;
+    uint32_t bits = 0;
+    std::atomic<TelemetryChannelMask> dirty{0};
+  };
+  Subscriber _subs[TELEMETRY_MAX_SUBSCRIBERS];
+  std::atomic<uint8_t> _subCount;
+  std::atomic<uint32_t> _notifications;
+  portMUX_TYPE _subMux = portMUX_INITIALIZER_UNLOCKED;
+
+  int8_t addSubscriber(TelemetryChannelMask mask, TaskHandle_t task,
+                       EventGroupHandle_t group, uint32_t bits);
+
+  // Tras liberar el mutex: notificar no debe alargar la sección de escritura
+  void notifySubscribers(TelemetryChannelMask changed);
+
+  // ================================================================
+  // ÚLTIMO VALOR Y VERSIÓN POR CAMPO (getDelta)
+  // Solo bajo el mutex de escritura; se leen con el seqlock.
+  // _fieldVersion = 0: nunca escrito.
+  // ================================================================
+  uint32_t _fieldVersion[TELEMETRY_MAX_KEYS];
+  uint64_t _fieldTs[TELEMETRY_MAX_KEYS];
+  float _fieldValue[TELEMETRY_MAX_KEYS];
+
+  // ================================================================
+  // CALIDAD POR CAMPO
+  // _fieldMaxAge/_fieldMin/_fieldMax: configuración (setMaxAgeAt,
+  // setRangeAt). _fieldDeadline (µs, = ts + max-age) y _fieldOutOfRange se
+  // calculan en recordField(), bajo el mutex de escritura.
+  // _customSlot: posición en _snapshot.custom_values -> slot.
+  // ================================================================
+  uint32_t _fieldMaxAge[TELEMETRY_MAX_KEYS];
+  float _fieldMin[TELEMETRY_MAX_KEYS];
+  float _fieldMax[TELEMETRY_MAX_KEYS];
+  uint64_t _fieldDeadline[TELEMETRY_MAX_KEYS];
+  bool _fieldOutOfRange[TELEMETRY_MAX_KEYS];
+  int16_t _customSlot[MAX_CUSTOM_VALUES];
+
+  // Dentro de una sección de lectura (o de escritura)
+  uint8_t qualityAt(int16_t slot, uint64_t nowUs) const {
+    if (_fieldVersion[slot] == 0)
+      return TELEMETRY_Q_NEVER;
+    uint8_t q = nowUs < _fieldDeadline[slot] ? TELEMETRY_Q_FRESH
+                                             : TELEMETRY_Q_STALE;
+    return _fieldOutOfRange[slot] ? (uint8_t)(q | TELEMETRY_Q_RANGE) : q;
+  }
+
+  // Bajo el mutex de escritura: versión del campo (la que publicará la
+  // escritura en curso), calidad y ring de historial
+  void recordField(int16_t slot, uint64_t ts, float value) {
+    _fieldVersion[slot] = _version.load(std::memory_order_relaxed) + 1;
+    _fieldTs[slot] = ts;
+    _fieldValue[slot] = value;
+    _fieldDeadline[slot] = ts + (uint64_t)_fieldMaxAge[slot] * 1000ULL;
+    // NaN siempre fuera de rango; un límite NAN nunca se excede
+    _fieldOutOfRange[slot] = value != value || value < _fieldMin[slot] ||
+                             value > _fieldMax[slot];
+
+    int8_t ring = _historyRing[slot];
+    if (ring >= 0)
+      _history.push(ring, ts, value);
+  }
+
+  // Escritura por slot dentro de una sección de escritura
+  bool writeGeneric(int16_t slot, float value, uint64_t now, const char *unit,
+                    const char *source);
+  bool writeCustom(int16_t slot, float value);
+
+  // Busca/inserta en la tabla hash (bajo _keyMux)
+  int16_t lookupKey(const char *key, TelemetryKeyId id, bool insert);
+  bool validSlot(int16_t slot) const {
+    return slot >= 0 && slot < (int16_t)getKeyCount();
+  }
+
   // Helper para tomar mutex
   bool
   takeMutex(TickType_t timeout = pdMS_TO_TICKS(TELEMETRY_MUTEX_TIMEOUT_MS));
   void giveMutex();
+
+  // Sección de escritura: mutex entre escritores + _seq impar
+  bool beginWrite();
+  void endWrite();
+
+  // Sección de lectura: copiar entre readBegin() y readRetry()
+  uint32_t readBegin();
+  bool readRetry(uint32_t seq);
+};
+
+// ============================================================================
+// TRANSACCIÓN DE ESCRITURA
+// ============================================================================
+
+/**
+ * @class TelemetryWriteTx
+ * @brief Actualización atómica de varios campos del bus
+ *
+ * Toma el mutex al construirse y publica todos los cambios en commit() (o
+ * al salir de scope). Mientras está abierta, los lectores siguen viendo
+ * la versión anterior completa.
+ *
+ *   TelemetryWriteTx tx(TelemetryBus::getInstance());
+ *   tx.setEngineRpm(rpm);
+ *   tx.setEngineLoad(load);
+ *   tx.commit();
+ *
+ * Todos los campos se sellan con el mismo instante: el de apertura, o el
+ * de captura de la muestra si la fuente lo conoce (ISR de SourceCAN).
+ *
+ * Si el mutex no se obtuvo (timeout) los setters no hacen nada: la
+ * actualización se descarta entera, igual que un setter suelto.
+ * No llamar a métodos de escritura de TelemetryBus con la transacción
+ * abierta (el mutex no es recursivo).
+ */
+class TelemetryWriteTx {
+public:
+  explicit TelemetryWriteTx(TelemetryBus &bus);
+  TelemetryWriteTx(TelemetryBus &bus, uint64_t sampleUs);
+  ~TelemetryWriteTx() { commit(); }
+
+  TelemetryWriteTx(const TelemetryWriteTx &) = delete;
+  TelemetryWriteTx &operator=(const TelemetryWriteTx &) = delete;
+
+  /**
+   * @brief true si la transacción tiene el mutex (aún no confirmada)
+   */
+  bool isOpen() const { return _open; }
+
+  /**
+   * @brief Publica los cambios y libera el mutex (idempotente)
+   */
+  void commit();
+
+  // Un setter por campo de TELEMETRY_SCHEMA; estampan el timestamp de su
+  // grupo (ts_gps_us, ts_engine_us, ...)
+#define TELEMETRY_TX_SETTER(ID, Setter, member, type, ...)                     \
+  void set##Setter(TELEMETRY_CTYPE(type) value);
+  TELEMETRY_SCHEMA(TELEMETRY_TX_SETTER)
+#undef TELEMETRY_TX_SETTER
+
+  void setField(TelemetryField field, float value);
+
+  void setGps(float lat, float lng, float alt, float speed, float course,
+              uint8_t sats, bool fix);
+  void setImuAccel(float x, float y, float z);
+  void setImuGyro(float x, float y, float z);
+  void setSuspension(float fl, float fr, float rl, float rr);
+
+  // Por slot (TelemetryBus::internKey)
+  void setCustomValueAt(int16_t slot, float value);
+  bool setValueAt(int16_t slot, float value, const char *unit = "",
+                  const char *source = "");
+
+private:
+  void record(const TelemetryKey &key, float value) {
+    _bus.recordField(key.slot, _now, value);
+  }
+
+  void touch(TelemetryChannelMask channel) {
+    _fields++;
+    _changed |= channel;
+  }
+
+  // touch() + timestamp de frescura del grupo (P1.1)
+  void stamp(TelemetryChannelMask channel);
+
+  TelemetryBus &_bus;
+  TelemetrySnapshot &_snap;      ///< _bus._snapshot
+  uint64_t _now;                 ///< Sello común (telemetryNowUs)
+  uint16_t _fields;              ///< Campos escritos
+  TelemetryChannelMask _changed; ///< Canales escritos (suscripciones)
+  bool _open;
 };
 
 // ============================================================================
 // CLAVES ESTÁNDAR DEL BUS
 // ============================================================================
 
+// IDs calculados en compilación: setValue/setCustomValue(TelemetryKey) no
+// hashean la clave en runtime. En el camino crítico, internar una vez y
+// escribir con setValueAt/setCustomValueAt
 namespace TelemetryKeys {
-// GPS
-constexpr const char *GPS_LAT = "gps.lat";
-constexpr const char *GPS_LNG = "gps.lng";
-constexpr const char *GPS_ALT = "gps.alt";
-constexpr const char *GPS_SPEED = "gps.speed";
-constexpr const char *GPS_COURSE = "gps.course";
-constexpr const char *GPS_SATS = "gps.sats";
-constexpr const char *GPS_FIX = "gps.fix";
-
-// IMU
-constexpr const char *IMU_ACCEL_X = "imu.accel_x";
-constexpr const char *IMU_ACCEL_Y = "imu.accel_y";
-constexpr const char *IMU_ACCEL_Z = "imu.accel_z";
-constexpr const char *IMU_GYRO_X = "imu.gyro_x";
-constexpr const char *IMU_GYRO_Y = "imu.gyro_y";
-constexpr const char *IMU_GYRO_Z = "imu.gyro_z";
-
-// Engine
-constexpr const char *ENGINE_RPM = "engine.rpm";
-constexpr const char *ENGINE_SPEED = "engine.speed";
-constexpr const char *ENGINE_COOLANT_TEMP = "engine.coolant_temp";
-constexpr const char *ENGINE_OIL_TEMP = "engine.oil_temp";
-constexpr const char *ENGINE_THROTTLE = "engine.throttle";
-constexpr const char *ENGINE_LOAD = "engine.load";
-constexpr const char *ENGINE_MAF = "engine.maf";
-constexpr const char *ENGINE_MAP = "engine.map";
-constexpr const char *ENGINE_INTAKE_TEMP = "engine.intake_temp";
-
-// Fuel
-constexpr const char *FUEL_LEVEL = "fuel.level";
-constexpr const char *FUEL_RATE = "fuel.rate";
-constexpr const char *FUEL_TOTAL = "fuel.total";
-
-// Battery
-constexpr const char *BATTERY_VOLTAGE = "battery.voltage";
-
-// Suspension
-constexpr const char *SUSP_FL = "suspension.fl";
-constexpr const char *SUSP_FR = "suspension.fr";
-constexpr const char *SUSP_RL = "suspension.rl";
-constexpr const char *SUSP_RR = "suspension.rr";
+// Campos de TELEMETRY_SCHEMA: slot = TelemetryField
+#define TELEMETRY_KEY_CONST(ID, Setter, member, type, key, ...)                \
+  constexpr TelemetryKey ID{key, (int16_t)TelemetryField::ID};
+TELEMETRY_SCHEMA(TELEMETRY_KEY_CONST)
+#undef TELEMETRY_KEY_CONST
+
+// Estado de enlace
+constexpr TelemetryKey OBD_STATUS{"OBD_Status", TELEMETRY_FIELD_COUNT};
+
+// Todas las claves estándar, en orden de slot
+constexpr TelemetryKey STANDARD[] = {
+#define TELEMETRY_KEY_LIST(ID, ...) ID,
+    TELEMETRY_SCHEMA(TELEMETRY_KEY_LIST)
+#undef TELEMETRY_KEY_LIST
+        OBD_STATUS,
+};
+constexpr int16_t STANDARD_COUNT = sizeof(STANDARD) / sizeof(STANDARD[0]);
 } // namespace TelemetryKeys
 
 #endif // TELEMETRY_BUS_H
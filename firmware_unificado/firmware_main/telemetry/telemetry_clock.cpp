@@ -0,0 +1,219 @@
+/**
+ * @file telemetry_clock.cpp
+ * @brief Implementación de la disciplina UTC del reloj de telemetría
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "telemetry_clock.h"
+#include <sys/time.h>
+
+// ============================================================================
+// DISCIPLINA
+// ============================================================================
+
+int64_t TelemetryClock::predictOffset(uint64_t monoUs) const {
+  int64_t elapsed = (int64_t)(monoUs - _anchorMonoUs);
+  return _offsetUs + elapsed * _driftPpb / 1000000000LL;
+}
+
+bool TelemetryClock::addReference(uint64_t utcUs, uint64_t monoUs,
+                                  TelemetryTimeSource source) {
+  int64_t measured = (int64_t)(utcUs - monoUs);
+
+  portENTER_CRITICAL(&_mux);
+  bool first = _source == TelemetryTimeSource::NONE;
+
+  // Una fuente peor no pisa a una mejor que sigue reportando
+  int64_t sinceLast = (int64_t)(monoUs - _lastRefMonoUs);
+  if (source < _source &&
+      sinceLast < (int64_t)TELEMETRY_CLOCK_HOLDOVER_US) {
+    _rejected++;
+    portEXIT_CRITICAL(&_mux);
+    return false;
+  }
+
+  int64_t predicted = predictOffset(monoUs);
+  int64_t error = first ? 0 : measured - predicted;
+  bool step = first || error > TELEMETRY_CLOCK_STEP_US ||
+              error < -TELEMETRY_CLOCK_STEP_US;
+
+  if (step) {
+    _offsetUs = measured;
+    _steps++;
+  } else {
+    // Frecuencia: un cuarto del error acumulado desde la referencia previa
+    if (sinceLast >= 1000000LL) {
+      int64_t drift = _driftPpb + error * 1000000000LL / sinceLast / 4;
+      if (drift > TELEMETRY_CLOCK_MAX_DRIFT_PPB)
+        drift = TELEMETRY_CLOCK_MAX_DRIFT_PPB;
+      if (drift < -TELEMETRY_CLOCK_MAX_DRIFT_PPB)
+        drift = -TELEMETRY_CLOCK_MAX_DRIFT_PPB;
+      _driftPpb = (int32_t)drift;
+    }
+    // Fase: la mitad del error, para filtrar el jitter de la referencia
+    _offsetUs = predicted + error / 2;
+  }
+
+  _anchorMonoUs = monoUs;
+  _lastRefMonoUs = monoUs;
+  _lastErrorUs = (int32_t)(step ? 0 : error);
+  _syncs++;
+  TelemetryTimeSource previous = _source;
+  _source = source;
+  portEXIT_CRITICAL(&_mux);
+
+  if (first || source != previous) {
+    Serial.printf("[CLOCK] UTC anchored (%s), epoch %llu\n",
+                  telemetryTimeSourceToString(source),
+                  (unsigned long long)(utcUs / 1000000ULL));
+  } else if (step) {
+    Serial.printf("[CLOCK] Step of %lld ms (%s)\n", (long long)(error / 1000),
+                  telemetryTimeSourceToString(source));
+  }
+  return true;
+}
+
+bool TelemetryClock::syncFromSystemTime() {
+  struct timeval tv;
+  uint64_t mono = telemetryNowUs();
+  if (gettimeofday(&tv, nullptr) != 0 ||
+      (uint64_t)tv.tv_sec < TELEMETRY_MIN_VALID_EPOCH) {
+    return false;
+  }
+
+  return addReference((uint64_t)tv.tv_sec * 1000000ULL +
+                          (uint64_t)tv.tv_usec,
+                      mono, TelemetryTimeSource::NTP);
+}
+
+// ============================================================================
+// CONVERSIÓN Y ESTADO
+// ============================================================================
+
+uint32_t telemetryBootId() {
+  static const uint32_t id = [] {
+    uint32_t r = esp_random();
+    return r != 0 ? r : 1u;
+  }();
+  return id;
+}
+
+uint64_t TelemetryClock::toUtcUs(uint64_t monoUs) const {
+  portENTER_CRITICAL(&_mux);
+  int64_t offset = predictOffset(monoUs);
+  bool anchored = _source != TelemetryTimeSource::NONE;
+  portEXIT_CRITICAL(&_mux);
+
+  return anchored ? monoUs + (uint64_t)offset : 0;
+}
+
+TelemetryTimeSource TelemetryClock::getSource() const {
+  portENTER_CRITICAL(&_mux);
+  TelemetryTimeSource source = _source;
+  portEXIT_CRITICAL(&_mux);
+  return source;
+}
+
+TelemetryClockStatus TelemetryClock::getStatus() const {
+  uint64_t now = telemetryNowUs();
+  TelemetryClockStatus status;
+
+  portENTER_CRITICAL(&_mux);
+  status.source = _source;
+  status.offsetUs = _offsetUs;
+  status.lastErrorUs = _lastErrorUs;
+  status.driftPpb = _driftPpb;
+  status.syncs = _syncs;
+  status.steps = _steps;
+  status.rejected = _rejected;
+  status.lastSyncAgeMs =
+      _syncs > 0 ? (uint32_t)((now - _lastRefMonoUs) / 1000) : 0;
+  portEXIT_CRITICAL(&_mux);
+
+  return status;
+}
+
+void TelemetryClock::printStatus() const {
+  TelemetryClockStatus s = getStatus();
+  Serial.printf("[CLOCK] Source: %s, syncs: %lu (steps %lu, rejected %lu)\n",
+                telemetryTimeSourceToString(s.source), (unsigned long)s.syncs,
+                (unsigned long)s.steps, (unsigned long)s.rejected);
+  Serial.printf("[CLOCK] Last error: %ld us, drift: %ld ppb, age: %lu ms\n",
+                (long)s.lastErrorUs, (long)s.driftPpb,
+                (unsigned long)s.lastSyncAgeMs);
+}
+
+const char *telemetryTimeSourceToString(TelemetryTimeSource source) {
+  switch (source) {
+  case TelemetryTimeSource::NTP:
+    return "NTP";
+  case TelemetryTimeSource::GPS:
+    return "GPS";
+  case TelemetryTimeSource::GPS_PPS:
+    return "GPS_PPS";
+  case TelemetryTimeSource::NONE:
+    break;
+  }
+  return "NONE";
+}
+
+// ============================================================================
+// CALENDARIO (UTC proléptico gregoriano, sin libc)
+// ============================================================================
+
+namespace {
+
+/// Días desde 1970-01-01 (algoritmo days_from_civil de H. Hinnant)
+int64_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  uint32_t yoe = (uint32_t)(y - era * 400);
+  uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+void put2(char *p, uint32_t v) {
+  p[0] = (char)('0' + v / 10 % 10);
+  p[1] = (char)('0' + v % 10);
+}
+
+} // namespace
+
+uint64_t telemetryEpochFromUtc(uint16_t year, uint8_t month, uint8_t day,
+                               uint8_t hour, uint8_t minute, uint8_t second) {
+  int64_t days = daysFromCivil(year, month, day);
+  return (uint64_t)(days * 86400LL + hour * 3600L + minute * 60L + second);
+}
+
+void telemetryFormatUtc(uint64_t utcUs, char *buf) {
+  uint64_t secs = utcUs / 1000000ULL;
+  uint32_t sod = (uint32_t)(secs % 86400ULL);
+  int64_t z = (int64_t)(secs / 86400ULL) + 719468;
+
+  // civil_from_days (H. Hinnant), solo fechas >= 1970
+  uint32_t era = (uint32_t)(z / 146097);
+  uint32_t doe = (uint32_t)(z - (int64_t)era * 146097);
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+  uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+  uint32_t y = yoe + era * 400 + (m <= 2);
+
+  put2(buf, y / 100);
+  put2(buf + 2, y);
+  buf[4] = '-';
+  put2(buf + 5, m);
+  buf[7] = '-';
+  put2(buf + 8, d);
+  buf[10] = ' ';
+  put2(buf + 11, sod / 3600);
+  buf[13] = ':';
+  put2(buf + 14, sod / 60 % 60);
+  buf[16] = ':';
+  put2(buf + 17, sod % 60);
+  buf[19] = '\0';
+}
@@ -0,0 +1,184 @@
+/**
+ * @file telemetry_clock.h
+ * @brief Base de tiempo común de la telemetría (µs monotónicos de 64 bits)
+ *
+ * Todas las muestras se sellan con telemetryNowUs() (esp_timer): 1 µs de
+ * resolución, monotónico desde el arranque y sin vuelta práctica (2^63 µs),
+ * a diferencia de millis() (1 ms, vuelta a los 49 días). Un mismo reloj
+ * para todas las fuentes permite alinear canales entre sí.
+ *
+ * TelemetryClock disciplina además ese reloj contra UTC: cada referencia
+ * (GPS con PPS, GPS por NMEA o NTP, en ese orden de prioridad) corrige un
+ * offset y una deriva cacheados, y utc = monotónico + offset + deriva.
+ * Las muestras conservan su sello monotónico y se convierten a UTC al
+ * serializar con pura aritmética entera (sin llamadas a libc), de modo que
+ * un ajuste de hora no reordena ni duplica muestras.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef TELEMETRY_CLOCK_H
+#define TELEMETRY_CLOCK_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+// Epoch mínimo considerado "hora sincronizada" (2020-01-01 00:00:00 UTC)
+#define TELEMETRY_MIN_VALID_EPOCH 1577836800ULL
+
+// Una referencia que difiere más que esto de la predicción salta (step);
+// por debajo se corrige gradualmente (slew) sin saltos en la serie
+#define TELEMETRY_CLOCK_STEP_US 500000LL
+
+// Tiempo que una referencia de mayor prioridad tapa a las de menor
+// (p. ej. NTP no pisa al GPS mientras el GPS siga reportando)
+#define TELEMETRY_CLOCK_HOLDOVER_US (600ULL * 1000000ULL)
+
+// Deriva máxima admitida para el oscilador del ESP32 (±500 ppm)
+#define TELEMETRY_CLOCK_MAX_DRIFT_PPB 500000L
+
+// Largo de "YYYY-MM-DD HH:MM:SS" con terminador
+#define TELEMETRY_UTC_STRING_LEN 20
+
+/**
+ * @brief Instante actual en µs monotónicos desde el arranque
+ */
+inline uint64_t telemetryNowUs() { return (uint64_t)esp_timer_get_time(); }
+
+/**
+ * @brief Identificador aleatorio (≠ 0) de este arranque
+ *
+ * Los sellos monotónicos solo son comparables dentro del arranque que los
+ * tomó: quien los persiste (buffer offline) guarda también este id.
+ */
+uint32_t telemetryBootId();
+
+/**
+ * @brief Extiende a 64 bits un instante de 32 bits del mismo reloj
+ *
+ * Para sellos tomados en una ISR, donde un valor de 64 bits no se publica
+ * atómicamente: basta con los 32 bits bajos si la muestra tiene menos de
+ * ~71 minutos respecto de nowUs.
+ */
+inline uint64_t telemetryExtendUs(uint32_t lowUs, uint64_t nowUs) {
+  return nowUs - (uint32_t)((uint32_t)nowUs - lowUs);
+}
+
+/**
+ * @enum TelemetryTimeSource
+ * @brief Origen del ancla UTC (mayor valor = mayor prioridad)
+ */
+enum class TelemetryTimeSource : uint8_t {
+  NONE = 0,   ///< Sin ancla: solo tiempo monotónico
+  NTP = 1,    ///< Hora del sistema sincronizada por SNTP
+  GPS = 2,    ///< Hora de la sentencia RMC (latencia NMEA, ~decenas de ms)
+  GPS_PPS = 3 ///< Flanco PPS etiquetado con la RMC siguiente (~µs)
+};
+
+/**
+ * @brief Estado de la disciplina del reloj (diagnóstico)
+ */
+struct TelemetryClockStatus {
+  TelemetryTimeSource source;
+  int64_t offsetUs;     ///< utc - monotónico en el último ancla
+  int32_t lastErrorUs;  ///< Referencia - predicción en la última sync
+  int32_t driftPpb;     ///< Deriva estimada del oscilador local
+  uint32_t syncs;       ///< Referencias aceptadas
+  uint32_t steps;       ///< De ellas, las que saltaron en vez de corregir
+  uint32_t rejected;    ///< Ignoradas por una fuente de mayor prioridad
+  uint32_t lastSyncAgeMs; ///< Antigüedad de la última referencia
+};
+
+/**
+ * @class TelemetryClock
+ * @brief Disciplina del reloj monotónico de la telemetría contra UTC
+ */
+class TelemetryClock {
+public:
+  static TelemetryClock &getInstance() {
+    static TelemetryClock instance;
+    return instance;
+  }
+
+  TelemetryClock(const TelemetryClock &) = delete;
+  TelemetryClock &operator=(const TelemetryClock &) = delete;
+
+  /**
+   * @brief Aporta una referencia: en el instante monoUs la hora UTC era utcUs
+   *
+   * La primera referencia (o una que discrepa más de
+   * TELEMETRY_CLOCK_STEP_US) ancla directamente; las siguientes corrigen
+   * la mitad del error de fase y estiman la deriva entre referencias.
+   *
+   * @return false si se ignoró por haber una fuente de mayor prioridad
+   *         vigente (ver TELEMETRY_CLOCK_HOLDOVER_US)
+   */
+  bool addReference(uint64_t utcUs, uint64_t monoUs,
+                    TelemetryTimeSource source);
+
+  /**
+   * @brief Toma la hora del sistema como referencia NTP si es válida
+   *
+   * Pensado para el callback de sincronización de SNTP.
+   */
+  bool syncFromSystemTime();
+
+  /**
+   * @brief Convierte un sello monotónico a UTC
+   * @return µs UTC desde 1970, o 0 si el reloj no está anclado
+   */
+  uint64_t toUtcUs(uint64_t monoUs) const;
+
+  /**
+   * @brief Hora UTC actual en µs (0 = no anclado)
+   */
+  uint64_t utcNowUs() const { return toUtcUs(telemetryNowUs()); }
+
+  bool isUtcValid() const { return getSource() != TelemetryTimeSource::NONE; }
+  TelemetryTimeSource getSource() const;
+  TelemetryClockStatus getStatus() const;
+
+  void printStatus() const;
+
+private:
+  TelemetryClock()
+      : _offsetUs(0), _anchorMonoUs(0), _lastRefMonoUs(0), _driftPpb(0),
+        _lastErrorUs(0), _syncs(0), _steps(0), _rejected(0),
+        _source(TelemetryTimeSource::NONE) {}
+
+  /// Offset previsto en monoUs (offset del ancla + deriva acumulada)
+  int64_t predictOffset(uint64_t monoUs) const;
+
+  // 64 bits no se leen atómicamente en el ESP32: todo el estado bajo _mux
+  int64_t _offsetUs;       ///< utc - monotónico en _anchorMonoUs
+  uint64_t _anchorMonoUs;  ///< Instante del último ancla
+  uint64_t _lastRefMonoUs; ///< Instante de la última referencia aceptada
+  int32_t _driftPpb;
+  int32_t _lastErrorUs;
+  uint32_t _syncs;
+  uint32_t _steps;
+  uint32_t _rejected;
+  TelemetryTimeSource _source;
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+/**
+ * @brief Nombre legible del origen del ancla
+ */
+const char *telemetryTimeSourceToString(TelemetryTimeSource source);
+
+/**
+ * @brief Fecha/hora UTC civil a segundos epoch (sin libc ni zona horaria)
+ */
+uint64_t telemetryEpochFromUtc(uint16_t year, uint8_t month, uint8_t day,
+                               uint8_t hour, uint8_t minute, uint8_t second);
+
+/**
+ * @brief Formatea µs UTC como "YYYY-MM-DD HH:MM:SS" (sin libc)
+ * @param buf Al menos TELEMETRY_UTC_STRING_LEN bytes
+ */
+void telemetryFormatUtc(uint64_t utcUs, char *buf);
+
+#endif // TELEMETRY_CLOCK_H
@@ -0,0 +1,166 @@
+/**
+ * @file telemetry_history.cpp
+ * @brief Implementación de los rings de historial del TelemetryBus
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "telemetry_history.h"
+
+// Mayor potencia de 2 <= n (n >= 1)
+static size_t floorPow2(size_t n) {
+  size_t p = 1;
+  while (p <= n / 2) {
+    p <<= 1;
+  }
+  return p;
+}
+
+uint8_t TelemetryHistory::begin(const size_t *capacities, uint8_t count,
+                                size_t budgetBytes, int8_t *rings) {
+  if (_arena != nullptr) {
+    Serial.println(F("[TELEMETRY] History already allocated, reboot to apply"));
+    for (uint8_t i = 0; i < count; i++) {
+      rings[i] = -1;
+    }
+    return 0;
+  }
+
+  if (count > TELEMETRY_HISTORY_MAX_CHANNELS)
+    count = TELEMETRY_HISTORY_MAX_CHANNELS;
+
+  // Repartir el presupuesto en orden de configuración
+  size_t samples[TELEMETRY_HISTORY_MAX_CHANNELS];
+  size_t budget = budgetBytes / sizeof(HistorySample);
+  size_t total = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    size_t cap = capacities[i] < TELEMETRY_HISTORY_MIN_SAMPLES
+                     ? TELEMETRY_HISTORY_MIN_SAMPLES
+                     : floorPow2(capacities[i]);
+    while (cap > TELEMETRY_HISTORY_MIN_SAMPLES && total + cap > budget) {
+      cap >>= 1;
+    }
+    if (total + cap > budget) {
+      samples[i] = 0;
+      continue;
+    }
+    if (cap < capacities[i]) {
+      Serial.printf("[TELEMETRY] History channel %u: %u -> %u samples\n", i,
+                    (unsigned)capacities[i], (unsigned)cap);
+    }
+    samples[i] = cap;
+    total += cap;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    rings[i] = -1;
+  }
+  if (total == 0)
+    return 0;
+
+  // Un solo bloque, PSRAM si la hay: no fragmenta el heap interno
+  _bytes = total * sizeof(HistorySample);
+  _psram = psramFound();
+  _arena = (HistorySample *)(_psram ? ps_malloc(_bytes) : malloc(_bytes));
+  if (_arena == nullptr && _psram) {
+    _psram = false;
+    _arena = (HistorySample *)malloc(_bytes);
+  }
+  if (_arena == nullptr) {
+    Serial.printf("[TELEMETRY] ERROR: History allocation failed (%u bytes)\n",
+                  (unsigned)_bytes);
+    _bytes = 0;
+    return 0;
+  }
+  memset(_arena, 0, _bytes);
+
+  size_t offset = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (samples[i] == 0) {
+      Serial.printf("[TELEMETRY] History channel %u dropped: budget "
+                    "exhausted\n",
+                    i);
+      continue;
+    }
+    Ring &r = _rings[_count];
+    r.buf = _arena + offset;
+    r.mask = samples[i] - 1;
+    r.head.store(0, std::memory_order_relaxed);
+    rings[i] = (int8_t)_count++;
+    offset += samples[i];
+  }
+
+  Serial.printf("[TELEMETRY] History: %u channels, %u bytes (%s)\n", _count,
+                (unsigned)_bytes, _psram ? "PSRAM" : "internal RAM");
+  return _count;
+}
+
+bool TelemetryHistory::open(int8_t ring, HistoryCursor &cursor,
+                            bool fromOldest) const {
+  if (ring < 0 || ring >= _count)
+    return false;
+
+  const Ring &r = _rings[ring];
+  uint32_t head = r.head.load(std::memory_order_acquire);
+  uint32_t avail = fromOldest ? head : 0;
+  if (avail > r.mask)
+    avail = r.mask; // Ver peek(): capacidad - 1 muestras legibles
+
+  cursor.ring = ring;
+  cursor.next = head - avail;
+  cursor.lost = 0;
+  return true;
+}
+
+size_t TelemetryHistory::peek(HistoryCursor &cursor, HistorySpan &span) const {
+  span = HistorySpan();
+  if (cursor.ring < 0 || cursor.ring >= _count)
+    return 0;
+
+  const Ring &r = _rings[cursor.ring];
+  uint32_t head = r.head.load(std::memory_order_acquire);
+  uint32_t avail = head - cursor.next;
+
+  // La muestra más vieja de un ring lleno es la próxima en sobrescribirse:
+  // se ofrecen como máximo capacidad - 1 para que consume() no falle sin
+  // que haya habido una escritura concurrente
+  if (avail > r.mask) {
+    cursor.lost += avail - r.mask;
+    cursor.next = head - r.mask;
+    avail = r.mask;
+  }
+  if (avail == 0)
+    return 0;
+
+  uint32_t start = cursor.next & r.mask;
+  uint32_t toEnd = r.mask + 1 - start;
+
+  span.first = r.buf + start;
+  span.firstCount = avail < toEnd ? avail : toEnd;
+  if (avail > toEnd) {
+    span.second = r.buf;
+    span.secondCount = avail - toEnd;
+  }
+  return avail;
+}
+
+bool TelemetryHistory::consume(HistoryCursor &cursor, size_t n) const {
+  if (cursor.ring < 0 || cursor.ring >= _count)
+    return false;
+
+  const Ring &r = _rings[cursor.ring];
+
+  // Releer head después de leer las muestras: si el escritor llegó a
+  // escribir sobre cursor.next, lo leído puede estar corrupto
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint32_t head = r.head.load(std::memory_order_relaxed);
+  bool intact = (head - cursor.next) <= r.mask;
+
+  if (!intact) {
+    cursor.lost += n;
+  }
+  cursor.next += n;
+  return intact;
+}
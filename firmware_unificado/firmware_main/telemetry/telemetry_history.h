@@ -0,0 +1,158 @@
+/**
+ * @file telemetry_history.h
+ * @brief Historial de alta frecuencia por canal del TelemetryBus
+ *
+ * El bus guarda solo el último valor de cada campo; lo muestreado más
+ * rápido que el intervalo cloud (IMU, suspensión, RPM CAN a 50-100 Hz) se
+ * pierde. Los canales configurados además escriben cada muestra
+ * (timestamp, valor) en un ring propio de tamaño fijo.
+ *
+ * - Memoria reservada una sola vez al arranque, en un único bloque dentro
+ *   de un presupuesto configurable (PSRAM si existe).
+ * - Un escritor (siempre bajo el mutex de escritura del bus) y cualquier
+ *   número de lectores, cada uno con su HistoryCursor: el logger, el
+ *   batcher cloud y el stream serial drenan a su propio ritmo sin copiar
+ *   ni bloquear al escritor.
+ * - Un lector lento no frena a nadie: pierde las muestras más viejas y
+ *   el cursor lo contabiliza en `lost`.
+ *
+ * Lectura sin copia:
+ *
+ *   HistorySpan span;
+ *   size_t n = history.peek(cursor, span);   // hasta 2 tramos contiguos
+ *   ... procesar span.first / span.second ...
+ *   if (!history.consume(cursor, n)) { descartar lo procesado }
+ *
+ * consume() devuelve false si el escritor alcanzó las muestras mientras se
+ * leían (mismo principio que el seqlock del bus).
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef TELEMETRY_HISTORY_H
+#define TELEMETRY_HISTORY_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Canales con historial simultáneos
+#define TELEMETRY_HISTORY_MAX_CHANNELS 16
+
+// Capacidad mínima de un ring (muestras, potencia de 2)
+#define TELEMETRY_HISTORY_MIN_SAMPLES 16
+
+/**
+ * @struct HistorySample
+ * @brief Muestra de un canal
+ */
+struct HistorySample {
+  uint64_t ts_us; ///< Muestra (telemetryNowUs)
+  float value;
+};
+
+/**
+ * @struct HistoryCursor
+ * @brief Posición de lectura de un consumidor en un canal
+ */
+struct HistoryCursor {
+  int8_t ring = -1;  ///< Canal (-1 = cursor sin abrir)
+  uint32_t next = 0; ///< Índice absoluto de la próxima muestra
+  uint32_t lost = 0; ///< Muestras sobrescritas antes de leerse
+};
+
+/**
+ * @struct HistorySpan
+ * @brief Muestras disponibles, en hasta dos tramos (el ring da la vuelta)
+ */
+struct HistorySpan {
+  const HistorySample *first = nullptr;
+  size_t firstCount = 0;
+  const HistorySample *second = nullptr;
+  size_t secondCount = 0;
+};
+
+/**
+ * @class TelemetryHistory
+ * @brief Rings de muestras por canal con cursores independientes
+ */
+class TelemetryHistory {
+public:
+  TelemetryHistory() : _arena(nullptr), _bytes(0), _count(0), _psram(false) {}
+
+  TelemetryHistory(const TelemetryHistory &) = delete;
+  TelemetryHistory &operator=(const TelemetryHistory &) = delete;
+
+  /**
+   * @brief Reserva los rings (una sola vez, al arranque)
+   *
+   * Cada capacidad se redondea hacia abajo a potencia de 2. Si el
+   * presupuesto no alcanza, los últimos canales se reducen a la mitad
+   * hasta TELEMETRY_HISTORY_MIN_SAMPLES y, si aun así no caben, quedan
+   * sin historial (ring -1 en rings[]).
+   *
+   * @param capacities Muestras pedidas por canal
+   * @param count Número de canales (<= TELEMETRY_HISTORY_MAX_CHANNELS)
+   * @param budgetBytes Memoria máxima para todas las muestras
+   * @param rings Output: índice de ring por canal, -1 si no se asignó
+   * @return Número de rings creados
+   */
+  uint8_t begin(const size_t *capacities, uint8_t count, size_t budgetBytes,
+                int8_t *rings);
+
+  /**
+   * @brief Agrega una muestra (solo el escritor del bus)
+   */
+  void push(int8_t ring, uint64_t ts, float value) {
+    Ring &r = _rings[ring];
+    uint32_t head = r.head.load(std::memory_order_relaxed);
+    r.buf[head & r.mask] = {ts, value};
+    r.head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Posiciona un cursor en un ring
+   * @param fromOldest true = desde la muestra más vieja disponible,
+   *        false = solo muestras futuras
+   */
+  bool open(int8_t ring, HistoryCursor &cursor, bool fromOldest = true) const;
+
+  /**
+   * @brief Muestras pendientes del cursor, sin copiarlas
+   * @return Total de muestras en span (0 = nada nuevo)
+   */
+  size_t peek(HistoryCursor &cursor, HistorySpan &span) const;
+
+  /**
+   * @brief Avanza el cursor tras procesar n muestras de peek()
+   * @return false si el escritor las sobrescribió durante la lectura
+   *         (el cursor avanza igual y las cuenta como perdidas)
+   */
+  bool consume(HistoryCursor &cursor, size_t n) const;
+
+  /**
+   * @brief Estadísticas
+   */
+  uint8_t channelCount() const { return _count; }
+  size_t bytesAllocated() const { return _bytes; }
+  bool inPsram() const { return _psram; }
+  uint32_t capacity(int8_t ring) const { return _rings[ring].mask + 1; }
+  uint32_t written(int8_t ring) const {
+    return _rings[ring].head.load(std::memory_order_acquire);
+  }
+
+private:
+  struct Ring {
+    HistorySample *buf = nullptr;
+    uint32_t mask = 0;
+    std::atomic<uint32_t> head{0}; ///< Total de muestras escritas
+  };
+
+  Ring _rings[TELEMETRY_HISTORY_MAX_CHANNELS];
+  HistorySample *_arena; ///< Bloque único con todos los rings
+  size_t _bytes;
+  uint8_t _count;
+  bool _psram;
+};
+
+#endif // TELEMETRY_HISTORY_H
@@ -0,0 +1,213 @@
+/**
+ * @file telemetry_schema.h
+ * @brief Esquema único de los campos de telemetría (X-macro)
+ *
+ * Cada campo del bus se declara una sola vez en TELEMETRY_SCHEMA. De esa
+ * tabla se generan en compilación:
+ * - los miembros de TelemetrySnapshot y las claves TelemetryKeys
+ *   (slot = posición en la tabla)
+ * - los setters de TelemetryBus / TelemetryWriteTx y el despacho por
+ *   campo (SensorConfig::MappingType de SourceCAN)
+ * - las tramas cloud JSON y binaria, los IDs de PayloadChannel, el stream
+ *   serial y los diagnósticos (GET_TELEMETRY, printStatus)
+ *
+ * Columnas de X(...):
+ *   ID        TelemetryField, TelemetryKeys, MappingType, PayloadChannel
+ *   Setter    sufijo del setter (set##Setter)
+ *   member    miembro de TelemetrySnapshot
+ *   type      TelemetryFieldType (tipo C y formato en las tramas)
+ *   key       clave del bus ("engine.rpm")
+ *   cloudKey  clave en la trama JSON (nullptr = no se envía)
+ *   payloadId ID binario de PayloadChannel (0 = no se envía). Contrato con
+ *             el servidor: solo se agregan nuevos, nunca se renumeran
+ *   liveKey   clave del stream serial LIVE (contrato con el configurador,
+ *             nullptr = no se envía)
+ *   unit      unidad de medida
+ *   min/max   rango físico plausible: fuera de él el canal se marca
+ *             TELEMETRY_Q_RANGE y no se envía
+ *   group     grupo/canal de suscripción (TELEMETRY_CH_##group)
+ *   emit      condición de envío en la trama cloud (TelemetryEmit)
+ *   staleMs   antigüedad máxima por defecto antes de considerar el dato
+ *             viejo (configurable por canal, TelemetryBus::setMaxAgeAt)
+ *
+ * El orden de la tabla es el orden de la trama JSON. Los slots no se
+ * persisten: agregar filas en cualquier posición es seguro.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================================
+// CANALES (SUSCRIPCIONES)
+// ============================================================================
+
+// Un bit por grupo de campos del bus
+typedef uint32_t TelemetryChannelMask;
+
+#define TELEMETRY_CH_GPS (1u << 0)
+#define TELEMETRY_CH_IMU (1u << 1)
+#define TELEMETRY_CH_ENGINE (1u << 2)
+#define TELEMETRY_CH_FUEL (1u << 3)
+#define TELEMETRY_CH_BATTERY (1u << 4)
+#define TELEMETRY_CH_SUSPENSION (1u << 5)
+#define TELEMETRY_CH_CUSTOM (1u << 6)  // setCustomValue* (sensores CAN/OBD)
+#define TELEMETRY_CH_GENERIC (1u << 7) // setValue*
+#define TELEMETRY_CH_ALL 0xFFFFFFFFu
+
+// ============================================================================
+// TABLA DE CAMPOS
+// ============================================================================
+
+// clang-format off
+#define TELEMETRY_SCHEMA(X) \
+  /*ID                   Setter             member               type     key                    cloudKey              id  liveKey     unit     min    max    group       emit        staleMs */ \
+  X(GPS_LAT,             GpsLat,            gps_lat,             COORD,   "gps.lat",             "lat",                1,  "lat",      "deg",   -90,   90,    GPS,        IF_GPS_FIX, 2000) \
+  X(GPS_LNG,             GpsLng,            gps_lng,             COORD,   "gps.lng",             "lng",                2,  "lng",      "deg",   -180,  180,   GPS,        IF_GPS_FIX, 2000) \
+  X(GPS_SPEED,           GpsSpeed,          gps_speed,           FLOAT32, "gps.speed",           "vel_kmh",            3,  "gps_spd",  "km/h",  0,     500,   GPS,        IF_GPS_FIX, 2000) \
+  X(GPS_ALT,             GpsAlt,            gps_alt,             FLOAT32, "gps.alt",             "alt_m",              4,  nullptr,    "m",     -500,  9000,  GPS,        IF_GPS_FIX, 2000) \
+  X(GPS_COURSE,          GpsCourse,         gps_course,          FLOAT32, "gps.course",          "rumbo",              5,  nullptr,    "deg",   0,     360,   GPS,        IF_GPS_FIX, 2000) \
+  X(GPS_SATS,            GpsSats,           gps_sats,            UINT8,   "gps.sats",            "gps_sats",           6,  "gps_sats", "",      0,     64,    GPS,        IF_GPS_FIX, 2000) \
+  X(IMU_ACCEL_X,         ImuAccelX,         imu_accel_x,         FLOAT32, "imu.accel_x",         "accel_x",            7,  "ax",       "m/s2",  -160,  160,   IMU,        IF_IMU,     2000) \
+  X(IMU_ACCEL_Y,         ImuAccelY,         imu_accel_y,         FLOAT32, "imu.accel_y",         "accel_y",            8,  "ay",       "m/s2",  -160,  160,   IMU,        IF_IMU,     2000) \
+  X(IMU_ACCEL_Z,         ImuAccelZ,         imu_accel_z,         FLOAT32, "imu.accel_z",         "accel_z",            9,  "az",       "m/s2",  -160,  160,   IMU,        IF_IMU,     2000) \
+  X(IMU_GYRO_X,          ImuGyroX,          imu_gyro_x,          FLOAT32, "imu.gyro_x",          "gyro_x",             10, nullptr,    "rad/s", -35,   35,    IMU,        IF_IMU,     2000) \
+  X(IMU_GYRO_Y,          ImuGyroY,          imu_gyro_y,          FLOAT32, "imu.gyro_y",          "gyro_y",             11, nullptr,    "rad/s", -35,   35,    IMU,        IF_IMU,     2000) \
+  X(IMU_GYRO_Z,          ImuGyroZ,          imu_gyro_z,          FLOAT32, "imu.gyro_z",          "gyro_z",             12, nullptr,    "rad/s", -35,   35,    IMU,        IF_IMU,     2000) \
+  X(ENGINE_RPM,          EngineRpm,         engine_rpm,          FLOAT32, "engine.rpm",          "0x0C",               13, "rpm",      "rpm",   0,     16383, ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_SPEED,        EngineSpeed,       engine_speed,        FLOAT32, "engine.speed",        "0x0D",               14, "speed",    "km/h",  0,     255,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_COOLANT_TEMP, EngineCoolantTemp, engine_coolant_temp, FLOAT32, "engine.coolant_temp", "0x05",               15, "temp",     "C",     -40,   215,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_OIL_TEMP,     EngineOilTemp,     engine_oil_temp,     FLOAT32, "engine.oil_temp",     "0x5C",               16, nullptr,    "C",     -40,   215,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_THROTTLE,     EngineThrottle,    engine_throttle,     FLOAT32, "engine.throttle",     "0x11",               17, "throttle", "%",     0,     100,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_LOAD,         EngineLoad,        engine_load,         FLOAT32, "engine.load",         "0x04",               18, "load",     "%",     0,     100,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_MAF,          EngineMaf,         engine_maf,          FLOAT32, "engine.maf",          "0x10",               19, "maf",      "g/s",   0,     655,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_MAP,          EngineMap,         engine_map,          FLOAT32, "engine.map",          "0x0B",               20, "map",      "kPa",   0,     255,   ENGINE,     IF_FRESH,   2000) \
+  X(ENGINE_INTAKE_TEMP,  EngineIntakeTemp,  engine_intake_temp,  FLOAT32, "engine.intake_temp",  "engine.intake_temp", 31, nullptr,    "C",     -40,   215,   ENGINE,     IF_FRESH,   2000) \
+  X(FUEL_LEVEL,          FuelLevel,         fuel_level,          FLOAT32, "fuel.level",          "0x2F",               21, "fuel",     "%",     0,     100,   FUEL,       IF_FRESH,   5000) \
+  X(FUEL_RATE,           FuelRate,          fuel_rate,           FLOAT32, "fuel.rate",           "0x5E",               22, nullptr,    "L/h",   0,     3276,  FUEL,       IF_FRESH,   5000) \
+  X(FUEL_TOTAL,          FuelTotal,         fuel_total,          FLOAT32, "fuel.total",          "fuel_total",         23, nullptr,    "L",     0,     1e6,   FUEL,       IF_FRESH,   5000) \
+  X(BATTERY_VOLTAGE,     BatteryVoltage,    battery_voltage,     FLOAT32, "battery.voltage",     "BAT",                24, "batt",     "V",     0,     36,    BATTERY,    IF_FRESH,   5000) \
+  X(SUSP_FL,             SuspFl,            susp_fl,             FLOAT32, "suspension.fl",       "susp_fl",            25, nullptr,    "mm",    -1000, 1000,  SUSPENSION, IF_FRESH,   2000) \
+  X(SUSP_FR,             SuspFr,            susp_fr,             FLOAT32, "suspension.fr",       "susp_fr",            26, nullptr,    "mm",    -1000, 1000,  SUSPENSION, IF_FRESH,   2000) \
+  X(SUSP_RL,             SuspRl,            susp_rl,             FLOAT32, "suspension.rl",       "susp_rl",            27, nullptr,    "mm",    -1000, 1000,  SUSPENSION, IF_FRESH,   2000) \
+  X(SUSP_RR,             SuspRr,            susp_rr,             FLOAT32, "suspension.rr",       "susp_rr",            28, nullptr,    "mm",    -1000, 1000,  SUSPENSION, IF_FRESH,   2000) \
+  X(GPS_FIX,             GpsFix,            gps_fix,             FLAG,    "gps.fix",             nullptr,              0,  nullptr,    "",      0,     1,     GPS,        NEVER,      2000)
+// clang-format on
+
+// ============================================================================
+// TIPOS DERIVADOS
+// ============================================================================
+
+/**
+ * @enum TelemetryFieldType
+ * @brief Tipo de un campo: miembro C del snapshot y formato en las tramas
+ */
+enum class TelemetryFieldType : uint8_t {
+  FLOAT32, ///< float; JSON número, binario f32
+  COORD,   ///< float en grados; JSON 6 decimales, binario i32 x 1e7
+  UINT8,   ///< uint8_t; JSON entero sin signo, binario f32
+  FLAG     ///< bool
+};
+
+// Tipo C del miembro de TelemetrySnapshot / parámetro del setter
+#define TELEMETRY_CTYPE_FLOAT32 float
+#define TELEMETRY_CTYPE_COORD float
+#define TELEMETRY_CTYPE_UINT8 uint8_t
+#define TELEMETRY_CTYPE_FLAG bool
+#define TELEMETRY_CTYPE(type) TELEMETRY_CTYPE_##type
+
+/**
+ * @enum TelemetryEmit
+ * @brief Condición para incluir un campo en la trama cloud
+ *
+ * Todas exigen además que el canal esté fresco y dentro de rango
+ * (calidad del snapshot); un cero legítimo se envía.
+ */
+enum class TelemetryEmit : uint8_t {
+  NEVER,      ///< Solo interno (gps_fix viaja en los flags)
+  IF_FRESH,   ///< Siempre que esté fresco
+  IF_GPS_FIX, ///< Bloque GPS, solo con fix
+  IF_IMU      ///< Bloque IMU, solo si la IMU está habilitada
+};
+
+/**
+ * @enum TelemetryField
+ * @brief Índice de un campo (= slot de su clave en el bus)
+ */
+enum class TelemetryField : uint8_t {
+#define TELEMETRY_FIELD_ENUM(ID, ...) ID,
+  TELEMETRY_SCHEMA(TELEMETRY_FIELD_ENUM)
+#undef TELEMETRY_FIELD_ENUM
+      COUNT
+};
+
+#define TELEMETRY_FIELD_COUNT ((uint8_t)TelemetryField::COUNT)
+
+/**
+ * @struct TelemetryFieldInfo
+ * @brief Metadatos de un campo (fila de TELEMETRY_SCHEMA)
+ */
+struct TelemetryFieldInfo {
+  const char *key;
+  const char *cloudKey;
+  uint8_t payloadId;
+  const char *liveKey;
+  const char *unit;
+  float min;
+  float max;
+  TelemetryFieldType type;
+  TelemetryChannelMask channel;
+  TelemetryEmit emit;
+  uint16_t staleMs;
+};
+
+// Índice = TelemetryField
+constexpr TelemetryFieldInfo TELEMETRY_FIELDS[] = {
+#define TELEMETRY_FIELD_INFO(ID, Setter, member, type, key, cloudKey, pid,    \
+                             liveKey, unit, min, max, group, emit, staleMs)   \
+  {key,                                                                        \
+   cloudKey,                                                                   \
+   pid,                                                                        \
+   liveKey,                                                                    \
+   unit,                                                                       \
+   min,                                                                        \
+   max,                                                                        \
+   TelemetryFieldType::type,                                                   \
+   TELEMETRY_CH_##group,                                                       \
+   TelemetryEmit::emit,                                                        \
+   staleMs},
+    TELEMETRY_SCHEMA(TELEMETRY_FIELD_INFO)
+#undef TELEMETRY_FIELD_INFO
+};
+
+static_assert(sizeof(TELEMETRY_FIELDS) / sizeof(TELEMETRY_FIELDS[0]) ==
+                  TELEMETRY_FIELD_COUNT,
+              "Una fila de metadatos por campo");
+
+/**
+ * @brief Metadatos de un campo
+ */
+constexpr const TelemetryFieldInfo &telemetryFieldInfo(TelemetryField f) {
+  return TELEMETRY_FIELDS[(uint8_t)f];
+}
+
+/**
+ * @brief Busca un campo por su clave del bus ("engine.rpm")
+ * @return false si la clave no es un campo estándar
+ */
+inline bool telemetryFieldByKey(const char *key, TelemetryField &out) {
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    if (strcmp(TELEMETRY_FIELDS[i].key, key) == 0) {
+      out = (TelemetryField)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif // TELEMETRY_SCHEMA_H
@@ -0,0 +1,124 @@
+/**
+ * @file bench.h
+ * @brief Micro-benchmarks estilo Google Benchmark para el entorno native
+ *
+ *   static void BM_algo(BenchState &state) {
+ *     while (state.keepRunning()) { ... benchDoNotOptimize(x); }
+ *   }
+ *   BENCHMARK(BM_algo, 2000); // presupuesto en ns/iteración
+ *
+ * Cada benchmark se calibra hasta durar ~BENCH_MIN_TIME_MS y reporta
+ * ns/iteración. El presupuesto es holgado (10x lo medido en un PC de
+ * desarrollo): solo detecta regresiones de orden de magnitud, que son las
+ * que se notan en el ESP32. Las comparaciones entre benchmarks (p. ej.
+ * contención/reposo) se hacen tras runBenchmarks() con benchResultNs().
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#define BENCH_MIN_TIME_MS 200
+
+/**
+ * @brief Evita que el compilador elimine un cálculo sin efectos
+ */
+template <typename T> inline void benchDoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchState {
+public:
+  explicit BenchState(uint64_t iterations) : _remaining(iterations) {}
+  bool keepRunning() { return _remaining-- > 0; }
+
+private:
+  uint64_t _remaining;
+};
+
+typedef void (*BenchFunction)(BenchState &);
+
+struct BenchEntry {
+  const char *name;
+  BenchFunction fn;
+  double budgetNs;
+  double resultNs; ///< ns/iteración medidos (0 = aún no ejecutado)
+};
+
+inline std::vector<BenchEntry> &benchRegistry() {
+  static std::vector<BenchEntry> registry;
+  return registry;
+}
+
+struct BenchRegistrar {
+  BenchRegistrar(const char *name, BenchFunction fn, double budgetNs) {
+    benchRegistry().push_back({name, fn, budgetNs, 0});
+  }
+};
+
+#define BENCHMARK(fn, budgetNs)                                                \
+  static BenchRegistrar bench_registrar_##fn(#fn, fn, budgetNs)
+
+/**
+ * @brief Ejecuta todos los benchmarks registrados
+ * @return Número de benchmarks que superaron su presupuesto
+ */
+inline int runBenchmarks() {
+  using clock = std::chrono::steady_clock;
+  int overBudget = 0;
+
+  printf("\n%-36s %14s %12s %10s\n", "Benchmark", "Iterations", "ns/iter",
+         "Budget");
+  printf("------------------------------------------------------------------"
+         "-----------\n");
+
+  for (BenchEntry &b : benchRegistry()) {
+    uint64_t iterations = 1;
+    double ns = 0;
+
+    for (;;) {
+      BenchState state(iterations);
+      auto t0 = clock::now();
+      b.fn(state);
+      ns = std::chrono::duration<double, std::nano>(clock::now() - t0)
+               .count();
+      if (ns >= BENCH_MIN_TIME_MS * 1e6 || iterations >= (1ULL << 40))
+        break;
+      // Extrapolar hacia el tiempo mínimo (x10 como máximo por paso)
+      double factor = ns > 0 ? (BENCH_MIN_TIME_MS * 1.4e6) / ns : 10.0;
+      iterations = (uint64_t)(iterations * (factor > 10.0 ? 10.0 : factor)) + 1;
+    }
+
+    double perIter = ns / iterations;
+    b.resultNs = perIter;
+    bool over = perIter > b.budgetNs;
+    overBudget += over ? 1 : 0;
+    printf("%-36s %14llu %12.1f %10.0f%s\n", b.name,
+           (unsigned long long)iterations, perIter, b.budgetNs,
+           over ? "  OVER BUDGET" : "");
+  }
+
+  printf("\n");
+  return overBudget;
+}
+
+/**
+ * @brief ns/iteración de un benchmark en la última runBenchmarks()
+ * @return 0 si no está registrado o no se ejecutó
+ */
+inline double benchResultNs(BenchFunction fn) {
+  for (const BenchEntry &b : benchRegistry()) {
+    if (b.fn == fn)
+      return b.resultNs;
+  }
+  return 0;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,704 @@
+/**
+ * @file bench_main.cpp
+ * @brief Benchmarks de los caminos calientes (pio test -e native -f bench_native)
+ *
+ * CloudManager::buildPayload() solo despacha a buildJsonPayload() y
+ * buildBinaryPayload(); se miden directamente (CloudManager depende de
+ * WiFi/PubSubClient). SourceCAN decodifica con decodeWithPlan() tras
+ * CanDispatchIndex::lookup(); BM_Can_DecodeSensor* miden como referencia
+ * el decodificador por trama al que sustituyó.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "../../cloud/binary_payload.h"
+#include "../../cloud/json_payload.h"
+#include "../../cloud/offline_buffer.h"
+#include "../../cloud/snapshot_record.h"
+#include "../../config/can_decode.h"
+#include "../../config/can_dispatch.h"
+#include "../../sources/ubx_parser.h"
+#include "../../telemetry/telemetry_bus.h"
+#include "bench.h"
+#include <LittleFS.h>
+#include <atomic>
+#include <obd_link.h>
+#include <thread>
+#include <unity.h>
+
+// Hora de captura de las tramas (µs UTC)
+#define BENCH_TIME_US (1700000000ULL * 1000000ULL)
+
+// ============================================================================
+// FIXTURES
+// ============================================================================
+
+static UnifiedConfig &benchConfig() {
+  static UnifiedConfig cfg;
+  strcpy(cfg.device_id, "DEV01");
+  strcpy(cfg.car_id, "CAR01");
+  cfg.imu.enabled = true;
+  return cfg;
+}
+
+/// Snapshot típico en pista: GPS, IMU, motor y 16 sensores custom
+static TelemetrySnapshot benchSnapshot() {
+  TelemetrySnapshot s;
+  s.gps_fix = true;
+  s.gps_lat = 19.432608f;
+  s.gps_lng = -99.133209f;
+  s.gps_speed = 132.4f;
+  s.gps_sats = 11;
+  s.imu_accel_x = 0.31f;
+  s.imu_accel_y = -1.02f;
+  s.imu_accel_z = 9.79f;
+  s.engine_rpm = 6543.0f;
+  s.engine_coolant_temp = 92.5f;
+  s.engine_throttle = 78.2f;
+  s.battery_voltage = 13.8f;
+  s.custom_count = 16;
+  for (int i = 0; i < s.custom_count; i++) {
+    snprintf(s.custom_values[i].key, MAX_KEY_LEN, "sensor_%02d", i);
+    s.custom_values[i].value = 10.0f * i + 0.5f;
+  }
+  s.wifi_rssi = -61;
+  s.heap_free = 154320;
+  return s;
+}
+
+static SensorConfig benchSensor(bool bigEndian) {
+  SensorConfig s = {};
+  strcpy(s.name, "RPM");
+  s.can_id = 0x640;
+  s.start_byte = 2;
+  s.start_bit = bigEndian ? 23 : 16; // DBC: MSB (Motorola) / LSB (Intel)
+  s.length = 16;
+  s.big_endian = bigEndian;
+  s.multiplier = 0.25f;
+  s.enabled = true;
+  return s;
+}
+
+/**
+ * @brief Hilos que repiten fn mientras dure el benchmark (contención)
+ */
+class BenchBackground {
+public:
+  BenchBackground(int threads, void (*fn)()) : _stop(false) {
+    for (int i = 0; i < threads; i++) {
+      _threads.emplace_back([this, fn] {
+        while (!_stop.load(std::memory_order_relaxed))
+          fn();
+      });
+    }
+  }
+
+  ~BenchBackground() {
+    _stop = true;
+    for (std::thread &t : _threads)
+      t.join();
+  }
+
+private:
+  std::atomic<bool> _stop;
+  std::vector<std::thread> _threads;
+};
+
+// Reintentos del seqlock por lectura en la última corrida de cada
+// benchmark de getSnapshot (se imprimen tras la tabla)
+static double g_retriesIdle = 0;
+static double g_retriesContended = 0;
+
+// ============================================================================
+// TELEMETRY BUS
+// ============================================================================
+
+static void BM_TelemetryBus_SetEngineRpm(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  float v = 0;
+  while (state.keepRunning()) {
+    bus.setEngineRpm(v);
+    v += 1.0f;
+  }
+}
+BENCHMARK(BM_TelemetryBus_SetEngineRpm, 1500);
+
+static void BM_TelemetryBus_SetCustomValue(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  float v = 0;
+  while (state.keepRunning()) {
+    bus.setCustomValue("sensor_15", v);
+    v += 1.0f;
+  }
+}
+BENCHMARK(BM_TelemetryBus_SetCustomValue, 1000);
+
+static void BM_TelemetryBus_SetCustomValueAt(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  int16_t slot = bus.internKey("sensor_15");
+  float v = 0;
+  while (state.keepRunning()) {
+    bus.setCustomValueAt(slot, v);
+    v += 1.0f;
+  }
+}
+BENCHMARK(BM_TelemetryBus_SetCustomValueAt, 1000);
+
+// Publicación OBD típica: 11 campos de motor/combustible en una toma
+static void writeTx11(float v) {
+  TelemetryWriteTx tx(TelemetryBus::getInstance());
+  tx.setEngineRpm(v);
+  tx.setEngineSpeed(v);
+  tx.setEngineCoolantTemp(v);
+  tx.setEngineThrottle(v);
+  tx.setEngineLoad(v);
+  tx.setEngineMaf(v);
+  tx.setEngineMap(v);
+  tx.setEngineOilTemp(v);
+  tx.setFuelLevel(v);
+  tx.setFuelRate(v);
+  tx.setBatteryVoltage(v);
+}
+
+static void BM_TelemetryBus_WriteTx11(BenchState &state) {
+  float v = 0;
+  while (state.keepRunning()) {
+    writeTx11(v);
+    v += 1.0f;
+  }
+}
+BENCHMARK(BM_TelemetryBus_WriteTx11, 2000);
+
+static void readSnapshotInBackground() {
+  static thread_local TelemetrySnapshot snap;
+  TelemetryBus::getInstance().getSnapshot(snap);
+  benchDoNotOptimize(snap);
+}
+
+static void writeTx11InBackground() {
+  static thread_local float v = 0;
+  writeTx11(v += 1.0f);
+}
+
+// ----------------------------------------------------------------------------
+// Escritura de una trama CAN (SourceCAN::processFrame): 4 señales en una
+// transacción sellada con el instante de la ISR. Se mide en reposo y con
+// dos lectores copiando snapshots sin parar (nube y serial); el runner
+// comprueba el cociente contención/reposo. BM_CanFrameMutex* es la
+// referencia: lectores que toman el mismo mutex que el escritor (el bus
+// anterior al seqlock)
+// ----------------------------------------------------------------------------
+
+// Cociente máximo contención/reposo del escritor CAN (runner multinúcleo)
+#define BENCH_CAN_WRITE_RATIO_MAX 1.5
+
+// Hilos que necesita la medida con contención: escritor + 2 lectores
+#define BENCH_CAN_WRITE_THREADS 3
+
+static void canFrameTx(uint64_t timestampUs, float v) {
+  static const int16_t slotA = TelemetryBus::getInstance().internKey("oil_p");
+  static const int16_t slotB = TelemetryBus::getInstance().internKey("fuel_p");
+  TelemetryWriteTx tx(TelemetryBus::getInstance(), timestampUs);
+  tx.setField(TelemetryField::ENGINE_RPM, v);
+  tx.setField(TelemetryField::ENGINE_THROTTLE, v);
+  tx.setCustomValueAt(slotA, v);
+  tx.setCustomValueAt(slotB, v);
+  tx.commit();
+}
+
+static void benchCanFrameTx(BenchState &state) {
+  uint64_t timestampUs = BENCH_TIME_US;
+  float v = 0;
+  while (state.keepRunning()) {
+    canFrameTx(timestampUs += 100, v);
+    v += 1.0f;
+  }
+}
+
+static void BM_CanFrame_WriteTx(BenchState &state) { benchCanFrameTx(state); }
+BENCHMARK(BM_CanFrame_WriteTx, 2000);
+
+static void BM_CanFrame_WriteTx_2Readers(BenchState &state) {
+  BenchBackground readers(2, readSnapshotInBackground);
+  benchCanFrameTx(state);
+}
+BENCHMARK(BM_CanFrame_WriteTx_2Readers, 20000);
+
+/**
+ * @brief Bus de referencia con lectores bajo mutex: getSnapshot() toma el
+ * mismo mutex que el escritor durante toda la copia
+ */
+struct MutexBus {
+  SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+  TelemetrySnapshot snapshot;
+};
+
+static MutexBus &mutexBus() {
+  static MutexBus bus;
+  return bus;
+}
+
+static void mutexBusWrite(uint64_t timestampUs, float v) {
+  MutexBus &bus = mutexBus();
+  xSemaphoreTake(bus.mutex, portMAX_DELAY);
+  bus.snapshot.engine_rpm = v;
+  bus.snapshot.engine_throttle = v;
+  bus.snapshot.custom_values[0].value = v;
+  bus.snapshot.custom_values[1].value = v;
+  bus.snapshot.ts_engine_us = timestampUs;
+  xSemaphoreGive(bus.mutex);
+}
+
+static void mutexBusReadInBackground() {
+  static thread_local TelemetrySnapshot snap;
+  MutexBus &bus = mutexBus();
+  xSemaphoreTake(bus.mutex, portMAX_DELAY);
+  memcpy(&snap, &bus.snapshot, sizeof(snap));
+  xSemaphoreGive(bus.mutex);
+  benchDoNotOptimize(snap);
+}
+
+static void benchCanFrameMutex(BenchState &state) {
+  uint64_t timestampUs = BENCH_TIME_US;
+  float v = 0;
+  while (state.keepRunning()) {
+    mutexBusWrite(timestampUs += 100, v);
+    v += 1.0f;
+  }
+}
+
+static void BM_CanFrameMutex_Write(BenchState &state) {
+  benchCanFrameMutex(state);
+}
+BENCHMARK(BM_CanFrameMutex_Write, 2000);
+
+static void BM_CanFrameMutex_Write_2Readers(BenchState &state) {
+  BenchBackground readers(2, mutexBusReadInBackground);
+  benchCanFrameMutex(state);
+}
+BENCHMARK(BM_CanFrameMutex_Write_2Readers, 200000);
+
+static void BM_TelemetryBus_GetSnapshot(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  TelemetrySnapshot snap;
+  uint32_t retries = bus.getReadRetries();
+  uint64_t reads = 0;
+  while (state.keepRunning()) {
+    bus.getSnapshot(snap);
+    benchDoNotOptimize(snap);
+    reads++;
+  }
+  g_retriesIdle = (double)(bus.getReadRetries() - retries) / reads;
+}
+BENCHMARK(BM_TelemetryBus_GetSnapshot, 1500);
+
+// Lector con un escritor de transacciones en paralelo: mide la copia con
+// reintentos incluidos
+static void BM_TelemetryBus_GetSnapshot_1Writer(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  TelemetrySnapshot snap;
+  BenchBackground writer(1, writeTx11InBackground);
+  uint32_t retries = bus.getReadRetries();
+  uint64_t reads = 0;
+  while (state.keepRunning()) {
+    bus.getSnapshot(snap);
+    benchDoNotOptimize(snap);
+    reads++;
+  }
+  g_retriesContended = (double)(bus.getReadRetries() - retries) / reads;
+}
+BENCHMARK(BM_TelemetryBus_GetSnapshot_1Writer, 20000);
+
+// Lector incremental: un campo cambiado por lectura
+static void BM_TelemetryBus_GetDelta1(BenchState &state) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  static TelemetryDelta delta;
+  uint32_t seen = bus.getVersion();
+  float rpm = 0;
+  while (state.keepRunning()) {
+    bus.setEngineRpm(rpm += 1.0f);
+    bus.getDelta(seen, delta);
+    seen = delta.version;
+    benchDoNotOptimize(delta);
+  }
+}
+BENCHMARK(BM_TelemetryBus_GetDelta1, 1500);
+
+// ============================================================================
+// CAN
+// ============================================================================
+
+/**
+ * @brief Decodificador por trama anterior a los planes (el antiguo
+ * SourceCAN::decodeSensor): reinterpreta la config en cada llamada.
+ * Referencia de comparación para decodeWithPlan()
+ */
+static float decodeSensor(const SensorConfig &sensor, const uint8_t *data,
+                          uint8_t len) {
+  uint64_t raw = 0;
+
+  if (sensor.big_endian) {
+    int startByte = sensor.start_byte;
+    int numBytes = sensor.length / 8;
+    if (numBytes == 0)
+      numBytes = 1;
+
+    if (startByte + numBytes <= len) {
+      if (numBytes == 1) {
+        raw = data[startByte];
+      } else if (numBytes == 2) {
+        raw = ((uint16_t)data[startByte] << 8) | data[startByte + 1];
+      } else if (numBytes == 4) {
+        raw = ((uint32_t)data[startByte] << 24) |
+              ((uint32_t)data[startByte + 1] << 16) |
+              ((uint32_t)data[startByte + 2] << 8) | data[startByte + 3];
+      }
+    }
+  } else {
+    uint64_t fullData = 0;
+    for (int i = 0; i < len; i++) {
+      fullData |= ((uint64_t)data[i] << (i * 8));
+    }
+    uint64_t mask =
+        (sensor.length >= 64) ? ~0ULL : ((1ULL << sensor.length) - 1);
+    if (sensor.start_bit < 64) {
+      raw = (fullData >> sensor.start_bit) & mask;
+    }
+  }
+
+  int64_t signedRaw = (int64_t)raw;
+  if (sensor.signed_val && sensor.length > 0 && sensor.length < 64) {
+    int shift = 64 - sensor.length;
+    signedRaw = ((int64_t)raw << shift) >> shift;
+  }
+  return (signedRaw * sensor.multiplier) + sensor.offset;
+}
+
+static void BM_Can_DecodeSensorIntel(BenchState &state) {
+  SensorConfig sensor = benchSensor(false);
+  uint8_t data[8] = {0, 0, 0x34, 0x12, 0, 0, 0, 0};
+  while (state.keepRunning()) {
+    benchDoNotOptimize(sensor);
+    float v = decodeSensor(sensor, data, 8);
+    benchDoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Can_DecodeSensorIntel, 150);
+
+static void BM_Can_DecodeSensorMotorola(BenchState &state) {
+  SensorConfig sensor = benchSensor(true);
+  uint8_t data[8] = {0, 0, 0x12, 0x34, 0, 0, 0, 0};
+  while (state.keepRunning()) {
+    benchDoNotOptimize(sensor);
+    float v = decodeSensor(sensor, data, 8);
+    benchDoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Can_DecodeSensorMotorola, 150);
+
+static void BM_Can_DecodeIntel(BenchState &state) {
+  CanDecodePlan plan;
+  compileDecodePlan(benchSensor(false), plan);
+  uint8_t data[8] = {0, 0, 0x34, 0x12, 0, 0, 0, 0};
+  float v = 0;
+  while (state.keepRunning()) {
+    benchDoNotOptimize(plan);
+    decodeWithPlan(plan, data, 8, v);
+    benchDoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Can_DecodeIntel, 150);
+
+static void BM_Can_DecodeMotorola(BenchState &state) {
+  CanDecodePlan plan;
+  compileDecodePlan(benchSensor(true), plan);
+  uint8_t data[8] = {0, 0, 0x12, 0x34, 0, 0, 0, 0};
+  float v = 0;
+  while (state.keepRunning()) {
+    benchDoNotOptimize(plan);
+    decodeWithPlan(plan, data, 8, v);
+    benchDoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Can_DecodeMotorola, 150);
+
+static void BM_Can_DispatchLookup(BenchState &state) {
+  std::vector<SensorConfig> sensors;
+  for (uint32_t i = 0; i < 32; i++) {
+    SensorConfig s = benchSensor(false);
+    s.can_id = 0x600 + i * 3;
+    sensors.push_back(s);
+  }
+  CanDispatchIndex index;
+  index.build(sensors);
+
+  const CanDecoder *decoders = nullptr;
+  uint16_t count = 0;
+  uint32_t id = 0;
+  while (state.keepRunning()) {
+    index.lookup(0x600 + (id++ % 96), decoders, count);
+    benchDoNotOptimize(decoders);
+  }
+}
+BENCHMARK(BM_Can_DispatchLookup, 50);
+
+// Tráfico del bus: 2 señales por ID configurado y 1 de cada 4 tramas con
+// un ID sin sensores. Una iteración = una trama despachada y decodificada
+// (tramas/s = 1e9 / ns por iteración)
+static std::vector<SensorConfig> dispatchSensors(uint16_t count) {
+  std::vector<SensorConfig> sensors;
+  for (uint16_t i = 0; i < count; i++) {
+    SensorConfig s = benchSensor(false);
+    s.can_id = 0x100 + (i / 2) * 4;
+    s.start_byte = (i % 2) * 4;
+    s.start_bit = s.start_byte * 8;
+    sensors.push_back(s);
+  }
+  return sensors;
+}
+
+static uint32_t dispatchFrameId(uint32_t frame, uint16_t count) {
+  uint32_t ids = count / 2;
+  uint32_t id = 0x100 + (frame % ids) * 4;
+  return (frame % 4 == 3) ? id + 1 : id; // +1: sin sensores
+}
+
+template <uint16_t N> static void benchCanDispatch(BenchState &state) {
+  static CanDispatchTable<N> index;
+  index.build(dispatchSensors(N));
+  uint8_t data[8] = {0x34, 0x12, 0, 0, 0x78, 0x56, 0, 0};
+  uint32_t frame = 0;
+  while (state.keepRunning()) {
+    const CanDecoder *decoders;
+    uint16_t count;
+    if (!index.lookup(dispatchFrameId(frame++, N), decoders, count))
+      continue;
+    for (uint16_t i = 0; i < count; i++) {
+      float v = 0;
+      decodeWithPlan(decoders[i].plan, data, 8, v);
+      benchDoNotOptimize(v);
+    }
+  }
+}
+
+static void BM_CanDispatch_50Sensors(BenchState &state) {
+  benchCanDispatch<50>(state);
+}
+BENCHMARK(BM_CanDispatch_50Sensors, 300);
+
+static void BM_CanDispatch_200Sensors(BenchState &state) {
+  benchCanDispatch<200>(state);
+}
+BENCHMARK(BM_CanDispatch_200Sensors, 300);
+
+static void BM_CanDispatch_500Sensors(BenchState &state) {
+  benchCanDispatch<500>(state);
+}
+BENCHMARK(BM_CanDispatch_500Sensors, 300);
+
+// Referencia: recorrido lineal de todos los sensores por trama (el
+// despacho anterior al índice), con planes ya compilados
+static void BM_CanDispatch_LinearScan500(BenchState &state) {
+  std::vector<SensorConfig> sensors = dispatchSensors(500);
+  std::vector<CanDecodePlan> plans(sensors.size());
+  for (size_t i = 0; i < sensors.size(); i++)
+    compileDecodePlan(sensors[i], plans[i]);
+  uint8_t data[8] = {0x34, 0x12, 0, 0, 0x78, 0x56, 0, 0};
+  uint32_t frame = 0;
+  while (state.keepRunning()) {
+    uint32_t id = dispatchFrameId(frame++, 500);
+    for (size_t i = 0; i < sensors.size(); i++) {
+      if (!sensors[i].enabled || sensors[i].can_id != id)
+        continue;
+      float v = 0;
+      decodeWithPlan(plans[i], data, 8, v);
+      benchDoNotOptimize(v);
+    }
+  }
+}
+BENCHMARK(BM_CanDispatch_LinearScan500, 20000);
+
+// ============================================================================
+// GPS
+// ============================================================================
+
+// Una solución NAV-PVT completa (100 bytes) por iteración
+static void BM_Gps_UbxNavPvt(BenchState &state) {
+  uint8_t payload[UBX_NAV_PVT_LEN] = {0};
+  payload[20] = 3; // 3D fix
+  payload[21] = 0x01;
+  uint8_t frame[UBX_NAV_PVT_LEN + UBX_FRAME_OVERHEAD];
+  size_t len = ubxBuildFrame(UBX_CLASS_NAV, UBX_ID_NAV_PVT, payload,
+                             sizeof(payload), frame, sizeof(frame));
+  UbxParser parser;
+  while (state.keepRunning()) {
+    for (size_t i = 0; i < len; i++) {
+      if (parser.push(frame[i])) {
+        UbxNavPvtView pvt(parser.payload());
+        benchDoNotOptimize(pvt.latE7());
+      }
+    }
+  }
+}
+BENCHMARK(BM_Gps_UbxNavPvt, 5000);
+
+// ============================================================================
+// ENLACE OBD (C3 -> PRINCIPAL)
+// ============================================================================
+
+/// Mensaje DATA del C3 con sus 14 PIDs y un DTC (116 bytes en la trama)
+static ObdLinkData benchObdLinkData() {
+  static const uint8_t PIDS[] = {0x0C, 0xFF, 0x05, 0x04, 0x0F, 0x0B, 0x10,
+                                 0x11, 0x0D, 0x5E, 0x2F, 0x0A, 0x5C, 0x3C};
+  ObdLinkData d;
+  d.tsUs = BENCH_TIME_US;
+  d.count = sizeof(PIDS);
+  for (uint8_t i = 0; i < d.count; i++) {
+    d.samples[i].pid = PIDS[i];
+    d.samples[i].value = 100.0f * i + 0.25f;
+    d.samples[i].ageMs = (uint16_t)(10 * i);
+  }
+  d.dtcCount = 1;
+  strcpy(d.dtcs[0], "P0301");
+  return d;
+}
+
+static void BM_ObdLink_EncodeData(BenchState &state) {
+  ObdLinkData data = benchObdLinkData();
+  uint8_t frame[OBD_LINK_MAX_FRAME];
+  uint8_t seq = 0;
+  while (state.keepRunning()) {
+    size_t len = obdLinkEncodeData(data, seq++, frame, sizeof(frame));
+    benchDoNotOptimize(len);
+  }
+}
+BENCHMARK(BM_ObdLink_EncodeData, 10000);
+
+// Recepción byte a byte (sincronismo, CRC) y lectura del payload
+static void BM_ObdLink_DecodeData(BenchState &state) {
+  uint8_t frame[OBD_LINK_MAX_FRAME];
+  size_t len = obdLinkEncodeData(benchObdLinkData(), 0, frame, sizeof(frame));
+  ObdLinkParser parser;
+  ObdLinkData out;
+  while (state.keepRunning()) {
+    for (size_t i = 0; i < len; i++) {
+      if (parser.push(frame[i]) == OBD_LINK_FRAME) {
+        obdLinkDecodeData(parser.payload(), parser.payloadLen(), &out);
+        benchDoNotOptimize(out.samples[0].value);
+      }
+    }
+  }
+}
+BENCHMARK(BM_ObdLink_DecodeData, 15000);
+
+// ============================================================================
+// TRAMAS CLOUD
+// ============================================================================
+
+static void BM_Payload_Json(BenchState &state) {
+  TelemetrySnapshot snap = benchSnapshot();
+  static char buf[JSON_PAYLOAD_MAX_SIZE];
+  while (state.keepRunning()) {
+    size_t len =
+        buildJsonPayload(snap, benchConfig(), BENCH_TIME_US, buf, sizeof(buf));
+    benchDoNotOptimize(len);
+  }
+}
+BENCHMARK(BM_Payload_Json, 35000);
+
+static void BM_Payload_Binary(BenchState &state) {
+  TelemetrySnapshot snap = benchSnapshot();
+  static uint8_t buf[BINARY_PAYLOAD_MAX_SIZE];
+  while (state.keepRunning()) {
+    size_t len = buildBinaryPayload(snap, benchConfig(), BENCH_TIME_US, buf,
+                                    sizeof(buf));
+    benchDoNotOptimize(len);
+  }
+}
+BENCHMARK(BM_Payload_Binary, 10000);
+
+// ============================================================================
+// BUFFER OFFLINE
+// ============================================================================
+
+static void BM_SnapshotRecord_EncodeDelta(BenchState &state) {
+  SnapshotRecordEncoder enc;
+  TelemetrySnapshot snap = benchSnapshot();
+  uint8_t rec[SNAPSHOT_RECORD_MAX_SIZE];
+  SnapshotRecordTime time;
+  time.utcUs = BENCH_TIME_US;
+  time.bootId = telemetryBootId();
+  enc.commit(snap, true);
+  while (state.keepRunning()) {
+    snap.engine_rpm += 1.0f;
+    size_t len = enc.encode(snap, time, false, rec, sizeof(rec));
+    benchDoNotOptimize(len);
+  }
+}
+BENCHMARK(BM_SnapshotRecord_EncodeDelta, 3000);
+
+static void BM_OfflineBuffer_PushPeekConsume(BenchState &state) {
+  OfflineBuffer &ob = OfflineBuffer::getInstance();
+  ob.clear();
+  TelemetrySnapshot snap = benchSnapshot();
+  TelemetrySnapshot out;
+  uint64_t timeUs = 0;
+  while (state.keepRunning()) {
+    snap.engine_rpm += 1.0f;
+    ob.push(snap, BENCH_TIME_US);
+    ob.peek(out, timeUs);
+    ob.consume();
+  }
+}
+BENCHMARK(BM_OfflineBuffer_PushPeekConsume, 150000);
+
+// ============================================================================
+// RUNNER
+// ============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static double contendedRatio(BenchFunction idle, BenchFunction contended) {
+  double idleNs = benchResultNs(idle);
+  return idleNs > 0 ? benchResultNs(contended) / idleNs : 0;
+}
+
+void test_benchmarks_within_budget() {
+  int overBudget = runBenchmarks();
+  printf("Seqlock retries per getSnapshot: %.4f idle, %.4f with 1 writer\n\n",
+         g_retriesIdle, g_retriesContended);
+  TEST_ASSERT_EQUAL_MESSAGE(0, overBudget,
+                            "Benchmark over budget (see table above)");
+}
+
+// El escritor CAN no debe esperar a los lectores: con un núcleo por hilo,
+// dos lectores en bucle apenas cambian su latencia
+void test_can_write_not_slowed_by_readers() {
+  double seqlock =
+      contendedRatio(BM_CanFrame_WriteTx, BM_CanFrame_WriteTx_2Readers);
+  double mutex =
+      contendedRatio(BM_CanFrameMutex_Write, BM_CanFrameMutex_Write_2Readers);
+  unsigned cores = std::thread::hardware_concurrency();
+  printf("CAN write with 2 readers / idle: %.2fx seqlock, %.2fx mutex "
+         "readers (%u cores)\n\n",
+         seqlock, mutex, cores);
+  if (cores < BENCH_CAN_WRITE_THREADS) {
+    TEST_IGNORE_MESSAGE("Contention ratio needs one core per thread");
+  }
+  TEST_ASSERT_TRUE_MESSAGE(seqlock <= BENCH_CAN_WRITE_RATIO_MAX,
+                           "CAN writer slowed down by snapshot readers");
+}
+
+int main() {
+  Serial.setQuiet(true);
+  LittleFS.format();
+  TelemetryBus::getInstance().begin();
+  OfflineBuffer::getInstance().begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_benchmarks_within_budget);
+  RUN_TEST(test_can_write_not_slowed_by_readers);
+  return UNITY_END();
+}
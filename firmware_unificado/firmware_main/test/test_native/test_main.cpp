@@ -0,0 +1,1545 @@
+/**
+ * @file test_main.cpp
+ * @brief Tests unitarios del entorno native (pio test -e native)
+ *
+ * Cubren los caminos calientes que no dependen de hardware: TelemetryBus,
+ * decodificación/dispatch CAN, parser UBX del GPS, respuestas OBD2
+ * multi-PID y planificador de PIDs, tramas cloud y buffer offline.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "../../cloud/binary_payload.h"
+#include "../../cloud/flash_log.h"
+#include "../../cloud/json_payload.h"
+#include "../../cloud/offline_buffer.h"
+#include "../../cloud/snapshot_record.h"
+#include "../../config/can_decode.h"
+#include "../../config/can_dispatch.h"
+#include "../../sources/can_filters.h"
+#include "../../sources/ubx_parser.h"
+#include "../../telemetry/telemetry_bus.h"
+#include <freertos/event_groups.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <obd_link.h>
+#include <obd_protocol.h>
+#include <obd_scheduler.h>
+#include <unity.h>
+
+void setUp() {
+  Serial.setQuiet(true);
+  LittleFS.format();
+}
+
+void tearDown() {}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static SensorConfig makeSensor(uint32_t canId, uint8_t startByte,
+                               uint8_t startBit, uint8_t length,
+                               bool bigEndian, bool isSigned = false) {
+  SensorConfig s = {};
+  strcpy(s.name, "TEST");
+  strcpy(s.cloud_id, "test");
+  s.can_id = canId;
+  s.start_byte = startByte;
+  s.start_bit = startBit;
+  s.length = length;
+  s.big_endian = bigEndian;
+  s.signed_val = isSigned;
+  s.multiplier = 1.0f;
+  s.offset = 0.0f;
+  s.enabled = true;
+  return s;
+}
+
+static UnifiedConfig makeConfig() {
+  static UnifiedConfig cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  strcpy(cfg.device_id, "DEV01");
+  strcpy(cfg.car_id, "CAR01");
+  return cfg;
+}
+
+// ============================================================================
+// CAN
+// ============================================================================
+
+void test_decode_intel_unsigned() {
+  CanDecodePlan plan;
+  TEST_ASSERT_TRUE(compileDecodePlan(makeSensor(0x100, 1, 8, 16, false), plan));
+
+  const uint8_t data[8] = {0x00, 0x34, 0x12};
+  float v = 0;
+  TEST_ASSERT_TRUE(decodeWithPlan(plan, data, 8, v));
+  TEST_ASSERT_EQUAL_FLOAT(4660.0f, v);
+}
+
+void test_decode_motorola_legacy_byte_aligned() {
+  // JSON sin start_bit: start_bit (aquí basura) se ignora
+  SensorConfig s = makeSensor(0x100, 2, 16, 16, true);
+  s.byte_aligned = true;
+  CanDecodePlan plan;
+  TEST_ASSERT_TRUE(compileDecodePlan(s, plan));
+
+  const uint8_t data[8] = {0x00, 0x00, 0x12, 0x34};
+  float v = 0;
+  TEST_ASSERT_TRUE(decodeWithPlan(plan, data, 8, v));
+  TEST_ASSERT_EQUAL_FLOAT(4660.0f, v);
+  TEST_ASSERT_EQUAL(4, plan.minLen);
+
+  s.big_endian = false;
+  TEST_ASSERT_TRUE(compileDecodePlan(s, plan));
+  TEST_ASSERT_TRUE(decodeWithPlan(plan, data, 8, v));
+  TEST_ASSERT_EQUAL_FLOAT(13330.0f, v);
+}
+
+/**
+ * Señales de configurator/tests/test.dbc más señales Motorola/Intel no
+ * alineadas a byte. Esperados calculados con un extractor DBC bit a bit
+ * (Motorola: MSB en start_bit, recorrido sawtooth).
+ */
+struct DbcDecodeCase {
+  const char *name;
+  uint8_t startBit;
+  uint8_t length;
+  bool bigEndian;
+  bool isSigned;
+  float scale;
+  float offset;
+  uint8_t data[8];
+  float expected;
+  uint8_t minLen;
+};
+
+static const DbcDecodeCase DBC_DECODE_CASES[] = {
+    // BO_ 100 EngineData
+    {"EngineSpeed 0|16@1+", 0, 16, false, false, 1.0f, 0.0f,
+     {0x40, 0x1F}, 8000.0f, 2},
+    {"CoolantTemp 16|8@1-", 16, 8, false, true, 1.0f, -40.0f,
+     {0x00, 0x00, 0xF6}, -50.0f, 3},
+    // BO_ 200 WheelSpeeds
+    {"FL_WheelSpeed 0|16@1+", 0, 16, false, false, 0.1f, 0.0f,
+     {0x2C, 0x01}, 30.0f, 2},
+    {"FR_WheelSpeed 16|16@1+", 16, 16, false, false, 0.1f, 0.0f,
+     {0x00, 0x00, 0xB8, 0x0B}, 300.0f, 4},
+    // Motorola con start_bit en el bit 0 de un byte (no alineadas)
+    {"8|16@0+", 8, 16, true, false, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 11068.0f, 4},
+    {"24|8@0+", 24, 8, true, false, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 77.0f, 5},
+    // 12 y 24 bits, sin alinear
+    {"11|12@0+", 11, 12, true, false, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 1110.0f, 3},
+    {"21|24@0-", 21, 24, true, true, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 5890666.0f, 6},
+    {"4|12@1+", 4, 12, false, false, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 833.0f, 2},
+    {"13|24@1-", 13, 24, false, true, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, -2899279.0f, 5},
+    // Motorola alineada a byte con start_bit DBC explícito
+    {"7|16@0+", 7, 16, true, false, 1.0f, 0.0f,
+     {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}, 4660.0f, 2},
+};
+
+void test_decode_dbc_signal_table() {
+  for (const DbcDecodeCase &c : DBC_DECODE_CASES) {
+    SensorConfig s = makeSensor(0x100, c.startBit / 8, c.startBit, c.length,
+                                c.bigEndian, c.isSigned);
+    s.multiplier = c.scale;
+    s.offset = c.offset;
+
+    CanDecodePlan plan;
+    TEST_ASSERT_TRUE_MESSAGE(compileDecodePlan(s, plan), c.name);
+    TEST_ASSERT_EQUAL_MESSAGE(c.minLen, plan.minLen, c.name);
+
+    float v = 0;
+    TEST_ASSERT_TRUE_MESSAGE(decodeWithPlan(plan, c.data, 8, v), c.name);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(c.expected, v, c.name);
+    TEST_ASSERT_FALSE_MESSAGE(decodeWithPlan(plan, c.data, c.minLen - 1, v),
+                              c.name);
+  }
+}
+
+void test_decode_motorola_signed() {
+  CanDecodePlan plan;
+  TEST_ASSERT_TRUE(
+      compileDecodePlan(makeSensor(0x100, 0, 7, 8, true, true), plan));
+
+  const uint8_t data[8] = {0xFE};
+  float v = 0;
+  TEST_ASSERT_TRUE(decodeWithPlan(plan, data, 8, v));
+  TEST_ASSERT_EQUAL_FLOAT(-2.0f, v);
+}
+
+void test_decode_float32_and_short_frame() {
+  SensorConfig s = makeSensor(0x100, 0, 0, 32, false);
+  s.is_float = true;
+  CanDecodePlan plan;
+  TEST_ASSERT_TRUE(compileDecodePlan(s, plan));
+
+  float expected = 12.5f;
+  uint8_t data[8] = {};
+  memcpy(data, &expected, 4);
+  float v = 0;
+  TEST_ASSERT_TRUE(decodeWithPlan(plan, data, 4, v));
+  TEST_ASSERT_EQUAL_FLOAT(expected, v);
+  TEST_ASSERT_FALSE(decodeWithPlan(plan, data, 3, v));
+}
+
+void test_dispatch_lookup() {
+  std::vector<SensorConfig> sensors = {
+      makeSensor(0x640, 0, 0, 16, false), makeSensor(0x640, 2, 16, 16, false),
+      makeSensor(0x7E8, 0, 0, 8, false)};
+  sensors[2].enabled = false;
+
+  CanDispatchIndex index;
+  index.build(sensors);
+  TEST_ASSERT_EQUAL(1, index.idCount());
+  TEST_ASSERT_EQUAL(2, index.sensorCount());
+
+  const CanDecoder *decoders = nullptr;
+  uint16_t count = 0;
+  TEST_ASSERT_TRUE(index.lookup(0x640, decoders, count));
+  TEST_ASSERT_EQUAL(2, count);
+  TEST_ASSERT_FALSE(index.lookup(0x7E8, decoders, count));
+}
+
+// ============================================================================
+// FILTROS HARDWARE CAN (MCP2515)
+// ============================================================================
+
+/// ¿Pasaría el ID por máscara + filtros, como en el MCP2515?
+static bool canFilterAccepts(const CanFilterPlan &plan, uint32_t id) {
+  for (uint8_t i = 0; i < CAN_HW_FILTER_COUNT; i++) {
+    if ((id & plan.mask) == plan.filters[i])
+      return true;
+  }
+  return false;
+}
+
+/// Conteo exhaustivo de los 2048 IDs estándar que acepta el plan
+static uint32_t canFilterCountStandard(const CanFilterPlan &plan) {
+  uint32_t n = 0;
+  for (uint32_t id = 0; id <= CAN_STD_ID_MASK; id++) {
+    if (canFilterAccepts(plan, id))
+      n++;
+  }
+  return n;
+}
+
+void test_can_filters_exact_standard() {
+  const uint32_t ids[] = {0x018, 0x100, 0x200, 0x310, 0x640, 0x7E8};
+  CanFilterPlan plan;
+  computeCanFilterPlan(ids, 6, plan);
+
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::STANDARD);
+  TEST_ASSERT_TRUE(plan.exact);
+  TEST_ASSERT_EQUAL_HEX32(CAN_STD_ID_MASK, plan.mask);
+  TEST_ASSERT_EQUAL(6, plan.filterCount);
+  TEST_ASSERT_EQUAL(0, plan.wildcardBits);
+  TEST_ASSERT_EQUAL_UINT32(6, plan.acceptedIds());
+  TEST_ASSERT_EQUAL_UINT32(6, canFilterCountStandard(plan));
+  for (uint32_t id : ids) {
+    TEST_ASSERT_TRUE(canFilterAccepts(plan, id));
+  }
+
+  // Menos IDs que filtros: los sobrantes repiten uno ya aceptado
+  computeCanFilterPlan(ids, 2, plan);
+  TEST_ASSERT_TRUE(plan.exact);
+  TEST_ASSERT_EQUAL_UINT32(2, canFilterCountStandard(plan));
+}
+
+void test_can_filters_standard_superset() {
+  // 7 IDs no caben en 6 filtros: la mejor máscara acepta 8 (1 falso)
+  const uint32_t ids[] = {0x640, 0x641, 0x642, 0x643, 0x644, 0x645, 0x646};
+  CanFilterPlan plan;
+  computeCanFilterPlan(ids, 7, plan);
+
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::STANDARD);
+  TEST_ASSERT_FALSE(plan.exact);
+  TEST_ASSERT_TRUE(plan.filterCount <= CAN_HW_FILTER_COUNT);
+  for (uint32_t id : ids) {
+    TEST_ASSERT_TRUE(canFilterAccepts(plan, id));
+  }
+  uint32_t accepted = canFilterCountStandard(plan);
+  TEST_ASSERT_EQUAL_UINT32(plan.acceptedIds(), accepted);
+  TEST_ASSERT_EQUAL_UINT32(1, accepted - plan.idCount);
+
+  // IDs dispersos: sigue siendo superconjunto y el conteo cuadra
+  const uint32_t sparse[] = {0x0A0, 0x123, 0x2F0, 0x3C1,
+                             0x456, 0x5A5, 0x6E7, 0x7FF};
+  computeCanFilterPlan(sparse, 8, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::STANDARD);
+  for (uint32_t id : sparse) {
+    TEST_ASSERT_TRUE(canFilterAccepts(plan, id));
+  }
+  accepted = canFilterCountStandard(plan);
+  TEST_ASSERT_EQUAL_UINT32(plan.acceptedIds(), accepted);
+  TEST_ASSERT_TRUE(accepted > plan.idCount);
+  TEST_ASSERT_TRUE(accepted < 2048);
+}
+
+void test_can_filters_extended_greedy() {
+  // 10 IDs J1939 consecutivos: basta ignorar el bit 0
+  uint32_t ids[10];
+  for (uint32_t i = 0; i < 10; i++) {
+    ids[i] = CAN_ID_EXT_FLAG | (0x18FF0000UL + i);
+  }
+  CanFilterPlan plan;
+  computeCanFilterPlan(ids, 10, plan);
+
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::EXTENDED);
+  TEST_ASSERT_EQUAL_HEX32(CAN_EXT_ID_MASK & ~1UL, plan.mask);
+  TEST_ASSERT_EQUAL(5, plan.filterCount);
+  TEST_ASSERT_EQUAL(1, plan.wildcardBits);
+  TEST_ASSERT_EQUAL_UINT32(10, plan.acceptedIds());
+  for (uint32_t id : ids) {
+    TEST_ASSERT_TRUE(canFilterAccepts(plan, id & CAN_EXT_ID_MASK));
+  }
+  TEST_ASSERT_FALSE(canFilterAccepts(plan, 0x18FF000AUL));
+}
+
+void test_can_filters_accept_all_cases() {
+  CanFilterPlan plan;
+
+  // Estándar + extendido (por flag y por valor > 11 bits)
+  const uint32_t mixedFlag[] = {0x100, CAN_ID_EXT_FLAG | 0x100};
+  computeCanFilterPlan(mixedFlag, 2, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::ACCEPT_ALL);
+  const uint32_t mixedValue[] = {0x7E8, 0x18DAF110UL};
+  computeCanFilterPlan(mixedValue, 2, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::ACCEPT_ALL);
+
+  // Más de CAN_FILTER_MAX_IDS
+  uint32_t many[CAN_FILTER_MAX_IDS + 1];
+  for (uint32_t i = 0; i < CAN_FILTER_MAX_IDS + 1; i++) {
+    many[i] = 0x100 + i;
+  }
+  computeCanFilterPlan(many, CAN_FILTER_MAX_IDS, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::STANDARD);
+  computeCanFilterPlan(many, CAN_FILTER_MAX_IDS + 1, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::ACCEPT_ALL);
+  TEST_ASSERT_EQUAL(CAN_FILTER_MAX_IDS + 1, plan.idCount);
+
+  // Conjunto vacío
+  computeCanFilterPlan(many, 0, plan);
+  TEST_ASSERT_TRUE(plan.mode == CanFilterPlan::Mode::ACCEPT_ALL);
+  TEST_ASSERT_EQUAL_UINT32(0, plan.acceptedIds());
+}
+
+// ============================================================================
+// GPS (UBX)
+// ============================================================================
+
+// Captura de un receptor u-blox M8 recién pasado a UBX: cola NMEA, el
+// ACK del CFG-RATE y una NAV-PVT (3D fix, 14 satélites)
+static const char UBX_CAPTURE_NMEA[] =
+    "$GNRMC,150926.00,A,3152.00393,N,11635.78107,W,54.0,90.1,140326,,,A*6C\r\n";
+static const uint8_t UBX_CAPTURE_ACK[] = {
+    0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, 0x06, 0x08, 0x16, 0x3F,
+};
+static const uint8_t UBX_CAPTURE_NAV_PVT[] = {
+    0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00, 0x00, 0xCA, 0x5B, 0x07, 0xEA, 0x07,
+    0x03, 0x0E, 0x0F, 0x09, 0x1A, 0x37, 0x14, 0x00, 0x00, 0x00, 0x88, 0xFF,
+    0xFF, 0xFF, 0x03, 0x01, 0x0A, 0x0E, 0x08, 0xCF, 0x80, 0xBA, 0x39, 0x7A,
+    0xFE, 0x12, 0x48, 0xE8, 0x01, 0x00, 0xAA, 0xAE, 0x01, 0x00, 0xDC, 0x05,
+    0x00, 0x00, 0xC4, 0x09, 0x00, 0x00, 0xE8, 0x03, 0x00, 0x00, 0x78, 0x69,
+    0x00, 0x00, 0xCE, 0xFF, 0xFF, 0xFF, 0x82, 0x6C, 0x00, 0x00, 0x79, 0x84,
+    0x89, 0x00, 0x2C, 0x01, 0x00, 0x00, 0x50, 0xC3, 0x00, 0x00, 0x78, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x7F, 0xFD,
+};
+
+void test_ubx_parser_recorded_stream() {
+  // Captura + la misma NAV-PVT con un byte corrupto + un 0xB5 suelto +
+  // la NAV-PVT íntegra, entregada en bloques de 7 bytes como la UART
+  std::vector<uint8_t> stream(UBX_CAPTURE_NMEA,
+                              UBX_CAPTURE_NMEA + strlen(UBX_CAPTURE_NMEA));
+  stream.insert(stream.end(), UBX_CAPTURE_ACK,
+                UBX_CAPTURE_ACK + sizeof(UBX_CAPTURE_ACK));
+  std::vector<uint8_t> corrupt(UBX_CAPTURE_NAV_PVT,
+                               UBX_CAPTURE_NAV_PVT +
+                                   sizeof(UBX_CAPTURE_NAV_PVT));
+  corrupt[40] ^= 0x10;
+  stream.insert(stream.end(), corrupt.begin(), corrupt.end());
+  stream.push_back(UBX_SYNC_1);
+  stream.insert(stream.end(), UBX_CAPTURE_NAV_PVT,
+                UBX_CAPTURE_NAV_PVT + sizeof(UBX_CAPTURE_NAV_PVT));
+
+  UbxParser parser;
+  uint8_t acks = 0, pvts = 0;
+  UbxNavPvtView pvt(nullptr);
+  uint8_t last[UBX_MAX_PAYLOAD];
+  for (size_t at = 0; at < stream.size(); at += 7) {
+    size_t end = at + 7 < stream.size() ? at + 7 : stream.size();
+    for (size_t i = at; i < end; i++) {
+      if (!parser.push(stream[i]))
+        continue;
+      if (parser.is(UBX_CLASS_ACK, UBX_ID_ACK_ACK)) {
+        acks++;
+        TEST_ASSERT_EQUAL_HEX8(UBX_ID_CFG_RATE, parser.payload()[1]);
+      } else if (parser.is(UBX_CLASS_NAV, UBX_ID_NAV_PVT)) {
+        pvts++;
+        TEST_ASSERT_EQUAL(UBX_NAV_PVT_LEN, parser.length());
+        memcpy(last, parser.payload(), parser.length());
+        pvt = UbxNavPvtView(last);
+      }
+    }
+  }
+
+  TEST_ASSERT_EQUAL(1, acks);
+  TEST_ASSERT_EQUAL(1, pvts);
+  TEST_ASSERT_EQUAL(1, parser.getChecksumErrors());
+
+  TEST_ASSERT_TRUE(pvt.utcValid());
+  TEST_ASSERT_EQUAL(2026, pvt.year());
+  TEST_ASSERT_EQUAL(14, pvt.day());
+  TEST_ASSERT_EQUAL(26, pvt.second());
+  TEST_ASSERT_EQUAL(-120, pvt.nanoNs());
+  TEST_ASSERT_TRUE(pvt.gnssFixOk());
+  TEST_ASSERT_EQUAL(3, pvt.fixType());
+  TEST_ASSERT_EQUAL(14, pvt.numSv());
+  TEST_ASSERT_EQUAL(318667321, pvt.latE7());
+  TEST_ASSERT_EQUAL(-1165963512, pvt.lonE7());
+  TEST_ASSERT_EQUAL(110250, pvt.heightMslMm());
+  TEST_ASSERT_EQUAL(27778, pvt.groundSpeedMmS());
+  TEST_ASSERT_EQUAL(9012345, pvt.headingE5());
+}
+
+void test_ubx_config_frames() {
+  // CFG-MSG que activa NAV-PVT (trama de referencia de u-center)
+  static const uint8_t expected[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00,
+                                     0x01, 0x07, 0x01, 0x13, 0x51};
+  uint8_t frame[UBX_CFG_MAX_FRAME];
+  size_t len = ubxBuildCfgMsg(UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1, frame,
+                              sizeof(frame));
+  TEST_ASSERT_EQUAL(sizeof(expected), len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, frame, len);
+
+  // Lo que se construye, el parser lo acepta
+  UbxParser parser;
+  len = ubxBuildCfgPrt(460800, frame, sizeof(frame));
+  TEST_ASSERT_EQUAL(UBX_CFG_MAX_FRAME, len);
+  bool done = false;
+  for (size_t i = 0; i < len; i++) {
+    done = parser.push(frame[i]);
+  }
+  TEST_ASSERT_TRUE(done);
+  TEST_ASSERT_TRUE(parser.is(UBX_CLASS_CFG, UBX_ID_CFG_PRT));
+  TEST_ASSERT_EQUAL(0, ubxBuildCfgRate(100, frame, 10));
+}
+
+// ============================================================================
+// OBD2 (MODE 01)
+// ============================================================================
+
+// Respuesta de un ELM327 a "010C0D04050F10" (ISO 15765-4 CAN): 15 bytes en
+// tres tramas, la última con relleno. Tal cual sale del ELM y como queda
+// en el payload de ELMduino, sin espacios ni saltos de línea
+static const char *OBD_MULTI_FRAME_RAW =
+    "00F \r0: 41 0C 1A F8 0D 32 \r1: 04 5A 05 7B 0F 3C 10 \r"
+    "2: 01 F4 55 55 55 55 55 \r\r";
+static const char *OBD_MULTI_FRAME_ELMDUINO =
+    "00F0:410C1AF80D321:045A057B0F3C102:01F45555555555";
+
+void test_obd_multi_pid_response() {
+  const uint8_t pids[] = {0x0C, 0x0D, 0x04, 0x05, 0x0F, 0x10};
+  char cmd[OBD_REQUEST_MAX_LEN];
+  TEST_ASSERT_EQUAL(14, obdBuildMode01Request(pids, 6, cmd, sizeof(cmd)));
+  TEST_ASSERT_EQUAL_STRING("010C0D04050F10", cmd);
+
+  const char *captures[] = {OBD_MULTI_FRAME_RAW, OBD_MULTI_FRAME_ELMDUINO};
+  for (const char *text : captures) {
+    uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+    ObdPidData data[OBD_MAX_BATCH_PIDS];
+    size_t len = obdElmResponseToBytes(text, bytes, sizeof(bytes));
+    TEST_ASSERT_EQUAL(15, len); // Sin cabecera, índices ni relleno
+    TEST_ASSERT_EQUAL(6, obdSplitMode01Response(bytes, len, pids, 6, data));
+
+    float expected[] = {1726.0f, 50.0f, 35.29f, 83.0f, 20.0f, 5.0f};
+    for (int i = 0; i < 6; i++) {
+      float value;
+      TEST_ASSERT_EQUAL_HEX8(pids[i], data[i].pid);
+      TEST_ASSERT_TRUE(
+          obdDecodeMode01(data[i].pid, data[i].data, data[i].len, &value));
+      TEST_ASSERT_FLOAT_WITHIN(0.01f, expected[i], value);
+    }
+  }
+}
+
+void test_obd_multi_pid_fallback_cases() {
+  const uint8_t pids[] = {0x0C, 0x0D};
+  uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+  ObdPidData data[OBD_MAX_BATCH_PIDS];
+  size_t len;
+
+  // Una sola trama tras el auto-protocolo, con eco de una segunda ECU
+  const char *twoEcus = "SEARCHING...\r41 0C 0B B8 0D 28 \r41 0D 29\r";
+  len = obdElmResponseToBytes(twoEcus, bytes, sizeof(bytes));
+  TEST_ASSERT_EQUAL(2, obdSplitMode01Response(bytes, len, pids, 2, data));
+  TEST_ASSERT_EQUAL_HEX8(0x0D, data[1].pid);
+  TEST_ASSERT_EQUAL_HEX8(0x28, data[1].data[0]);
+
+  // ECU sin multi-PID: responde solo al primero, con error o negativo
+  len = obdElmResponseToBytes("410C0BB8", bytes, sizeof(bytes));
+  TEST_ASSERT_EQUAL(1, obdSplitMode01Response(bytes, len, pids, 2, data));
+  len = obdElmResponseToBytes("NO DATA", bytes, sizeof(bytes));
+  TEST_ASSERT_EQUAL(0, len);
+  TEST_ASSERT_EQUAL(0, obdSplitMode01Response(bytes, len, pids, 2, data));
+  len = obdElmResponseToBytes("7F 01 12", bytes, sizeof(bytes));
+  TEST_ASSERT_EQUAL(0, obdSplitMode01Response(bytes, len, pids, 2, data));
+
+  // Respuesta truncada: el PID incompleto se descarta
+  len = obdElmResponseToBytes("410D28 0C0B", bytes, sizeof(bytes));
+  TEST_ASSERT_EQUAL(1, obdSplitMode01Response(bytes, len, pids, 2, data));
+  TEST_ASSERT_EQUAL_HEX8(0x0D, data[0].pid);
+
+  // Límites de la petición
+  const uint8_t seven[] = {1, 2, 3, 4, 5, 6, 7};
+  char cmd[OBD_REQUEST_MAX_LEN];
+  TEST_ASSERT_EQUAL(0, obdBuildMode01Request(seven, 7, cmd, sizeof(cmd)));
+  TEST_ASSERT_EQUAL(0, obdBuildMode01Request(pids, 2, cmd, 6));
+  TEST_ASSERT_EQUAL(6, obdBuildMode01Request(pids, 2, cmd, 7));
+}
+
+void test_obd_pid_table() {
+  // Cada PID de la tabla está en su índice y con su largo J1979
+  for (unsigned pid = 0; pid <= 0x66; pid++) {
+    const ObdPidInfo *info = obdMode01Info((uint8_t)pid);
+    TEST_ASSERT_NOT_NULL(info);
+    TEST_ASSERT_EQUAL_HEX8(pid, info->pid);
+    TEST_ASSERT_EQUAL(info->bytes, obdMode01DataLength((uint8_t)pid));
+  }
+  TEST_ASSERT_TRUE(obdMode01Info(0x67) == nullptr);
+  TEST_ASSERT_EQUAL(4, obdMode01DataLength(0x80)); // Mapa sin fila
+  TEST_ASSERT_EQUAL(0, obdMode01DataLength(0x67));
+
+  // Una fórmula por tipo de valor crudo
+  struct {
+    uint8_t pid;
+    uint8_t data[2];
+    float expected;
+  } cases[] = {
+      {0x06, {0x80, 0}, 0.0f},        // Trim: A*100/128 - 100
+      {0x0E, {0x00, 0}, -64.0f},      // Avance: A/2 - 64
+      {0x14, {0xC8, 0x80}, 1.0f},     // Sonda O2: A/200 (B es el trim)
+      {0x1F, {0x01, 0x2C}, 300.0f},   // Tiempo de marcha: 256A + B
+      {0x32, {0xFF, 0xFC}, -1.0f},    // Presión EVAP: con signo / 4
+      {0x3C, {0x11, 0x94}, 410.0f},   // Catalizador: AB/10 - 40
+      {0x42, {0x36, 0xB0}, 14.0f},    // Voltaje del módulo: AB/1000
+      {0x5E, {0x00, 0xC8}, 10.0f},    // Consumo: AB/20
+  };
+  for (const auto &c : cases) {
+    float value;
+    TEST_ASSERT_TRUE(obdDecodeMode01(c.pid, c.data, 2, &value));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, c.expected, value);
+    TEST_ASSERT_TRUE(obdMode01InRange(c.pid, value));
+  }
+
+  // Sin valor escalar, datos cortos o PID fuera de la tabla
+  const uint8_t d[4] = {0xBE, 0x1F, 0xA8, 0x13};
+  float value;
+  TEST_ASSERT_FALSE(obdDecodeMode01(0x01, d, 4, &value));
+  TEST_ASSERT_FALSE(obdDecodeMode01(0x0C, d, 1, &value));
+  TEST_ASSERT_FALSE(obdDecodeMode01(0x70, d, 4, &value));
+
+  // Rango: RPM acotada a valores posibles, PID desconocido nunca válido
+  TEST_ASSERT_TRUE(obdMode01InRange(0x0C, 9500.0f));
+  TEST_ASSERT_FALSE(obdMode01InRange(0x0C, 16000.0f));
+  TEST_ASSERT_FALSE(obdMode01InRange(0x05, -41.0f));
+  TEST_ASSERT_FALSE(obdMode01InRange(0x70, 0.0f));
+
+  // Campo del bus de los PIDs con campo estándar
+  TEST_ASSERT_EQUAL_STRING("engine.rpm", obdMode01Info(0x0C)->busKey);
+  TEST_ASSERT_EQUAL_STRING("engine.intake_temp", obdMode01Info(0x0F)->busKey);
+  TEST_ASSERT_TRUE(obdMode01Info(0x42)->busKey == nullptr);
+}
+
+void test_obd_supported_pids_and_vin() {
+  uint8_t bytes[OBD_MAX_RESPONSE_BYTES];
+  size_t len;
+  ObdSupportedPids supported = {{0}, 0};
+
+  // 0100 con dos ECUs: los mapas se combinan
+  len = obdElmResponseToBytes("41 00 BE 1F A8 13\r41 00 80 40 00 00\r",
+                              bytes, sizeof(bytes));
+  TEST_ASSERT_TRUE(obdParseSupportedMap(bytes, len, 0x00, &supported.maps[0]));
+  TEST_ASSERT_EQUAL_HEX32(0xBE5FA813, supported.maps[0]);
+  supported.count = 1;
+  TEST_ASSERT_TRUE(supported.supports(0x0C));
+  TEST_ASSERT_TRUE(supported.supports(0x0A)); // Solo la segunda ECU
+  TEST_ASSERT_FALSE(supported.supports(0x02));
+  TEST_ASSERT_TRUE(supported.supports(0x20)); // Hay mapa 0x20
+  TEST_ASSERT_FALSE(supported.supports(0x2F)); // Mapa 0x20 no leído
+
+  len = obdElmResponseToBytes("4120 00020000", bytes, sizeof(bytes));
+  TEST_ASSERT_FALSE(obdParseSupportedMap(bytes, len, 0x40, &supported.maps[1]));
+  TEST_ASSERT_TRUE(obdParseSupportedMap(bytes, len, 0x20, &supported.maps[1]));
+  supported.count = 2;
+  TEST_ASSERT_TRUE(supported.supports(0x2F));
+  TEST_ASSERT_FALSE(supported.supports(0x40)); // Sin mapa 0x40
+  TEST_ASSERT_FALSE(supported.supports(0x5C));
+
+  len = obdElmResponseToBytes("NO DATA", bytes, sizeof(bytes));
+  TEST_ASSERT_FALSE(obdParseSupportedMap(bytes, len, 0x00, &supported.maps[0]));
+
+  // VIN en CAN: una cabecera y tres tramas
+  char vin[OBD_VIN_LEN + 1];
+  const char *canVin = "014\r0: 49 02 01 31 44 34\r1: 47 50 30 30 52 35 35\r"
+                       "2: 42 31 32 33 34 35 36\r";
+  len = obdElmResponseToBytes(canVin, bytes, sizeof(bytes));
+  TEST_ASSERT_TRUE(obdParseVin(bytes, len, vin));
+  TEST_ASSERT_EQUAL_STRING("1D4GP00R55B123456", vin);
+
+  // VIN en protocolos anteriores: cinco líneas con relleno 0x00
+  const char *legacyVin = "49 02 01 00 00 00 31\r49 02 02 44 34 47 50\r"
+                          "49 02 03 30 30 52 35\r49 02 04 35 42 31 32\r"
+                          "49 02 05 33 34 35 36\r";
+  len = obdElmResponseToBytes(legacyVin, bytes, sizeof(bytes));
+  TEST_ASSERT_TRUE(obdParseVin(bytes, len, vin));
+  TEST_ASSERT_EQUAL_STRING("1D4GP00R55B123456", vin);
+
+  // Truncado o con caracteres fuera de ISO 3779
+  len = obdElmResponseToBytes("014\r0: 49 02 01 31 44 34\r", bytes,
+                              sizeof(bytes));
+  TEST_ASSERT_FALSE(obdParseVin(bytes, len, vin));
+  len = obdElmResponseToBytes("49 02 01 31 44 34 49 4F", bytes, sizeof(bytes));
+  TEST_ASSERT_FALSE(obdParseVin(bytes, len, vin));
+}
+
+// Pasa bytes por el receptor y devuelve cuántas tramas válidas completó
+static int obdLinkFeed(ObdLinkParser &parser, const uint8_t *bytes, size_t len,
+                       int *crcErrors) {
+  int frames = 0;
+  for (size_t i = 0; i < len; i++) {
+    ObdLinkResult r = parser.push(bytes[i]);
+    if (r == OBD_LINK_FRAME)
+      frames++;
+    if (r == OBD_LINK_ERROR_CRC)
+      (*crcErrors)++;
+  }
+  return frames;
+}
+
+void test_obd_link_round_trip() {
+  // Valor de verificación de CRC-16/CCITT-FALSE
+  TEST_ASSERT_EQUAL_HEX32(0x29B1,
+                          obdLinkCrc16((const uint8_t *)"123456789", 9));
+
+  ObdLinkData in;
+  in.tsUs = 0x0123456789ABCDEFULL;
+  in.count = 3;
+  in.samples[0] = {0x0C, 6543.25f, 12};
+  in.samples[1] = {OBD_LINK_PID_BATTERY, 13.8f, 0};
+  in.samples[2] = {0x05, -40.0f, 0xFFFF};
+  in.dtcCount = 2;
+  strcpy(in.dtcs[0], "P0301");
+  strcpy(in.dtcs[1], "U0100");
+
+  uint8_t frame[OBD_LINK_MAX_FRAME];
+  size_t len = obdLinkEncodeData(in, 7, frame, sizeof(frame));
+  TEST_ASSERT_EQUAL(6 + (8 + 1 + 3 * 7 + 1 + 2 * 5) + 2, len);
+  TEST_ASSERT_EQUAL(0, obdLinkEncodeData(in, 7, frame, len - 1));
+
+  // Ruido, una línea JSON de depuración y la trama en el mismo puerto
+  const char *noise = "\xA5garbage{\"t\":\"OBD_STATUS\",\"data\":\"ON\"}\n";
+  ObdLinkParser parser;
+  int crcErrors = 0;
+  TEST_ASSERT_EQUAL(0, obdLinkFeed(parser, (const uint8_t *)noise,
+                                   strlen(noise), &crcErrors));
+  TEST_ASSERT_FALSE(parser.inFrame());
+  TEST_ASSERT_EQUAL(1, obdLinkFeed(parser, frame, len, &crcErrors));
+  TEST_ASSERT_EQUAL(OBD_LINK_DATA, parser.type());
+  TEST_ASSERT_EQUAL(7, parser.seq());
+
+  ObdLinkData out;
+  TEST_ASSERT_TRUE(
+      obdLinkDecodeData(parser.payload(), parser.payloadLen(), &out));
+  TEST_ASSERT_TRUE(out.tsUs == in.tsUs);
+  TEST_ASSERT_EQUAL(3, out.count);
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL_HEX8(in.samples[i].pid, out.samples[i].pid);
+    TEST_ASSERT_EQUAL_FLOAT(in.samples[i].value, out.samples[i].value);
+    TEST_ASSERT_EQUAL(in.samples[i].ageMs, out.samples[i].ageMs);
+  }
+  TEST_ASSERT_EQUAL(2, out.dtcCount);
+  TEST_ASSERT_EQUAL_STRING("P0301", out.dtcs[0]);
+  TEST_ASSERT_EQUAL_STRING("U0100", out.dtcs[1]);
+
+  // Un bit cambiado: se descarta y la trama siguiente llega bien
+  uint8_t bad[OBD_LINK_MAX_FRAME];
+  memcpy(bad, frame, len);
+  bad[20] ^= 0x04;
+  TEST_ASSERT_EQUAL(0, obdLinkFeed(parser, bad, len, &crcErrors));
+  TEST_ASSERT_EQUAL(1, crcErrors);
+  TEST_ASSERT_EQUAL(1, obdLinkFeed(parser, frame, len, &crcErrors));
+
+  // Eventos de un byte y versión desconocida
+  uint8_t status = OBD_LINK_STATUS_CONNECTED;
+  uint8_t small[OBD_LINK_HEADER_LEN + 1 + OBD_LINK_CRC_LEN];
+  size_t smallLen = obdLinkEncodeFrame(OBD_LINK_STATUS, 8, &status, 1, small,
+                                       sizeof(small));
+  TEST_ASSERT_EQUAL(sizeof(small), smallLen);
+  TEST_ASSERT_EQUAL(1, obdLinkFeed(parser, small, smallLen, &crcErrors));
+  TEST_ASSERT_EQUAL(OBD_LINK_STATUS, parser.type());
+  TEST_ASSERT_EQUAL(OBD_LINK_STATUS_CONNECTED, parser.payload()[0]);
+
+  small[2] = OBD_LINK_VERSION + 1;
+  TEST_ASSERT_EQUAL(OBD_LINK_PENDING, parser.push(small[0]));
+  TEST_ASSERT_EQUAL(OBD_LINK_PENDING, parser.push(small[1]));
+  TEST_ASSERT_EQUAL(OBD_LINK_ERROR_VERSION, parser.push(small[2]));
+
+  // Payload truncado o con más lecturas de las admitidas
+  TEST_ASSERT_FALSE(obdLinkDecodeData(frame + OBD_LINK_HEADER_LEN, 20, &out));
+  uint8_t tooMany[10] = {0};
+  tooMany[8] = OBD_LINK_MAX_SAMPLES + 1;
+  TEST_ASSERT_FALSE(obdLinkDecodeData(tooMany, sizeof(tooMany), &out));
+}
+
+// Lista de PIDs del C3: RPM, BAT (no agrupable) y el resto Mode 01
+static const uint8_t SCHED_PIDS[] = {0x0C, 0x00, 0x05, 0x04, 0x0F, 0x0B,
+                                     0x10, 0x11, 0x0D, 0x5E, 0x2F, 0x0A,
+                                     0x5C, 0x3C};
+static const int SCHED_COUNT = sizeof(SCHED_PIDS);
+
+// Simula 60 s de polling con un ELM de RTT fijo y 80 ms entre peticiones;
+// devuelve lecturas por canal y el mayor hueco entre lecturas de cada uno
+static void simulateSchedule(uint8_t batch, uint32_t rttMs,
+                             uint32_t *reads, uint32_t *maxGapMs) {
+  ObdScheduler sched;
+  for (int i = 0; i < SCHED_COUNT; i++) {
+    ObdSchedule plan = obdDefaultSchedule(SCHED_PIDS[i]);
+    TEST_ASSERT_EQUAL(i, sched.add(plan.periodMs, plan.priority,
+                                   SCHED_PIDS[i] != 0x00));
+    sched.setActive(i, true);
+    reads[i] = 0;
+    maxGapMs[i] = 0;
+  }
+
+  uint32_t last[SCHED_COUNT] = {0};
+  uint32_t now = 0;
+  while (now < 60000) {
+    uint8_t picked[OBD_MAX_BATCH_PIDS];
+    uint8_t n = sched.next(now, batch, picked);
+    if (n == 0) {
+      now += 10;
+      continue;
+    }
+    if (n > 1) {
+      for (uint8_t i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(SCHED_PIDS[picked[i]] != 0x00); // BAT va solo
+      }
+    }
+    for (uint8_t i = 0; i < n; i++) {
+      uint8_t ch = picked[i];
+      if (now - last[ch] > maxGapMs[ch])
+        maxGapMs[ch] = now - last[ch];
+      last[ch] = now;
+      reads[ch]++;
+    }
+    now += rttMs;
+    sched.recordRtt(rttMs);
+    now += 80;
+  }
+}
+
+void test_obd_link_resync_after_bad_frame() {
+  ObdLinkData in;
+  in.tsUs = 1;
+  in.count = 1;
+  in.samples[0] = {0x0C, 3000.0f, 0};
+  in.dtcCount = 0;
+  uint8_t data[OBD_LINK_MAX_FRAME];
+  size_t dataLen = obdLinkEncodeData(in, 1, data, sizeof(data));
+  TEST_ASSERT_TRUE(dataLen > 0);
+
+  // Largo corrupto (0xFF): el cuerpo absorbe las 32 tramas siguientes,
+  // que deben llegar igual y en orden tras el error de CRC
+  const size_t smallLen = OBD_LINK_HEADER_LEN + 1 + OBD_LINK_CRC_LEN;
+  uint8_t stream[OBD_LINK_MAX_FRAME + 32 * smallLen];
+  memcpy(stream, data, dataLen);
+  stream[5] = 0xFF;
+  size_t streamLen = dataLen;
+  uint8_t status = OBD_LINK_STATUS_CONNECTED;
+  for (uint8_t seq = 0; seq < 32; seq++) {
+    streamLen += obdLinkEncodeFrame(OBD_LINK_STATUS, seq, &status, 1,
+                                    stream + streamLen, smallLen);
+  }
+  TEST_ASSERT_TRUE(streamLen > OBD_LINK_MAX_FRAME);
+
+  ObdLinkParser parser;
+  int frames = 0, crcErrors = 0;
+  for (size_t i = 0; i < streamLen; i++) {
+    ObdLinkResult r = parser.push(stream[i]);
+    if (r == OBD_LINK_ERROR_CRC)
+      crcErrors++;
+    if (r == OBD_LINK_FRAME) {
+      TEST_ASSERT_EQUAL(OBD_LINK_STATUS, parser.type());
+      TEST_ASSERT_EQUAL(frames, parser.seq());
+      frames++;
+    }
+  }
+  TEST_ASSERT_EQUAL(1, crcErrors);
+  TEST_ASSERT_EQUAL(32, frames);
+  TEST_ASSERT_FALSE(parser.inFrame());
+
+  // Trama truncada (bytes perdidos en la UART): la siguiente empieza
+  // dentro de su cuerpo y se recupera del buffer
+  crcErrors = 0;
+  TEST_ASSERT_EQUAL(0, obdLinkFeed(parser, data, dataLen - 3, &crcErrors));
+  TEST_ASSERT_EQUAL(1, obdLinkFeed(parser, data, dataLen, &crcErrors));
+  TEST_ASSERT_EQUAL(1, crcErrors);
+  TEST_ASSERT_EQUAL(OBD_LINK_DATA, parser.type());
+  TEST_ASSERT_FALSE(parser.inFrame());
+
+  // Versión desconocida seguida de una trama válida
+  uint8_t badVersion[OBD_LINK_MAX_FRAME];
+  memcpy(badVersion, data, dataLen);
+  badVersion[2] = OBD_LINK_VERSION + 1;
+  TEST_ASSERT_EQUAL(0, obdLinkFeed(parser, badVersion, dataLen, &crcErrors));
+  TEST_ASSERT_EQUAL(1, obdLinkFeed(parser, data, dataLen, &crcErrors));
+}
+
+void test_obd_scheduler_rates() {
+  uint32_t reads[SCHED_COUNT], gaps[SCHED_COUNT];
+
+  // Multi-PID: hay ancho de banda; cada canal cerca de su tasa objetivo
+  // (los de 10 Hz quedan limitados por una petición cada 140 ms: 428 en
+  // 60 s, menos las 30 que se lleva BAT sola)
+  simulateSchedule(OBD_MAX_BATCH_PIDS, 60, reads, gaps);
+  TEST_ASSERT_UINT32_WITHIN(10, 399, reads[0]); // RPM
+  TEST_ASSERT_UINT32_WITHIN(10, 399, reads[8]); // Velocidad
+  TEST_ASSERT_UINT32_WITHIN(4, 30, reads[2]);   // Refrigerante, 0.5 Hz
+  TEST_ASSERT_UINT32_WITHIN(2, 6, reads[10]);   // Nivel de combustible
+  // BAT ocupa una petición entera y los de 10 Hz siempre vencen antes:
+  // queda en el piso anti-inanición (una lectura cada dos períodos)
+  TEST_ASSERT_UINT32_WITHIN(4, 30, reads[1]);
+
+  // Un PID por petición: no alcanza para todos. Los rápidos se llevan el
+  // ancho de banda y los lentos siguen leyéndose
+  simulateSchedule(1, 60, reads, gaps);
+  TEST_ASSERT_TRUE(reads[0] > 10 * reads[2]);
+  for (int i = 0; i < SCHED_COUNT; i++) {
+    TEST_ASSERT_TRUE(reads[i] > 0);
+    TEST_ASSERT_TRUE(gaps[i] < 40000);
+  }
+}
+
+// ============================================================================
+// TELEMETRY BUS
+// ============================================================================
+
+void test_bus_snapshot() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+  bus.setEngineRpm(3000.0f);
+  bus.setCustomValue("oil_press", 4.5f);
+
+  TelemetrySnapshot snap;
+  bus.getSnapshot(snap);
+  TEST_ASSERT_EQUAL_FLOAT(3000.0f, snap.engine_rpm);
+
+  bool found = false;
+  for (int i = 0; i < snap.custom_count; i++) {
+    if (strcmp(snap.custom_values[i].key, "oil_press") == 0) {
+      TEST_ASSERT_EQUAL_FLOAT(4.5f, snap.custom_values[i].value);
+      found = true;
+    }
+  }
+  TEST_ASSERT_TRUE(found);
+}
+
+void test_bus_key_registry() {
+  static_assert(TelemetryKeys::ENGINE_RPM.id == telemetryKeyId("engine.rpm"),
+                "ID de clave calculado en compilación");
+
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // Internar es idempotente y equivale a escribir por nombre
+  int16_t slot = bus.internKey("can.oil_press");
+  TEST_ASSERT_TRUE(slot >= 0);
+  TEST_ASSERT_EQUAL(slot, bus.internKey("can.oil_press"));
+  TEST_ASSERT_EQUAL(slot, bus.findKey("can.oil_press"));
+  TEST_ASSERT_EQUAL(TELEMETRY_NO_SLOT, bus.findKey("can.never_seen"));
+
+  bus.setCustomValueAt(slot, 1.0f);
+  bus.setCustomValue("can.oil_press", 2.5f);
+
+  TelemetrySnapshot snap;
+  bus.getSnapshot(snap);
+  int hits = 0;
+  for (int i = 0; i < snap.custom_count; i++) {
+    if (strcmp(snap.custom_values[i].key, "can.oil_press") == 0) {
+      TEST_ASSERT_EQUAL_FLOAT(2.5f, snap.custom_values[i].value);
+      hits++;
+    }
+  }
+  TEST_ASSERT_EQUAL(1, hits);
+
+  // Valores genéricos por TelemetryKey y por String comparten slot
+  TelemetryValue out;
+  TEST_ASSERT_TRUE(bus.setValue(TelemetryKeys::OBD_STATUS, 1.0f, "", "OBD"));
+  TEST_ASSERT_TRUE(bus.getValue(String("OBD_Status"), out));
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, out.value);
+  TEST_ASSERT_EQUAL_STRING("OBD", out.source);
+
+  // Slots fuera de rango se ignoran
+  bus.setCustomValueAt(TELEMETRY_NO_SLOT, 9.0f);
+  TEST_ASSERT_FALSE(bus.setValueAt(TELEMETRY_MAX_KEYS, 9.0f));
+}
+
+static std::atomic<bool> writerStop{false};
+static std::atomic<bool> writerDone{false};
+
+static void writerTask(void *) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  for (float i = 0; !writerStop; i += 1.0f) {
+    bus.setImuAccel(i, i, i);
+  }
+  writerDone = true;
+  vTaskDelete(nullptr);
+}
+
+void test_bus_snapshot_consistent_under_writer() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+  writerStop = false;
+  writerDone = false;
+  xTaskCreatePinnedToCore(writerTask, "Writer", 4096, nullptr, 1, nullptr, 1);
+
+  TelemetrySnapshot snap;
+  for (int i = 0; i < 20000; i++) {
+    bus.getSnapshot(snap);
+    TEST_ASSERT_EQUAL_FLOAT(snap.imu_accel_x, snap.imu_accel_y);
+    TEST_ASSERT_EQUAL_FLOAT(snap.imu_accel_x, snap.imu_accel_z);
+  }
+
+  writerStop = true;
+  while (!writerDone) {
+    vTaskDelay(1);
+  }
+}
+
+static void txWriterTask(void *) {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  for (float i = 0; !writerStop; i += 1.0f) {
+    TelemetryWriteTx tx(bus);
+    tx.setEngineRpm(i);
+    tx.setEngineLoad(i);
+    tx.setEngineCoolantTemp(i);
+  }
+  writerDone = true;
+  vTaskDelete(nullptr);
+}
+
+void test_bus_write_transaction() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // Una transacción = una toma del mutex y una versión, N campos
+  uint32_t locks = bus.getWriteLocks();
+  uint32_t fields = bus.getWriteFields();
+  uint32_t version = bus.getVersion();
+  {
+    TelemetryWriteTx tx(bus);
+    TEST_ASSERT_TRUE(tx.isOpen());
+    tx.setEngineRpm(1.0f);
+    tx.setEngineLoad(1.0f);
+    tx.setEngineCoolantTemp(1.0f);
+  }
+  TEST_ASSERT_EQUAL_UINT32(locks + 1, bus.getWriteLocks());
+  TEST_ASSERT_EQUAL_UINT32(fields + 3, bus.getWriteFields());
+  TEST_ASSERT_EQUAL_UINT32(version + 1, bus.getVersion());
+
+  // Los lectores nunca ven una transacción a medias
+  writerStop = false;
+  writerDone = false;
+  xTaskCreatePinnedToCore(txWriterTask, "TxWriter", 4096, nullptr, 1, nullptr,
+                          1);
+
+  TelemetrySnapshot snap;
+  for (int i = 0; i < 20000; i++) {
+    bus.getSnapshot(snap);
+    TEST_ASSERT_EQUAL_FLOAT(snap.engine_rpm, snap.engine_load);
+    TEST_ASSERT_EQUAL_FLOAT(snap.engine_rpm, snap.engine_coolant_temp);
+  }
+
+  writerStop = true;
+  while (!writerDone) {
+    vTaskDelay(1);
+  }
+}
+
+void test_bus_history_cursors() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // 40 -> 32 muestras (potencia de 2); canal custom por clave
+  TEST_ASSERT_EQUAL(2, bus.beginHistory("imu.accel_x:40, can.susp_raw:16",
+                                        4096));
+  int16_t rawSlot = bus.findKey("can.susp_raw");
+  TEST_ASSERT_TRUE(rawSlot >= 0);
+
+  HistoryCursor logger, cloud, late;
+  TEST_ASSERT_TRUE(bus.openHistory(TelemetryKeys::IMU_ACCEL_X, logger));
+  TEST_ASSERT_TRUE(bus.openHistory("imu.accel_x", cloud));
+  TEST_ASSERT_FALSE(bus.openHistory(TelemetryKeys::ENGINE_RPM, late));
+
+  const TelemetryHistory &history = bus.getHistory();
+  for (int i = 0; i < 10; i++) {
+    TelemetryWriteTx tx(bus);
+    tx.setImuAccel((float)i, 0, 0);
+    tx.setCustomValueAt(rawSlot, (float)i);
+  }
+
+  // Cada cursor drena por su cuenta, sin copiar
+  HistorySpan span;
+  TEST_ASSERT_EQUAL(10, history.peek(logger, span));
+  TEST_ASSERT_EQUAL(10, span.firstCount);
+  TEST_ASSERT_EQUAL_FLOAT(9.0f, span.first[9].value);
+  TEST_ASSERT_TRUE(history.consume(logger, 10));
+  TEST_ASSERT_EQUAL(0, history.peek(logger, span));
+  TEST_ASSERT_EQUAL(10, history.peek(cloud, span));
+
+  // Lector lento: el ring da la vuelta y se pierden las más viejas
+  for (int i = 10; i < 100; i++) {
+    bus.setImuAccel((float)i, 0, 0);
+  }
+  size_t n = history.peek(cloud, span);
+  TEST_ASSERT_EQUAL(31, n);
+  TEST_ASSERT_EQUAL(69, cloud.lost);
+  TEST_ASSERT_EQUAL(n, span.firstCount + span.secondCount);
+  const HistorySample &last =
+      span.secondCount ? span.second[span.secondCount - 1]
+                       : span.first[span.firstCount - 1];
+  TEST_ASSERT_EQUAL_FLOAT(99.0f, last.value);
+  TEST_ASSERT_TRUE(history.consume(cloud, n));
+
+  // Las muestras se sobrescriben mientras se leen: consume() lo detecta
+  TEST_ASSERT_TRUE(history.peek(logger, span) > 0);
+  for (int i = 0; i < 40; i++) {
+    bus.setImuAccel(0, 0, 0);
+  }
+  TEST_ASSERT_FALSE(history.consume(logger, 1));
+}
+
+// ============================================================================
+// TRAMAS CLOUD
+// ============================================================================
+
+static std::atomic<int16_t> notifySlot{TELEMETRY_NO_SLOT};
+
+static void customWriterTask(void *) {
+  TelemetryBus::getInstance().setCustomValueAt(notifySlot, 3.0f);
+  writerDone = true;
+  vTaskDelete(nullptr);
+}
+
+void test_bus_subscriptions() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // Cada suscriptor acumula solo sus canales, en su propio conjunto
+  int8_t engine = bus.subscribe(TELEMETRY_CH_ENGINE);
+  int8_t all = bus.subscribe(TELEMETRY_CH_ALL);
+  TEST_ASSERT_NOT_EQUAL(TELEMETRY_NO_SUBSCRIBER, engine);
+  TEST_ASSERT_NOT_EQUAL(TELEMETRY_NO_SUBSCRIBER, all);
+
+  bus.setImuAccel(0.0f, 0.0f, 1.0f);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.takeDirty(engine));
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_IMU, bus.takeDirty(all));
+
+  {
+    TelemetryWriteTx tx(bus);
+    tx.setEngineRpm(3000.0f);
+    tx.setFuelLevel(50.0f);
+  }
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_ENGINE, bus.takeDirty(engine));
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_ENGINE | TELEMETRY_CH_FUEL,
+                           bus.takeDirty(all));
+  TEST_ASSERT_EQUAL_UINT32(0, bus.takeDirty(engine));
+  TEST_ASSERT_EQUAL_UINT32(0, bus.takeDirty(TELEMETRY_NO_SUBSCRIBER));
+
+  // Notificación de tarea: una sola hasta que el suscriptor tome el set
+  int8_t custom = bus.subscribe(TELEMETRY_CH_CUSTOM,
+                                xTaskGetCurrentTaskHandle(), 0x04);
+  notifySlot = bus.internKey("sub.test");
+  uint32_t sent = bus.getNotifications();
+  bus.setCustomValueAt(notifySlot, 1.0f);
+  bus.setCustomValueAt(notifySlot, 2.0f);
+
+  uint32_t bits = 0;
+  TEST_ASSERT_EQUAL(pdTRUE, xTaskNotifyWait(0, 0xFFFFFFFF, &bits, 100));
+  TEST_ASSERT_EQUAL_UINT32(0x04, bits);
+  TEST_ASSERT_EQUAL_UINT32(sent + 1, bus.getNotifications());
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_CUSTOM, bus.takeDirty(custom));
+
+  // Ya tomado: la próxima escritura (otra tarea) vuelve a despertarla
+  writerDone = false;
+  xTaskCreatePinnedToCore(customWriterTask, "CustomWriter", 4096, nullptr, 1,
+                          nullptr, 1);
+  TEST_ASSERT_EQUAL(pdTRUE, xTaskNotifyWait(0, 0xFFFFFFFF, &bits, 1000));
+  TEST_ASSERT_EQUAL_UINT32(0x04, bits);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_CUSTOM, bus.takeDirty(custom));
+  while (!writerDone) {
+    vTaskDelay(1);
+  }
+
+  // Event group
+  EventGroupHandle_t group = xEventGroupCreate();
+  int8_t gps = bus.subscribeEventGroup(TELEMETRY_CH_GPS, group, 0x01);
+  TEST_ASSERT_NOT_EQUAL(TELEMETRY_NO_SUBSCRIBER, gps);
+  bus.setBatteryVoltage(12.6f);
+  TEST_ASSERT_EQUAL_UINT32(0, xEventGroupGetBits(group));
+  bus.setGps(19.4f, -99.1f, 2240.0f, 0.0f, 0.0f, 9, true);
+  TEST_ASSERT_EQUAL_UINT32(
+      0x01, xEventGroupWaitBits(group, 0x01, pdTRUE, pdFALSE, 100));
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_CH_GPS, bus.takeDirty(gps));
+}
+
+void test_bus_delta() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  static TelemetryDelta delta;
+  TEST_ASSERT_EQUAL(0, bus.getDelta(0, delta));
+  uint32_t seen = delta.version;
+
+  {
+    TelemetryWriteTx tx(bus);
+    tx.setEngineRpm(4200.0f);
+    tx.setEngineLoad(55.0f);
+  }
+  TEST_ASSERT_EQUAL(2, bus.getDelta(seen, delta));
+  TEST_ASSERT_EQUAL_UINT32(seen + 1, delta.version);
+  TEST_ASSERT_EQUAL(TelemetryKeys::ENGINE_RPM.slot, delta.entries[0].slot);
+  TEST_ASSERT_EQUAL_FLOAT(4200.0f, delta.entries[0].value);
+  TEST_ASSERT_EQUAL(TelemetryKeys::ENGINE_LOAD.slot, delta.entries[1].slot);
+  seen = delta.version;
+
+  // Sin escrituras: delta vacío, misma versión
+  TEST_ASSERT_EQUAL(0, bus.getDelta(seen, delta));
+  TEST_ASSERT_EQUAL_UINT32(seen, delta.version);
+
+  // Custom y genéricos entran por su slot; lo ya leído no se repite
+  int16_t slot = bus.internKey("delta.test");
+  bus.setCustomValueAt(slot, 7.5f);
+  bus.setValue(TelemetryKeys::OBD_STATUS, 1.0f);
+  TEST_ASSERT_EQUAL(2, bus.getDelta(seen, delta));
+  TEST_ASSERT_EQUAL(TelemetryKeys::OBD_STATUS.slot, delta.entries[0].slot);
+  TEST_ASSERT_EQUAL(slot, delta.entries[1].slot);
+  TEST_ASSERT_EQUAL_STRING("delta.test", bus.getKeyName(slot));
+
+  // Desde 0: todo lo escrito alguna vez
+  TEST_ASSERT_EQUAL(4, bus.getDelta(0, delta));
+
+  float rpm = 0;
+  TEST_ASSERT_TRUE(bus.getLatest(TelemetryKeys::ENGINE_RPM, rpm));
+  TEST_ASSERT_EQUAL_FLOAT(4200.0f, rpm);
+  TEST_ASSERT_FALSE(bus.getLatest(TelemetryKeys::FUEL_RATE, rpm));
+}
+
+void test_bus_quality() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // Nunca escrito -> NEVER; un cero legítimo es fresco
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_NEVER,
+                         bus.getQuality(TelemetryKeys::ENGINE_RPM));
+  bus.setEngineRpm(0.0f);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_FRESH,
+                         bus.getQuality(TelemetryKeys::ENGINE_RPM));
+
+  // Fuera del rango del esquema (0..16383): fresco pero no utilizable
+  bus.setEngineRpm(70000.0f);
+  uint8_t q = bus.getQuality(TelemetryKeys::ENGINE_RPM);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_FRESH | TELEMETRY_Q_RANGE, q);
+  TEST_ASSERT_FALSE(telemetryQualityUsable(q));
+
+  // Antigüedad máxima configurable por canal (custom)
+  int16_t slot = bus.internKey("quality.test");
+  TEST_ASSERT_TRUE(bus.setMaxAgeAt(slot, 5));
+  TEST_ASSERT_TRUE(bus.setRangeAt(slot, NAN, 10.0f));
+  bus.setCustomValueAt(slot, 3.0f);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_FRESH, bus.getQualityAt(slot));
+  delay(10);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_STALE, bus.getQualityAt(slot));
+
+  TelemetrySnapshot snap;
+  bus.getSnapshot(snap);
+  TEST_ASSERT_FALSE(snap.usable(TelemetryField::ENGINE_RPM));
+  TEST_ASSERT_EQUAL(1, snap.custom_count);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_Q_STALE, snap.custom_values[0].quality);
+}
+
+void test_bus_sample_timebase() {
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+
+  // Sello de 32 bits de una ISR extendido a 64 bits, también tras la vuelta
+  uint64_t now = (1ULL << 32) + 500;
+  TEST_ASSERT_TRUE(telemetryExtendUs(0xFFFFFF00UL, now) == now - 756);
+  TEST_ASSERT_TRUE(telemetryExtendUs(400, now) == now - 100);
+
+  // La transacción sella con el instante de captura, no con el de escritura
+  static TelemetryDelta delta;
+  bus.getDelta(0, delta);
+  uint32_t seen = delta.version;
+  uint64_t sampleUs = telemetryNowUs() - 2500;
+  {
+    TelemetryWriteTx tx(bus, sampleUs);
+    tx.setEngineRpm(3100.0f);
+  }
+  TEST_ASSERT_EQUAL(1, bus.getDelta(seen, delta));
+  TEST_ASSERT_TRUE(delta.entries[0].timestamp_us == sampleUs);
+
+  TelemetrySnapshot snap;
+  bus.getSnapshot(snap);
+  TEST_ASSERT_TRUE(snap.ts_engine_us == sampleUs);
+  TEST_ASSERT_TRUE(snap.captured_us > sampleUs);
+
+  // Ancla UTC: los sellos monotónicos se convierten al serializar
+  TelemetryClock &clock = TelemetryClock::getInstance();
+  uint64_t utc = 1767225600ULL * 1000000ULL;
+  clock.addReference(utc, sampleUs, TelemetryTimeSource::NTP);
+  TEST_ASSERT_TRUE(clock.isUtcValid());
+  TEST_ASSERT_TRUE(clock.toUtcUs(sampleUs + 1234) == utc + 1234);
+}
+
+void test_clock_discipline() {
+  TelemetryClock &clock = TelemetryClock::getInstance();
+  uint64_t mono = telemetryNowUs() + 10000000ULL;
+  uint64_t utc = 1767225600ULL * 1000000ULL;
+  clock.addReference(utc, mono, TelemetryTimeSource::NTP);
+  uint32_t steps = clock.getStatus().steps;
+
+  // El GPS desplaza al NTP; un error chico se corrige a medias (sin salto)
+  mono += 10000000ULL;
+  utc += 10000000ULL;
+  TEST_ASSERT_TRUE(
+      clock.addReference(utc + 800, mono, TelemetryTimeSource::GPS));
+  TelemetryClockStatus cs = clock.getStatus();
+  TEST_ASSERT_EQUAL(TelemetryTimeSource::GPS, cs.source);
+  TEST_ASSERT_EQUAL(steps, cs.steps);
+  TEST_ASSERT_EQUAL(800, cs.lastErrorUs);
+  TEST_ASSERT_TRUE(cs.driftPpb > 0);
+  TEST_ASSERT_TRUE(clock.toUtcUs(mono) == utc + 400);
+
+  // Mientras el GPS reporte, el NTP no lo pisa
+  TEST_ASSERT_FALSE(clock.addReference(utc + 50000, mono + 1000,
+                                       TelemetryTimeSource::NTP));
+  TEST_ASSERT_EQUAL(TelemetryTimeSource::GPS, clock.getSource());
+
+  // Un error grande salta de una vez
+  mono += 1000000ULL;
+  utc += 1000000ULL + 3000000ULL;
+  clock.addReference(utc, mono, TelemetryTimeSource::GPS_PPS);
+  TEST_ASSERT_EQUAL(steps + 1, clock.getStatus().steps);
+  TEST_ASSERT_TRUE(clock.toUtcUs(mono) == utc);
+
+  // Calendario sin libc (incluye un 29 de febrero)
+  char dt[TELEMETRY_UTC_STRING_LEN];
+  uint64_t leap = telemetryEpochFromUtc(2024, 2, 29, 12, 34, 56);
+  TEST_ASSERT_TRUE(leap == 1709210096ULL);
+  telemetryFormatUtc(leap * 1000000ULL + 999999ULL, dt);
+  TEST_ASSERT_EQUAL_STRING("2024-02-29 12:34:56", dt);
+  telemetryFormatUtc(0, dt);
+  TEST_ASSERT_EQUAL_STRING("1970-01-01 00:00:00", dt);
+}
+
+void test_json_payload_matches_legacy_frame() {
+  UnifiedConfig cfg = makeConfig();
+  TelemetrySnapshot snap;
+  snap.engine_rpm = 6543.0f;
+  snap.battery_voltage = 13.8f;
+  snap.quality[(uint8_t)TelemetryField::ENGINE_RPM] = TELEMETRY_Q_FRESH;
+  snap.quality[(uint8_t)TelemetryField::BATTERY_VOLTAGE] = TELEMETRY_Q_FRESH;
+  snap.engine_load = 40.0f; // congelado: no se envía aunque sea != 0
+  snap.quality[(uint8_t)TelemetryField::ENGINE_LOAD] = TELEMETRY_Q_STALE;
+  snap.wifi_rssi = -67;
+  snap.heap_free = 123456;
+
+  // 2023-11-14 22:13:20.250 UTC: "dt" trunca a segundos
+  const uint64_t timeUs = 1700000000ULL * 1000000ULL + 250000ULL;
+  char buf[JSON_PAYLOAD_MAX_SIZE];
+  size_t len = buildJsonPayload(snap, cfg, timeUs, buf, sizeof(buf));
+  TEST_ASSERT_TRUE(len > 0);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"id\":\"DEV01\",\"idc\":\"CAR01\",\"d\":false,"
+      "\"dt\":\"2023-11-14 22:13:20\",\"s\":{\"0x0C\":{\"v\":6543},"
+      "\"BAT\":{\"v\":13.8},\"wifi_rssi\":{\"v\":-67},"
+      "\"heap_free\":{\"v\":123456}},\"DTC\":[]}",
+      buf);
+  TEST_ASSERT_EQUAL(0, buildJsonPayload(snap, cfg, timeUs, buf, 32));
+}
+
+void test_json_payload_unsynced_omits_dt() {
+  UnifiedConfig cfg = makeConfig();
+  TelemetrySnapshot snap;
+  snap.engine_rpm = 900.0f;
+  snap.quality[(uint8_t)TelemetryField::ENGINE_RPM] = TELEMETRY_Q_FRESH;
+
+  // Reloj sin anclar: ni "dt" ni una fecha de 1970
+  char buf[JSON_PAYLOAD_MAX_SIZE];
+  size_t len = buildJsonPayload(snap, cfg, 0, buf, sizeof(buf));
+  TEST_ASSERT_TRUE(len > 0);
+  TEST_ASSERT_EQUAL(len, strlen(buf));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"id\":\"DEV01\",\"idc\":\"CAR01\",\"d\":false,"
+      "\"s\":{\"0x0C\":{\"v\":900},\"wifi_rssi\":{\"v\":0},"
+      "\"heap_free\":{\"v\":0}},\"DTC\":[]}",
+      buf);
+  TEST_ASSERT_TRUE(strstr(buf, "1970") == nullptr);
+}
+
+void test_binary_payload_header() {
+  UnifiedConfig cfg = makeConfig();
+  TelemetrySnapshot snap;
+  snap.engine_rpm = 6543.0f;
+  snap.quality[(uint8_t)TelemetryField::ENGINE_RPM] = TELEMETRY_Q_FRESH;
+
+  uint8_t buf[BINARY_PAYLOAD_MAX_SIZE];
+  uint64_t timeUs = 1700000000ULL * 1000000ULL + 123456ULL;
+  size_t len = buildBinaryPayload(snap, cfg, timeUs, buf, sizeof(buf));
+  TEST_ASSERT_TRUE(len > 0);
+  TEST_ASSERT_EQUAL_HEX8(BINARY_PAYLOAD_MAGIC, buf[0]);
+  TEST_ASSERT_EQUAL(BINARY_PAYLOAD_VERSION, buf[1]);
+  TEST_ASSERT_EQUAL_HEX8(BINARY_FLAG_TIME_VALID, buf[2]);
+
+  uint64_t wire = 0;
+  for (int i = 7; i >= 0; i--) {
+    wire = (wire << 8) | buf[3 + i];
+  }
+  TEST_ASSERT_TRUE(wire == timeUs);
+}
+
+void test_schema_field_roundtrip() {
+  // Cada campo con ID de canal se lee/escribe por ID y por campo igual
+  TelemetrySnapshot snap;
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    uint8_t id = TELEMETRY_FIELDS[i].payloadId;
+    if (id == 0)
+      continue;
+    payloadChannelSet(snap, id, (float)(i + 1));
+    TEST_ASSERT_EQUAL_FLOAT((float)(i + 1),
+                            telemetryFieldGet(snap, (TelemetryField)i));
+    TEST_ASSERT_EQUAL_FLOAT((float)(i + 1), payloadChannelGet(snap, id));
+  }
+
+  // Campos que antes no tenían setter ni despacho (intake, suspensión)
+  TelemetryBus &bus = TelemetryBus::getInstance();
+  bus.begin();
+  bus.setField(TelemetryField::ENGINE_INTAKE_TEMP, 31.0f);
+  bus.setField(TelemetryField::SUSP_FL, 42.0f);
+  float v = 0;
+  TEST_ASSERT_TRUE(bus.getLatest(TelemetryKeys::SUSP_FL, v));
+  TEST_ASSERT_EQUAL_FLOAT(42.0f, v);
+
+  bus.getSnapshot(snap);
+  TEST_ASSERT_TRUE(snap.usable(TelemetryField::SUSP_FL));
+  UnifiedConfig cfg = makeConfig();
+  static char json[JSON_PAYLOAD_MAX_SIZE];
+  TEST_ASSERT_TRUE(buildJsonPayload(snap, cfg, 0, json, sizeof(json)) > 0);
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"engine.intake_temp\":{\"v\":31}"));
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"susp_fl\":{\"v\":42}"));
+}
+
+// ============================================================================
+// REGISTROS Y BUFFER OFFLINE
+// ============================================================================
+
+void test_snapshot_record_delta_roundtrip() {
+  SnapshotRecordEncoder enc;
+  SnapshotRecordDecoder dec;
+  TelemetrySnapshot a, b, out;
+  SnapshotRecordTime t1, t2, time;
+  t1.utcUs = 1;
+  t2.utcUs = 2;
+  uint8_t rec[SNAPSHOT_RECORD_MAX_SIZE];
+
+  a.engine_rpm = 1000.0f;
+  a.quality[(uint8_t)TelemetryField::ENGINE_RPM] = TELEMETRY_Q_FRESH;
+  a.gps_fix = true;
+  size_t len = enc.encode(a, t1, true, rec, sizeof(rec));
+  TEST_ASSERT_TRUE(len > 0);
+  enc.commit(a, true);
+  TEST_ASSERT_TRUE(dec.decode(rec, len, out, time));
+  TEST_ASSERT_EQUAL_FLOAT(1000.0f, out.engine_rpm);
+  TEST_ASSERT_TRUE(out.usable(TelemetryField::ENGINE_RPM));
+
+  // El RPM se congela sin cambiar de valor: el delta lleva la calidad
+  b = a;
+  b.engine_speed = 88.0f;
+  b.quality[(uint8_t)TelemetryField::ENGINE_RPM] = TELEMETRY_Q_STALE;
+  size_t deltaLen = enc.encode(b, t2, false, rec, sizeof(rec));
+  TEST_ASSERT_TRUE(deltaLen < len + 16);
+
+  // Aplicar dos veces el mismo delta es idempotente
+  TEST_ASSERT_TRUE(dec.decode(rec, deltaLen, out, time));
+  TEST_ASSERT_TRUE(dec.decode(rec, deltaLen, out, time));
+  TEST_ASSERT_TRUE(time.utcUs == 2);
+  TEST_ASSERT_EQUAL_FLOAT(1000.0f, out.engine_rpm);
+  TEST_ASSERT_EQUAL_FLOAT(88.0f, out.engine_speed);
+  TEST_ASSERT_FALSE(out.usable(TelemetryField::ENGINE_RPM));
+  TEST_ASSERT_TRUE(out.gps_fix);
+}
+
+void test_flash_log_survives_reboot() {
+  uint8_t rec[64];
+  {
+    FlashLog log;
+    TEST_ASSERT_TRUE(log.begin());
+    for (uint32_t i = 0; i < 100; i++) {
+      memset(rec, (uint8_t)i, sizeof(rec));
+      TEST_ASSERT_TRUE(log.append(rec, sizeof(rec)));
+    }
+    TEST_ASSERT_TRUE(log.flush());
+  }
+
+  FlashLog log;
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_EQUAL(100, log.count());
+
+  size_t len = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    TEST_ASSERT_TRUE(log.peek(rec, sizeof(rec), len));
+    TEST_ASSERT_EQUAL(sizeof(rec), len);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)i, rec[0]);
+    log.consume();
+  }
+  TEST_ASSERT_TRUE(log.isEmpty());
+}
+
+// Sin nuevas escrituras el cache solo llega a flash por flushIfStale()
+void test_flash_log_flushes_stale_cache() {
+  uint8_t rec[64] = {0x5A};
+  {
+    FlashLog log;
+    TEST_ASSERT_TRUE(log.begin());
+    log.clear();
+    uint32_t t0 = millis();
+    TEST_ASSERT_TRUE(log.append(rec, sizeof(rec)));
+
+    TEST_ASSERT_TRUE(log.flushIfStale(t0 + FLASH_LOG_FLUSH_MS - 1000));
+    TEST_ASSERT_EQUAL(0, log.getFlushCount());
+    TEST_ASSERT_TRUE(log.flushIfStale(t0 + FLASH_LOG_FLUSH_MS + 1000));
+    TEST_ASSERT_EQUAL(1, log.getFlushCount());
+  }
+
+  FlashLog log;
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_EQUAL(1, log.count());
+  log.clear();
+}
+
+void test_offline_buffer_fifo() {
+  OfflineBuffer &ob = OfflineBuffer::getInstance();
+  ob.begin();
+  ob.clear();
+
+  // Muestras a 1 ms: la resolución en µs sobrevive al buffer
+  const uint64_t t0 = BINARY_MIN_VALID_EPOCH * 1000000ULL;
+  TelemetrySnapshot snap;
+  for (uint32_t i = 0; i < 500; i++) {
+    snap.engine_rpm = (float)(i % 7) * 1000.0f;
+    snap.fuel_level = (float)i;
+    TEST_ASSERT_TRUE(ob.push(snap, t0 + i * 1000ULL));
+  }
+  TEST_ASSERT_EQUAL(500, ob.count());
+
+  TelemetrySnapshot out;
+  uint64_t timeUs = 0;
+  for (uint32_t i = 0; i < 500; i++) {
+    TEST_ASSERT_TRUE(ob.peek(out, timeUs));
+    TEST_ASSERT_TRUE(timeUs == t0 + i * 1000ULL);
+    TEST_ASSERT_EQUAL_FLOAT((float)(i % 7) * 1000.0f, out.engine_rpm);
+    TEST_ASSERT_EQUAL_FLOAT((float)i, out.fuel_level);
+    ob.consume();
+  }
+  TEST_ASSERT_TRUE(ob.isEmpty());
+}
+
+void test_offline_buffer_resolves_unsynced_time() {
+  TelemetryClock &clock = TelemetryClock::getInstance();
+  if (!clock.isUtcValid()) {
+    clock.addReference(BINARY_MIN_VALID_EPOCH * 1000000ULL, telemetryNowUs(),
+                       TelemetryTimeSource::NTP);
+  }
+
+  OfflineBuffer &ob = OfflineBuffer::getInstance();
+  ob.clear();
+
+  // Guardado antes de sincronizar: la hora se resuelve al drenar
+  TelemetrySnapshot snap;
+  snap.captured_us = 5000000ULL;
+  TEST_ASSERT_TRUE(ob.push(snap, 0));
+
+  TelemetrySnapshot out;
+  uint64_t timeUs = 0;
+  TEST_ASSERT_TRUE(ob.peek(out, timeUs));
+  TEST_ASSERT_TRUE(timeUs != 0);
+  TEST_ASSERT_TRUE(timeUs == clock.toUtcUs(5000000ULL));
+  ob.consume();
+  TEST_ASSERT_TRUE(ob.isEmpty());
+
+  // El sello monotónico de otro arranque no es resoluble; la hora UTC
+  // guardada siempre manda
+  SnapshotRecordTime time;
+  time.monoUs = 5000000ULL;
+  time.bootId = telemetryBootId() + 1;
+  TEST_ASSERT_TRUE(time.resolveUtcUs(telemetryBootId(), clock) == 0);
+  time.utcUs = 42;
+  TEST_ASSERT_TRUE(time.resolveUtcUs(telemetryBootId(), clock) == 42);
+  time.utcUs = 0;
+  time.bootId = 0;
+  TEST_ASSERT_TRUE(time.resolveUtcUs(telemetryBootId(), clock) == 0);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_intel_unsigned);
+  RUN_TEST(test_decode_motorola_legacy_byte_aligned);
+  RUN_TEST(test_decode_dbc_signal_table);
+  RUN_TEST(test_decode_motorola_signed);
+  RUN_TEST(test_decode_float32_and_short_frame);
+  RUN_TEST(test_dispatch_lookup);
+  RUN_TEST(test_can_filters_exact_standard);
+  RUN_TEST(test_can_filters_standard_superset);
+  RUN_TEST(test_can_filters_extended_greedy);
+  RUN_TEST(test_can_filters_accept_all_cases);
+  RUN_TEST(test_ubx_parser_recorded_stream);
+  RUN_TEST(test_ubx_config_frames);
+  RUN_TEST(test_obd_multi_pid_response);
+  RUN_TEST(test_obd_multi_pid_fallback_cases);
+  RUN_TEST(test_obd_pid_table);
+  RUN_TEST(test_obd_supported_pids_and_vin);
+  RUN_TEST(test_obd_link_round_trip);
+  RUN_TEST(test_obd_link_resync_after_bad_frame);
+  RUN_TEST(test_obd_scheduler_rates);
+  RUN_TEST(test_bus_snapshot);
+  RUN_TEST(test_bus_key_registry);
+  RUN_TEST(test_bus_snapshot_consistent_under_writer);
+  RUN_TEST(test_bus_write_transaction);
+  RUN_TEST(test_bus_history_cursors);
+  RUN_TEST(test_bus_subscriptions);
+  RUN_TEST(test_bus_delta);
+  RUN_TEST(test_bus_quality);
+  RUN_TEST(test_bus_sample_timebase);
+  RUN_TEST(test_clock_discipline);
+  RUN_TEST(test_json_payload_matches_legacy_frame);
+  RUN_TEST(test_json_payload_unsynced_omits_dt);
+  RUN_TEST(test_binary_payload_header);
+  RUN_TEST(test_schema_field_roundtrip);
+  RUN_TEST(test_snapshot_record_delta_roundtrip);
+  RUN_TEST(test_flash_log_survives_reboot);
+  RUN_TEST(test_flash_log_flushes_stale_cache);
+  RUN_TEST(test_offline_buffer_fifo);
+  RUN_TEST(test_offline_buffer_resolves_unsynced_time);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+/**
+ * @file obd_pid_cache.cpp
+ * @brief Implementación de la caché de PIDs soportados
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "obd_pid_cache.h"
+
+#include <Preferences.h>
+#include <string.h>
+
+#define OBD_PID_CACHE_NAMESPACE "obd_pids"
+#define OBD_PID_CACHE_KEY "cache"
+#define OBD_PID_CACHE_VERSION 1
+
+struct ObdPidCacheEntry {
+  char vin[OBD_VIN_LEN + 1];
+  ObdSupportedPids pids;
+};
+
+struct ObdPidCacheBlob {
+  uint8_t version;
+  uint8_t next; ///< Próxima entrada a reemplazar
+  ObdPidCacheEntry entries[OBD_PID_CACHE_SLOTS];
+};
+
+static bool readBlob(Preferences &prefs, ObdPidCacheBlob *blob) {
+  if (prefs.getBytesLength(OBD_PID_CACHE_KEY) != sizeof(*blob) ||
+      prefs.getBytes(OBD_PID_CACHE_KEY, blob, sizeof(*blob)) !=
+          sizeof(*blob) ||
+      blob->version != OBD_PID_CACHE_VERSION) {
+    memset(blob, 0, sizeof(*blob));
+    blob->version = OBD_PID_CACHE_VERSION;
+    return false;
+  }
+  return true;
+}
+
+bool obdPidCacheLoad(const char *vin, ObdSupportedPids *out) {
+  Preferences prefs;
+  if (!prefs.begin(OBD_PID_CACHE_NAMESPACE, true)) {
+    return false; // Namespace todavía no creado
+  }
+
+  ObdPidCacheBlob blob;
+  bool found = false;
+  if (readBlob(prefs, &blob)) {
+    for (uint8_t i = 0; i < OBD_PID_CACHE_SLOTS; i++) {
+      const ObdPidCacheEntry &e = blob.entries[i];
+      if (strncmp(e.vin, vin, OBD_VIN_LEN) == 0 && e.pids.count > 0 &&
+          e.pids.count <= OBD_SUPPORTED_MAPS) {
+        *out = e.pids;
+        found = true;
+        break;
+      }
+    }
+  }
+  prefs.end();
+  return found;
+}
+
+void obdPidCacheStore(const char *vin, const ObdSupportedPids &pids) {
+  Preferences prefs;
+  if (!prefs.begin(OBD_PID_CACHE_NAMESPACE, false)) {
+    return;
+  }
+
+  ObdPidCacheBlob blob;
+  readBlob(prefs, &blob);
+
+  // Mismo VIN: se actualiza en su lugar; si no, se pisa el más antiguo
+  uint8_t slot = blob.next % OBD_PID_CACHE_SLOTS;
+  bool existing = false;
+  for (uint8_t i = 0; i < OBD_PID_CACHE_SLOTS; i++) {
+    if (strncmp(blob.entries[i].vin, vin, OBD_VIN_LEN) == 0) {
+      slot = i;
+      existing = true;
+      break;
+    }
+  }
+
+  ObdPidCacheEntry &e = blob.entries[slot];
+  strncpy(e.vin, vin, OBD_VIN_LEN);
+  e.vin[OBD_VIN_LEN] = '\0';
+  e.pids = pids;
+  if (!existing) {
+    blob.next = (uint8_t)((slot + 1) % OBD_PID_CACHE_SLOTS);
+  }
+
+  prefs.putBytes(OBD_PID_CACHE_KEY, &blob, sizeof(blob));
+  prefs.end();
+}
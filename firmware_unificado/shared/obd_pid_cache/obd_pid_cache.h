@@ -0,0 +1,32 @@
+/**
+ * @file obd_pid_cache.h
+ * @brief Caché en NVS de los PIDs soportados por vehículo (VIN)
+ *
+ * Guarda los mapas 0x00/0x20/0x40/0x60 de los últimos vehículos vistos
+ * para que una reconexión al mismo auto no repita el descubrimiento.
+ * Separada de obd_protocol porque depende de Preferences (ESP32).
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef OBD_PID_CACHE_H
+#define OBD_PID_CACHE_H
+
+#include <obd_protocol.h>
+
+// Vehículos recordados (se reemplaza el más antiguo)
+#define OBD_PID_CACHE_SLOTS 4
+
+/**
+ * @brief Busca los PIDs soportados guardados para un VIN
+ * @return false si el VIN no está en la caché
+ */
+bool obdPidCacheLoad(const char *vin, ObdSupportedPids *out);
+
+/**
+ * @brief Guarda (o actualiza) los PIDs soportados de un VIN
+ */
+void obdPidCacheStore(const char *vin, const ObdSupportedPids &pids);
+
+#endif // OBD_PID_CACHE_H
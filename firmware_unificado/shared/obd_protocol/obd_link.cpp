@@ -0,0 +1,259 @@
+/**
+ * @file obd_link.cpp
+ * @brief Implementación del protocolo binario C3 → principal
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "obd_link.h"
+
+#include <string.h>
+
+// ============================================================================
+// CRC
+// ============================================================================
+
+// Tabla de a 4 bits: 32 bytes en flash y 2 búsquedas por byte, ~4 veces
+// más rápida que bit a bit
+static const uint16_t CRC16_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+uint16_t obdLinkCrc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+// ============================================================================
+// CODIFICACIÓN
+// ============================================================================
+
+static void putU16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t getU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void putF32(uint8_t *p, float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  for (uint8_t i = 0; i < 4; i++) {
+    p[i] = (uint8_t)(bits >> (8 * i));
+  }
+}
+
+static float getF32(const uint8_t *p) {
+  uint32_t bits = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    bits |= (uint32_t)p[i] << (8 * i);
+  }
+  float v;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+// Cabecera y CRC alrededor de un payload ya escrito en out + HEADER_LEN
+static size_t finishFrame(uint8_t type, uint8_t seq, size_t len,
+                          uint8_t *out) {
+  out[0] = OBD_LINK_SYNC0;
+  out[1] = OBD_LINK_SYNC1;
+  out[2] = OBD_LINK_VERSION;
+  out[3] = type;
+  out[4] = seq;
+  out[5] = (uint8_t)len;
+
+  size_t end = OBD_LINK_HEADER_LEN + len;
+  putU16(out + end, obdLinkCrc16(out + 2, end - 2));
+  return end + OBD_LINK_CRC_LEN;
+}
+
+size_t obdLinkEncodeFrame(uint8_t type, uint8_t seq, const uint8_t *payload,
+                          size_t len, uint8_t *out, size_t cap) {
+  if (len > OBD_LINK_MAX_PAYLOAD ||
+      cap < OBD_LINK_HEADER_LEN + len + OBD_LINK_CRC_LEN) {
+    return 0;
+  }
+  if (len > 0) {
+    memcpy(out + OBD_LINK_HEADER_LEN, payload, len);
+  }
+  return finishFrame(type, seq, len, out);
+}
+
+size_t obdLinkEncodeData(const ObdLinkData &data, uint8_t seq, uint8_t *out,
+                         size_t cap) {
+  if (data.count > OBD_LINK_MAX_SAMPLES || data.dtcCount > OBD_LINK_MAX_DTCS) {
+    return 0;
+  }
+  size_t len = 8 + 1 + 7 * (size_t)data.count + 1 +
+               OBD_LINK_DTC_LEN * (size_t)data.dtcCount;
+  if (cap < OBD_LINK_HEADER_LEN + len + OBD_LINK_CRC_LEN) {
+    return 0;
+  }
+
+  uint8_t *p = out + OBD_LINK_HEADER_LEN;
+  for (uint8_t i = 0; i < 8; i++) {
+    *p++ = (uint8_t)(data.tsUs >> (8 * i));
+  }
+
+  *p++ = data.count;
+  for (uint8_t i = 0; i < data.count; i++) {
+    const ObdLinkSample &s = data.samples[i];
+    *p++ = s.pid;
+    putF32(p, s.value);
+    putU16(p + 4, s.ageMs);
+    p += 6;
+  }
+
+  *p++ = data.dtcCount;
+  for (uint8_t i = 0; i < data.dtcCount; i++) {
+    // Códigos más cortos se rellenan con 0
+    strncpy((char *)p, data.dtcs[i], OBD_LINK_DTC_LEN);
+    p += OBD_LINK_DTC_LEN;
+  }
+
+  return finishFrame(OBD_LINK_DATA, seq, len, out);
+}
+
+bool obdLinkDecodeData(const uint8_t *payload, size_t len, ObdLinkData *out) {
+  const uint8_t *p = payload;
+  const uint8_t *end = payload + len;
+
+  if (end - p < 9) {
+    return false;
+  }
+  out->tsUs = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    out->tsUs |= (uint64_t)*p++ << (8 * i);
+  }
+
+  out->count = *p++;
+  if (out->count > OBD_LINK_MAX_SAMPLES || end - p < 7 * out->count + 1) {
+    return false;
+  }
+  for (uint8_t i = 0; i < out->count; i++) {
+    ObdLinkSample &s = out->samples[i];
+    s.pid = *p++;
+    s.value = getF32(p);
+    s.ageMs = getU16(p + 4);
+    p += 6;
+  }
+
+  out->dtcCount = *p++;
+  if (out->dtcCount > OBD_LINK_MAX_DTCS ||
+      end - p < OBD_LINK_DTC_LEN * out->dtcCount) {
+    return false;
+  }
+  for (uint8_t i = 0; i < out->dtcCount; i++) {
+    memcpy(out->dtcs[i], p, OBD_LINK_DTC_LEN);
+    out->dtcs[i][OBD_LINK_DTC_LEN] = '\0';
+    p += OBD_LINK_DTC_LEN;
+  }
+  // Bytes de más: campos de una versión posterior, se ignoran
+  return true;
+}
+
+// ============================================================================
+// RECEPTOR
+// ============================================================================
+
+ObdLinkParser::ObdLinkParser()
+    : _state(HUNT_SYNC0), _pos(0), _replayPos(0), _replayLen(0) {
+  memset(_frame, 0, sizeof(_frame));
+}
+
+ObdLinkResult ObdLinkParser::push(uint8_t byte) {
+  if (_replayPos == _replayLen) {
+    return step(byte);
+  }
+
+  // Resincronizando: el byte nuevo va detrás de los pendientes
+  if (_replayLen == sizeof(_replay)) {
+    memmove(_replay, _replay + _replayPos, _replayLen - _replayPos);
+    _replayLen -= _replayPos;
+    _replayPos = 0;
+    if (_replayLen == sizeof(_replay)) {
+      _replayPos = 1; // Sin espacio: se pierde el más antiguo
+    }
+  }
+  _replay[_replayLen++] = byte;
+
+  while (_replayPos < _replayLen) {
+    ObdLinkResult r = step(_replay[_replayPos++]);
+    if (r != OBD_LINK_PENDING) {
+      return r;
+    }
+  }
+  _replayPos = _replayLen = 0;
+  return OBD_LINK_PENDING;
+}
+
+void ObdLinkParser::resync() {
+  // _frame[0] es el sincronismo de la trama descartada; desde _frame[1]
+  // puede empezar la siguiente (A5 5A). Esos bytes van delante de los que
+  // aún estaban pendientes
+  uint16_t pending = _replayLen - _replayPos;
+  uint16_t keep = _pos - 1;
+  if (keep + pending > sizeof(_replay)) {
+    keep = sizeof(_replay) - pending;
+  }
+  memmove(_replay + keep, _replay + _replayPos, pending);
+  memcpy(_replay, _frame + _pos - keep, keep);
+  _replayPos = 0;
+  _replayLen = keep + pending;
+  _state = HUNT_SYNC0;
+}
+
+ObdLinkResult ObdLinkParser::step(uint8_t byte) {
+  switch (_state) {
+  case HUNT_SYNC0:
+    if (byte == OBD_LINK_SYNC0) {
+      _state = HUNT_SYNC1;
+    }
+    return OBD_LINK_PENDING;
+
+  case HUNT_SYNC1:
+    if (byte == OBD_LINK_SYNC1) {
+      _frame[0] = OBD_LINK_SYNC0;
+      _frame[1] = OBD_LINK_SYNC1;
+      _pos = 2;
+      _state = HEADER;
+    } else if (byte != OBD_LINK_SYNC0) {
+      _state = HUNT_SYNC0;
+    }
+    return OBD_LINK_PENDING;
+
+  case HEADER:
+    _frame[_pos++] = byte;
+    if (_pos == 3 && byte != OBD_LINK_VERSION) {
+      resync();
+      return OBD_LINK_ERROR_VERSION;
+    }
+    if (_pos == OBD_LINK_HEADER_LEN) {
+      _state = BODY;
+    }
+    return OBD_LINK_PENDING;
+
+  case BODY: {
+    _frame[_pos++] = byte;
+    size_t end = OBD_LINK_HEADER_LEN + _frame[5];
+    if (_pos < end + OBD_LINK_CRC_LEN) {
+      return OBD_LINK_PENDING;
+    }
+    _state = HUNT_SYNC0;
+    if (getU16(_frame + end) != obdLinkCrc16(_frame + 2, end - 2)) {
+      resync();
+      return OBD_LINK_ERROR_CRC;
+    }
+    return OBD_LINK_FRAME;
+  }
+  }
+  return OBD_LINK_PENDING;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file obd_link.h
+ * @brief Protocolo binario C3 → principal por UART
+ *
+ * Tramas con prefijo de largo y CRC-16:
+ *
+ *   A5 5A | versión | tipo | secuencia | largo | payload | CRC-16 (LE)
+ *
+ * El CRC (CCITT-FALSE) cubre desde la versión hasta el payload. Los dos
+ * bytes de sincronismo permiten que el receptor distinga las tramas de
+ * las líneas JSON de depuración ({...}\n) en el mismo puerto y se
+ * resincronice tras un byte perdido. Todos los enteros van en little
+ * endian.
+ *
+ * Payload DATA (v1):
+ *   ts_us u64 | n u8 | n × (pid u8, valor f32, antigüedad u16 ms)
+ *   | ndtc u8 | ndtc × 5 caracteres ASCII
+ *
+ * Un receptor v1 ignora tipos desconocidos y bytes de más al final del
+ * payload: agregar campos al final no requiere cambiar la versión.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef OBD_LINK_H
+#define OBD_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBD_LINK_SYNC0 0xA5
+#define OBD_LINK_SYNC1 0x5A
+#define OBD_LINK_VERSION 1
+
+// sync(2) + versión + tipo + secuencia + largo
+#define OBD_LINK_HEADER_LEN 6
+#define OBD_LINK_CRC_LEN 2
+#define OBD_LINK_MAX_PAYLOAD 255
+#define OBD_LINK_MAX_FRAME                                                     \
+  (OBD_LINK_HEADER_LEN + OBD_LINK_MAX_PAYLOAD + OBD_LINK_CRC_LEN)
+
+#define OBD_LINK_MAX_SAMPLES 24
+#define OBD_LINK_MAX_DTCS 8
+#define OBD_LINK_DTC_LEN 5 // "P0301"
+
+// PID de la tensión de batería (AT RV, no es Mode 01)
+#define OBD_LINK_PID_BATTERY 0xFF
+
+/**
+ * @enum ObdLinkType
+ * @brief Tipo de trama
+ */
+enum ObdLinkType : uint8_t {
+  OBD_LINK_DATA = 1,       ///< Lecturas de PIDs y DTCs (ObdLinkData)
+  OBD_LINK_STATUS = 2,     ///< Estado del enlace OBD (ObdLinkStatus)
+  OBD_LINK_DTC_CLEARED = 3 ///< Resultado de CLEAR_DTC (ObdLinkDtcResult)
+};
+
+/// Payload de OBD_LINK_STATUS
+enum ObdLinkStatus : uint8_t {
+  OBD_LINK_STATUS_DISCONNECTED = 0,
+  OBD_LINK_STATUS_CONNECTED = 1,
+  OBD_LINK_STATUS_OBD_OFF = 2, ///< Respuesta a OBD_ENABLE 0
+  OBD_LINK_STATUS_OBD_ON = 3   ///< Respuesta a OBD_ENABLE 1
+};
+
+/// Payload de OBD_LINK_DTC_CLEARED
+enum ObdLinkDtcResult : uint8_t {
+  OBD_LINK_DTC_FAILED = 0,
+  OBD_LINK_DTC_SUCCESS = 1,
+  OBD_LINK_DTC_BUSY = 2
+};
+
+/**
+ * @brief Lectura de un PID
+ */
+struct ObdLinkSample {
+  uint8_t pid;    ///< PID Mode 01 u OBD_LINK_PID_BATTERY
+  float value;    ///< Unidades de ingeniería (ver obd_pids.h)
+  uint16_t ageMs; ///< Antigüedad respecto de tsUs (0xFFFF = sin lectura)
+};
+
+/**
+ * @brief Contenido de una trama DATA
+ */
+struct ObdLinkData {
+  uint64_t tsUs; ///< Reloj del C3 al armar la trama
+  uint8_t count;
+  ObdLinkSample samples[OBD_LINK_MAX_SAMPLES];
+  uint8_t dtcCount;
+  char dtcs[OBD_LINK_MAX_DTCS][OBD_LINK_DTC_LEN + 1];
+};
+
+/**
+ * @brief CRC-16/CCITT-FALSE (polinomio 0x1021, inicial 0xFFFF)
+ */
+uint16_t obdLinkCrc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief Arma una trama con el payload dado
+ * @return Bytes escritos en out, 0 si no cabe en cap
+ */
+size_t obdLinkEncodeFrame(uint8_t type, uint8_t seq, const uint8_t *payload,
+                          size_t len, uint8_t *out, size_t cap);
+
+/**
+ * @brief Arma una trama DATA
+ * @return Bytes escritos en out, 0 si no cabe en cap o hay demasiadas
+ *         lecturas o DTCs
+ */
+size_t obdLinkEncodeData(const ObdLinkData &data, uint8_t seq, uint8_t *out,
+                         size_t cap);
+
+/**
+ * @brief Lee el payload de una trama DATA
+ * @return false si está truncado o excede los máximos
+ */
+bool obdLinkDecodeData(const uint8_t *payload, size_t len, ObdLinkData *out);
+
+/**
+ * @enum ObdLinkResult
+ * @brief Resultado de ObdLinkParser::push
+ */
+enum ObdLinkResult : uint8_t {
+  OBD_LINK_PENDING = 0,  ///< Trama incompleta (o buscando sincronismo)
+  OBD_LINK_FRAME,        ///< Trama completa y válida
+  OBD_LINK_ERROR_CRC,    ///< CRC inválido: trama descartada
+  OBD_LINK_ERROR_VERSION ///< Versión no soportada: trama descartada
+};
+
+/**
+ * @class ObdLinkParser
+ * @brief Receptor de tramas byte a byte, sin memoria dinámica
+ *
+ * Una trama descartada (CRC o versión) no se tira entera: un largo
+ * corrupto puede haber absorbido las tramas siguientes. Sus bytes, salvo
+ * el primer sincronismo, se vuelven a analizar antes que los nuevos, una
+ * trama resultante por push().
+ */
+class ObdLinkParser {
+public:
+  ObdLinkParser();
+
+  /// Procesa un byte recibido (antes, los pendientes de resincronizar)
+  ObdLinkResult push(uint8_t byte);
+
+  /// ¿Hay una trama a medio recibir o bytes pendientes de analizar?
+  bool inFrame() const {
+    return _state != HUNT_SYNC0 || _replayPos < _replayLen;
+  }
+
+  void reset() {
+    _state = HUNT_SYNC0;
+    _replayPos = _replayLen = 0;
+  }
+
+  // Última trama válida (hasta el próximo push)
+  uint8_t type() const { return _frame[3]; }
+  uint8_t seq() const { return _frame[4]; }
+  uint8_t version() const { return _frame[2]; }
+  const uint8_t *payload() const { return _frame + OBD_LINK_HEADER_LEN; }
+  uint8_t payloadLen() const { return _frame[5]; }
+
+private:
+  enum State : uint8_t { HUNT_SYNC0, HUNT_SYNC1, HEADER, BODY };
+
+  ObdLinkResult step(uint8_t byte);
+  void resync();
+
+  State _state;
+  uint16_t _pos; ///< Bytes de _frame recibidos
+  uint8_t _frame[OBD_LINK_MAX_FRAME];
+
+  // Bytes de una trama descartada pendientes de volver a analizar
+  uint16_t _replayPos;
+  uint16_t _replayLen;
+  uint8_t _replay[OBD_LINK_MAX_FRAME];
+};
+
+#endif // OBD_LINK_H
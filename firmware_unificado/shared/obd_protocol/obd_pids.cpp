@@ -0,0 +1,198 @@
+/**
+ * @file obd_pids.cpp
+ * @brief Tabla de PIDs Mode 01 y su decodificación
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "obd_pids.h"
+
+#include <stddef.h>
+
+// ============================================================================
+// TABLA (SAE J1979)
+// ============================================================================
+
+// Formatos repetidos: largo, fórmula, escala, offset, mínimo, máximo
+#define OBD_BITS(n) n, OBD_FORMULA_NONE, 0, 0, 0, 0
+#define OBD_PERCENT 1, OBD_FORMULA_A, 100.0f / 255, 0, 0, 100
+#define OBD_TEMP 1, OBD_FORMULA_A, 1, -40, -40, 215
+#define OBD_TRIM(n) n, OBD_FORMULA_A, 100.0f / 128, -100, -100, 99.2f
+#define OBD_O2_VOLTS 2, OBD_FORMULA_A, 0.005f, 0, 0, 1.275f
+#define OBD_LAMBDA 4, OBD_FORMULA_AB, 2.0f / 65536, 0, 0, 2
+#define OBD_CAT_TEMP 2, OBD_FORMULA_AB, 0.1f, -40, -40, 1200
+#define OBD_COUNT(n) n, n == 1 ? OBD_FORMULA_A : OBD_FORMULA_AB, 1, 0, 0, \
+                     n == 1 ? 255 : 65535
+
+// Índice = PID. Los rangos son los de la fórmula salvo RPM, MAF, consumo
+// y temperatura de catalizador, acotados a valores físicamente posibles
+// para descartar lecturas corruptas
+// clang-format off
+static constexpr ObdPidInfo MODE01_PIDS[] = {
+  /*PID  largo, fórmula, escala, offset, mín, máx                          nombre                       unidad   campo del bus */
+  {0x00, OBD_BITS(4),                                                      "PIDS_01_20",                "",      nullptr},
+  {0x01, OBD_BITS(4),                                                      "MONITOR_STATUS",            "",      nullptr},
+  {0x02, OBD_BITS(2),                                                      "FREEZE_DTC",                "",      nullptr},
+  {0x03, OBD_BITS(2),                                                      "FUEL_SYSTEM_STATUS",        "",      nullptr},
+  {0x04, OBD_PERCENT,                                                      "ENGINE_LOAD",               "%",     "engine.load"},
+  {0x05, OBD_TEMP,                                                         "COOLANT_TEMP",              "C",     "engine.coolant_temp"},
+  {0x06, OBD_TRIM(1),                                                      "STFT_B1",                   "%",     nullptr},
+  {0x07, OBD_TRIM(1),                                                      "LTFT_B1",                   "%",     nullptr},
+  {0x08, OBD_TRIM(1),                                                      "STFT_B2",                   "%",     nullptr},
+  {0x09, OBD_TRIM(1),                                                      "LTFT_B2",                   "%",     nullptr},
+  {0x0A, 1, OBD_FORMULA_A,         3,            0,    0,      765,        "FUEL_PRESSURE",             "kPa",   nullptr},
+  {0x0B, 1, OBD_FORMULA_A,         1,            0,    0,      255,        "MAP",                       "kPa",   "engine.map"},
+  {0x0C, 2, OBD_FORMULA_AB,        0.25f,        0,    0,      10000,      "RPM",                       "rpm",   "engine.rpm"},
+  {0x0D, 1, OBD_FORMULA_A,         1,            0,    0,      255,        "SPEED",                     "km/h",  "engine.speed"},
+  {0x0E, 1, OBD_FORMULA_A,         0.5f,         -64,  -64,    63.5f,      "TIMING_ADVANCE",            "deg",   nullptr},
+  {0x0F, OBD_TEMP,                                                         "INTAKE_TEMP",               "C",     "engine.intake_temp"},
+  {0x10, 2, OBD_FORMULA_AB,        0.01f,        0,    0,      500,        "MAF",                       "g/s",   "engine.maf"},
+  {0x11, OBD_PERCENT,                                                      "THROTTLE",                  "%",     "engine.throttle"},
+  {0x12, OBD_BITS(1),                                                      "SECONDARY_AIR_STATUS",      "",      nullptr},
+  {0x13, OBD_BITS(1),                                                      "O2_SENSORS_PRESENT",        "",      nullptr},
+  {0x14, OBD_O2_VOLTS,                                                     "O2_S1_VOLTAGE",             "V",     nullptr},
+  {0x15, OBD_O2_VOLTS,                                                     "O2_S2_VOLTAGE",             "V",     nullptr},
+  {0x16, OBD_O2_VOLTS,                                                     "O2_S3_VOLTAGE",             "V",     nullptr},
+  {0x17, OBD_O2_VOLTS,                                                     "O2_S4_VOLTAGE",             "V",     nullptr},
+  {0x18, OBD_O2_VOLTS,                                                     "O2_S5_VOLTAGE",             "V",     nullptr},
+  {0x19, OBD_O2_VOLTS,                                                     "O2_S6_VOLTAGE",             "V",     nullptr},
+  {0x1A, OBD_O2_VOLTS,                                                     "O2_S7_VOLTAGE",             "V",     nullptr},
+  {0x1B, OBD_O2_VOLTS,                                                     "O2_S8_VOLTAGE",             "V",     nullptr},
+  {0x1C, OBD_BITS(1),                                                      "OBD_STANDARD",              "",      nullptr},
+  {0x1D, OBD_BITS(1),                                                      "O2_SENSORS_PRESENT_4B",     "",      nullptr},
+  {0x1E, OBD_BITS(1),                                                      "AUX_INPUT_STATUS",          "",      nullptr},
+  {0x1F, OBD_COUNT(2),                                                     "RUN_TIME",                  "s",     nullptr},
+  {0x20, OBD_BITS(4),                                                      "PIDS_21_40",                "",      nullptr},
+  {0x21, OBD_COUNT(2),                                                     "DISTANCE_MIL_ON",           "km",    nullptr},
+  {0x22, 2, OBD_FORMULA_AB,        0.079f,       0,    0,      5177.27f,   "FUEL_RAIL_PRESSURE_VAC",    "kPa",   nullptr},
+  {0x23, 2, OBD_FORMULA_AB,        10,           0,    0,      655350,     "FUEL_RAIL_GAUGE_PRESSURE",  "kPa",   nullptr},
+  {0x24, OBD_LAMBDA,                                                       "O2_S1_LAMBDA",              "",      nullptr},
+  {0x25, OBD_LAMBDA,                                                       "O2_S2_LAMBDA",              "",      nullptr},
+  {0x26, OBD_LAMBDA,                                                       "O2_S3_LAMBDA",              "",      nullptr},
+  {0x27, OBD_LAMBDA,                                                       "O2_S4_LAMBDA",              "",      nullptr},
+  {0x28, OBD_LAMBDA,                                                       "O2_S5_LAMBDA",              "",      nullptr},
+  {0x29, OBD_LAMBDA,                                                       "O2_S6_LAMBDA",              "",      nullptr},
+  {0x2A, OBD_LAMBDA,                                                       "O2_S7_LAMBDA",              "",      nullptr},
+  {0x2B, OBD_LAMBDA,                                                       "O2_S8_LAMBDA",              "",      nullptr},
+  {0x2C, OBD_PERCENT,                                                      "COMMANDED_EGR",             "%",     nullptr},
+  {0x2D, OBD_TRIM(1),                                                      "EGR_ERROR",                 "%",     nullptr},
+  {0x2E, OBD_PERCENT,                                                      "EVAP_PURGE",                "%",     nullptr},
+  {0x2F, OBD_PERCENT,                                                      "FUEL_LEVEL",                "%",     "fuel.level"},
+  {0x30, OBD_COUNT(1),                                                     "WARMUPS_SINCE_CLEAR",       "",      nullptr},
+  {0x31, OBD_COUNT(2),                                                     "DISTANCE_SINCE_CLEAR",      "km",    nullptr},
+  {0x32, 2, OBD_FORMULA_AB_SIGNED, 0.25f,        0,    -8192,  8191.75f,   "EVAP_VAPOR_PRESSURE",       "Pa",    nullptr},
+  {0x33, 1, OBD_FORMULA_A,         1,            0,    0,      255,        "BARO_PRESSURE",             "kPa",   nullptr},
+  {0x34, OBD_LAMBDA,                                                       "O2_S1_LAMBDA_WR",           "",      nullptr},
+  {0x35, OBD_LAMBDA,                                                       "O2_S2_LAMBDA_WR",           "",      nullptr},
+  {0x36, OBD_LAMBDA,                                                       "O2_S3_LAMBDA_WR",           "",      nullptr},
+  {0x37, OBD_LAMBDA,                                                       "O2_S4_LAMBDA_WR",           "",      nullptr},
+  {0x38, OBD_LAMBDA,                                                       "O2_S5_LAMBDA_WR",           "",      nullptr},
+  {0x39, OBD_LAMBDA,                                                       "O2_S6_LAMBDA_WR",           "",      nullptr},
+  {0x3A, OBD_LAMBDA,                                                       "O2_S7_LAMBDA_WR",           "",      nullptr},
+  {0x3B, OBD_LAMBDA,                                                       "O2_S8_LAMBDA_WR",           "",      nullptr},
+  {0x3C, OBD_CAT_TEMP,                                                     "CAT_TEMP_B1S1",             "C",     nullptr},
+  {0x3D, OBD_CAT_TEMP,                                                     "CAT_TEMP_B2S1",             "C",     nullptr},
+  {0x3E, OBD_CAT_TEMP,                                                     "CAT_TEMP_B1S2",             "C",     nullptr},
+  {0x3F, OBD_CAT_TEMP,                                                     "CAT_TEMP_B2S2",             "C",     nullptr},
+  {0x40, OBD_BITS(4),                                                      "PIDS_41_60",                "",      nullptr},
+  {0x41, OBD_BITS(4),                                                      "MONITOR_STATUS_CYCLE",      "",      nullptr},
+  {0x42, 2, OBD_FORMULA_AB,        0.001f,       0,    0,      65.535f,    "CONTROL_VOLTAGE",           "V",     nullptr},
+  {0x43, 2, OBD_FORMULA_AB,        100.0f / 255, 0,    0,      25700,      "ABSOLUTE_LOAD",             "%",     nullptr},
+  {0x44, 2, OBD_FORMULA_AB,        2.0f / 65536, 0,    0,      2,          "COMMANDED_LAMBDA",          "",      nullptr},
+  {0x45, OBD_PERCENT,                                                      "RELATIVE_THROTTLE",         "%",     nullptr},
+  {0x46, OBD_TEMP,                                                         "AMBIENT_TEMP",              "C",     nullptr},
+  {0x47, OBD_PERCENT,                                                      "ABS_THROTTLE_B",            "%",     nullptr},
+  {0x48, OBD_PERCENT,                                                      "ABS_THROTTLE_C",            "%",     nullptr},
+  {0x49, OBD_PERCENT,                                                      "ACCEL_PEDAL_D",             "%",     nullptr},
+  {0x4A, OBD_PERCENT,                                                      "ACCEL_PEDAL_E",             "%",     nullptr},
+  {0x4B, OBD_PERCENT,                                                      "ACCEL_PEDAL_F",             "%",     nullptr},
+  {0x4C, OBD_PERCENT,                                                      "COMMANDED_THROTTLE",        "%",     nullptr},
+  {0x4D, OBD_COUNT(2),                                                     "TIME_MIL_ON",               "min",   nullptr},
+  {0x4E, OBD_COUNT(2),                                                     "TIME_SINCE_CLEAR",          "min",   nullptr},
+  {0x4F, OBD_BITS(4),                                                      "MAX_VALUES",                "",      nullptr},
+  {0x50, 4, OBD_FORMULA_A,         10,           0,    0,      2550,       "MAF_MAX",                   "g/s",   nullptr},
+  {0x51, OBD_BITS(1),                                                      "FUEL_TYPE",                 "",      nullptr},
+  {0x52, OBD_PERCENT,                                                      "ETHANOL",                   "%",     nullptr},
+  {0x53, 2, OBD_FORMULA_AB,        0.005f,       0,    0,      327.675f,   "EVAP_ABS_PRESSURE",         "kPa",   nullptr},
+  {0x54, 2, OBD_FORMULA_AB_SIGNED, 1,            0,    -32768, 32767,      "EVAP_PRESSURE",             "Pa",    nullptr},
+  {0x55, OBD_TRIM(2),                                                      "STFT_O2_B1_B3",             "%",     nullptr},
+  {0x56, OBD_TRIM(2),                                                      "LTFT_O2_B1_B3",             "%",     nullptr},
+  {0x57, OBD_TRIM(2),                                                      "STFT_O2_B2_B4",             "%",     nullptr},
+  {0x58, OBD_TRIM(2),                                                      "LTFT_O2_B2_B4",             "%",     nullptr},
+  {0x59, 2, OBD_FORMULA_AB,        10,           0,    0,      655350,     "FUEL_RAIL_ABS_PRESSURE",    "kPa",   nullptr},
+  {0x5A, OBD_PERCENT,                                                      "RELATIVE_ACCEL_PEDAL",      "%",     nullptr},
+  {0x5B, OBD_PERCENT,                                                      "HYBRID_BATTERY_LIFE",       "%",     nullptr},
+  {0x5C, 1, OBD_FORMULA_A,         1,            -40,  -40,    210,        "OIL_TEMP",                  "C",     "engine.oil_temp"},
+  {0x5D, 2, OBD_FORMULA_AB,        1.0f / 128,   -210, -210,   301.99f,    "INJECTION_TIMING",          "deg",   nullptr},
+  {0x5E, 2, OBD_FORMULA_AB,        0.05f,        0,    0,      100,        "FUEL_RATE",                 "L/h",   "fuel.rate"},
+  {0x5F, OBD_BITS(1),                                                      "EMISSION_REQUIREMENTS",     "",      nullptr},
+  {0x60, OBD_BITS(4),                                                      "PIDS_61_80",                "",      nullptr},
+  {0x61, 1, OBD_FORMULA_A,         1,            -125, -125,   130,        "DEMAND_TORQUE",             "%",     nullptr},
+  {0x62, 1, OBD_FORMULA_A,         1,            -125, -125,   130,        "ACTUAL_TORQUE",             "%",     nullptr},
+  {0x63, OBD_COUNT(2),                                                     "REFERENCE_TORQUE",          "Nm",    nullptr},
+  {0x64, OBD_BITS(5),                                                      "TORQUE_DATA",               "",      nullptr},
+  {0x65, OBD_BITS(2),                                                      "AUX_IO_SUPPORTED",          "",      nullptr},
+  {0x66, OBD_BITS(5),                                                      "MAF_SENSOR",                "",      nullptr},
+};
+// clang-format on
+
+static constexpr size_t MODE01_PID_COUNT =
+    sizeof(MODE01_PIDS) / sizeof(MODE01_PIDS[0]);
+
+// El acceso por índice exige que la fila i sea el PID i
+static constexpr bool tableIsIndexed(size_t i) {
+  return i >= MODE01_PID_COUNT ||
+         (MODE01_PIDS[i].pid == i && tableIsIndexed(i + 1));
+}
+static_assert(tableIsIndexed(0), "MODE01_PIDS: fila fuera de orden");
+
+// ============================================================================
+// CONSULTA Y DECODIFICACIÓN
+// ============================================================================
+
+const ObdPidInfo *obdMode01Info(uint8_t pid) {
+  return pid < MODE01_PID_COUNT ? &MODE01_PIDS[pid] : nullptr;
+}
+
+uint8_t obdMode01DataLength(uint8_t pid) {
+  if (pid < MODE01_PID_COUNT) {
+    return MODE01_PIDS[pid].bytes;
+  }
+  // Resto de los mapas de PIDs soportados
+  if (pid == 0x80 || pid == 0xA0 || pid == 0xC0) {
+    return 4;
+  }
+  return 0;
+}
+
+bool obdDecodeMode01(uint8_t pid, const uint8_t *d, uint8_t len,
+                     float *value) {
+  const ObdPidInfo *info = obdMode01Info(pid);
+  if (info == nullptr || len < info->bytes) {
+    return false;
+  }
+
+  float raw;
+  switch (info->formula) {
+  case OBD_FORMULA_A:
+    raw = d[0];
+    break;
+  case OBD_FORMULA_AB:
+    raw = (float)((d[0] << 8) | d[1]);
+    break;
+  case OBD_FORMULA_AB_SIGNED:
+    raw = (float)(int16_t)((d[0] << 8) | d[1]);
+    break;
+  default:
+    return false;
+  }
+
+  *value = raw * info->scale + info->offset;
+  return true;
+}
+
+bool obdMode01InRange(uint8_t pid, float value) {
+  const ObdPidInfo *info = obdMode01Info(pid);
+  return info != nullptr && value >= info->min && value <= info->max;
+}
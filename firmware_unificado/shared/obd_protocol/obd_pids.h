@@ -0,0 +1,70 @@
+/**
+ * @file obd_pids.h
+ * @brief Tabla de PIDs Mode 01 de SAE J1979 (0x00-0x66)
+ *
+ * Una fila por PID con su largo, fórmula, unidad, rango válido y campo de
+ * TelemetryBus. Decodificar y validar un valor es un acceso por índice:
+ * habilitar cualquier PID estándar no requiere código propio en ninguno de
+ * los dos firmwares.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef OBD_PIDS_H
+#define OBD_PIDS_H
+
+#include <stdint.h>
+
+/**
+ * @enum ObdFormula
+ * @brief Valor crudo del que sale el valor físico (crudo * scale + offset)
+ */
+enum ObdFormula : uint8_t {
+  OBD_FORMULA_NONE = 0, ///< Sin valor escalar (mapas de bits, estados)
+  OBD_FORMULA_A,        ///< A
+  OBD_FORMULA_AB,       ///< 256A + B
+  OBD_FORMULA_AB_SIGNED ///< 256A + B en complemento a 2
+};
+
+/**
+ * @brief Definición de un PID Mode 01
+ */
+struct ObdPidInfo {
+  uint8_t pid;
+  uint8_t bytes; ///< Bytes de datos (A, B, ...)
+  ObdFormula formula;
+  float scale;
+  float offset;
+  float min; ///< Rango válido: fuera de él la lectura se descarta
+  float max;
+  const char *name;
+  const char *unit;
+  const char *busKey; ///< Campo de TelemetryBus, nullptr = "obd.<pid>"
+};
+
+/**
+ * @brief Definición de un PID Mode 01
+ * @return nullptr si el PID no está en la tabla
+ */
+const ObdPidInfo *obdMode01Info(uint8_t pid);
+
+/**
+ * @brief Bytes de datos que devuelve un PID Mode 01 (0 = desconocido)
+ */
+uint8_t obdMode01DataLength(uint8_t pid);
+
+/**
+ * @brief Convierte los datos de un PID a unidades de ingeniería
+ * @return false si el PID no tiene fórmula o faltan bytes
+ */
+bool obdDecodeMode01(uint8_t pid, const uint8_t *data, uint8_t len,
+                     float *value);
+
+/**
+ * @brief ¿El valor está dentro del rango válido del PID?
+ * @return false también si el PID no está en la tabla
+ */
+bool obdMode01InRange(uint8_t pid, float value);
+
+#endif // OBD_PIDS_H
@@ -0,0 +1,223 @@
+/**
+ * @file obd_protocol.cpp
+ * @brief Implementación de las peticiones y respuestas Mode 01
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "obd_protocol.h"
+
+// ============================================================================
+// PETICIÓN
+// ============================================================================
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+size_t obdBuildMode01Request(const uint8_t *pids, uint8_t count, char *out,
+                             size_t cap) {
+  size_t len = 2 + 2 * (size_t)count;
+  if (count == 0 || count > OBD_MAX_BATCH_PIDS || cap < len + 1) {
+    return 0;
+  }
+
+  out[0] = '0';
+  out[1] = '1';
+  for (uint8_t i = 0; i < count; i++) {
+    out[2 + 2 * i] = HEX_DIGITS[pids[i] >> 4];
+    out[3 + 2 * i] = HEX_DIGITS[pids[i] & 0x0F];
+  }
+  out[len] = '\0';
+  return len;
+}
+
+// ============================================================================
+// RESPUESTA
+// ============================================================================
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+static bool isAlnum(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+         (c >= 'a' && c <= 'z');
+}
+
+size_t obdElmResponseToBytes(const char *text, uint8_t *out, size_t cap) {
+  // Se trabaja en nibbles: el índice de trama es un solo dígito pegado a
+  // los datos cuando ELMduino quita los saltos de línea ("00E0:410C...")
+  size_t nibbles = 0;
+  size_t total = 0; // Largo anunciado en la cabecera multitrama
+  bool multiFrame = false;
+  const char *p = text;
+
+  while (*p != '\0') {
+    if (*p == ':') {
+      // El último dígito era el índice de trama
+      if (nibbles > 0)
+        nibbles--;
+      if (!multiFrame) {
+        // Lo anterior es la cabecera con el largo total en bytes
+        for (size_t i = 0; i < nibbles; i++) {
+          uint8_t b = out[i / 2];
+          total = (total << 4) | ((i % 2) == 0 ? b >> 4 : b & 0x0F);
+        }
+        nibbles = 0;
+        multiFrame = true;
+      }
+      p++;
+      continue;
+    }
+
+    if (!isAlnum(*p)) {
+      p++;
+      continue;
+    }
+
+    // Palabra completa: solo se acepta si es toda hexadecimal
+    const char *start = p;
+    bool hex = true;
+    while (isAlnum(*p)) {
+      if (hexValue(*p) < 0)
+        hex = false;
+      p++;
+    }
+    if (!hex)
+      continue;
+
+    for (const char *c = start; c < p; c++) {
+      if (nibbles / 2 >= cap)
+        break;
+      uint8_t v = (uint8_t)hexValue(*c);
+      if ((nibbles % 2) == 0) {
+        out[nibbles / 2] = (uint8_t)(v << 4);
+      } else {
+        out[nibbles / 2] |= v;
+      }
+      nibbles++;
+    }
+  }
+
+  size_t bytes = nibbles / 2;
+  if (multiFrame && total > 0 && total < bytes) {
+    bytes = total; // Relleno de la última trama
+  }
+  return bytes;
+}
+
+uint8_t obdSplitMode01Response(const uint8_t *bytes, size_t len,
+                               const uint8_t *requested, uint8_t count,
+                               ObdPidData *out) {
+  if (len == 0 || bytes[0] != OBD_MODE01_RESPONSE) {
+    return 0; // Sin datos o respuesta negativa (0x7F)
+  }
+
+  uint8_t found = 0;
+  size_t i = 1;
+
+  while (i < len && found < count) {
+    uint8_t pid = bytes[i];
+
+    int slot = -1;
+    for (uint8_t k = 0; k < count; k++) {
+      if (requested[k] == pid) {
+        slot = k;
+        break;
+      }
+    }
+    bool duplicate = false;
+    for (uint8_t k = 0; k < found; k++) {
+      if (out[k].pid == pid)
+        duplicate = true;
+    }
+
+    if (slot < 0 && pid == OBD_MODE01_RESPONSE) {
+      i++; // Respuesta de otra ECU a continuación
+      continue;
+    }
+
+    uint8_t dataLen = obdMode01DataLength(pid);
+    if (dataLen == 0 || i + 1 + dataLen > len) {
+      break; // Relleno o respuesta truncada
+    }
+
+    if (slot >= 0 && !duplicate) {
+      out[found].pid = pid;
+      out[found].len = dataLen;
+      out[found].data = bytes + i + 1;
+      found++;
+    }
+    i += 1 + dataLen;
+  }
+
+  return found;
+}
+
+// ============================================================================
+// PIDS SOPORTADOS Y VIN
+// ============================================================================
+
+bool obdParseSupportedMap(const uint8_t *bytes, size_t len, uint8_t basePid,
+                          uint32_t *map) {
+  bool found = false;
+  *map = 0;
+
+  size_t i = 0;
+  while (i + 6 <= len) {
+    if (bytes[i] == OBD_MODE01_RESPONSE && bytes[i + 1] == basePid) {
+      const uint8_t *d = bytes + i + 2;
+      *map |= ((uint32_t)d[0] << 24) | ((uint32_t)d[1] << 16) |
+              ((uint32_t)d[2] << 8) | d[3];
+      found = true;
+      i += 6;
+    } else {
+      i++;
+    }
+  }
+  return found;
+}
+
+static bool isVinChar(uint8_t c) {
+  // Alfanuméricos en mayúscula sin I, O ni Q (ISO 3779)
+  if (c >= '0' && c <= '9')
+    return true;
+  return c >= 'A' && c <= 'Z' && c != 'I' && c != 'O' && c != 'Q';
+}
+
+bool obdParseVin(const uint8_t *bytes, size_t len, char *vin) {
+  char chars[OBD_VIN_LEN + 8];
+  size_t n = 0;
+
+  // Se descartan las cabeceras "49 02 <n>" (una en CAN, una por línea en
+  // los protocolos anteriores) y el relleno 0x00
+  size_t i = 0;
+  while (i < len) {
+    if (i + 2 < len && bytes[i] == 0x49 && bytes[i + 1] == 0x02) {
+      i += 3;
+      continue;
+    }
+    if (bytes[i] != 0x00) {
+      if (!isVinChar(bytes[i]) || n >= sizeof(chars)) {
+        return false;
+      }
+      chars[n++] = (char)bytes[i];
+    }
+    i++;
+  }
+
+  if (n != OBD_VIN_LEN) {
+    return false;
+  }
+  for (size_t k = 0; k < OBD_VIN_LEN; k++) {
+    vin[k] = chars[k];
+  }
+  vin[OBD_VIN_LEN] = '\0';
+  return true;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file obd_protocol.h
+ * @brief Protocolo OBD2 Mode 01 común al firmware principal y al C3
+ *
+ * Consultas de varios PIDs en una sola petición (hasta 6, ISO 15765-4) y
+ * separación de la respuesta del ELM327, de una o varias tramas CAN, en
+ * los datos de cada PID (fórmulas y rangos en obd_pids.h). No depende de
+ * Arduino ni de ELMduino: ambos firmwares la enlazan como librería
+ * (lib_extra_dirs = ../shared) y se prueba en el entorno native del
+ * firmware principal.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef OBD_PROTOCOL_H
+#define OBD_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "obd_pids.h"
+
+// PIDs por petición Mode 01 admitidos por ISO 15765-4
+#define OBD_MAX_BATCH_PIDS 6
+
+// Primer byte de una respuesta positiva a Mode 01 (0x40 + servicio)
+#define OBD_MODE01_RESPONSE 0x41
+
+// "01" + 2 dígitos por PID + terminador
+#define OBD_REQUEST_MAX_LEN (2 + 2 * OBD_MAX_BATCH_PIDS + 1)
+
+// Bytes de una respuesta de 6 PIDs de hasta 4 bytes cada uno, con margen
+#define OBD_MAX_RESPONSE_BYTES 48
+
+// Mapas de PIDs soportados que se leen: 0x00, 0x20, 0x40 y 0x60
+// (PIDs 0x01-0x80)
+#define OBD_SUPPORTED_MAPS 4
+
+// Largo del VIN (Mode 09 PID 02), sin terminador
+#define OBD_VIN_LEN 17
+
+// Buffer de respuesta del ELM327 (ELMduino reserva 40 por defecto, poco
+// para una respuesta multitrama con los índices "0:", "1:", ...)
+#define OBD_ELM_PAYLOAD_LEN 128
+
+/**
+ * @brief Datos de un PID dentro de una respuesta Mode 01
+ */
+struct ObdPidData {
+  uint8_t pid;
+  uint8_t len;         ///< Bytes de datos (A, B, ...)
+  const uint8_t *data; ///< Apunta al buffer pasado a obdSplitMode01Response
+};
+
+/**
+ * @brief PIDs Mode 01 soportados por el vehículo (mapas 0x00/0x20/...)
+ */
+struct ObdSupportedPids {
+  uint32_t maps[OBD_SUPPORTED_MAPS]; ///< Bit 31 del mapa n = PID n*0x20+1
+  uint8_t count;                     ///< Mapas leídos
+
+  bool supports(uint8_t pid) const {
+    if (pid == 0x00)
+      return true;
+    uint8_t map = (uint8_t)((pid - 1) / 32);
+    if (map >= count)
+      return false;
+    return (maps[map] >> (31 - (pid - 1) % 32)) & 1;
+  }
+};
+
+/**
+ * @brief Arma la petición Mode 01 de varios PIDs (ej: "010C0D05")
+ * @return Largo del comando (sin '\r'), 0 si count es 0 o mayor que
+ *         OBD_MAX_BATCH_PIDS o no cabe en cap
+ */
+size_t obdBuildMode01Request(const uint8_t *pids, uint8_t count, char *out,
+                             size_t cap);
+
+/**
+ * @brief Convierte el texto de respuesta del ELM327 en bytes
+ *
+ * Acepta la respuesta con o sin espacios y saltos de línea. En respuestas
+ * multitrama descarta la cabecera con el largo total y los índices de
+ * trama ("0:", "1:", ...) y recorta el relleno de la última trama.
+ * Las palabras que no son hexadecimales (SEARCHING..., NO DATA) se omiten.
+ *
+ * @return Bytes escritos en out
+ */
+size_t obdElmResponseToBytes(const char *text, uint8_t *out, size_t cap);
+
+/**
+ * @brief Separa una respuesta Mode 01 en los datos de cada PID pedido
+ *
+ * Los PIDs pueden llegar en cualquier orden; se ignoran los no pedidos,
+ * los repetidos y la cabecera 0x41 de una segunda ECU.
+ *
+ * @param out Al menos count elementos
+ * @return PIDs encontrados
+ */
+uint8_t obdSplitMode01Response(const uint8_t *bytes, size_t len,
+                               const uint8_t *requested, uint8_t count,
+                               ObdPidData *out);
+
+/**
+ * @brief Lee el mapa de soportados de la respuesta a "01<basePid>"
+ *
+ * Si responden varias ECUs se combinan sus mapas (OR).
+ *
+ * @return false si ninguna ECU respondió a ese mapa
+ */
+bool obdParseSupportedMap(const uint8_t *bytes, size_t len, uint8_t basePid,
+                          uint32_t *map);
+
+/**
+ * @brief Extrae el VIN de la respuesta a "0902"
+ *
+ * Acepta la respuesta CAN (una sola cabecera 49 02 01 y 17 caracteres) y
+ * la de protocolos anteriores (cinco líneas 49 02 <n> de 4 bytes).
+ *
+ * @param vin Al menos OBD_VIN_LEN + 1 bytes
+ * @return false si no hay 17 caracteres de VIN válidos
+ */
+bool obdParseVin(const uint8_t *bytes, size_t len, char *vin);
+
+#endif // OBD_PROTOCOL_H
@@ -0,0 +1,154 @@
+/**
+ * @file obd_scheduler.cpp
+ * @brief Implementación del planificador de PIDs OBD2
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#include "obd_scheduler.h"
+
+// ============================================================================
+// PLAN POR DEFECTO
+// ============================================================================
+
+ObdSchedule obdDefaultSchedule(uint8_t pid) {
+  switch (pid) {
+  case 0x0C: // RPM
+  case 0x0D: // Velocidad
+  case 0x11: // Acelerador
+    return {100, OBD_PRIORITY_HIGH};
+  case 0x04: // Carga
+  case 0x0B: // MAP
+  case 0x10: // MAF
+    return {200, OBD_PRIORITY_NORMAL};
+  case 0x05: // Refrigerante
+  case 0x0F: // Aire de admisión
+  case 0x3C: // Catalizador
+  case 0x5C: // Aceite
+    return {2000, OBD_PRIORITY_LOW};
+  case 0x2F: // Nivel de combustible
+    return {10000, OBD_PRIORITY_LOW};
+  default:
+    return {1000, OBD_PRIORITY_NORMAL};
+  }
+}
+
+// ============================================================================
+// PLANIFICADOR
+// ============================================================================
+
+ObdScheduler::ObdScheduler() : _count(0), _rttMs(0) {}
+
+void ObdScheduler::clear() {
+  _count = 0;
+  _rttMs = 0;
+}
+
+int8_t ObdScheduler::add(uint16_t periodMs, ObdPriority priority,
+                         bool batchable) {
+  if (_count >= OBD_SCHED_MAX_CHANNELS) {
+    return -1;
+  }
+
+  Channel &ch = _channels[_count];
+  ch.periodMs = periodMs > 0 ? periodMs : 1;
+  ch.priority = priority;
+  ch.batchable = batchable;
+  ch.active = false;
+  ch.polled = false;
+  ch.lastMs = 0;
+  return (int8_t)_count++;
+}
+
+void ObdScheduler::setActive(uint8_t channel, bool active) {
+  if (channel < _count) {
+    _channels[channel].active = active;
+  }
+}
+
+void ObdScheduler::recordRtt(uint32_t rttMs) {
+  _rttMs = _rttMs == 0 ? rttMs : (_rttMs * 3 + rttMs) / 4;
+}
+
+int ObdScheduler::rank(const Channel &ch, uint32_t nowMs, uint32_t &elapsed,
+                       uint32_t &period) const {
+  if (!ch.active) {
+    return -1;
+  }
+
+  // Nunca más seguido que lo que tarda una respuesta
+  period = ch.periodMs > _rttMs ? ch.periodMs : _rttMs;
+
+  if (!ch.polled) {
+    elapsed = 2 * period;
+    return OBD_PRIORITY_HIGH + 3; // Primera lectura cuanto antes
+  }
+
+  elapsed = nowMs - ch.lastMs;
+  if (elapsed >= 2 * period) {
+    return OBD_PRIORITY_HIGH + 2; // Sin leer hace dos períodos: primero
+  }
+  if (elapsed >= period) {
+    return ch.priority + 1;
+  }
+  if (elapsed + _rttMs >= period) {
+    return 0; // Vencería antes de la próxima petición
+  }
+  return -1;
+}
+
+uint8_t ObdScheduler::next(uint32_t nowMs, uint8_t maxCount, uint8_t *out) {
+  bool chosen[OBD_SCHED_MAX_CHANNELS] = {false};
+  uint8_t picked = 0;
+
+  while (picked < maxCount) {
+    int best = -1;
+    int bestRank = -1;
+    uint32_t bestElapsed = 0;
+    uint32_t bestPeriod = 1;
+
+    for (uint8_t i = 0; i < _count; i++) {
+      const Channel &ch = _channels[i];
+      if (chosen[i] || (picked > 0 && !ch.batchable)) {
+        continue;
+      }
+
+      uint32_t elapsed, period;
+      int r = rank(ch, nowMs, elapsed, period);
+      if (r < 0 || (picked == 0 && r == 0)) {
+        continue; // El primero del lote tiene que estar vencido
+      }
+
+      // A igual rango, el más atrasado respecto de su período, pesado por
+      // prioridad: con el enlace saturado todos caen a "dos períodos" y
+      // el reparto queda proporcional a tasa objetivo x (prioridad + 1)
+      elapsed *= ch.priority + 1;
+      if (r > bestRank ||
+          (r == bestRank &&
+           (uint64_t)elapsed * bestPeriod > (uint64_t)bestElapsed * period)) {
+        best = i;
+        bestRank = r;
+        bestElapsed = elapsed;
+        bestPeriod = period;
+      }
+    }
+
+    if (best < 0) {
+      break;
+    }
+
+    out[picked++] = (uint8_t)best;
+    chosen[best] = true;
+
+    if (!_channels[best].batchable) {
+      break; // Va solo en su petición
+    }
+  }
+
+  for (uint8_t i = 0; i < picked; i++) {
+    _channels[out[i]].lastMs = nowMs;
+    _channels[out[i]].polled = true;
+  }
+  return picked;
+}
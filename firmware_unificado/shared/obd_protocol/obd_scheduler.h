@@ -0,0 +1,109 @@
+/**
+ * @file obd_scheduler.h
+ * @brief Planificador de PIDs OBD2 por período objetivo y prioridad
+ *
+ * Cada canal (un PID) tiene un período objetivo y una prioridad. En cada
+ * petición se eligen los canales vencidos: primero los que llevan más de
+ * dos períodos sin leerse (anti-inanición), luego por prioridad y, a
+ * igual rango, el más atrasado en proporción a su período (pesado por
+ * prioridad: con el enlace saturado los rápidos se llevan el ancho de
+ * banda y los lentos siguen leyéndose, más espaciados). Con lugar
+ * en el lote se suman los que vencen antes de la próxima oportunidad
+ * (dentro de un RTT), que viajan gratis en la misma petición.
+ *
+ * El RTT del ELM327 se mide en cada respuesta: ningún canal se pide más
+ * seguido que un RTT y el margen de adelanto sigue al enlace real.
+ *
+ * @author Neurona Racing Development
+ * @date 2026-10-16
+ */
+
+#ifndef OBD_SCHEDULER_H
+#define OBD_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBD_SCHED_MAX_CHANNELS 20
+
+/**
+ * @enum ObdPriority
+ * @brief Prioridad de un canal cuando no hay ancho de banda para todos
+ */
+enum ObdPriority : uint8_t {
+  OBD_PRIORITY_LOW = 0,    ///< Temperaturas, nivel de combustible
+  OBD_PRIORITY_NORMAL = 1, ///< Carga, MAP, MAF, consumo
+  OBD_PRIORITY_HIGH = 2    ///< RPM, acelerador, velocidad
+};
+
+/**
+ * @brief Período y prioridad por defecto de un PID Mode 01
+ */
+struct ObdSchedule {
+  uint16_t periodMs;
+  ObdPriority priority;
+};
+
+/**
+ * @brief Plan por defecto: 10 Hz para RPM/acelerador/velocidad, 5 Hz para
+ *        carga/MAP/MAF, 0.5 Hz temperaturas, 0.1 Hz nivel de combustible
+ *        y 1 Hz para el resto
+ */
+ObdSchedule obdDefaultSchedule(uint8_t pid);
+
+/**
+ * @class ObdScheduler
+ * @brief Selección de los próximos PIDs a pedir
+ */
+class ObdScheduler {
+public:
+  ObdScheduler();
+
+  /// Elimina todos los canales
+  void clear();
+
+  /**
+   * @brief Agrega un canal (inactivo hasta setActive)
+   * @param batchable false para lo que no es Mode 01 (ej: BAT), que se
+   *        pide siempre solo
+   * @return Índice del canal (orden de alta), -1 si no hay lugar
+   */
+  int8_t add(uint16_t periodMs, ObdPriority priority, bool batchable);
+
+  void setActive(uint8_t channel, bool active);
+
+  /**
+   * @brief Elige los canales de la próxima petición y los marca leídos
+   * @param maxCount Tamaño máximo del lote (1 = un PID por petición)
+   * @param out Al menos maxCount elementos
+   * @return Canales elegidos (0 = nada vencido todavía). Un canal no
+   *         agrupable se devuelve siempre solo
+   */
+  uint8_t next(uint32_t nowMs, uint8_t maxCount, uint8_t *out);
+
+  /// Registra el tiempo de ida y vuelta de una petición
+  void recordRtt(uint32_t rttMs);
+
+  uint32_t getRttMs() const { return _rttMs; }
+  uint8_t getCount() const { return _count; }
+
+private:
+  struct Channel {
+    uint16_t periodMs;
+    ObdPriority priority;
+    bool batchable;
+    bool active;
+    bool polled;     ///< Ya se pidió al menos una vez
+    uint32_t lastMs; ///< Última vez que se eligió
+  };
+
+  /// Rango del canal ahora: -1 no candidato, 0 adelantable, 1+ vencido
+  int rank(const Channel &ch, uint32_t nowMs, uint32_t &elapsed,
+           uint32_t &period) const;
+
+  Channel _channels[OBD_SCHED_MAX_CHANNELS];
+  uint8_t _count;
+  uint32_t _rttMs; ///< RTT promediado (EMA 1/4)
+};
+
+#endif // OBD_SCHEDULER_H
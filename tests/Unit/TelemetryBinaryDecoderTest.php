@@ -0,0 +1,93 @@
+<?php
+
+use App\Services\TelemetryBinaryDecoder;
+
+/**
+ * Construye una trama binaria igual a la del firmware (cloud/binary_payload.cpp).
+ * v2 lleva la hora en µs (u64), v1 en segundos (u32).
+ */
+function binaryFrame(array $channels, array $custom = [], int $flags = 0x02, int $epoch = 1767225600, int $version = 2): string
+{
+    $str = fn (string $s) => chr(strlen($s)) . $s;
+
+    $time = $version >= 2 ? pack('P', $epoch * 1000000 + 250000) : pack('V', $epoch);
+    $frame = pack('CCC', 0x4E, $version, $flags) . $time
+        . $str('NEURONA_001')
+        . $str('TRUCK-2024-001')
+        . chr(count($channels));
+
+    foreach ($channels as $id => $value) {
+        $frame .= in_array($id, [1, 2], true)
+            ? pack('CV', $id, (int) round($value * 1e7) & 0xFFFFFFFF)
+            : pack('Cg', $id, $value);
+    }
+
+    $frame .= chr(count($custom));
+    foreach ($custom as $key => $value) {
+        $frame .= $str($key) . pack('g', $value);
+    }
+
+    return $frame . chr(0);
+}
+
+test('binary frames are told apart from json', function () {
+    expect(TelemetryBinaryDecoder::isBinary(binaryFrame([])))->toBeTrue();
+    expect(TelemetryBinaryDecoder::isBinary('{"id":"x"}'))->toBeFalse();
+    expect(TelemetryBinaryDecoder::isBinary(''))->toBeFalse();
+});
+
+test('decodes to the same shape as the json frame', function () {
+    $frame = binaryFrame(
+        [1 => 31.8667321, 2 => -116.5963512, 13 => 5200.0, 24 => 13.5, 29 => -61.0],
+        ['susp_travel' => 42.25],
+        0x03,
+    );
+
+    $data = (new TelemetryBinaryDecoder())->decode($frame);
+
+    expect($data['id'])->toBe('NEURONA_001');
+    expect($data['idc'])->toBe('TRUCK-2024-001');
+    expect($data['d'])->toBeTrue();
+    expect($data['dt'])->toBe(date('Y-m-d H:i:s', 1767225600));
+    expect($data['DTC'])->toBe([]);
+    expect($data['s']['lat']['v'])->toBe(31.8667321);
+    expect($data['s']['lng']['v'])->toBe(-116.5963512);
+    expect($data['s']['0x0C']['v'])->toEqual(5200.0);
+    expect($data['s']['BAT']['v'])->toEqual(13.5);
+    expect($data['s']['wifi_rssi']['v'])->toEqual(-61.0);
+    expect($data['s']['susp_travel']['v'])->toEqual(42.25);
+});
+
+test('v1 frames with a u32 epoch are still accepted', function () {
+    $data = (new TelemetryBinaryDecoder())->decode(binaryFrame([13 => 5200.0], [], 0x02, 1767225600, 1));
+
+    expect($data['dt'])->toBe(date('Y-m-d H:i:s', 1767225600));
+    expect($data['s']['0x0C']['v'])->toEqual(5200.0);
+});
+
+test('unsynchronized clock falls back to epoch string', function () {
+    $data = (new TelemetryBinaryDecoder())->decode(binaryFrame([], [], 0x00, 0));
+
+    expect($data['dt'])->toBe('1970-01-01 00:00:00');
+    expect($data['d'])->toBeFalse();
+});
+
+test('truncated or unknown version frames are rejected', function () {
+    $frame = binaryFrame([13 => 5200.0]);
+    $decoder = new TelemetryBinaryDecoder();
+
+    expect($decoder->decode(substr($frame, 0, -3)))->toBeNull();
+    expect($decoder->decode(chr(0x4E) . chr(3) . substr($frame, 2)))->toBeNull();
+});
+
+test('binary frame is smaller than the equivalent json frame', function () {
+    $channels = [];
+    foreach (array_keys(TelemetryBinaryDecoder::CHANNELS) as $id) {
+        $channels[$id] = in_array($id, [1, 2], true) ? 31.866732 : 1234.5;
+    }
+
+    $binary = binaryFrame($channels);
+    $json = json_encode((new TelemetryBinaryDecoder())->decode($binary));
+
+    expect(strlen($binary))->toBeLessThan(intdiv(strlen($json), 2));
+});